@@ -80,8 +80,16 @@ int main() {
     // 假设格式为：[4字节长度][数据Payload]
     while (fread(&payload_len, sizeof(int32_t), 1, in_file) == 1) {
 
+        // 0 长度记录是接收端抖动缓冲标记的丢包，补一帧静音（480 samples）
+        if (payload_len == 0) {
+            static const uint8_t silence[480 * 2 * 2] = { 0 };
+            fwrite(silence, 1, sizeof(silence), out_file);
+            packet_count++;
+            continue;
+        }
+
         // 安全检查：防止脏数据导致分配过大内存
-        if (payload_len <= 0 || payload_len > 1024 * 1024) {
+        if (payload_len < 0 || payload_len > 1024 * 1024) {
             printf("Warning: Invalid packet length %d, stopping.\n", payload_len);
             break;
         }
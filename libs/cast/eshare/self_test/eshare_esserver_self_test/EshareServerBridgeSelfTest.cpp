@@ -0,0 +1,184 @@
+#include <QCoreApplication>
+#include <QDebug>
+#include <QMetaObject>
+#include <QStringList>
+#include <QTimer>
+
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "EshareServerBridge.h"
+
+using namespace WQt::Cast::Eshare;
+
+// 用 EshareServerBridge 起一个完整的 ESServer，按命令行选收包方式，便于逐个模式对接真实发送端：
+//   --udp hv|mmsg|uring   音频 UDP 收包方式
+//   --video hv|uring      51030 收包方式
+//   --shards N            51030 reuseport 分片数，0 表示单个监听
+//   --seconds N           运行 N 秒后自动停止，0 表示等输入 q
+// 每秒打印一次收到的媒体单元数和字节数
+
+namespace
+{
+
+struct Options
+{
+    hhcast::ESUdpBackend udp = hhcast::ESUdpBackend::Hv;
+    hhcast::ESVideoBackend video = hhcast::ESVideoBackend::Hv;
+    size_t shards = 0;
+    int seconds = 0;
+};
+
+bool ParseOptions(const QStringList& args, Options& options)
+{
+    for (int i = 1; i + 1 < args.size(); i += 2)
+    {
+        const QString& key = args.at(i);
+        const QString& value = args.at(i + 1);
+
+        if (key == QStringLiteral("--udp"))
+        {
+            if (value == QStringLiteral("hv"))
+                options.udp = hhcast::ESUdpBackend::Hv;
+            else if (value == QStringLiteral("mmsg"))
+                options.udp = hhcast::ESUdpBackend::RecvMmsg;
+            else if (value == QStringLiteral("uring"))
+                options.udp = hhcast::ESUdpBackend::IoUring;
+            else
+                return false;
+        }
+        else if (key == QStringLiteral("--video"))
+        {
+            if (value == QStringLiteral("hv"))
+                options.video = hhcast::ESVideoBackend::Hv;
+            else if (value == QStringLiteral("uring"))
+                options.video = hhcast::ESVideoBackend::IoUring;
+            else
+                return false;
+        }
+        else if (key == QStringLiteral("--shards"))
+        {
+            options.shards = static_cast<size_t>(qMax(0, value.toInt()));
+        }
+        else if (key == QStringLiteral("--seconds"))
+        {
+            options.seconds = qMax(0, value.toInt());
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    Options options;
+    if (!ParseOptions(app.arguments(), options))
+    {
+        qDebug().noquote() << "usage: eshare_esserver_self_test [--udp hv|mmsg|uring] [--video hv|uring]"
+                              " [--shards N] [--seconds N]";
+        return 1;
+    }
+
+    hhcast::ESServerConfig config;
+    config.udpReceive.backend = options.udp;
+    config.videoReceive.backend = options.video;
+    config.socket.videoReusePortShards = options.shards;
+
+    EshareServerBridge bridge;
+    bridge.SetConfig(config);
+
+    quint64 units = 0;
+    quint64 bytes = 0;
+
+    QObject::connect(&bridge, &EshareServerBridge::SigLog,
+                     [](const QString& text) {
+                         qDebug().noquote() << text;
+                     });
+
+    QObject::connect(&bridge, &EshareServerBridge::SigError,
+                     [](const QString& text) {
+                         qDebug().noquote() << text;
+                     });
+
+    QObject::connect(&bridge, &EshareServerBridge::SigSessionOpened,
+                     [](quint32 streamId, const QString& name, const QString& peerIp, bool restored) {
+                         qDebug().noquote() << "[BRIDGE_TEST] session opened:" << streamId << name << peerIp
+                                            << (restored ? "restored" : "");
+                     });
+
+    QObject::connect(&bridge, &EshareServerBridge::SigSessionClosed,
+                     [](quint32 streamId, int cause, bool disconnected) {
+                         qDebug().noquote() << "[BRIDGE_TEST] session closed:" << streamId << "cause" << cause
+                                            << (disconnected ? "disconnected" : "");
+                     });
+
+    QObject::connect(&bridge, &EshareServerBridge::SigMediaBatch,
+                     [&units, &bytes](const EshareMediaBatch& batch) {
+                         for (const EshareMediaUnit& unit : batch.units)
+                         {
+                             ++units;
+                             bytes += static_cast<quint64>(unit.size);
+                         }
+                     });
+
+    QObject::connect(&bridge, &EshareServerBridge::SigStopped,
+                     [&app]() {
+                         qDebug().noquote() << "[BRIDGE_TEST] bridge stopped.";
+                         app.quit();
+                     });
+
+    if (!bridge.Start())
+    {
+        qDebug().noquote() << "[BRIDGE_TEST] bridge start failed.";
+        return 1;
+    }
+
+    qDebug().noquote() << "[BRIDGE_TEST] bridge started, udp=" << static_cast<int>(options.udp)
+                       << "video=" << static_cast<int>(options.video) << "shards=" << options.shards;
+
+    QTimer statsTimer;
+    QObject::connect(&statsTimer, &QTimer::timeout,
+                     [&units, &bytes, &bridge]() {
+                         qDebug().noquote() << "[BRIDGE_TEST] media units=" << units << "bytes=" << bytes
+                                            << "dropped batches=" << bridge.GetDroppedMediaBatches();
+                     });
+    statsTimer.start(1000);
+
+    if (options.seconds > 0)
+    {
+        QTimer::singleShot(options.seconds * 1000, &bridge, [&bridge]() {
+            bridge.Stop();
+        });
+    }
+    else
+    {
+        qDebug().noquote() << "";
+        qDebug().noquote() << "[INPUT] Type 'q' and press Enter to stop.";
+
+        std::thread inputThread([&bridge]() {
+            std::string line;
+            while (std::getline(std::cin, line))
+            {
+                if (line == "q" || line == "Q")
+                {
+                    QMetaObject::invokeMethod(&bridge, [&bridge]() {
+                        bridge.Stop();
+                    }, Qt::QueuedConnection);
+                    break;
+                }
+            }
+        });
+
+        inputThread.detach();
+    }
+
+    return app.exec();
+}
\ No newline at end of file
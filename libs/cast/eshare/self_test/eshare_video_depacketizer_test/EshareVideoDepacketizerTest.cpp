@@ -0,0 +1,239 @@
+#include <QByteArray>
+#include <QObject>
+#include <QRandomGenerator>
+#include <QVector>
+#include <QtTest>
+
+#include <cstring>
+
+#include "EshareVideoDepacketizer.h"
+
+using namespace WQt::Cast::Eshare;
+
+// 51030 拆包：按偏移交出单元后每个单元的拷贝量，与原来 mid 拷负载 + remove 搬移的做法对比，
+// 并用 QBENCHMARK 比较两者的吞吐。流是固定种子生成的，随机分块模拟 TCP 读
+
+namespace
+{
+
+constexpr int kHeaderLen = 128;
+
+struct StreamData
+{
+    QByteArray bytes;
+    QVector<QByteArray> payloads;
+    QVector<qsizetype> chunks;
+};
+
+StreamData MakeStream(int units)
+{
+    QRandomGenerator rng(51030);
+    StreamData stream;
+
+    for (int i = 0; i < units; ++i)
+    {
+        // 以 P 帧为主，每 30 帧一个大的 I 帧
+        const quint32 payloadLen = (i % 30 == 0) ? 200000 + rng.bounded(100000) : 2000 + rng.bounded(30000);
+        QByteArray payload(static_cast<qsizetype>(payloadLen), Qt::Uninitialized);
+        for (char& c : payload)
+            c = static_cast<char>(rng.bounded(256));
+
+        QByteArray header(kHeaderLen, '\0');
+        const quint32 kind = static_cast<quint32>(EshareVideoUnitKind::Frame);
+        std::memcpy(header.data(), &payloadLen, 4);
+        std::memcpy(header.data() + 4, &kind, 4);
+
+        stream.bytes += header;
+        stream.bytes += payload;
+        stream.payloads.append(payload);
+    }
+
+    for (qsizetype pos = 0; pos < stream.bytes.size();)
+    {
+        const qsizetype chunk = qMin<qsizetype>(1 + rng.bounded(64 * 1024), stream.bytes.size() - pos);
+        stream.chunks.append(chunk);
+        pos += chunk;
+    }
+    return stream;
+}
+
+// 原实现：追加到 QByteArray，mid 拷出负载，remove 把剩余数据搬到开头
+class LegacyDepacketizer
+{
+public:
+    quint64 copiedBytes = 0;
+    quint64 units = 0;
+
+    template <typename Fn>
+    void PushBytes(const QByteArray& data, Fn&& onUnit)
+    {
+        m_buffer += data;
+        copiedBytes += static_cast<quint64>(data.size());
+
+        while (m_buffer.size() >= kHeaderLen)
+        {
+            quint32 payloadLen = 0;
+            std::memcpy(&payloadLen, m_buffer.constData(), 4);
+            const qsizetype totalLen = kHeaderLen + static_cast<qsizetype>(payloadLen);
+            if (m_buffer.size() < totalLen)
+                return;
+
+            const QByteArray payload = m_buffer.mid(kHeaderLen, payloadLen);
+            copiedBytes += payloadLen;
+            ++units;
+            onUnit(payload);
+
+            copiedBytes += static_cast<quint64>(m_buffer.size() - totalLen);
+            m_buffer.remove(0, totalLen);
+        }
+    }
+
+private:
+    QByteArray m_buffer;
+};
+
+class CollectSink : public IEshareVideoUnitSink
+{
+public:
+    QVector<QByteArray> payloads;
+    QVector<EshareVideoUnit> retained;
+
+    void OnVideoUnit(const EshareVideoUnit& unit) override
+    {
+        payloads.append(unit.Payload().toByteArray());
+
+        // 模拟解码端留住最近几帧，迫使拆包器换块而不是原地写
+        retained.append(unit);
+        if (retained.size() > 8)
+            retained.removeFirst();
+    }
+};
+
+class CountSink : public IEshareVideoUnitSink
+{
+public:
+    quint64 bytes = 0;
+
+    void OnVideoUnit(const EshareVideoUnit& unit) override
+    {
+        bytes += unit.payloadLen;
+    }
+};
+
+template <typename Push>
+void FeedChunks(const StreamData& stream, Push&& push)
+{
+    qsizetype pos = 0;
+    for (qsizetype chunk : stream.chunks)
+    {
+        push(QByteArray::fromRawData(stream.bytes.constData() + pos, chunk));
+        pos += chunk;
+    }
+}
+
+} // namespace
+
+class EshareVideoDepacketizerTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase()
+    {
+        m_stream = MakeStream(600);
+    }
+
+    void payloadsMatch()
+    {
+        EshareVideoDepacketizer depacketizer;
+        CollectSink sink;
+        depacketizer.SetSink(&sink);
+
+        FeedChunks(m_stream, [&](const QByteArray& chunk) { depacketizer.PushBytes(chunk); });
+
+        QCOMPARE(sink.payloads.size(), m_stream.payloads.size());
+        QVERIFY(sink.payloads == m_stream.payloads);
+
+        // 换块之后，留住的单元仍指向原来的数据
+        for (int i = 0; i < sink.retained.size(); ++i)
+        {
+            const int index = m_stream.payloads.size() - sink.retained.size() + i;
+            QCOMPARE(sink.retained.at(i).Payload().toByteArray(), m_stream.payloads.at(index));
+        }
+    }
+
+    void copiesPerUnit()
+    {
+        EshareVideoDepacketizer depacketizer;
+        CollectSink sink;
+        depacketizer.SetSink(&sink);
+        FeedChunks(m_stream, [&](const QByteArray& chunk) { depacketizer.PushBytes(chunk); });
+
+        LegacyDepacketizer legacy;
+        FeedChunks(m_stream, [&](const QByteArray& chunk) { legacy.PushBytes(chunk, [](const QByteArray&) {}); });
+
+        const EshareVideoDepacketizerStats stats = depacketizer.GetStats();
+        QCOMPARE(stats.units, legacy.units);
+        QCOMPARE(stats.inputBytes, static_cast<quint64>(m_stream.bytes.size()));
+
+        const double units = static_cast<double>(stats.units);
+        const double offsetPerUnit = static_cast<double>(stats.copiedBytes) / units;
+        const double legacyPerUnit = static_cast<double>(legacy.copiedBytes) / units;
+        const double inputPerUnit = static_cast<double>(stats.inputBytes) / units;
+
+        qInfo().noquote() << QStringLiteral("copied bytes/unit: offset=%1 (%2x input) legacy=%3 (%4x input); "
+                                            "compactions=%5 blockSwitches=%6 blocksAllocated=%7")
+                             .arg(offsetPerUnit, 0, 'f', 0)
+                             .arg(offsetPerUnit / inputPerUnit, 0, 'f', 3)
+                             .arg(legacyPerUnit, 0, 'f', 0)
+                             .arg(legacyPerUnit / inputPerUnit, 0, 'f', 3)
+                             .arg(stats.compactions)
+                             .arg(stats.blockSwitches)
+                             .arg(stats.blocksAllocated);
+
+        // 输入写入块是必需的一次，换块时再搬一次未解析的尾部；原做法每份负载至少拷两次
+        QVERIFY(offsetPerUnit < inputPerUnit * 2.0);
+        QVERIFY(offsetPerUnit < legacyPerUnit);
+    }
+
+    void pushThroughput_data()
+    {
+        QTest::addColumn<bool>("legacy");
+        QTest::newRow("offset") << false;
+        QTest::newRow("legacy") << true;
+    }
+
+    void pushThroughput()
+    {
+        QFETCH(bool, legacy);
+        quint64 delivered = 0;
+
+        QBENCHMARK
+        {
+            if (legacy)
+            {
+                LegacyDepacketizer depacketizer;
+                FeedChunks(m_stream, [&](const QByteArray& chunk) {
+                    depacketizer.PushBytes(chunk, [&](const QByteArray& payload) { delivered += payload.size(); });
+                });
+            }
+            else
+            {
+                EshareVideoDepacketizer depacketizer;
+                CountSink sink;
+                depacketizer.SetSink(&sink);
+                FeedChunks(m_stream, [&](const QByteArray& chunk) { depacketizer.PushBytes(chunk); });
+                delivered += sink.bytes;
+            }
+        }
+
+        QVERIFY(delivered > 0);
+    }
+
+private:
+    StreamData m_stream;
+};
+
+QTEST_GUILESS_MAIN(EshareVideoDepacketizerTest)
+
+#include "EshareVideoDepacketizerTest.moc"
\ No newline at end of file
@@ -23,6 +23,22 @@ Eshare51040RtspServer::Eshare51040RtspServer(QObject* parent)
 
     connect(m_server, &QTcpServer::newConnection,
             this, &Eshare51040RtspServer::OnNewConnection);
+
+    m_audioJitterBuffer.SetPayloadCallback(
+        [this](const hhcast::ESAudioPayloadInfo& info) {
+            OnAudioPayloadReady(info);
+        });
+
+    m_audioJitterBuffer.SetGapCallback(
+        [this](const hhcast::ESAudioGapInfo& gap) {
+            OnAudioGap(gap);
+        });
+
+    m_audioJitterTimer = new QTimer(this);
+    m_audioJitterTimer->setInterval(10);
+
+    connect(m_audioJitterTimer, &QTimer::timeout,
+            this, &Eshare51040RtspServer::OnAudioJitterTimer);
 }
 
 bool Eshare51040RtspServer::Start(const QString& localIp, quint16 port)
@@ -110,22 +126,6 @@ void Eshare51040RtspServer::OnNewConnection()
     }
 }
 
-static QString ToReadableRtspMessage(const QByteArray& encoded)
-{
-    QByteArray tmp = encoded;
-
-    WQt::Cast::Eshare::RtspLiteMessage msg;
-    QByteArray raw;
-    QString error;
-    if (WQt::Cast::Eshare::RtspLiteCodec::TryDecode(tmp, msg, &raw, &error))
-    {
-        return WQt::Cast::Eshare::RtspLiteCodec::MessageToDebugString(msg);
-    }
-
-    return QStringLiteral("<decode failed: %1>\nHEX:\n%2")
-        .arg(error, QString::fromUtf8(encoded.toHex(' ')));
-}
-
 void Eshare51040RtspServer::OnSocketReadyRead()
 {
     auto* socket = qobject_cast<QTcpSocket*>(sender());
@@ -138,30 +138,31 @@ void Eshare51040RtspServer::OnSocketReadyRead()
     while (true)
     {
         RtspLiteMessage req;
-        QByteArray rawReq;
         QString error;
 
-        if (!RtspLiteCodec::TryDecode(buffer, req, &rawReq, &error))
+        const int bufferedBefore = buffer.size();
+        if (!RtspLiteCodec::TryDecode(buffer, req, nullptr, &error))
             break;
 
         emit SigLog(QStringLiteral("[51040S] <<< RECV from %1 (%2 bytes)\n%3")
                     .arg(PeerToString(socket))
-                    .arg(rawReq.size())
+                    .arg(bufferedBefore - buffer.size())
                     .arg(RtspLiteCodec::MessageToDebugString(req)));
 
-        bool ok = false;
-        const QByteArray respBytes = BuildResponse(rawReq, &ok);
-        if (!ok)
+        // 请求只解码一次，响应直接用消息对象打日志，不再回解编码结果
+        RtspLiteMessage resp;
+        if (!BuildResponse(req, resp))
         {
             emit SigLog(QStringLiteral("[51040S] ignore unsupported request from %1")
                         .arg(PeerToString(socket)));
             continue;
         }
 
+        const QByteArray respBytes = RtspLiteCodec::Encode(resp);
         emit SigLog(QStringLiteral("[51040S] >>> SEND to %1 (%2 bytes)\n%3")
                         .arg(PeerToString(socket))
                         .arg(respBytes.size())
-                        .arg(ToReadableRtspMessage(respBytes)));
+                        .arg(RtspLiteCodec::MessageToDebugString(resp)));
 
         socket->write(respBytes);
         socket->flush();
@@ -252,28 +253,12 @@ void Eshare51040RtspServer::OnAudioDataReadyRead()
             continue;
         }
 
-        const QByteArray payload = datagram.mid(12);
+        const qint64 payloadLen = readLen - 12;
 
+        // rtp dump / csv 记录到达顺序，便于排查网络抖动
         if (m_audioRtpDumpFile.isOpen())
             m_audioRtpDumpFile.write(datagram);
 
-        if (m_audioPayloadDumpFile.isOpen())
-            m_audioPayloadDumpFile.write(payload);
-
-        if (m_audioPayloadLenDumpFile.isOpen())
-        {
-            const quint32 payloadLen = static_cast<quint32>(payload.size());
-
-            char lenBuf[4];
-            lenBuf[0] = static_cast<char>(payloadLen & 0xFF);
-            lenBuf[1] = static_cast<char>((payloadLen >> 8) & 0xFF);
-            lenBuf[2] = static_cast<char>((payloadLen >> 16) & 0xFF);
-            lenBuf[3] = static_cast<char>((payloadLen >> 24) & 0xFF);
-
-            m_audioPayloadLenDumpFile.write(lenBuf, 4);
-            m_audioPayloadLenDumpFile.write(payload);
-        }
-
         if (m_audioDumpCsvFile.isOpen())
         {
             QTextStream ts(&m_audioDumpCsvFile);
@@ -282,10 +267,23 @@ void Eshare51040RtspServer::OnAudioDataReadyRead()
                << timestamp << ','
                << ssrc << ','
                << readLen << ','
-               << payload.size() << '\n';
+               << payloadLen << '\n';
             ts.flush();
         }
 
+        if (payloadLen > 0)
+        {
+            hhcast::ESAudioPayloadInfo info;
+            info.payloadType = payloadType;
+            info.sequence = seq;
+            info.timestamp = timestamp;
+            info.ssrc = ssrc;
+            info.payload = p + 12;
+            info.payloadSize = static_cast<size_t>(payloadLen);
+
+            m_audioJitterBuffer.Push(info, static_cast<quint64>(m_audioClock.nsecsElapsed() / 1000));
+        }
+
         if (m_audioPacketIndex < 20)
         {
             emit SigLog(QStringLiteral("[51040S] dump rtp[%1]: from=%2:%3 pt=%4 seq=%5 ts=%6 ssrc=0x%7 rtpLen=%8 payloadLen=%9")
@@ -297,13 +295,80 @@ void Eshare51040RtspServer::OnAudioDataReadyRead()
                             .arg(timestamp)
                             .arg(QString::number(ssrc, 16).rightJustified(8, QLatin1Char('0')))
                             .arg(readLen)
-                            .arg(payload.size()));
+                            .arg(payloadLen));
         }
 
         ++m_audioPacketIndex;
     }
 }
 
+void Eshare51040RtspServer::OnAudioJitterTimer()
+{
+    m_audioJitterBuffer.Poll(static_cast<quint64>(m_audioClock.nsecsElapsed() / 1000));
+}
+
+void Eshare51040RtspServer::OnAudioPayloadReady(const hhcast::ESAudioPayloadInfo& info)
+{
+    const char* payload = reinterpret_cast<const char*>(info.payload);
+    const qint64 payloadLen = static_cast<qint64>(info.payloadSize);
+
+    if (m_audioPayloadDumpFile.isOpen())
+        m_audioPayloadDumpFile.write(payload, payloadLen);
+
+    if (m_audioPayloadLenDumpFile.isOpen())
+    {
+        const quint32 len = static_cast<quint32>(payloadLen);
+
+        char lenBuf[4];
+        lenBuf[0] = static_cast<char>(len & 0xFF);
+        lenBuf[1] = static_cast<char>((len >> 8) & 0xFF);
+        lenBuf[2] = static_cast<char>((len >> 16) & 0xFF);
+        lenBuf[3] = static_cast<char>((len >> 24) & 0xFF);
+
+        m_audioPayloadLenDumpFile.write(lenBuf, 4);
+        m_audioPayloadLenDumpFile.write(payload, payloadLen);
+    }
+}
+
+void Eshare51040RtspServer::OnAudioGap(const hhcast::ESAudioGapInfo& gap)
+{
+    // 每个丢失包写一条 0 长度记录，解码端据此补静音
+    if (m_audioPayloadLenDumpFile.isOpen())
+    {
+        const char zero[4] = { 0, 0, 0, 0 };
+        for (quint16 i = 0; i < gap.count; ++i)
+            m_audioPayloadLenDumpFile.write(zero, 4);
+    }
+
+    if (m_audioGapCount < 20)
+    {
+        emit SigLog(QStringLiteral("[51040S] audio gap: seq=%1 count=%2 ts=%3 samples=%4")
+                        .arg(gap.firstSequence)
+                        .arg(gap.count)
+                        .arg(gap.timestamp)
+                        .arg(gap.durationSamples));
+    }
+
+    ++m_audioGapCount;
+}
+
+void Eshare51040RtspServer::LogAudioJitterStats()
+{
+    const hhcast::ESAudioJitterStats stats = m_audioJitterBuffer.GetStats();
+    if (stats.received == 0)
+        return;
+
+    emit SigLog(QStringLiteral("[51040S] audio jitter: recv=%1 out=%2 lost=%3 late=%4 dup=%5 reorder=%6 jitter=%7ms target=%8ms")
+                    .arg(stats.received)
+                    .arg(stats.delivered)
+                    .arg(stats.lost)
+                    .arg(stats.late)
+                    .arg(stats.duplicate)
+                    .arg(stats.reordered)
+                    .arg(stats.jitterMs, 0, 'f', 2)
+                    .arg(stats.targetDepthMs));
+}
+
 void Eshare51040RtspServer::OnControlReadyRead()
 {
     if (!m_controlSocket)
@@ -342,25 +407,9 @@ void Eshare51040RtspServer::OnMouseReadyRead()
     }
 }
 
-QByteArray Eshare51040RtspServer::BuildResponse(const QByteArray& rawRequest, bool* ok)
+bool Eshare51040RtspServer::BuildResponse(const RtspLiteMessage& req, RtspLiteMessage& resp) const
 {
-    if (ok)
-        *ok = true;
-
-    QByteArray tmp = rawRequest;
-
-    RtspLiteMessage req;
-    QByteArray rawMsg;
-    QString error;
-    const bool decoded = RtspLiteCodec::TryDecode(tmp, req, &rawMsg, &error);
-    if (!decoded)
-    {
-        if (ok)
-            *ok = false;
-        return {};
-    }
-
-    RtspLiteMessage resp;
+    resp = RtspLiteMessage{};
     const QString cseq = req.headerValue(QStringLiteral("CSeq"));
 
     const bool isSetup = req.startLine.startsWith(QStringLiteral("SETUP "), Qt::CaseInsensitive);
@@ -389,7 +438,7 @@ QByteArray Eshare51040RtspServer::BuildResponse(const QByteArray& rawRequest, bo
             resp.body = BuildAudioSetupPlist();
         }
 
-        return RtspLiteCodec::Encode(resp);
+        return true;
     }
 
     if (isOptions)
@@ -402,7 +451,7 @@ QByteArray Eshare51040RtspServer::BuildResponse(const QByteArray& rawRequest, bo
         resp.setHeader(QStringLiteral("Video-Audio"), QStringLiteral("1"));
         resp.setHeader(QStringLiteral("Content-Type"), QStringLiteral("application/json"));
         resp.body = BuildOptionsJson();
-        return RtspLiteCodec::Encode(resp);
+        return true;
     }
 
     if (isTeardown)
@@ -411,12 +460,10 @@ QByteArray Eshare51040RtspServer::BuildResponse(const QByteArray& rawRequest, bo
         if (!cseq.isEmpty())
             resp.setHeader(QStringLiteral("CSeq"), cseq);
         resp.body.clear();
-        return RtspLiteCodec::Encode(resp);
+        return true;
     }
 
-    if (ok)
-        *ok = false;
-    return {};
+    return false;
 }
 
 QByteArray Eshare51040RtspServer::BuildVideoSetupPlist() const
@@ -600,6 +647,11 @@ bool Eshare51040RtspServer::StartUdpServices()
 
 void Eshare51040RtspServer::StopUdpServices()
 {
+    m_audioJitterTimer->stop();
+    m_audioJitterBuffer.Flush();
+    LogAudioJitterStats();
+    m_audioJitterBuffer.Reset();
+
     CloseAudioDumpFiles();
 
     if (m_audioDataSocket)
@@ -665,6 +717,10 @@ bool Eshare51040RtspServer::OpenAudioDumpFiles()
     ts.flush();
 
     m_audioPacketIndex = 0;
+    m_audioGapCount = 0;
+    m_audioJitterBuffer.Reset();
+    m_audioClock.start();
+    m_audioJitterTimer->start();
 
     emit SigLog(QStringLiteral("[51040S] audio dump dir ready: %1").arg(dumpDir));
     return true;
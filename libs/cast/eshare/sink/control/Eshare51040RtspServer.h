@@ -1,12 +1,17 @@
 #pragma once
 
 #include <QObject>
+#include <QElapsedTimer>
 #include <QHash>
+#include <QTimer>
 #include <QTcpServer>
 #include <QTcpSocket>
 #include <QUdpSocket>
 #include <QFile>
 
+#include "ESAudioJitterBuffer.h"
+#include "EshareRtspLiteMessage.h"
+
 namespace WQt::Cast::Eshare
 {
 
@@ -34,9 +39,10 @@ private slots:
     void OnAudioDataReadyRead();
     void OnControlReadyRead();
     void OnMouseReadyRead();
+    void OnAudioJitterTimer();
 
 private:
-    QByteArray BuildResponse(const QByteArray& rawRequest, bool* ok = nullptr);
+    bool BuildResponse(const RtspLiteMessage& req, RtspLiteMessage& resp) const;
     QByteArray BuildVideoSetupPlist() const;
     QByteArray BuildAudioSetupPlist() const;
     QByteArray BuildOptionsJson() const;
@@ -49,6 +55,10 @@ private:
     bool OpenAudioDumpFiles();
     void CloseAudioDumpFiles();
 
+    void OnAudioPayloadReady(const hhcast::ESAudioPayloadInfo& info);
+    void OnAudioGap(const hhcast::ESAudioGapInfo& gap);
+    void LogAudioJitterStats();
+
     static quint16 ReadBE16(const uchar* p);
     static quint32 ReadBE32(const uchar* p);
 
@@ -80,6 +90,12 @@ private:
     QFile m_audioPayloadLenDumpFile;   // [4字节长度][payload]
     QFile m_audioDumpCsvFile;
     quint64 m_audioPacketIndex = 0;
+
+    // 按 seq/timestamp 排序去重后再写 payload dump，丢包位置写 0 长度记录
+    hhcast::ESAudioJitterBuffer m_audioJitterBuffer;
+    QElapsedTimer m_audioClock;
+    QTimer* m_audioJitterTimer = nullptr;   // 流停顿/结束时按时间把缓冲里的包放出来
+    quint64 m_audioGapCount = 0;
 };
 
 } // namespace WQt::Cast::Eshare
\ No newline at end of file
@@ -5,9 +5,22 @@
 
 #include "EshareJsonLineCodec.h"
 
+#include <chrono>
+
 namespace WQt::Cast::Eshare
 {
 
+namespace
+{
+
+qint64 NowSteadyUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
 Eshare57395HeartbeatServer::Eshare57395HeartbeatServer(QObject* parent)
     : QObject(parent)
 {
@@ -63,6 +76,7 @@ void Eshare57395HeartbeatServer::Stop()
         CloseAndDeleteSocket(socket);
     }
     m_recvBuffers.clear();
+    m_clockSyncs.clear();
 
     if (m_server->isListening())
     {
@@ -81,7 +95,8 @@ void Eshare57395HeartbeatServer::OnNewConnection()
         if (!socket)
             continue;
 
-        m_recvBuffers.insert(socket, QByteArray{});
+        m_recvBuffers.insert(socket, hhcast::ESJsonLineSplitter{});
+        m_clockSyncs.insert(socket, std::make_shared<hhcast::ESClockSync>());
 
         connect(socket, &QTcpSocket::readyRead,
                 this, &Eshare57395HeartbeatServer::OnSocketReadyRead);
@@ -100,25 +115,45 @@ void Eshare57395HeartbeatServer::OnSocketReadyRead()
     if (!socket)
         return;
 
-    QByteArray& buffer = m_recvBuffers[socket];
-    buffer += socket->readAll();
+    const qint64 recvUs = NowSteadyUs();
+    hhcast::ESJsonLineSplitter& splitter = m_recvBuffers[socket];
+    const QByteArray data = socket->readAll();
+    splitter.Append(data.constData(), static_cast<size_t>(data.size()));
 
-    while (true)
+    std::string_view line;
+    while (splitter.Next(line))
     {
-        QByteArray rawLine;
-        QJsonObject obj;
-        QString error;
-
-        if (!JsonLineCodec::TryDecode(buffer, &rawLine, obj, &error))
-            break;
+        const QByteArray rawLine = QByteArray::fromRawData(line.data(), static_cast<qsizetype>(line.size()));
 
         emit SigLog(QStringLiteral("[57395S] <<< RECV from %1 (%2 bytes)\n%3")
                     .arg(PeerToString(socket))
                     .arg(rawLine.size())
-                    .arg(JsonLineCodec::ToPrettyString(obj)));
+                    .arg(QString::fromUtf8(rawLine)));
+
+        std::string scratch;
+        hhcast::ESEshareJsonMessage msg;
+        if (!m_scanner.Parse(line) || !hhcast::ParseEshareJsonMessage(m_scanner, msg, &scratch, false))
+        {
+            emit SigLog(QStringLiteral("[57395S] ignore unsupported json from %1")
+                        .arg(PeerToString(socket)));
+            continue;
+        }
+
+        // 发送端带了 sendUs 才回计时字段
+        hhcast::ESHeartbeatTiming timing;
+        const hhcast::ESHeartbeatTiming* replyTiming = nullptr;
+        if (msg.kind == hhcast::ESEshareJsonKind::Heartbeat && msg.timing.sendUs != 0)
+        {
+            UpdateClockSync(socket, msg.timing, recvUs);
+
+            timing.echoUs = msg.timing.sendUs;
+            timing.echoRecvUs = recvUs;
+            timing.sendUs = NowSteadyUs();
+            replyTiming = &timing;
+        }
 
         bool ok = false;
-        const QByteArray respBytes = BuildResponse(obj, &ok);
+        const QByteArray respBytes = BuildResponse(msg, replyTiming, &ok);
         if (!ok)
         {
             emit SigLog(QStringLiteral("[57395S] ignore unsupported json from %1")
@@ -134,6 +169,14 @@ void Eshare57395HeartbeatServer::OnSocketReadyRead()
         socket->write(respBytes);
         socket->flush();
     }
+
+    if (splitter.IsOverflowed())
+    {
+        emit SigLog(QStringLiteral("[57395S] line too long from %1, drop %2 bytes")
+                    .arg(PeerToString(socket))
+                    .arg(splitter.GetBufferedSize()));
+        splitter.Reset();
+    }
 }
 
 void Eshare57395HeartbeatServer::OnSocketDisconnected()
@@ -145,6 +188,7 @@ void Eshare57395HeartbeatServer::OnSocketDisconnected()
     emit SigLog(QStringLiteral("[57395S] disconnected: %1").arg(PeerToString(socket)));
 
     m_recvBuffers.remove(socket);
+    m_clockSyncs.remove(socket);
     socket->deleteLater();
 }
 
@@ -167,7 +211,25 @@ void Eshare57395HeartbeatServer::OnSocketError(QAbstractSocket::SocketError sock
                 .arg(socket->errorString()));
 }
 
-QByteArray Eshare57395HeartbeatServer::BuildResponse(const QJsonObject& reqObj, bool* ok)
+void Eshare57395HeartbeatServer::UpdateClockSync(QTcpSocket* socket,
+                                                 const hhcast::ESHeartbeatTiming& peer,
+                                                 qint64 recvUs)
+{
+    const std::shared_ptr<hhcast::ESClockSync> clockSync = m_clockSyncs.value(socket);
+    hhcast::ESClockExchange exchange;
+    if (!clockSync || !hhcast::ESClockSync::MakeExchange(peer, recvUs, exchange))
+        return;
+
+    if (!clockSync->AddExchange(exchange))
+        return;
+
+    const hhcast::ESClockSyncStats stats = clockSync->GetStats();
+    emit SigClockSync(PeerToString(socket), stats.rttUs, stats.offsetUs);
+}
+
+QByteArray Eshare57395HeartbeatServer::BuildResponse(const hhcast::ESEshareJsonMessage& req,
+                                                     const hhcast::ESHeartbeatTiming* timing,
+                                                     bool* ok)
 {
     if (ok)
         *ok = true;
@@ -175,7 +237,7 @@ QByteArray Eshare57395HeartbeatServer::BuildResponse(const QJsonObject& reqObj,
     QJsonObject resp;
 
     // 第一条通常是 client-info
-    if (reqObj.contains(QStringLiteral("clientName")))
+    if (req.kind == hhcast::ESEshareJsonKind::ClientInfo)
     {
         resp.insert(QStringLiteral("replyHeartbeat"), 0);
         resp.insert(QStringLiteral("castState"), 1);
@@ -188,9 +250,9 @@ QByteArray Eshare57395HeartbeatServer::BuildResponse(const QJsonObject& reqObj,
     }
 
     // 后续是 heartbeat
-    if (reqObj.contains(QStringLiteral("heartbeat")))
+    if (req.kind == hhcast::ESEshareJsonKind::Heartbeat)
     {
-        const int hb = reqObj.value(QStringLiteral("heartbeat")).toInt(-1);
+        const qint64 hb = req.heartbeat;
 
         resp.insert(QStringLiteral("replyHeartbeat"), hb);
         resp.insert(QStringLiteral("castState"), 1);
@@ -199,6 +261,13 @@ QByteArray Eshare57395HeartbeatServer::BuildResponse(const QJsonObject& reqObj,
         resp.insert(QStringLiteral("multiScreen"), 0);
         resp.insert(QStringLiteral("isModerator"), 0);
         resp.insert(QStringLiteral("radioMode"), 0);
+
+        if (timing)
+        {
+            resp.insert(QStringLiteral("sendUs"), static_cast<qint64>(timing->sendUs));
+            resp.insert(QStringLiteral("echoUs"), static_cast<qint64>(timing->echoUs));
+            resp.insert(QStringLiteral("echoRecvUs"), static_cast<qint64>(timing->echoRecvUs));
+        }
         return JsonLineCodec::Encode(resp);
     }
 
@@ -5,6 +5,10 @@
 #include <QTcpServer>
 #include <QTcpSocket>
 
+#include <memory>
+
+#include "ESJsonLineScanner.h"
+
 namespace WQt::Cast::Eshare
 {
 
@@ -22,6 +26,8 @@ signals:
     void SigStarted(quint16 port);
     void SigStopped();
     void SigError(const QString& text);
+    // 发送端心跳带计时字段时，每次往返后更新（最小 RTT 选择后的结果）
+    void SigClockSync(const QString& peer, qint64 rttUs, qint64 clockOffsetUs);
 
 private slots:
     void OnNewConnection();
@@ -30,7 +36,10 @@ private slots:
     void OnSocketError(QAbstractSocket::SocketError socketError);
 
 private:
-    QByteArray BuildResponse(const QJsonObject& reqObj, bool* ok = nullptr);
+    QByteArray BuildResponse(const hhcast::ESEshareJsonMessage& req,
+                             const hhcast::ESHeartbeatTiming* timing,
+                             bool* ok = nullptr);
+    void UpdateClockSync(QTcpSocket* socket, const hhcast::ESHeartbeatTiming& peer, qint64 recvUs);
     QString PeerToString(QTcpSocket* socket) const;
     void CloseAndDeleteSocket(QTcpSocket* socket);
 
@@ -38,7 +47,9 @@ private:
     QTcpServer* m_server = nullptr;
     QString m_localIp;
     quint16 m_port = 57395;
-    QHash<QTcpSocket*, QByteArray> m_recvBuffers;
+    QHash<QTcpSocket*, hhcast::ESJsonLineSplitter> m_recvBuffers;
+    QHash<QTcpSocket*, std::shared_ptr<hhcast::ESClockSync>> m_clockSyncs;
+    hhcast::ESJsonLineScanner m_scanner;
 };
 
 } // namespace WQt::Cast::Eshare
\ No newline at end of file
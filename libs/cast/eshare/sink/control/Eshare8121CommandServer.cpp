@@ -106,19 +106,10 @@ void Eshare8121CommandServer::OnSocketReadyRead()
                 .arg(PeerToString(socket))
                 .arg(buffer.size()));
 
-    // 8121 sender 请求固定是 3 行，最后有 CRLF，简单按行数兜底即可
-    QByteArray normalized = buffer;
-    normalized.replace("\r\n", "\n");
-
-    const QList<QByteArray> lines = normalized.split('\n');
-    int nonEmptyCount = 0;
-    for (const QByteArray& line : lines)
-    {
-        if (!line.trimmed().isEmpty())
-            ++nonEmptyCount;
-    }
-
-    if (nonEmptyCount < 3)
+    // 8121 sender 请求固定是 3 行，最后有 CRLF，凑齐 3 行非空行即可处理；命令名不区分大小写
+    hhcast::ESEshareCommandRequest req;
+    if (!hhcast::ParseEshareCommandRequest(
+            std::string_view(buffer.constData(), static_cast<size_t>(buffer.size())), req, true))
         return;
 
     emit SigLog(QStringLiteral("[8121S] <<< RECV from %1 (%2 bytes)\n%3")
@@ -126,7 +117,7 @@ void Eshare8121CommandServer::OnSocketReadyRead()
                 .arg(buffer.size())
                 .arg(QString::fromUtf8(buffer)));
 
-    const QByteArray respBytes = BuildResponse(buffer);
+    const QByteArray respBytes = BuildResponse(req);
 
     emit SigLog(QStringLiteral("[8121S] >>> SEND to %1 (%2 bytes)\n%3")
                 .arg(PeerToString(socket))
@@ -169,22 +160,9 @@ void Eshare8121CommandServer::OnSocketError(QAbstractSocket::SocketError socketE
                 .arg(socket->errorString()));
 }
 
-QByteArray Eshare8121CommandServer::BuildResponse(const QByteArray& rawRequest)
+QByteArray Eshare8121CommandServer::BuildResponse(const hhcast::ESEshareCommandRequest& req)
 {
-    QByteArray normalized = rawRequest;
-    normalized.replace("\r\n", "\n");
-
-    const QString text = QString::fromUtf8(normalized);
-    const QStringList lines = text.split('\n', Qt::SkipEmptyParts);
-
-    const QString command = (lines.size() >= 1) ? lines[0].trimmed() : QString{};
-    const QString clientName = (lines.size() >= 2) ? lines[1].trimmed() : QString{};
-    const QString clientVersion = (lines.size() >= 3) ? lines[2].trimmed() : QString{};
-
-    Q_UNUSED(clientName);
-    Q_UNUSED(clientVersion);
-
-    if (command.compare(QStringLiteral("getServerInfo"), Qt::CaseInsensitive) == 0)
+    if (req.command == hhcast::ESEshareCommand::GetServerInfo)
     {
         QJsonObject obj;
         obj.insert(QStringLiteral("name"), QStringLiteral("WQtLib EShare Sink"));
@@ -199,7 +177,7 @@ QByteArray Eshare8121CommandServer::BuildResponse(const QByteArray& rawRequest)
         return QJsonDocument(obj).toJson(QJsonDocument::Compact);
     }
 
-    if (command.compare(QStringLiteral("dongleConnected"), Qt::CaseInsensitive) == 0)
+    if (req.command == hhcast::ESEshareCommand::DongleConnected)
     {
         QByteArray resp;
         resp += "WQtLib EShare Sink\r\n";
@@ -209,7 +187,8 @@ QByteArray Eshare8121CommandServer::BuildResponse(const QByteArray& rawRequest)
 
     QJsonObject obj;
     obj.insert(QStringLiteral("error"), QStringLiteral("unknown command"));
-    obj.insert(QStringLiteral("command"), command);
+    obj.insert(QStringLiteral("command"),
+               QString::fromUtf8(req.commandText.data(), static_cast<qsizetype>(req.commandText.size())));
     return QJsonDocument(obj).toJson(QJsonDocument::Compact);
 }
 
@@ -5,6 +5,8 @@
 #include <QTcpServer>
 #include <QTcpSocket>
 
+#include "ESJsonLineScanner.h"
+
 namespace WQt::Cast::Eshare
 {
 
@@ -30,7 +32,7 @@ private slots:
     void OnSocketError(QAbstractSocket::SocketError socketError);
 
 private:
-    QByteArray BuildResponse(const QByteArray& rawRequest);
+    QByteArray BuildResponse(const hhcast::ESEshareCommandRequest& req);
     QString PeerToString(QTcpSocket* socket) const;
     void CloseAndDeleteSocket(QTcpSocket* socket);
 
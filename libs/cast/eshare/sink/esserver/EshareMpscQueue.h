@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+
+namespace WQt::Cast::Eshare
+{
+
+struct EshareMpscNode
+{
+    std::atomic<EshareMpscNode*> next{ nullptr };
+};
+
+// 侵入式无锁队列（Vyukov MPSC）：任意线程 Push，只有一个线程 Pop。
+// 节点归调用方所有，队列只串链表；Push 不会失败也不分配内存
+class EshareMpscQueue
+{
+public:
+    EshareMpscQueue()
+        : m_head(&m_stub)
+        , m_tail(&m_stub)
+    {
+    }
+
+    EshareMpscQueue(const EshareMpscQueue&) = delete;
+    EshareMpscQueue& operator=(const EshareMpscQueue&) = delete;
+
+    void Push(EshareMpscNode* node)
+    {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        EshareMpscNode* prev = m_head.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    // 队列空，或某个生产者刚换了 head 还没接上链时返回 nullptr，下次再取即可
+    EshareMpscNode* Pop()
+    {
+        EshareMpscNode* tail = m_tail;
+        EshareMpscNode* next = tail->next.load(std::memory_order_acquire);
+
+        if (tail == &m_stub)
+        {
+            if (next == nullptr)
+                return nullptr;
+
+            m_tail = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+
+        if (next != nullptr)
+        {
+            m_tail = next;
+            return tail;
+        }
+
+        if (tail != m_head.load(std::memory_order_acquire))
+            return nullptr;
+
+        // tail 是最后一个节点，塞回 stub 才能把它摘下来
+        Push(&m_stub);
+        next = tail->next.load(std::memory_order_acquire);
+        if (next != nullptr)
+        {
+            m_tail = next;
+            return tail;
+        }
+        return nullptr;
+    }
+
+private:
+    std::atomic<EshareMpscNode*> m_head;
+    EshareMpscNode* m_tail;
+    EshareMpscNode m_stub;
+};
+
+} // namespace WQt::Cast::Eshare
\ No newline at end of file
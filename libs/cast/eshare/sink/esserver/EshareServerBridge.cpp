@@ -0,0 +1,417 @@
+#include "EshareServerBridge.h"
+#include "EshareMpscQueue.h"
+#include "EshareSlotPool.h"
+
+#include "ESServer.h"
+#include "IESServerCallbackV2.h"
+
+#include <QTimer>
+
+#include <atomic>
+#include <cstring>
+
+namespace WQt::Cast::Eshare
+{
+
+namespace
+{
+
+struct BridgeEvent : public EshareMpscNode
+{
+    enum class Type
+    {
+        SessionOpen,
+        SessionClose,
+        Media,
+        Quota,
+        HandedOff,
+    };
+
+    Type type = Type::Media;
+    quint32 streamId = 0;
+    QString name;
+    QString peerIp;
+    bool flag = false;          // SessionOpen: restored；SessionClose: disconnected
+    int cause = 0;              // SessionClose: cause；Quota: level
+    int action = 0;
+
+    EshareMediaBatch batch;
+    qint64 bytes = 0;
+    QByteArray buffer;          // Media: 本批负载，槽位复用时原地重写
+};
+
+// 槽位归还时超过该容量的缓冲不留，空闲槽位占的内存有上限
+constexpr qsizetype kMaxRetainedBufferBytes = 256 * 1024;
+
+} // namespace
+
+// 在 ESServer 的各线程上回调，只做拷贝和入队
+class EshareServerBridge::Sink : public hhcast::IESServerCallbackV2
+{
+public:
+    Sink(qint64 maxQueuedBytes, int poolSlots)
+        : m_maxQueuedBytes(maxQueuedBytes)
+        , m_pool(static_cast<size_t>(poolSlots))
+    {
+    }
+
+    ~Sink() override
+    {
+        while (BridgeEvent* event = Pop())
+            Recycle(event);
+    }
+
+    void OnSessionOpen(const hhcast::ESSessionOpenEvent& event) override
+    {
+        BridgeEvent* item = AcquireControlEvent();
+        item->type = BridgeEvent::Type::SessionOpen;
+        item->streamId = event.streamId;
+        item->name = QString::fromUtf8(event.name.data(), static_cast<qsizetype>(event.name.size()));
+        item->peerIp = QString::fromUtf8(event.peerIp.data(), static_cast<qsizetype>(event.peerIp.size()));
+        item->flag = event.restored;
+        m_queue.Push(item);
+    }
+
+    void OnSessionClose(const hhcast::ESSessionCloseEvent& event) override
+    {
+        BridgeEvent* item = AcquireControlEvent();
+        item->type = BridgeEvent::Type::SessionClose;
+        item->streamId = event.streamId;
+        item->flag = event.disconnected;
+        item->cause = static_cast<int>(event.cause);
+        m_queue.Push(item);
+    }
+
+    void OnMediaBatch(const hhcast::ESMediaBatch& batch) override
+    {
+        qint64 total = 0;
+        for (const auto& event : batch.video)
+            total += static_cast<qint64>(event.unit.payloadSize);
+        for (const auto& event : batch.audio)
+            total += static_cast<qint64>(event.info.payloadSize);
+
+        if (total == 0)
+            return;
+
+        // GUI 线程跟不上时丢新批次，保证内存有上限
+        if (m_queuedBytes.load(std::memory_order_relaxed) + total > m_maxQueuedBytes)
+        {
+            m_droppedBatches.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        // 槽位用完说明 GUI 线程积压了太多批次，同样丢新批次
+        BridgeEvent* item = m_pool.Acquire();
+        if (item == nullptr)
+        {
+            m_droppedBatches.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        // 上次的缓冲已没有单元引用且容量够就原地重写，否则新分配；
+        // 先整块拷完再让各单元引用，避免写入时触发 detach
+        const qsizetype size = static_cast<qsizetype>(total);
+        if (item->buffer.isDetached() && item->buffer.capacity() >= size)
+        {
+            // 引用计数降到 1 之前其他线程对缓冲的读取要先于这里的写入
+            std::atomic_thread_fence(std::memory_order_acquire);
+            item->buffer.resize(size);
+        }
+        else
+        {
+            item->buffer = QByteArray(size, Qt::Uninitialized);
+        }
+
+        char* out = item->buffer.data();
+        for (const auto& event : batch.video)
+        {
+            std::memcpy(out, event.unit.payload, event.unit.payloadSize);
+            out += event.unit.payloadSize;
+        }
+        for (const auto& event : batch.audio)
+        {
+            std::memcpy(out, event.info.payload, event.info.payloadSize);
+            out += event.info.payloadSize;
+        }
+
+        item->type = BridgeEvent::Type::Media;
+        item->bytes = total;
+        item->batch.units.reserve(static_cast<qsizetype>(batch.video.Size() + batch.audio.Size()));
+
+        int offset = 0;
+        for (const auto& event : batch.video)
+        {
+            EshareMediaUnit unit;
+            unit.type = EshareMediaType::Video;
+            unit.streamId = event.streamId;
+            unit.kind = static_cast<quint32>(event.unit.kind);
+            unit.timestamp = event.unit.timestamp32_32;
+            unit.presentationUs = event.unit.presentationUs;
+            unit.data = item->buffer;
+            unit.offset = offset;
+            unit.size = static_cast<int>(event.unit.payloadSize);
+            offset += unit.size;
+            item->batch.units.push_back(std::move(unit));
+        }
+        for (const auto& event : batch.audio)
+        {
+            EshareMediaUnit unit;
+            unit.type = EshareMediaType::Audio;
+            unit.streamId = event.streamId;
+            unit.kind = event.info.payloadType;
+            unit.timestamp = event.info.timestamp;
+            unit.sequence = event.info.sequence;
+            unit.presentationUs = event.info.presentationUs;
+            unit.data = item->buffer;
+            unit.offset = offset;
+            unit.size = static_cast<int>(event.info.payloadSize);
+            offset += unit.size;
+            item->batch.units.push_back(std::move(unit));
+        }
+
+        m_queuedBytes.fetch_add(total, std::memory_order_relaxed);
+        m_queue.Push(item);
+    }
+
+    void OnSessionQuota(const hhcast::ESSessionQuotaEvent& event) override
+    {
+        BridgeEvent* item = AcquireControlEvent();
+        item->type = BridgeEvent::Type::Quota;
+        item->streamId = event.streamId;
+        item->cause = static_cast<int>(event.stats.level);
+        item->action = static_cast<int>(event.action);
+        m_queue.Push(item);
+    }
+
+    void OnHandedOff() override
+    {
+        BridgeEvent* item = AcquireControlEvent();
+        item->type = BridgeEvent::Type::HandedOff;
+        m_queue.Push(item);
+    }
+
+    // 只在 bridge 所在线程调用
+    BridgeEvent* Pop()
+    {
+        BridgeEvent* event = static_cast<BridgeEvent*>(m_queue.Pop());
+        if (event && event->type == BridgeEvent::Type::Media)
+            m_queuedBytes.fetch_sub(event->bytes, std::memory_order_relaxed);
+        return event;
+    }
+
+    // 只在 bridge 所在线程调用，event 交出后不能再用
+    void Recycle(BridgeEvent* event)
+    {
+        if (!m_pool.Owns(event))
+        {
+            delete event;
+            return;
+        }
+
+        // 单元里的引用释放后缓冲才可能被下次原地复用
+        event->batch.units.clear();
+        event->name.clear();
+        event->peerIp.clear();
+        if (event->buffer.capacity() > kMaxRetainedBufferBytes)
+            event->buffer = QByteArray();
+        m_pool.Release(event);
+    }
+
+    quint64 GetDroppedBatches() const
+    {
+        return m_droppedBatches.load(std::memory_order_relaxed);
+    }
+
+private:
+    // 会话事件不能丢，槽位用完时退回堆分配
+    BridgeEvent* AcquireControlEvent()
+    {
+        BridgeEvent* item = m_pool.Acquire();
+        return item ? item : new BridgeEvent;
+    }
+
+private:
+    EshareMpscQueue m_queue;
+    const qint64 m_maxQueuedBytes;
+    EshareSlotPool<BridgeEvent> m_pool;
+    std::atomic<qint64> m_queuedBytes{ 0 };
+    std::atomic<quint64> m_droppedBatches{ 0 };
+};
+
+EshareServerBridge::EshareServerBridge(QObject* parent)
+    : QObject(parent)
+{
+    qRegisterMetaType<WQt::Cast::Eshare::EshareMediaBatch>();
+
+    m_drainTimer = new QTimer(this);
+    m_drainTimer->setTimerType(Qt::PreciseTimer);
+
+    connect(m_drainTimer, &QTimer::timeout,
+            this, &EshareServerBridge::OnDrainTimer);
+}
+
+EshareServerBridge::~EshareServerBridge()
+{
+    Stop();
+}
+
+void EshareServerBridge::SetConfig(const hhcast::ESServerConfig& config)
+{
+    m_config = config;
+}
+
+void EshareServerBridge::SetDrainIntervalMs(int intervalMs)
+{
+    m_drainIntervalMs = (intervalMs > 0) ? intervalMs : 16;
+}
+
+void EshareServerBridge::SetMaxUnitsPerDrain(int units)
+{
+    m_maxUnitsPerDrain = (units > 0) ? units : 4096;
+}
+
+void EshareServerBridge::SetEventPoolSize(int slotCount)
+{
+    m_eventPoolSize = (slotCount > 0) ? slotCount : 256;
+}
+
+void EshareServerBridge::SetMaxQueuedBytes(qint64 bytes)
+{
+    m_maxQueuedBytes = bytes;
+}
+
+bool EshareServerBridge::Start()
+{
+    if (m_running)
+    {
+        emit SigLog(QStringLiteral("[ESBridge] Start ignored: already running"));
+        return true;
+    }
+
+    m_server = std::make_unique<hhcast::ESServer>();
+    m_sink = std::make_shared<Sink>(m_maxQueuedBytes, m_eventPoolSize);
+
+    m_server->SetConfig(m_config);
+    m_server->SetCallbackV2(m_sink);
+
+    const int ret = m_server->StartServer();
+    if (ret != 0)
+    {
+        emit SigError(QStringLiteral("[ESBridge] start server failed, ret=%1").arg(ret));
+        m_server.reset();
+        m_sink.reset();
+        return false;
+    }
+
+    m_drainTimer->start(m_drainIntervalMs);
+    m_running = true;
+
+    emit SigLog(QStringLiteral("[ESBridge] started, drain every %1 ms").arg(m_drainIntervalMs));
+    emit SigStarted();
+    return true;
+}
+
+void EshareServerBridge::Stop()
+{
+    if (!m_running)
+        return;
+
+    m_drainTimer->stop();
+    m_server->StopServer();
+
+    // 停服时关闭会话的事件也交出去，不受单次上限约束
+    Drain(0);
+
+    const quint64 dropped = m_sink->GetDroppedBatches();
+    m_server.reset();
+    m_sink.reset();
+    m_running = false;
+
+    emit SigLog(QStringLiteral("[ESBridge] stopped, dropped media batches=%1").arg(dropped));
+    emit SigStopped();
+}
+
+bool EshareServerBridge::IsRunning() const
+{
+    return m_running;
+}
+
+quint64 EshareServerBridge::GetDroppedMediaBatches() const
+{
+    return m_sink ? m_sink->GetDroppedBatches() : 0;
+}
+
+hhcast::ESServer* EshareServerBridge::GetServer() const
+{
+    return m_server.get();
+}
+
+void EshareServerBridge::OnDrainTimer()
+{
+    Drain(m_maxUnitsPerDrain);
+}
+
+void EshareServerBridge::Drain(int maxUnits)
+{
+    if (!m_sink)
+        return;
+
+    // 每个媒体单元、每个会话事件各算一份；达到上限后剩下的留给下一次定时器，不卡住 GUI 线程
+    int processed = 0;
+
+    // 相邻的媒体合成一批；遇到会话事件先把之前的媒体发出去，保持先后顺序
+    EshareMediaBatch pending;
+
+    auto flushMedia = [this, &pending]()
+    {
+        if (pending.units.isEmpty())
+            return;
+
+        emit SigMediaBatch(pending);
+        pending.units.clear();
+    };
+
+    while (maxUnits <= 0 || processed < maxUnits)
+    {
+        BridgeEvent* event = m_sink->Pop();
+        if (event == nullptr)
+            break;
+
+        switch (event->type)
+        {
+        case BridgeEvent::Type::Media:
+            // 拷的是单元（缓冲只加引用），槽位里的单元数组清空后容量留给下次
+            pending.units.append(event->batch.units);
+            processed += static_cast<int>(event->batch.units.size());
+            break;
+
+        case BridgeEvent::Type::SessionOpen:
+            flushMedia();
+            emit SigSessionOpened(event->streamId, event->name, event->peerIp, event->flag);
+            break;
+
+        case BridgeEvent::Type::SessionClose:
+            flushMedia();
+            emit SigSessionClosed(event->streamId, event->cause, event->flag);
+            break;
+
+        case BridgeEvent::Type::Quota:
+            flushMedia();
+            emit SigSessionQuota(event->streamId, event->cause, event->action);
+            break;
+
+        case BridgeEvent::Type::HandedOff:
+            flushMedia();
+            emit SigHandedOff();
+            break;
+        }
+
+        if (event->type != BridgeEvent::Type::Media)
+            ++processed;
+        m_sink->Recycle(event);
+    }
+
+    flushMedia();
+}
+
+} // namespace WQt::Cast::Eshare
\ No newline at end of file
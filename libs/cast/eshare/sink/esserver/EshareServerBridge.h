@@ -0,0 +1,122 @@
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QMetaType>
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+#include <memory>
+
+#include "ESServerConfig.h"
+
+class QTimer;
+
+namespace hhcast
+{
+class ESServer;
+}
+
+namespace WQt::Cast::Eshare
+{
+
+enum class EshareMediaType : quint8
+{
+    Video,
+    Audio,
+};
+
+// 一批媒体共用一块 data（引用计数），单元只记偏移；可以留用或转给其他线程
+struct EshareMediaUnit
+{
+    EshareMediaType type = EshareMediaType::Video;
+    quint32 streamId = 0;
+    quint32 kind = 0;              // 视频为 ESVideoUnitKind，音频为 RTP payload type
+    quint64 timestamp = 0;         // 视频为 timestamp32_32，音频为 RTP 时间戳
+    quint16 sequence = 0;          // 音频 RTP 序号
+    quint64 presentationUs = 0;    // 播放 deadline（steady_clock 微秒），0 表示未知
+
+    QByteArray data;
+    int offset = 0;
+    int size = 0;
+
+    QByteArrayView Payload() const
+    {
+        return QByteArrayView(data.constData() + offset, size);
+    }
+};
+
+struct EshareMediaBatch
+{
+    QVector<EshareMediaUnit> units;    // 按到达顺序，可能含多个会话
+};
+
+// ESServer 的 Qt 适配：收包、拆包都在 ESServer 自己的 hv 线程上，
+// 事件放进预分配的槽位、经无锁队列交给本对象所在线程，按帧间隔定时取出，每次取出的单元数有上限。
+// 会话事件与媒体保持先后顺序
+class EshareServerBridge : public QObject
+{
+    Q_OBJECT
+public:
+    explicit EshareServerBridge(QObject* parent = nullptr);
+    ~EshareServerBridge() override;
+
+    // 以下需在 Start 之前设置
+    void SetConfig(const hhcast::ESServerConfig& config);
+    void SetDrainIntervalMs(int intervalMs);
+    // 一次定时取出的媒体单元与会话事件总数上限，超出的留到下一次；按整批判断，最多多出一批
+    void SetMaxUnitsPerDrain(int units);
+    // 事件槽位数，hv 线程上不再逐事件分配；槽位用完时丢新的媒体批次，会话事件退回堆分配
+    void SetEventPoolSize(int slotCount);
+    // 积压的媒体超过该字节数时丢弃新到的批次，会话事件不丢
+    void SetMaxQueuedBytes(qint64 bytes);
+
+    bool Start();
+    void Stop();
+    bool IsRunning() const;
+
+    quint64 GetDroppedMediaBatches() const;
+
+    // 查询统计等，Start 之后有效
+    hhcast::ESServer* GetServer() const;
+
+signals:
+    void SigLog(const QString& text);
+    void SigStarted();
+    void SigStopped();
+    void SigError(const QString& text);
+
+    void SigSessionOpened(quint32 streamId, const QString& name, const QString& peerIp, bool restored);
+    // cause 为 hhcast::ESSessionCloseCause
+    void SigSessionClosed(quint32 streamId, int cause, bool disconnected);
+    void SigMediaBatch(const WQt::Cast::Eshare::EshareMediaBatch& batch);
+    // level 为 hhcast::ESQuotaLevel，action 为 hhcast::ESQuotaAction
+    void SigSessionQuota(quint32 streamId, int level, int action);
+    void SigHandedOff();
+
+private slots:
+    void OnDrainTimer();
+
+private:
+    class Sink;
+
+    // maxUnits <= 0 表示取空
+    void Drain(int maxUnits);
+
+private:
+    hhcast::ESServerConfig m_config;
+    std::unique_ptr<hhcast::ESServer> m_server;
+    std::shared_ptr<Sink> m_sink;
+
+    QTimer* m_drainTimer = nullptr;
+    int m_drainIntervalMs = 16;
+    int m_maxUnitsPerDrain = 4096;
+    int m_eventPoolSize = 256;
+    qint64 m_maxQueuedBytes = 64 * 1024 * 1024;
+    bool m_running = false;
+};
+
+} // namespace WQt::Cast::Eshare
+
+Q_DECLARE_METATYPE(WQt::Cast::Eshare::EshareMediaBatch)
\ No newline at end of file
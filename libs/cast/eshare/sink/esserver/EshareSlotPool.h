@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace WQt::Cast::Eshare
+{
+
+// 定长对象池：构造时一次分配 capacity 个 T，之后 Acquire/Release 不再分配内存。
+// 任意线程 Acquire，任意线程 Release；空闲槽位串成栈，栈顶带版本号防 ABA。
+// 对象归还时不析构，下次取出沿用上次的内容和容量，由调用方自行重置
+template <typename T>
+class EshareSlotPool
+{
+public:
+    explicit EshareSlotPool(size_t capacity)
+        : m_capacity(static_cast<uint32_t>(capacity))
+        , m_items(new T[capacity])
+        , m_next(new std::atomic<uint32_t>[capacity])
+    {
+        // 链成 0 -> 1 -> ... -> capacity-1，下标存为 index + 1，0 表示栈底
+        for (uint32_t i = 0; i < m_capacity; ++i)
+            m_next[i].store(i + 1 < m_capacity ? i + 2 : 0, std::memory_order_relaxed);
+        m_head.store(m_capacity > 0 ? 1 : 0, std::memory_order_release);
+    }
+
+    EshareSlotPool(const EshareSlotPool&) = delete;
+    EshareSlotPool& operator=(const EshareSlotPool&) = delete;
+
+    // 池空返回 nullptr
+    T* Acquire()
+    {
+        uint64_t head = m_head.load(std::memory_order_acquire);
+        for (;;)
+        {
+            const uint32_t top = static_cast<uint32_t>(head);
+            if (top == 0)
+                return nullptr;
+
+            const uint32_t next = m_next[top - 1].load(std::memory_order_relaxed);
+            if (m_head.compare_exchange_weak(head, NextHead(head, next),
+                                             std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                return &m_items[top - 1];
+            }
+        }
+    }
+
+    void Release(T* item)
+    {
+        const uint32_t index = static_cast<uint32_t>(item - m_items.get());
+        uint64_t head = m_head.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            m_next[index].store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+            if (m_head.compare_exchange_weak(head, NextHead(head, index + 1),
+                                             std::memory_order_release, std::memory_order_relaxed))
+            {
+                return;
+            }
+        }
+    }
+
+    bool Owns(const T* item) const
+    {
+        return item >= m_items.get() && item < m_items.get() + m_capacity;
+    }
+
+    size_t Capacity() const
+    {
+        return m_capacity;
+    }
+
+private:
+    // 高 32 位是版本号，每次改栈顶加一
+    static uint64_t NextHead(uint64_t head, uint32_t top)
+    {
+        return (((head >> 32) + 1) << 32) | top;
+    }
+
+private:
+    const uint32_t m_capacity;
+    std::unique_ptr<T[]> m_items;
+    std::unique_ptr<std::atomic<uint32_t>[]> m_next;
+    std::atomic<uint64_t> m_head{ 0 };
+};
+
+} // namespace WQt::Cast::Eshare
\ No newline at end of file
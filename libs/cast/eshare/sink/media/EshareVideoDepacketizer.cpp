@@ -1,77 +1,209 @@
 #include "EshareVideoDepacketizer.h"
 
+#include <cstring>
+
 namespace WQt::Cast::Eshare
 {
 
+namespace
+{
+
+constexpr qsizetype kHeaderLen = 128;
+constexpr qsizetype kBlockSize = 256 * 1024;
+// 按单元头预留空间的上限，防止错误的 payloadLen 一次申请过大
+constexpr qsizetype kMaxReserve = 16 * 1024 * 1024;
+constexpr int kMaxPooledBlocks = 4;
+
+} // namespace
+
 EshareVideoDepacketizer::EshareVideoDepacketizer(QObject* parent)
     : QObject(parent)
 {
 }
 
+void EshareVideoDepacketizer::SetSink(IEshareVideoUnitSink* sink)
+{
+    m_sink = sink;
+}
+
 void EshareVideoDepacketizer::Reset()
 {
-    m_buffer.clear();
+    // 块和池留着复用，已交出的单元不受影响
+    m_readOffset = 0;
+    m_writeOffset = 0;
+    m_pendingUnitLen = 0;
+}
+
+EshareVideoDepacketizerStats EshareVideoDepacketizer::GetStats() const
+{
+    return m_stats;
 }
 
-quint32 EshareVideoDepacketizer::ReadLe32(const QByteArray& data, int offset)
+quint32 EshareVideoDepacketizer::ReadLe32(const char* data)
 {
-    return  (static_cast<quint32>(static_cast<unsigned char>(data[offset + 0]))      ) |
-           (static_cast<quint32>(static_cast<unsigned char>(data[offset + 1])) <<  8) |
-           (static_cast<quint32>(static_cast<unsigned char>(data[offset + 2])) << 16) |
-           (static_cast<quint32>(static_cast<unsigned char>(data[offset + 3])) << 24);
+    const auto* p = reinterpret_cast<const unsigned char*>(data);
+    return  (static_cast<quint32>(p[0])      ) |
+           (static_cast<quint32>(p[1]) <<  8) |
+           (static_cast<quint32>(p[2]) << 16) |
+           (static_cast<quint32>(p[3]) << 24);
 }
 
-quint64 EshareVideoDepacketizer::ReadLe64(const QByteArray& data, int offset)
+quint64 EshareVideoDepacketizer::ReadLe64(const char* data)
 {
+    const auto* p = reinterpret_cast<const unsigned char*>(data);
     quint64 v = 0;
     for (int i = 0; i < 8; ++i)
     {
-        v |= (static_cast<quint64>(static_cast<unsigned char>(data[offset + i])) << (8 * i));
+        v |= (static_cast<quint64>(p[i]) << (8 * i));
     }
     return v;
 }
 
+QByteArray EshareVideoDepacketizer::TakeBlock(qsizetype minSize)
+{
+    // 只有没有单元再引用的块才能复用
+    for (int i = 0; i < m_pool.size(); ++i)
+    {
+        const QByteArray& candidate = m_pool.at(i);
+        if (candidate.isDetached() && candidate.size() >= minSize)
+        {
+            QByteArray block = std::move(m_pool[i]);
+            m_pool.removeAt(i);
+            return block;
+        }
+    }
+
+    ++m_stats.blocksAllocated;
+    return QByteArray(qMax(kBlockSize, minSize), Qt::Uninitialized);
+}
+
+void EshareVideoDepacketizer::RecycleBlock(QByteArray&& block)
+{
+    if (block.isNull())
+        return;
+
+    // 池满时丢最旧的，还被单元引用的会在单元释放时自然回收
+    if (m_pool.size() >= kMaxPooledBlocks)
+        m_pool.removeFirst();
+
+    m_pool.append(std::move(block));
+}
+
+void EshareVideoDepacketizer::Reserve(qsizetype extra)
+{
+    const bool owned = m_block.isDetached();
+    if (owned && m_block.size() - m_writeOffset >= extra)
+        return;
+
+    const qsizetype pending = m_writeOffset - m_readOffset;
+
+    // 块没被单元引用且空间够：只把未解析的尾部搬到开头
+    if (owned && m_block.size() - pending >= extra)
+    {
+        if (pending > 0)
+            std::memmove(m_block.data(), m_block.constData() + m_readOffset, static_cast<size_t>(pending));
+
+        m_readOffset = 0;
+        m_writeOffset = pending;
+        m_stats.copiedBytes += static_cast<quint64>(pending);
+        ++m_stats.compactions;
+        return;
+    }
+
+    // 块还被交出的单元引用（写入会触发整块 detach）或容量不足：换块
+    QByteArray next = TakeBlock(pending + extra);
+    if (pending > 0)
+        std::memcpy(next.data(), m_block.constData() + m_readOffset, static_cast<size_t>(pending));
+
+    RecycleBlock(std::move(m_block));
+    m_block = std::move(next);
+    m_readOffset = 0;
+    m_writeOffset = pending;
+    m_stats.copiedBytes += static_cast<quint64>(pending);
+    ++m_stats.blockSwitches;
+}
+
+void EshareVideoDepacketizer::Deliver(const EshareVideoUnit& unit)
+{
+    if (m_sink)
+    {
+        m_sink->OnVideoUnit(unit);
+        return;
+    }
+
+    emit SigLog(QStringLiteral("[VDEP] unit ready: kind=0x%1 payload=%2 ts=0x%3")
+                .arg(QString::number(static_cast<quint32>(unit.kind), 16))
+                .arg(unit.payloadLen)
+                .arg(QString::number(unit.timestamp32_32, 16)));
+
+    emit SigUnitReady(unit);
+}
+
 void EshareVideoDepacketizer::PushBytes(const QByteArray& data)
 {
     if (data.isEmpty())
         return;
 
-    m_buffer += data;
+    const qsizetype size = data.size();
+    m_stats.inputBytes += static_cast<quint64>(size);
+
+    // 已知正在收的单元有多长时一次留够，避免大帧分多次换块
+    qsizetype extra = size;
+    if (m_pendingUnitLen > 0)
+    {
+        const qsizetype pending = m_writeOffset - m_readOffset;
+        extra = qMax(extra, qMin(m_pendingUnitLen, kMaxReserve) - pending);
+    }
+
+    Reserve(extra);
+    std::memcpy(m_block.data() + m_writeOffset, data.constData(), static_cast<size_t>(size));
+    m_writeOffset += size;
+    m_stats.copiedBytes += static_cast<quint64>(size);
 
     while (true)
     {
-        if (m_buffer.size() < 128)
-            return;
+        const qsizetype pending = m_writeOffset - m_readOffset;
+        if (pending < kHeaderLen)
+            break;
 
-        const quint32 payloadLen = ReadLe32(m_buffer, 0x00);
-        const quint32 kindRaw = ReadLe32(m_buffer, 0x04);
-        const quint64 ts = ReadLe64(m_buffer, 0x08);
+        const char* header = m_block.constData() + m_readOffset;
+        const quint32 payloadLen = ReadLe32(header + 0x00);
+        const quint32 kindRaw = ReadLe32(header + 0x04);
+        const quint64 ts = ReadLe64(header + 0x08);
 
-        const qint64 totalLen = 128ll + static_cast<qint64>(payloadLen);
-        if (totalLen < 128)
+        const qint64 totalLen = kHeaderLen + static_cast<qint64>(payloadLen);
+        if (totalLen < kHeaderLen)
         {
             emit SigError(QStringLiteral("[VDEP] invalid totalLen"));
-            m_buffer.clear();
+            Reset();
             return;
         }
 
-        if (m_buffer.size() < totalLen)
-            return;
+        if (pending < totalLen)
+        {
+            m_pendingUnitLen = static_cast<qsizetype>(totalLen);
+            break;
+        }
 
         EshareVideoUnit unit;
         unit.payloadLen = payloadLen;
         unit.kind = static_cast<EshareVideoUnitKind>(kindRaw);
         unit.timestamp32_32 = ts;
-        unit.payload = m_buffer.mid(128, payloadLen);
+        unit.block = m_block;
+        unit.offset = static_cast<int>(m_readOffset + kHeaderLen);
 
-        emit SigLog(QStringLiteral("[VDEP] unit ready: kind=0x%1 payload=%2 ts=0x%3")
-                    .arg(QString::number(kindRaw, 16))
-                    .arg(payloadLen)
-                    .arg(QString::number(ts, 16)));
+        m_readOffset += static_cast<qsizetype>(totalLen);
+        m_pendingUnitLen = 0;
+        ++m_stats.units;
 
-        emit SigUnitReady(unit);
+        Deliver(unit);
+    }
 
-        m_buffer.remove(0, static_cast<int>(totalLen));
+    // 全部解析完且没人留用时从头写，免去下次搬移
+    if (m_readOffset == m_writeOffset && m_block.isDetached())
+    {
+        m_readOffset = 0;
+        m_writeOffset = 0;
     }
 }
 
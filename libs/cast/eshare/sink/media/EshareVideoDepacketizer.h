@@ -2,6 +2,8 @@
 
 #include <QObject>
 #include <QByteArray>
+#include <QByteArrayView>
+#include <QVector>
 
 namespace WQt::Cast::Eshare
 {
@@ -12,12 +14,40 @@ enum class EshareVideoUnitKind : quint32
     Frame  = 0x00000101,
 };
 
+// payload 不单独拷贝：block 是拆包器的缓冲块（引用计数），单元只记偏移。
+// 留用 unit 即留用整块，拆包器会换新块继续写，不会改到已交出的数据
 struct EshareVideoUnit
 {
     quint32 payloadLen = 0;
     EshareVideoUnitKind kind = EshareVideoUnitKind::Frame;
     quint64 timestamp32_32 = 0;
-    QByteArray payload;
+
+    QByteArray block;
+    int offset = 0;
+
+    QByteArrayView Payload() const
+    {
+        return QByteArrayView(block.constData() + offset, static_cast<qsizetype>(payloadLen));
+    }
+};
+
+// 直连接收端：在 PushBytes 的调用线程上同步回调，不经过信号
+class IEshareVideoUnitSink
+{
+public:
+    virtual ~IEshareVideoUnitSink() = default;
+
+    virtual void OnVideoUnit(const EshareVideoUnit& unit) = 0;
+};
+
+struct EshareVideoDepacketizerStats
+{
+    quint64 units = 0;
+    quint64 inputBytes = 0;
+    quint64 copiedBytes = 0;        // 输入写入缓冲块 + 搬移未解析尾部的字节数
+    quint64 compactions = 0;        // 原地搬移次数
+    quint64 blockSwitches = 0;      // 因块被单元占用或容量不足换块的次数
+    quint64 blocksAllocated = 0;
 };
 
 class EshareVideoDepacketizer : public QObject
@@ -26,20 +56,41 @@ class EshareVideoDepacketizer : public QObject
 public:
     explicit EshareVideoDepacketizer(QObject* parent = nullptr);
 
+    // 设置后单元直接交给 sink，不再发 SigUnitReady 和逐单元的 SigLog；传 nullptr 恢复信号
+    void SetSink(IEshareVideoUnitSink* sink);
+
     void PushBytes(const QByteArray& data);
     void Reset();
 
+    EshareVideoDepacketizerStats GetStats() const;
+
 signals:
     void SigLog(const QString& text);
     void SigUnitReady(const WQt::Cast::Eshare::EshareVideoUnit& unit);
     void SigError(const QString& text);
 
 private:
-    static quint32 ReadLe32(const QByteArray& data, int offset);
-    static quint64 ReadLe64(const QByteArray& data, int offset);
+    static quint32 ReadLe32(const char* data);
+    static quint64 ReadLe64(const char* data);
+
+    // 保证当前块可独占写入且尾部至少还有 extra 字节
+    void Reserve(qsizetype extra);
+    QByteArray TakeBlock(qsizetype minSize);
+    void RecycleBlock(QByteArray&& block);
+
+    void Deliver(const EshareVideoUnit& unit);
 
 private:
-    QByteArray m_buffer;
+    QByteArray m_block;
+    qsizetype m_readOffset = 0;
+    qsizetype m_writeOffset = 0;
+    qsizetype m_pendingUnitLen = 0;     // 已读到头、还没收全的单元总长
+
+    // 换下来的块，等交出的单元都释放后复用
+    QVector<QByteArray> m_pool;
+
+    IEshareVideoUnitSink* m_sink = nullptr;
+    EshareVideoDepacketizerStats m_stats;
 };
 
 } // namespace WQt::Cast::Eshare
\ No newline at end of file
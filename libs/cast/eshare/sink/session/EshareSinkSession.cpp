@@ -83,18 +83,7 @@ EshareSinkSession::EshareSinkSession(QObject* parent)
     connect(m_videoDepacketizer, &EshareVideoDepacketizer::SigLog,
             this, &EshareSinkSession::SigLog);
 
-    connect(m_videoDepacketizer, &EshareVideoDepacketizer::SigUnitReady,
-            this, [this](const EshareVideoUnit& unit) {
-                if (!m_h264DumpFile.isOpen())
-                    return;
-
-                if (unit.kind == EshareVideoUnitKind::Config ||
-                    unit.kind == EshareVideoUnitKind::Frame)
-                {
-                    m_h264DumpFile.write(unit.payload);
-                    m_h264DumpFile.flush();
-                }
-            });
+    m_videoDepacketizer->SetSink(this);
 
     connect(m_52020Stub, &EsharePassivePortListener::SigLog,
             this, &EshareSinkSession::SigLog);
@@ -272,10 +261,32 @@ void EshareSinkSession::Stop()
         m_h264DumpFile.close();
     }
 
+    const EshareVideoDepacketizerStats stats = m_videoDepacketizer->GetStats();
+    emit SigLog(QStringLiteral("[SINK] video units=%1 input=%2 copied=%3 bytes, compactions=%4 blockSwitches=%5")
+                    .arg(stats.units)
+                    .arg(stats.inputBytes)
+                    .arg(stats.copiedBytes)
+                    .arg(stats.compactions)
+                    .arg(stats.blockSwitches));
+
     m_running = false;
 
     emit SigLog(QStringLiteral("[SINK] session stopped."));
     emit SigStopped();
 }
 
+void EshareSinkSession::OnVideoUnit(const EshareVideoUnit& unit)
+{
+    if (!m_h264DumpFile.isOpen())
+        return;
+
+    if (unit.kind == EshareVideoUnitKind::Config ||
+        unit.kind == EshareVideoUnitKind::Frame)
+    {
+        const QByteArrayView payload = unit.Payload();
+        m_h264DumpFile.write(payload.data(), payload.size());
+        m_h264DumpFile.flush();
+    }
+}
+
 } // namespace WQt::Cast::Eshare
\ No newline at end of file
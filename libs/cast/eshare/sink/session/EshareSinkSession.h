@@ -4,6 +4,8 @@
 #include <QString>
 #include <QFile>
 
+#include "EshareVideoDepacketizer.h"
+
 namespace WQt::Cast::Eshare
 {
 
@@ -13,10 +15,9 @@ class Eshare57395HeartbeatServer;
 class Eshare8600CameraServer;
 class Eshare51040RtspServer;
 class EshareVideoReceiver;
-class EshareVideoDepacketizer;
 class EsharePassivePortListener;
 
-class EshareSinkSession : public QObject
+class EshareSinkSession : public QObject, private IEshareVideoUnitSink
 {
     Q_OBJECT
 public:
@@ -31,6 +32,10 @@ signals:
     void SigStopped();
     void SigError(const QString& text);
 
+private:
+    // 视频单元由拆包器直接回调，不走逐帧信号
+    void OnVideoUnit(const EshareVideoUnit& unit) override;
+
 private:
     QString m_localIp;
     bool m_running = false;
@@ -3,9 +3,22 @@
 
 #include <QJsonDocument>
 
+#include <chrono>
+
 namespace WQt::Cast::Eshare
 {
 
+namespace
+{
+
+qint64 NowSteadyUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
 Eshare57395HeartbeatClient::Eshare57395HeartbeatClient(QObject* parent)
     : QObject(parent)
 {
@@ -58,9 +71,22 @@ void Eshare57395HeartbeatClient::Stop()
     }
 }
 
+void Eshare57395HeartbeatClient::SetClockSyncEnabled(bool enabled)
+{
+    m_clockSyncEnabled = enabled;
+}
+
+hhcast::ESClockSyncStats Eshare57395HeartbeatClient::GetClockSyncStats() const
+{
+    return m_clockSync.GetStats();
+}
+
 void Eshare57395HeartbeatClient::ResetState()
 {
     m_recvBuffer.clear();
+    m_clockSync.Reset();
+    m_lastPeerSendUs = 0;
+    m_lastPeerRecvUs = 0;
     m_nextHeartbeat = 1;
     m_clientInfoAcked = false;
     m_stopping = false;
@@ -98,6 +124,16 @@ void Eshare57395HeartbeatClient::SendHeartbeat()
     QJsonObject obj;
     obj.insert("heartbeat", m_nextHeartbeat);
 
+    if (m_clockSyncEnabled)
+    {
+        if (m_lastPeerSendUs != 0)
+        {
+            obj.insert("echoUs", m_lastPeerSendUs);
+            obj.insert("echoRecvUs", m_lastPeerRecvUs);
+        }
+        obj.insert("sendUs", NowSteadyUs());
+    }
+
     const QByteArray payload = JsonLineCodec::Encode(obj);
 
     emit SigLog(QString("[57395] >>> SEND heartbeat=%1 (%2 bytes)\n%3")
@@ -118,11 +154,12 @@ void Eshare57395HeartbeatClient::OnHeartbeatTimeout()
 
 void Eshare57395HeartbeatClient::OnReadyRead()
 {
+    const qint64 recvUs = NowSteadyUs();
     m_recvBuffer += m_socket->readAll();
-    TryParseIncoming();
+    TryParseIncoming(recvUs);
 }
 
-void Eshare57395HeartbeatClient::TryParseIncoming()
+void Eshare57395HeartbeatClient::TryParseIncoming(qint64 recvUs)
 {
     while (true)
     {
@@ -152,6 +189,7 @@ void Eshare57395HeartbeatClient::TryParseIncoming()
         else
         {
             state.success = true;
+            UpdateClockSync(obj, recvUs, state);
             emit SigHeartbeatState(state);
         }
     }
@@ -191,6 +229,34 @@ Eshare57395State Eshare57395HeartbeatClient::BuildStateFromJson(const QByteArray
     return state;
 }
 
+void Eshare57395HeartbeatClient::UpdateClockSync(const QJsonObject& obj,
+                                                 qint64 recvUs,
+                                                 Eshare57395State& state)
+{
+    if (!m_clockSyncEnabled || !obj.contains("sendUs"))
+        return;
+
+    hhcast::ESHeartbeatTiming peer;
+    peer.sendUs = obj.value("sendUs").toInteger();
+    peer.echoUs = obj.value("echoUs").toInteger();
+    peer.echoRecvUs = obj.value("echoRecvUs").toInteger();
+
+    hhcast::ESClockExchange exchange;
+    if (hhcast::ESClockSync::MakeExchange(peer, recvUs, exchange))
+        m_clockSync.AddExchange(exchange);
+
+    m_lastPeerSendUs = peer.sendUs;
+    m_lastPeerRecvUs = recvUs;
+
+    const hhcast::ESClockSyncStats stats = m_clockSync.GetStats();
+    state.clockSyncValid = stats.valid;
+    if (stats.valid)
+    {
+        state.rttUs = stats.rttUs;
+        state.clockOffsetUs = stats.offsetUs;
+    }
+}
+
 void Eshare57395HeartbeatClient::FinishWithError(const QString& text)
 {
     Eshare57395State state;
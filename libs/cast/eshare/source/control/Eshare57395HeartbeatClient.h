@@ -5,6 +5,8 @@
 #include <QTimer>
 #include <QJsonObject>
 
+#include "ESClockSync.h"
+
 namespace WQt::Cast::Eshare
 {
 
@@ -35,6 +37,11 @@ struct Eshare57395State
     int multiScreen = -1;
     int isModerator = -1;
     int radioMode = -1;
+
+    // 开启计时扩展且接收端支持时有效，取窗口内最小 RTT 样本
+    bool clockSyncValid = false;
+    qint64 rttUs = -1;
+    qint64 clockOffsetUs = 0;   // 接收端时钟 - 本端时钟
 };
 
 class Eshare57395HeartbeatClient : public QObject
@@ -50,6 +57,10 @@ public:
 
     void Stop();
 
+    // 心跳附带 sendUs / echoUs / echoRecvUs，双方据此估计 RTT 和时钟偏差；接收端不认识时忽略
+    void SetClockSyncEnabled(bool enabled);
+    hhcast::ESClockSyncStats GetClockSyncStats() const;
+
 signals:
     void SigLog(const QString& text);
     void SigClientInfoAck(const WQt::Cast::Eshare::Eshare57395State& state);
@@ -68,7 +79,8 @@ private:
     void FinishWithError(const QString& text);
     void SendClientInfo();
     void SendHeartbeat();
-    void TryParseIncoming();
+    void TryParseIncoming(qint64 recvUs);
+    void UpdateClockSync(const QJsonObject& obj, qint64 recvUs, Eshare57395State& state);
     Eshare57395State BuildStateFromJson(const QByteArray& rawLine, const QJsonObject& obj) const;
 
 private:
@@ -85,6 +97,11 @@ private:
     int m_nextHeartbeat = 1;
     bool m_clientInfoAcked = false;
     bool m_stopping = false;
+
+    bool m_clockSyncEnabled = false;
+    hhcast::ESClockSync m_clockSync;
+    qint64 m_lastPeerSendUs = 0;   // 最近一条应答的 sendUs 及其收到时间，下一次心跳回带
+    qint64 m_lastPeerRecvUs = 0;
 };
 
 } // namespace WQt::Cast::Eshare
\ No newline at end of file
@@ -8,6 +8,7 @@ EshareSessionClient::EshareSessionClient(QObject* parent)
 {
     m_probe8700 = new Eshare8700ProbeClient(this);
     m_heartbeat57395 = new Eshare57395HeartbeatClient(this);
+    m_heartbeat57395->SetClockSyncEnabled(true);
     m_cmd8121 = new Eshare8121CommandClient(this);
     m_camera8600 = new Eshare8600CameraClient(this);
     m_rtsp51040 = new Eshare51040RtspClient(this);
@@ -270,6 +271,13 @@ void EshareSessionClient::On57395HeartbeatState(const Eshare57395State& state)
             .arg(state.castState)
             .arg(state.mirrorMode)
             .arg(state.castMode));
+
+    if (state.clockSyncValid)
+    {
+        EmitLog(QString("[SESSION] 57395 rtt=%1us clockOffset=%2us")
+                .arg(state.rttUs)
+                .arg(state.clockOffsetUs));
+    }
 }
 
 void EshareSessionClient::On57395Stopped()
@@ -0,0 +1,203 @@
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "ESAudioDatagramParser.h"
+#include "ESAudioRtpParser.h"
+
+// 音频 datagram 切包微基准：构造多 RTP 拼接的 datagram，
+// 对比逐字节扫描的参考实现（原实现）和 ESAudioDatagramParser（预测 + SIMD 扫描），
+// 先校验两边切出的 payload 完全一致，再输出每个 datagram 的耗时。返回 0 表示结果一致
+
+namespace {
+
+using Datagram = std::vector<uint8_t>;
+
+constexpr uint8_t kPayloadType = 96;
+constexpr uint32_t kSsrc = 0x11223344;
+constexpr size_t kRtpHeaderSize = 12;
+constexpr int kRounds = 200;
+
+struct Scenario {
+    const char* name;
+    size_t packetsPerDatagram;
+    size_t minPayload;
+    size_t maxPayload;
+};
+
+struct SplitRecord {
+    uint16_t sequence = 0;
+    size_t offset = 0;
+    size_t payloadSize = 0;
+};
+
+static void WriteRtpHeader(uint8_t* p, uint16_t seq, uint32_t ts)
+{
+    p[0] = 0x80;
+    p[1] = kPayloadType;
+    p[2] = static_cast<uint8_t>(seq >> 8);
+    p[3] = static_cast<uint8_t>(seq);
+    p[4] = static_cast<uint8_t>(ts >> 24);
+    p[5] = static_cast<uint8_t>(ts >> 16);
+    p[6] = static_cast<uint8_t>(ts >> 8);
+    p[7] = static_cast<uint8_t>(ts);
+    p[8] = static_cast<uint8_t>(kSsrc >> 24);
+    p[9] = static_cast<uint8_t>(kSsrc >> 16);
+    p[10] = static_cast<uint8_t>(kSsrc >> 8);
+    p[11] = static_cast<uint8_t>(kSsrc);
+}
+
+static std::vector<Datagram> BuildDatagrams(const Scenario& scenario, size_t count)
+{
+    std::mt19937 rng(0x5eed);
+    std::uniform_int_distribution<size_t> payloadDist(scenario.minPayload, scenario.maxPayload);
+    std::uniform_int_distribution<int> byteDist(0, 255);
+
+    std::vector<Datagram> datagrams;
+    datagrams.reserve(count);
+    uint16_t seq = 1000;
+    uint32_t ts = 0;
+    for (size_t i = 0; i < count; ++i) {
+        Datagram datagram;
+        for (size_t k = 0; k < scenario.packetsPerDatagram; ++k) {
+            const size_t payloadSize = payloadDist(rng);
+            const size_t offset = datagram.size();
+            datagram.resize(offset + kRtpHeaderSize + payloadSize);
+            WriteRtpHeader(datagram.data() + offset, seq++, ts);
+            ts += 480;
+            for (size_t b = 0; b < payloadSize; ++b) {
+                datagram[offset + kRtpHeaderSize + b] = static_cast<uint8_t>(byteDist(rng));
+            }
+        }
+        datagrams.push_back(std::move(datagram));
+    }
+    return datagrams;
+}
+
+// 原实现：每个偏移都完整解析一次候选头
+static size_t ReferenceFindNext(const uint8_t* data, size_t size, size_t offset)
+{
+    const uint8_t* cur = data + offset;
+    const size_t scanBegin = offset + kRtpHeaderSize + static_cast<size_t>(cur[0] & 0x0F) * 4;
+    const uint16_t nextSeq = static_cast<uint16_t>(((cur[2] << 8) | cur[3]) + 1);
+    for (size_t pos = scanBegin; pos + kRtpHeaderSize <= size; ++pos) {
+        const uint8_t* p = data + pos;
+        const size_t minHeaderLen = kRtpHeaderSize + static_cast<size_t>(p[0] & 0x0F) * 4;
+        if (((p[0] >> 6) & 0x03) != 2 || size - pos < minHeaderLen) {
+            continue;
+        }
+        if ((p[1] & 0x7F) != (cur[1] & 0x7F) || std::memcmp(p + 8, cur + 8, 4) != 0) {
+            continue;
+        }
+        if (static_cast<uint16_t>((p[2] << 8) | p[3]) != nextSeq) {
+            continue;
+        }
+        return pos;
+    }
+    return size;
+}
+
+static void ReferenceParse(hhcast::ESAudioRtpParser& parser, const uint8_t* data, size_t size)
+{
+    size_t offset = 0;
+    while (offset + kRtpHeaderSize <= size) {
+        const size_t next = ReferenceFindNext(data, size, offset);
+        if (!parser.ParsePacket(data + offset, next - offset) || next == size) {
+            return;
+        }
+        offset = next;
+    }
+}
+
+template <typename ParseFn>
+static double MeasureNsPerDatagram(const std::vector<Datagram>& datagrams, ParseFn&& parse)
+{
+    const auto begin = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; ++round) {
+        for (const Datagram& datagram : datagrams) {
+            parse(datagram.data(), datagram.size());
+        }
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - begin;
+    const double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    return ns / static_cast<double>(datagrams.size() * kRounds);
+}
+
+static bool RunScenario(const Scenario& scenario)
+{
+    const std::vector<Datagram> datagrams = BuildDatagrams(scenario, 2000);
+
+    std::vector<SplitRecord> expected;
+    std::vector<SplitRecord> actual;
+    const uint8_t* base = nullptr;
+    auto recorder = [&base](std::vector<SplitRecord>& out) {
+        return [&base, &out](const hhcast::ESAudioPayloadInfo& info) {
+            out.push_back({ info.sequence, static_cast<size_t>(info.payload - base), info.payloadSize });
+        };
+    };
+
+    hhcast::ESAudioRtpParser reference;
+    reference.SetCallback(recorder(expected));
+    hhcast::ESAudioDatagramParser parser;
+    parser.SetCallback(recorder(actual));
+    for (const Datagram& datagram : datagrams) {
+        base = datagram.data();
+        ReferenceParse(reference, datagram.data(), datagram.size());
+        parser.ParseDatagram(datagram.data(), datagram.size());
+    }
+
+    bool same = expected.size() == actual.size() &&
+                expected.size() == datagrams.size() * scenario.packetsPerDatagram;
+    for (size_t i = 0; same && i < expected.size(); ++i) {
+        same = expected[i].sequence == actual[i].sequence &&
+               expected[i].offset == actual[i].offset &&
+               expected[i].payloadSize == actual[i].payloadSize;
+    }
+    if (!same) {
+        std::cout << "[AudioParserBench] FAIL " << scenario.name
+                  << " reference=" << expected.size() << " parser=" << actual.size() << std::endl;
+        return false;
+    }
+
+    hhcast::ESAudioRtpParser timedReference;
+    const double referenceNs = MeasureNsPerDatagram(datagrams, [&](const uint8_t* data, size_t size) {
+        ReferenceParse(timedReference, data, size);
+    });
+
+    hhcast::ESAudioDatagramParser timedParser;
+    const double parserNs = MeasureNsPerDatagram(datagrams, [&](const uint8_t* data, size_t size) {
+        timedParser.ParseDatagram(data, size);
+    });
+
+    std::cout << "[AudioParserBench] " << scenario.name
+              << " packets/datagram=" << scenario.packetsPerDatagram
+              << " reference=" << referenceNs << "ns"
+              << " parser=" << parserNs << "ns"
+              << " speedup=" << (parserNs > 0 ? referenceNs / parserNs : 0.0) << "x"
+              << " predicted=" << timedParser.GetPredictedSplitCount()
+              << "/" << timedParser.GetSplitPacketCount() << std::endl;
+    return true;
+}
+
+} // namespace
+
+int main()
+{
+    const Scenario scenarios[] = {
+        { "single", 1, 240, 240 },
+        { "fixed", 4, 240, 240 },
+        { "variable", 4, 120, 360 },
+        { "large", 8, 960, 1100 },
+    };
+
+    bool ok = true;
+    for (const Scenario& scenario : scenarios) {
+        ok &= RunScenario(scenario);
+    }
+
+    std::cout << "[AudioParserBench] " << (ok ? "all passed" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
\ No newline at end of file
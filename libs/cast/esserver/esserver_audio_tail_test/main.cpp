@@ -0,0 +1,212 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ESSession.h"
+#include "ESUtils.h"
+
+// 音频尾包自测：喂一段 RTP 后停止输入，检查抖动缓冲压着的最后几包能由 PollAudio 按时间放出、
+// 由 FlushAudio 在关闭前一次吐出，关闭后再进的包被丢弃；
+// 另起线程并发 Input / PollAudio，关闭时 Flush，配合 TSan 检查音频锁。返回 0 表示全部通过
+
+namespace {
+
+constexpr uint8_t kPayloadType = 96;
+constexpr uint32_t kSsrc = 0x11223344;
+constexpr size_t kRtpHeaderSize = 12;
+constexpr size_t kPayloadSize = 200;
+constexpr uint32_t kSamplesPerPacket = 480;
+constexpr uint64_t kPacketIntervalUs = 10000;
+
+static bool Check(bool condition, const char* name)
+{
+    std::cout << "[AudioTailTest] " << (condition ? "PASS " : "FAIL ") << name << std::endl;
+    return condition;
+}
+
+static std::vector<uint8_t> BuildDatagram(uint16_t seq)
+{
+    const uint32_t ts = static_cast<uint32_t>(seq) * kSamplesPerPacket;
+    std::vector<uint8_t> datagram(kRtpHeaderSize + kPayloadSize, static_cast<uint8_t>(seq));
+    uint8_t* p = datagram.data();
+    p[0] = 0x80;
+    p[1] = kPayloadType;
+    p[2] = static_cast<uint8_t>(seq >> 8);
+    p[3] = static_cast<uint8_t>(seq);
+    p[4] = static_cast<uint8_t>(ts >> 24);
+    p[5] = static_cast<uint8_t>(ts >> 16);
+    p[6] = static_cast<uint8_t>(ts >> 8);
+    p[7] = static_cast<uint8_t>(ts);
+    p[8] = static_cast<uint8_t>(kSsrc >> 24);
+    p[9] = static_cast<uint8_t>(kSsrc >> 16);
+    p[10] = static_cast<uint8_t>(kSsrc >> 8);
+    p[11] = static_cast<uint8_t>(kSsrc);
+    return datagram;
+}
+
+struct Collector {
+    std::mutex mutex;
+    std::vector<uint16_t> sequences;
+    uint32_t gapPackets = 0;
+
+    void Attach(hhcast::ESSession& session)
+    {
+        session.SetAudioCallback(
+            [this](uint32_t, const uint8_t*, size_t, const hhcast::ESAudioPayloadInfo& info) {
+                std::lock_guard<std::mutex> lock(mutex);
+                sequences.push_back(info.sequence);
+            });
+        session.SetAudioGapCallback(
+            [this](uint32_t, const hhcast::ESAudioGapInfo& gap) {
+                std::lock_guard<std::mutex> lock(mutex);
+                gapPackets += gap.count;
+            });
+    }
+
+    size_t Count()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return sequences.size();
+    }
+
+    bool InOrder(uint16_t first, size_t count, uint16_t skip)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        uint16_t expected = first;
+        size_t index = 0;
+        for (size_t i = 0; i < count; ++i, ++expected) {
+            if (expected == skip) {
+                continue;
+            }
+            if (index >= sequences.size() || sequences[index] != expected) {
+                return false;
+            }
+            ++index;
+        }
+        return index == sequences.size();
+    }
+};
+
+// 按 10ms 间隔喂 count 个包，返回最后一个包的到达时间
+static uint64_t Feed(hhcast::ESSession& session, uint16_t first, size_t count, uint64_t baseUs, uint16_t skip)
+{
+    uint64_t arrivalUs = baseUs;
+    for (size_t i = 0; i < count; ++i) {
+        const uint16_t seq = static_cast<uint16_t>(first + i);
+        arrivalUs = baseUs + i * kPacketIntervalUs;
+        if (seq == skip) {
+            continue;
+        }
+        const std::vector<uint8_t> datagram = BuildDatagram(seq);
+        session.InputAudioUdpDatagram(datagram.data(), datagram.size(), arrivalUs);
+    }
+    return arrivalUs;
+}
+
+static bool RunPollReleasesTail()
+{
+    hhcast::ESSession session(1);
+    session.SetAudioJitterConfig(hhcast::ESAudioJitterConfig{});
+    Collector collector;
+    collector.Attach(session);
+
+    const uint16_t first = 1000;
+    const size_t count = 30;
+    const uint16_t skip = 1020;
+    const uint64_t baseUs = hhcast::GetSteadyTimeUs();
+    const uint64_t lastUs = Feed(session, first, count, baseUs, skip);
+
+    // 输入停了，目标深度内的尾包还压在缓冲里
+    bool ok = Check(collector.Count() < count - 1, "tail held after input stops");
+
+    session.PollAudio(lastUs + 1000);
+    ok &= Check(collector.Count() < count - 1, "poll before hold time keeps tail");
+
+    session.PollAudio(lastUs + 1000000);
+    ok &= Check(collector.Count() == count - 1, "poll after hold time releases tail");
+    ok &= Check(collector.InOrder(first, count, skip), "tail delivered in sequence order");
+    ok &= Check(collector.gapPackets == 1, "missing packet reported as gap");
+    ok &= Check(session.GetAudioJitterStats().delivered == count - 1, "jitter stats count tail");
+    return ok;
+}
+
+static bool RunFlushOnClose()
+{
+    hhcast::ESSession session(2);
+    session.SetAudioJitterConfig(hhcast::ESAudioJitterConfig{});
+    Collector collector;
+    collector.Attach(session);
+
+    const uint16_t first = 500;
+    const size_t count = 12;
+    const uint64_t baseUs = hhcast::GetSteadyTimeUs();
+    Feed(session, first, count, baseUs, 0);
+
+    bool ok = Check(collector.Count() < count, "tail held before close");
+
+    session.MarkClosed();
+    session.FlushAudio();
+    ok &= Check(collector.Count() == count, "flush on close releases tail");
+    ok &= Check(collector.InOrder(first, count, 0), "flushed tail in sequence order");
+
+    const std::vector<uint8_t> late = BuildDatagram(static_cast<uint16_t>(first + count));
+    ok &= Check(!session.InputAudioUdpDatagram(late.data(), late.size(), baseUs + count * kPacketIntervalUs),
+                "input after close rejected");
+    session.FlushAudio();
+    ok &= Check(collector.Count() == count, "nothing delivered after close");
+    return ok;
+}
+
+// 输入线程和定时出包线程各跑各的，关闭后收到的包应与送进去的完全一致
+static bool RunConcurrentPoll()
+{
+    hhcast::ESSession session(3);
+    session.SetAudioJitterConfig(hhcast::ESAudioJitterConfig{});
+    Collector collector;
+    collector.Attach(session);
+
+    std::atomic<bool> running{ true };
+    std::thread poller([&]() {
+        while (running.load()) {
+            session.PollAudio(hhcast::GetSteadyTimeUs());
+            session.GetAudioJitterStats();
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    });
+
+    const uint16_t first = 0;
+    const size_t count = 2000;
+    for (size_t i = 0; i < count; ++i) {
+        const std::vector<uint8_t> datagram = BuildDatagram(static_cast<uint16_t>(first + i));
+        session.InputAudioUdpDatagram(datagram.data(), datagram.size());
+        if (i % 100 == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    session.MarkClosed();
+    session.FlushAudio();
+    running = false;
+    poller.join();
+
+    bool ok = Check(collector.Count() == count, "concurrent poll delivers every packet once");
+    ok &= Check(collector.InOrder(first, count, 0xffff), "concurrent poll keeps sequence order");
+    return ok;
+}
+
+} // namespace
+
+int main()
+{
+    bool ok = true;
+    ok &= RunPollReleasesTail();
+    ok &= RunFlushOnClose();
+    ok &= RunConcurrentPoll();
+
+    std::cout << "[AudioTailTest] " << (ok ? "all passed" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
\ No newline at end of file
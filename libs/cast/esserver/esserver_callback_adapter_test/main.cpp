@@ -0,0 +1,127 @@
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "IESServerCallbackV2.h"
+
+// 旧接口适配自测：各关闭原因经 ESServerCallbackAdapter 转成 IESServerCallback 的调用，
+// 检查只有对端断开和超时先回调 OnDisconnect，服务停止、交接、配额断开只回调 OnSessionClosed；
+// 交接按 ESServer 的顺序走一遍（OnHandedOff 之后各会话以 HandedOff 关闭）。返回 0 表示全部通过
+
+namespace {
+
+using hhcast::ESSessionCloseCause;
+
+static bool Check(bool condition, const std::string& name)
+{
+    std::cout << "[CallbackAdapterTest] " << (condition ? "PASS " : "FAIL ") << name << std::endl;
+    return condition;
+}
+
+// 按调用顺序记下旧接口收到的事件
+class RecordingCallback : public hhcast::IESServerCallback {
+public:
+    void OnConnect(uint32_t streamId, const std::string& name, const std::string& ip) override
+    {
+        calls.push_back("connect " + std::to_string(streamId) + " " + name + " " + ip);
+    }
+
+    void OnDisconnect(uint32_t streamId) override
+    {
+        calls.push_back("disconnect " + std::to_string(streamId));
+    }
+
+    void OnVideoData(uint32_t, const uint8_t*, size_t) override {}
+    void OnAudioData(uint32_t, const uint8_t*, size_t) override {}
+
+    void OnSessionClosed(uint32_t streamId, ESSessionCloseCause cause) override
+    {
+        calls.push_back("closed " + std::to_string(streamId) + " " +
+                        std::to_string(static_cast<int>(cause)));
+    }
+
+    void OnHandedOff() override
+    {
+        calls.push_back("handedoff");
+    }
+
+    std::vector<std::string> calls;
+};
+
+// 与 ESServer::CloseSession / ClearSessions 填事件的方式一致
+static hhcast::ESSessionCloseEvent MakeCloseEvent(uint32_t streamId, ESSessionCloseCause cause)
+{
+    hhcast::ESSessionCloseEvent event;
+    event.streamId = streamId;
+    event.cause = cause;
+    event.disconnected = hhcast::IsDisconnectCause(cause);
+    return event;
+}
+
+static bool RunCause(ESSessionCloseCause cause, const char* name, bool expectDisconnect)
+{
+    auto recorder = std::make_shared<RecordingCallback>();
+    hhcast::ESServerCallbackAdapter adapter(recorder);
+    adapter.OnSessionClose(MakeCloseEvent(7, cause));
+
+    const std::string closed = "closed 7 " + std::to_string(static_cast<int>(cause));
+    const std::vector<std::string> expected = expectDisconnect
+        ? std::vector<std::string>{ "disconnect 7", closed }
+        : std::vector<std::string>{ closed };
+    return Check(recorder->calls == expected,
+                 std::string(name) + (expectDisconnect ? " -> OnDisconnect + OnSessionClosed"
+                                                       : " -> OnSessionClosed only"));
+}
+
+static bool RunHandoff()
+{
+    auto recorder = std::make_shared<RecordingCallback>();
+    hhcast::ESServerCallbackAdapter adapter(recorder);
+
+    hhcast::ESSessionOpenEvent open;
+    open.streamId = 0x0a000001;
+    open.name = "sender";
+    open.peerIp = "10.0.0.1";
+    adapter.OnSessionOpen(open);
+
+    // 新进程确认接管后，57395 连接在本进程这边断开（CloseSession）和 StopServer（ClearSessions）
+    // 关掉的会话原因都记为 HandedOff
+    adapter.OnHandedOff();
+    adapter.OnSessionClose(MakeCloseEvent(open.streamId, ESSessionCloseCause::HandedOff));
+    adapter.OnSessionClose(MakeCloseEvent(0x0a000002, ESSessionCloseCause::HandedOff));
+
+    const std::string handedOff = std::to_string(static_cast<int>(ESSessionCloseCause::HandedOff));
+    const std::vector<std::string> expected = {
+        "connect " + std::to_string(open.streamId) + " sender 10.0.0.1",
+        "handedoff",
+        "closed " + std::to_string(open.streamId) + " " + handedOff,
+        "closed " + std::to_string(0x0a000002) + " " + handedOff,
+    };
+
+    bool ok = Check(recorder->calls == expected, "handoff closes sessions without OnDisconnect");
+    for (const std::string& call : recorder->calls) {
+        if (call.compare(0, 10, "disconnect") == 0) {
+            ok &= Check(false, "unexpected " + call);
+        }
+    }
+    return ok;
+}
+
+} // namespace
+
+int main()
+{
+    bool ok = true;
+    ok &= RunCause(ESSessionCloseCause::PeerClosed, "PeerClosed", true);
+    ok &= RunCause(ESSessionCloseCause::HeartbeatTimeout, "HeartbeatTimeout", true);
+    ok &= RunCause(ESSessionCloseCause::MediaTimeout, "MediaTimeout", true);
+    ok &= RunCause(ESSessionCloseCause::ServerStopped, "ServerStopped", false);
+    ok &= RunCause(ESSessionCloseCause::HandedOff, "HandedOff", false);
+    ok &= RunCause(ESSessionCloseCause::QuotaExceeded, "QuotaExceeded", false);
+    ok &= RunHandoff();
+
+    std::cout << "[CallbackAdapterTest] " << (ok ? "all passed" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "ESAudioDriftResampler.h"
+
+// 变速重采样时钟偏差自测：发送端按 44100*(1+skew) 的时钟推 480 帧，本地按 44100 每 10ms 拉 441 帧，
+// 检查控制器收敛到实际偏差、水位回到目标且稳态无欠载/丢弃；
+// 另起线程并发 PullS16 / Stop / Start，配合 ASan/TSan 检查拉取缓冲的并发访问。返回 0 表示全部通过
+
+namespace {
+
+constexpr uint32_t kSampleRate = 44100;
+constexpr uint16_t kChannels = 2;
+constexpr uint32_t kPushFrames = 480;
+constexpr uint32_t kPullFrames = 441;
+constexpr double kPi = 3.14159265358979323846;
+
+static bool Check(bool condition, const char* name)
+{
+    std::cout << "[DriftTest] " << (condition ? "PASS " : "FAIL ") << name << std::endl;
+    return condition;
+}
+
+static bool RunSkew(double skewPpm, double seconds)
+{
+    hhcast::ESAudioDriftResampler resampler;
+    hhcast::ESAudioDriftConfig config;
+    config.enabled = true;
+    config.sampleRate = kSampleRate;
+    config.channels = kChannels;
+    if (resampler.Start(config) != 0) {
+        return Check(false, "start");
+    }
+
+    const double sourceRate = kSampleRate * (1.0 + skewPpm * 1e-6);
+    std::vector<float> in(kPushFrames * kChannels);
+    std::vector<float> out(kPullFrames * kChannels);
+    double sourceTime = 0.0;
+    double localTime = 0.0;
+    double phase = 0.0;
+    double correctionSum = 0.0;
+    uint64_t correctionCount = 0;
+    hhcast::ESAudioDriftStats settled;
+
+    while (localTime < seconds) {
+        // 发送端略微领先，模拟网络/解码把数据先送到
+        while (sourceTime < localTime + 0.010) {
+            for (uint32_t i = 0; i < kPushFrames; ++i) {
+                const float v = 0.5f * static_cast<float>(std::sin(phase));
+                in[i * kChannels] = v;
+                in[i * kChannels + 1] = v;
+                phase += 2.0 * kPi * 1000.0 / kSampleRate;
+            }
+            resampler.Push(in.data(), kPushFrames);
+            sourceTime += kPushFrames / sourceRate;
+        }
+
+        resampler.Pull(out.data(), kPullFrames);
+        localTime += static_cast<double>(kPullFrames) / kSampleRate;
+
+        // 前一半时间留给控制器收敛，后一半统计
+        if (localTime > seconds / 2) {
+            const hhcast::ESAudioDriftStats stats = resampler.GetStats();
+            if (correctionCount == 0) {
+                settled = stats;
+            }
+            correctionSum += stats.correctionPpm;
+            ++correctionCount;
+        }
+    }
+
+    const hhcast::ESAudioDriftStats stats = resampler.GetStats();
+    const double meanCorrection = correctionSum / static_cast<double>(correctionCount);
+    std::cout << "[DriftTest] skew=" << skewPpm << "ppm correction=" << meanCorrection
+              << "ppm fill=" << stats.smoothedFillMs << "ms underruns=" << stats.underruns
+              << " dropped=" << stats.droppedSamples << std::endl;
+
+    bool ok = true;
+    ok &= Check(std::fabs(meanCorrection - skewPpm) < 30.0, "correction tracks sender skew");
+    ok &= Check(std::fabs(stats.smoothedFillMs - config.targetFillMs) < 10.0, "fill settles at target");
+    ok &= Check(stats.underruns == settled.underruns, "no underruns once settled");
+    ok &= Check(stats.droppedSamples == settled.droppedSamples, "no drops once settled");
+    resampler.Stop();
+    return ok;
+}
+
+static bool RunConcurrentStop()
+{
+    hhcast::ESAudioDriftResampler resampler;
+    hhcast::ESAudioDriftConfig config;
+    config.enabled = true;
+    config.sampleRate = kSampleRate;
+    config.channels = kChannels;
+    resampler.Start(config);
+
+    std::atomic<bool> running{ true };
+    std::thread puller([&]() {
+        std::vector<int16_t> out(kPullFrames * kChannels);
+        while (running.load()) {
+            resampler.PullS16(out.data(), kPullFrames);
+        }
+    });
+
+    std::vector<float> in(kPushFrames * kChannels, 0.25f);
+    for (int i = 0; i < 2000; ++i) {
+        resampler.Push(in.data(), kPushFrames);
+        if (i % 50 == 0) {
+            resampler.Stop();
+            resampler.Start(config);
+        }
+    }
+
+    running = false;
+    puller.join();
+    resampler.Stop();
+    return Check(true, "concurrent PullS16 with Stop/Start");
+}
+
+} // namespace
+
+int main()
+{
+    bool ok = true;
+    ok &= RunSkew(300.0, 600.0);
+    ok &= RunSkew(-500.0, 600.0);
+    ok &= RunSkew(0.0, 600.0);
+    ok &= RunConcurrentStop();
+
+    std::cout << "[DriftTest] " << (ok ? "all passed" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
\ No newline at end of file
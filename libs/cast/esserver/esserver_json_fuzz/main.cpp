@@ -0,0 +1,286 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ESJsonLineScanner.h"
+
+// 57395 / 8121 控制消息解析的模糊测试 + 微基准：
+// 1. 固定用例检查 client-info 必须带 clientType、heartbeat 保留 int64、8121 命令区分大小写；
+// 2. 以 corpus 目录下的样本为种子做确定性变异（翻转/插入/删除/截断/拼接），随机分块喂给切行器，
+//    检查不崩溃、字段视图都落在行内、分块结果与整块一致；
+// 3. 对比就地扫描和原来 find 子串的取值方式，输出每行耗时。
+// 用法：esserver_json_fuzz [corpus 目录] [变异轮数]。返回 0 表示全部通过
+
+#ifndef ESSERVER_JSON_CORPUS_DIR
+#define ESSERVER_JSON_CORPUS_DIR "corpus"
+#endif
+
+namespace {
+
+constexpr int kDefaultIterations = 200000;
+constexpr int kBenchLines = 1000000;
+
+static bool Check(bool condition, const char* name)
+{
+    if (!condition) {
+        std::cout << "[JsonFuzz] FAIL " << name << std::endl;
+    }
+    return condition;
+}
+
+// 原 ESServer 里按子串查找取值的方式，只用于基准对比
+static bool LegacyGetInt(const std::string& json, const std::string& key, int& value)
+{
+    const std::string pattern = "\"" + key + "\"";
+    size_t pos = json.find(pattern);
+    if (pos == std::string::npos) {
+        return false;
+    }
+
+    pos = json.find(':', pos + pattern.size());
+    if (pos == std::string::npos) {
+        return false;
+    }
+
+    ++pos;
+    while (pos < json.size() && std::isspace(static_cast<unsigned char>(json[pos]))) {
+        ++pos;
+    }
+
+    size_t end = pos;
+    if (end < json.size() && (json[end] == '-' || json[end] == '+')) {
+        ++end;
+    }
+    while (end < json.size() && std::isdigit(static_cast<unsigned char>(json[end]))) {
+        ++end;
+    }
+
+    if (end == pos) {
+        return false;
+    }
+
+    value = std::stoi(json.substr(pos, end - pos));
+    return true;
+}
+
+static std::vector<std::string> LoadCorpus(const std::filesystem::path& dir)
+{
+    std::vector<std::string> seeds;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+        if (!entry.is_regular_file()) {
+            continue;
+        }
+        std::ifstream in(entry.path(), std::ios::binary);
+        seeds.emplace_back(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    std::sort(seeds.begin(), seeds.end());
+    return seeds;
+}
+
+static bool RunFixedCases()
+{
+    bool ok = true;
+    hhcast::ESJsonLineScanner scanner;
+    hhcast::ESEshareJsonMessage msg;
+    std::string scratch;
+
+    ok &= Check(scanner.Parse(R"({"clientName":"PC","clientType":"windows"})") &&
+                hhcast::ParseEshareJsonMessage(scanner, msg, &scratch) &&
+                msg.kind == hhcast::ESEshareJsonKind::ClientInfo && msg.clientName == "PC" &&
+                msg.clientType == "windows", "client info");
+
+    ok &= Check(scanner.Parse(R"({"clientName":"PC"})") &&
+                !hhcast::ParseEshareJsonMessage(scanner, msg, &scratch), "client info requires clientType");
+    ok &= Check(hhcast::ParseEshareJsonMessage(scanner, msg, &scratch, false) &&
+                msg.kind == hhcast::ESEshareJsonKind::ClientInfo, "client info without clientType when allowed");
+
+    ok &= Check(scanner.Parse(R"({"heartbeat":9007199254740993})") &&
+                hhcast::ParseEshareJsonMessage(scanner, msg, &scratch) &&
+                msg.kind == hhcast::ESEshareJsonKind::Heartbeat && msg.heartbeat == 9007199254740993LL,
+                "heartbeat keeps int64");
+
+    hhcast::ESEshareCommandRequest request;
+    ok &= Check(hhcast::ParseEshareCommandRequest("getServerInfo\r\nPC\r\n1.0\r\n", request) &&
+                request.command == hhcast::ESEshareCommand::GetServerInfo, "8121 exact command");
+    ok &= Check(hhcast::ParseEshareCommandRequest("GETSERVERINFO\r\nPC\r\n1.0\r\n", request) &&
+                request.command == hhcast::ESEshareCommand::Unknown, "8121 command is case sensitive");
+    ok &= Check(hhcast::ParseEshareCommandRequest("DongleConnected\r\nPC\r\n1.0\r\n", request, true) &&
+                request.command == hhcast::ESEshareCommand::DongleConnected, "8121 ignoreCase");
+    ok &= Check(!hhcast::ParseEshareCommandRequest("getServerInfo\r\nPC\r\n", request), "8121 needs three lines");
+
+    std::cout << "[JsonFuzz] fixed cases " << (ok ? "passed" : "FAILED") << std::endl;
+    return ok;
+}
+
+static void Mutate(std::string& data, const std::vector<std::string>& seeds, std::mt19937& rng)
+{
+    static const char kAlphabet[] = "{}[]\":,\\ u0123456789abcdefntrl-+.eE\r\n";
+    const int ops = 1 + static_cast<int>(rng() % 4);
+    for (int i = 0; i < ops; ++i) {
+        const size_t pos = data.empty() ? 0 : rng() % data.size();
+        switch (rng() % 5) {
+        case 0:
+            if (!data.empty()) {
+                data[pos] = static_cast<char>(data[pos] ^ (1 << (rng() % 8)));
+            }
+            break;
+        case 1:
+            data.insert(data.begin() + static_cast<std::ptrdiff_t>(pos), kAlphabet[rng() % (sizeof(kAlphabet) - 1)]);
+            break;
+        case 2:
+            if (!data.empty()) {
+                data.erase(pos, 1 + rng() % 4);
+            }
+            break;
+        case 3:
+            data.resize(pos);
+            break;
+        default: {
+            const std::string& other = seeds[rng() % seeds.size()];
+            const size_t from = other.empty() ? 0 : rng() % other.size();
+            data.insert(pos, other, from, std::string::npos);
+            break;
+        }
+        }
+    }
+}
+
+static bool FieldsInside(const hhcast::ESJsonLineScanner& scanner, std::string_view line)
+{
+    const char* begin = line.data();
+    const char* end = line.data() + line.size();
+    for (size_t i = 0; i < scanner.GetFieldCount(); ++i) {
+        const hhcast::ESJsonField& field = scanner.GetField(i);
+        if (field.key.data() < begin || field.key.data() + field.key.size() > end ||
+            field.raw.data() < begin || field.raw.data() + field.raw.size() > end) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static std::vector<std::string> SplitAll(const std::string& data, std::mt19937* rng)
+{
+    hhcast::ESJsonLineSplitter splitter;
+    std::vector<std::string> lines;
+    size_t offset = 0;
+    while (offset < data.size()) {
+        const size_t chunk = rng ? 1 + (*rng)() % 16 : data.size();
+        const size_t n = std::min(chunk, data.size() - offset);
+        splitter.Append(data.data() + offset, n);
+        offset += n;
+
+        std::string_view line;
+        while (splitter.Next(line)) {
+            lines.emplace_back(line);
+        }
+    }
+    return lines;
+}
+
+static bool RunFuzz(const std::vector<std::string>& seeds, int iterations)
+{
+    std::mt19937 rng(0x57395);
+    hhcast::ESJsonLineScanner scanner;
+    uint64_t parsed = 0;
+    uint64_t messages = 0;
+
+    for (int it = 0; it < iterations; ++it) {
+        std::string data = seeds[rng() % seeds.size()];
+        Mutate(data, seeds, rng);
+
+        const std::vector<std::string> whole = SplitAll(data, nullptr);
+        const std::vector<std::string> chunked = SplitAll(data, &rng);
+        if (!Check(whole == chunked, "chunked split matches whole split")) {
+            return false;
+        }
+
+        for (const std::string& line : whole) {
+            if (!scanner.Parse(line)) {
+                continue;
+            }
+            ++parsed;
+            if (!Check(FieldsInside(scanner, line), "field views stay inside the line")) {
+                return false;
+            }
+
+            for (size_t i = 0; i < scanner.GetFieldCount(); ++i) {
+                std::string decoded;
+                hhcast::ESJsonLineScanner::Unescape(scanner.GetField(i).raw, decoded);
+            }
+
+            std::string scratch;
+            hhcast::ESEshareJsonMessage msg;
+            if (hhcast::ParseEshareJsonMessage(scanner, msg, &scratch)) {
+                ++messages;
+            }
+        }
+
+        hhcast::ESEshareCommandRequest request;
+        hhcast::ParseEshareCommandRequest(data, request);
+    }
+
+    std::cout << "[JsonFuzz] " << iterations << " mutations, parsed=" << parsed
+              << " messages=" << messages << std::endl;
+    return true;
+}
+
+static void RunBench()
+{
+    const std::string line = R"({"heartbeat":123,"clientType":"windows","clientName":"DESKTOP-ABC"})";
+    hhcast::ESJsonLineScanner scanner;
+    int64_t sum = 0;
+
+    const auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < kBenchLines; ++i) {
+        scanner.Parse(line);
+        hhcast::ESEshareJsonMessage msg;
+        hhcast::ParseEshareJsonMessage(scanner, msg);
+        sum += msg.heartbeat;
+    }
+    const auto t1 = std::chrono::steady_clock::now();
+    for (int i = 0; i < kBenchLines; ++i) {
+        const std::string copy(line);
+        int heartbeat = 0;
+        LegacyGetInt(copy, "heartbeat", heartbeat);
+        sum += heartbeat;
+    }
+    const auto t2 = std::chrono::steady_clock::now();
+
+    const double scanNs = std::chrono::duration<double, std::nano>(t1 - t0).count() / kBenchLines;
+    const double legacyNs = std::chrono::duration<double, std::nano>(t2 - t1).count() / kBenchLines;
+    std::cout << "[JsonFuzz] bench scanner=" << scanNs << "ns/line legacy=" << legacyNs
+              << "ns/line (checksum " << sum << ")" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const std::filesystem::path corpusDir = (argc > 1) ? argv[1] : ESSERVER_JSON_CORPUS_DIR;
+    const int iterations = (argc > 2) ? std::atoi(argv[2]) : kDefaultIterations;
+
+    const std::vector<std::string> seeds = LoadCorpus(corpusDir);
+    if (seeds.empty()) {
+        std::cout << "[JsonFuzz] FAIL no corpus in " << corpusDir.string() << std::endl;
+        return 1;
+    }
+
+    bool ok = RunFixedCases();
+    ok &= RunFuzz(seeds, iterations);
+    RunBench();
+
+    std::cout << "[JsonFuzz] " << (ok ? "all passed" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,329 @@
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+#include "ESMulticastProtocol.h"
+#include "ESMulticastPublisher.h"
+#include "ESMulticastReceiver.h"
+
+// 组播转发回环自测：发送端真实发到回环组播，用一个普通 socket 收下所有 datagram，
+// 按固定规律丢包后喂给接收端，检查 FEC 恢复、unit 上限和发送端重连后的重新同步。
+// 返回 0 表示全部通过
+
+namespace {
+
+using Packet = std::vector<uint8_t>;
+using hhcast::kEsMulticastHeaderSize;
+using hhcast::kEsMulticastShardHeaderSize;
+
+constexpr uint32_t kStreamId = 7;
+
+#ifdef _WIN32
+using SocketFd = SOCKET;
+#else
+using SocketFd = int;
+#endif
+
+static void CloseFd(SocketFd fd)
+{
+#ifdef _WIN32
+    closesocket(fd);
+#else
+    close(fd);
+#endif
+}
+
+class Capture {
+public:
+    bool Open(const hhcast::ESMulticastConfig& config)
+    {
+        m_fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+        const int reuse = 1;
+        setsockopt(m_fd, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(config.port);
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        if (bind(m_fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+            std::cout << "[MulticastTest] bind " << config.port << " failed" << std::endl;
+            return false;
+        }
+
+        ip_mreq mreq;
+        std::memset(&mreq, 0, sizeof(mreq));
+        inet_pton(AF_INET, config.group.c_str(), &mreq.imr_multiaddr);
+        mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+        if (setsockopt(m_fd, IPPROTO_IP, IP_ADD_MEMBERSHIP,
+                       reinterpret_cast<const char*>(&mreq), sizeof(mreq)) != 0) {
+            std::cout << "[MulticastTest] join " << config.group << " failed" << std::endl;
+            return false;
+        }
+
+        int rcvbuf = 8 * 1024 * 1024;
+        setsockopt(m_fd, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&rcvbuf), sizeof(rcvbuf));
+
+#ifdef _WIN32
+        const DWORD timeoutMs = 200;
+        setsockopt(m_fd, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeoutMs), sizeof(timeoutMs));
+#else
+        timeval tv;
+        tv.tv_sec = 0;
+        tv.tv_usec = 200 * 1000;
+        setsockopt(m_fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+#endif
+        return true;
+    }
+
+    ~Capture()
+    {
+        CloseFd(m_fd);
+    }
+
+    // 收到超时为止
+    void Drain(std::vector<Packet>& out)
+    {
+        std::vector<uint8_t> buffer(65536);
+        while (true) {
+            const auto n = recv(m_fd, reinterpret_cast<char*>(buffer.data()), static_cast<int>(buffer.size()), 0);
+            if (n <= 0) {
+                break;
+            }
+            out.emplace_back(buffer.begin(), buffer.begin() + n);
+        }
+    }
+
+private:
+    SocketFd m_fd = static_cast<SocketFd>(-1);
+};
+
+struct Delivered {
+    std::vector<Packet> video;
+    size_t audio = 0;
+};
+
+static void Bind(hhcast::ESMulticastReceiver& receiver, Delivered& delivered)
+{
+    receiver.SetVideoCallback(
+        [&delivered](uint32_t, const uint8_t* payload, size_t size, const hhcast::ESVideoUnit&) {
+            delivered.video.emplace_back(payload, payload + size);
+        });
+    receiver.SetAudioCallback(
+        [&delivered](uint32_t, const uint8_t*, size_t, const hhcast::ESAudioPayloadInfo&) {
+            ++delivered.audio;
+        });
+}
+
+static std::vector<Packet> PublishRound(hhcast::ESMulticastPublisher& publisher,
+                                        Capture& capture,
+                                        std::mt19937& rng,
+                                        size_t unitCount,
+                                        std::vector<Packet>& sent)
+{
+    std::vector<Packet> packets;
+    for (size_t i = 0; i < unitCount; ++i) {
+        Packet payload(100 + rng() % 6000);
+        for (auto& b : payload) {
+            b = static_cast<uint8_t>(rng());
+        }
+        sent.push_back(payload);
+
+        hhcast::ESVideoUnit unit;
+        unit.rawKind = static_cast<uint32_t>(hhcast::ESVideoUnitKind::Frame);
+        unit.payload = payload.data();
+        unit.payloadSize = payload.size();
+        publisher.PublishVideoUnit(kStreamId, unit);
+
+        hhcast::ESAudioPayloadInfo audio;
+        audio.payload = payload.data();
+        audio.payloadSize = 64;
+        audio.sequence = static_cast<uint16_t>(i);
+        publisher.PublishAudioPacket(kStreamId, audio);
+
+        // 分批收，避免 socket 缓冲溢出变成不可控的丢包
+        if (i % 16 == 15) {
+            capture.Drain(packets);
+        }
+    }
+
+    capture.Drain(packets);
+    return packets;
+}
+
+static bool Expect(bool condition, const char* what)
+{
+    std::cout << "[MulticastTest] " << (condition ? "PASS " : "FAIL ") << what << std::endl;
+    return condition;
+}
+
+static bool SameUnits(const std::vector<Packet>& sent, const std::vector<Packet>& got, size_t from)
+{
+    if (got.size() < from || got.size() - from != sent.size()) {
+        return false;
+    }
+
+    for (size_t i = 0; i < sent.size(); ++i) {
+        if (got[from + i] != sent[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool RunFecRound(hhcast::ESFecScheme scheme, uint8_t parityShards, uint16_t port)
+{
+    hhcast::ESMulticastConfig config;
+    config.enabled = true;
+    config.port = port;
+    config.fecScheme = scheme;
+    config.fecDataShards = 8;
+    config.fecParityShards = parityShards;
+
+    Capture capture;
+    hhcast::ESMulticastPublisher publisher;
+    if (!capture.Open(config) || publisher.Start(config) != 0) {
+        return Expect(false, "start publisher");
+    }
+
+    std::mt19937 rng(static_cast<unsigned>(port));
+    std::vector<Packet> sent;
+    const std::vector<Packet> packets = PublishRound(publisher, capture, rng, 300, sent);
+    publisher.Stop();
+
+    if (packets.size() != publisher.GetDataPacketCount() + publisher.GetParityPacketCount()) {
+        return Expect(false, "capture saw every datagram");
+    }
+
+    // 每 9 个（Xor 一组 8+1）丢 1 个，保证每组最多缺一个分片。
+    // 最后一组还没凑满、没有校验包，末尾几个不丢
+    hhcast::ESMulticastReceiver receiver;
+    Delivered delivered;
+    Bind(receiver, delivered);
+    for (size_t i = 0; i < packets.size(); ++i) {
+        if (i % 9 == 4 && i + 16 < packets.size()) {
+            continue;
+        }
+        receiver.InputDatagram(packets[i].data(), packets[i].size());
+    }
+
+    bool ok = true;
+    ok &= Expect(receiver.GetRecoveredShardCount() > 0, "fec recovered dropped shards");
+    ok &= Expect(SameUnits(sent, delivered.video, 0), "video units intact and in order");
+    ok &= Expect(delivered.audio == sent.size(), "audio packets delivered");
+    ok &= Expect(receiver.GetLostUnitCount() == 0, "no unit lost");
+    return ok;
+}
+
+static bool RunUnitSizeLimit()
+{
+    hhcast::ESMulticastReceiver receiver;
+    Delivered delivered;
+    Bind(receiver, delivered);
+
+    // 伪造一个声明 4GB unit 的分片，接收端应直接丢弃而不是按它分配内存
+    uint8_t datagram[kEsMulticastHeaderSize + kEsMulticastShardHeaderSize + 16];
+    std::memset(datagram, 0, sizeof(datagram));
+
+    hhcast::ESMulticastHeader header;
+    header.streamId = kStreamId;
+    header.shardSize = static_cast<uint16_t>(kEsMulticastShardHeaderSize + 16);
+    hhcast::WriteMulticastHeader(header, datagram);
+
+    hhcast::ESMulticastShardHeader shard;
+    shard.mediaType = hhcast::ESMulticastMediaType::Video;
+    shard.fragLen = 16;
+    shard.fragCount = 1;
+    shard.unitSize = 0xFFFFFFF0u;
+    shard.fragOffset = 0;
+    hhcast::WriteMulticastShardHeader(shard, datagram + kEsMulticastHeaderSize);
+
+    for (uint32_t unitId = 0; unitId < 8; ++unitId) {
+        shard.unitId = unitId;
+        hhcast::WriteMulticastShardHeader(shard, datagram + kEsMulticastHeaderSize);
+        receiver.InputDatagram(datagram, sizeof(datagram));
+    }
+
+    return Expect(delivered.video.empty() && receiver.GetDeliveredUnitCount() == 0,
+                  "oversized unit dropped without allocation");
+}
+
+// 发送端 RemoveStream 后重新计数：一次 epoch 变化，一次 epoch 被改成相同值（只能靠回退距离识别）
+static bool RunReconnect(uint16_t port, bool keepEpoch)
+{
+    hhcast::ESMulticastConfig config;
+    config.enabled = true;
+    config.port = port;
+    config.fecScheme = hhcast::ESFecScheme::Xor;
+
+    Capture capture;
+    hhcast::ESMulticastPublisher publisher;
+    if (!capture.Open(config) || publisher.Start(config) != 0) {
+        return Expect(false, "start publisher");
+    }
+
+    std::mt19937 rng(static_cast<unsigned>(port));
+    std::vector<Packet> firstSent;
+    const std::vector<Packet> first = PublishRound(publisher, capture, rng, 2000, firstSent);
+
+    publisher.RemoveStream(kStreamId);
+
+    std::vector<Packet> secondSent;
+    std::vector<Packet> second = PublishRound(publisher, capture, rng, 50, secondSent);
+    publisher.Stop();
+
+    if (keepEpoch && !first.empty()) {
+        for (auto& packet : second) {
+            packet[7] = first.front()[7];
+        }
+    }
+
+    hhcast::ESMulticastReceiver receiver;
+    Delivered delivered;
+    Bind(receiver, delivered);
+    for (const auto& packet : first) {
+        receiver.InputDatagram(packet.data(), packet.size());
+    }
+    for (const auto& packet : second) {
+        receiver.InputDatagram(packet.data(), packet.size());
+    }
+
+    bool ok = true;
+    ok &= Expect(receiver.GetResyncCount() > 0, keepEpoch ? "resync on unitId rewind" : "resync on new epoch");
+    ok &= Expect(SameUnits(secondSent, delivered.video, firstSent.size()), "units after reconnect delivered");
+    return ok;
+}
+
+} // namespace
+
+int main()
+{
+#ifdef _WIN32
+    WSADATA wsa;
+    WSAStartup(MAKEWORD(2, 2), &wsa);
+#endif
+
+    bool ok = true;
+    ok &= RunFecRound(hhcast::ESFecScheme::Xor, 1, 52191);
+    ok &= RunFecRound(hhcast::ESFecScheme::ReedSolomon, 3, 52192);
+    ok &= RunUnitSizeLimit();
+    ok &= RunReconnect(52194, false);
+    ok &= RunReconnect(52195, true);
+
+    std::cout << "[MulticastTest] " << (ok ? "all passed" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "ESPipeline.h"
+#include "ESVideoDepacketizer.h"
+
+// 视频链微基准：同一段 51030 字节流按 16KB 分块喂入，对比
+//   callback：PushBytes + SetCallback 的 std::function（ESPipeline 之前 ESSession 的接法）
+//   pipeline：Append + DrainUnits(ESPipeline<过滤, 分发>)（ESSession 现在的接法）
+// 两边末端是同一个累加器，先校验单元数和校验和一致，再输出每个单元的耗时（多次取最小）。
+// 流里每 8 个单元夹一个未知类型，两条路都要把它滤掉。返回 0 表示结果一致
+
+namespace {
+
+constexpr size_t kHeaderSize = 128;       // 51030 单元头，前 16 字节是长度/类型/时间戳
+constexpr size_t kChunkSize = 16 * 1024;
+constexpr size_t kStreamBytes = 8 * 1024 * 1024;
+constexpr int kRepeats = 5;
+
+struct Scenario {
+    const char* name;
+    size_t payloadSize;
+};
+
+static void WriteLe32(uint8_t* p, uint32_t v)
+{
+    for (int i = 0; i < 4; ++i) {
+        p[i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+}
+
+static void WriteLe64(uint8_t* p, uint64_t v)
+{
+    for (int i = 0; i < 8; ++i) {
+        p[i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+}
+
+static std::vector<uint8_t> BuildStream(size_t payloadSize, size_t& unitCount)
+{
+    const size_t unitBytes = kHeaderSize + payloadSize;
+    unitCount = std::max<size_t>(kStreamBytes / unitBytes, 64);
+
+    std::vector<uint8_t> stream(unitCount * unitBytes);
+    for (size_t i = 0; i < unitCount; ++i) {
+        uint8_t* p = stream.data() + i * unitBytes;
+        uint32_t kind = static_cast<uint32_t>(hhcast::ESVideoUnitKind::Frame);
+        if (i % 8 == 7) {
+            kind = 0x200;
+        }
+        else if (i % 64 == 0) {
+            kind = static_cast<uint32_t>(hhcast::ESVideoUnitKind::Config);
+        }
+        WriteLe32(p, static_cast<uint32_t>(payloadSize));
+        WriteLe32(p + 4, kind);
+        WriteLe64(p + 8, static_cast<uint64_t>(i) << 32);
+        std::fill(p + kHeaderSize, p + unitBytes, static_cast<uint8_t>(i));
+    }
+    return stream;
+}
+
+// 两条路共用的末端：只读头字段和负载首字节，不让负载拷贝盖过调用开销
+struct Accumulator {
+    uint64_t units = 0;
+    uint64_t checksum = 0;
+
+    void operator()(const hhcast::ESVideoUnit& unit)
+    {
+        ++units;
+        checksum = checksum * 31 + unit.timestamp32_32 + unit.payloadSize + unit.payload[0] +
+                   static_cast<uint32_t>(unit.kind);
+    }
+};
+
+struct KnownUnit {
+    bool operator()(const hhcast::ESVideoUnit& unit) const
+    {
+        return (unit.kind == hhcast::ESVideoUnitKind::Config || unit.kind == hhcast::ESVideoUnitKind::Frame) &&
+               unit.payloadSize > 0;
+    }
+};
+
+struct AccumulatorRef {
+    Accumulator* target;
+
+    void operator()(const hhcast::ESVideoUnit& unit) const
+    {
+        (*target)(unit);
+    }
+};
+
+using Pipeline = hhcast::ESPipeline<hhcast::ESFilterStage<KnownUnit>, hhcast::ESDispatchStage<AccumulatorRef>>;
+
+template <typename FeedFn>
+static void FeedChunks(const std::vector<uint8_t>& stream, FeedFn&& feed)
+{
+    for (size_t offset = 0; offset < stream.size(); offset += kChunkSize) {
+        feed(stream.data() + offset, std::min(kChunkSize, stream.size() - offset));
+    }
+}
+
+static Accumulator RunCallback(const std::vector<uint8_t>& stream, double& ns)
+{
+    Accumulator acc;
+    hhcast::ESVideoDepacketizer depacketizer;
+    depacketizer.SetCallback([&acc](const hhcast::ESVideoUnit& unit) {
+        acc(unit);
+    });
+
+    const auto begin = std::chrono::steady_clock::now();
+    FeedChunks(stream, [&](const uint8_t* data, size_t size) {
+        depacketizer.PushBytes(data, size);
+    });
+    ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - begin).count());
+    return acc;
+}
+
+static Accumulator RunPipeline(const std::vector<uint8_t>& stream, double& ns)
+{
+    Accumulator acc;
+    hhcast::ESVideoDepacketizer depacketizer;
+    Pipeline pipeline(hhcast::ESFilterStage<KnownUnit>(), hhcast::ESDispatchStage<AccumulatorRef>(AccumulatorRef{ &acc }));
+
+    const auto begin = std::chrono::steady_clock::now();
+    FeedChunks(stream, [&](const uint8_t* data, size_t size) {
+        if (depacketizer.Append(data, size)) {
+            depacketizer.DrainUnits(pipeline);
+        }
+    });
+    ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - begin).count());
+    return acc;
+}
+
+static bool RunScenario(const Scenario& scenario)
+{
+    size_t unitCount = 0;
+    const std::vector<uint8_t> stream = BuildStream(scenario.payloadSize, unitCount);
+    const uint64_t expectedUnits = unitCount - unitCount / 8;
+
+    double callbackNs = 0;
+    double pipelineNs = 0;
+    double ns = 0;
+    Accumulator callback;
+    Accumulator pipeline;
+    for (int i = 0; i < kRepeats; ++i) {
+        callback = RunCallback(stream, ns);
+        callbackNs = (i == 0) ? ns : std::min(callbackNs, ns);
+        pipeline = RunPipeline(stream, ns);
+        pipelineNs = (i == 0) ? ns : std::min(pipelineNs, ns);
+    }
+
+    if (callback.units != expectedUnits || pipeline.units != expectedUnits ||
+        callback.checksum != pipeline.checksum) {
+        std::cout << "[PipelineBench] FAIL " << scenario.name << " expected=" << expectedUnits
+                  << " callback=" << callback.units << " pipeline=" << pipeline.units << std::endl;
+        return false;
+    }
+
+    const double units = static_cast<double>(unitCount);
+    std::cout << "[PipelineBench] " << scenario.name
+              << " payload=" << scenario.payloadSize << "B units=" << unitCount
+              << " callback=" << callbackNs / units << "ns"
+              << " pipeline=" << pipelineNs / units << "ns"
+              << " speedup=" << (pipelineNs > 0 ? callbackNs / pipelineNs : 0.0) << "x" << std::endl;
+    return true;
+}
+
+} // namespace
+
+int main()
+{
+    const Scenario scenarios[] = {
+        { "tiny", 16 },
+        { "small", 64 },
+        { "medium", 1024 },
+        { "frame", 64 * 1024 },
+    };
+
+    bool ok = true;
+    for (const Scenario& scenario : scenarios) {
+        ok &= RunScenario(scenario);
+    }
+
+    std::cout << "[PipelineBench] " << (ok ? "all passed" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,386 @@
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "ESServer.h"
+
+// 会话超时回收自测：起一个完整的 ESServer，从 127.0.0.x 发 client-info 和一段音频 RTP 后静默，
+// 等心跳/媒体超时把会话回收，检查：
+//   - 抖动缓冲压着的尾包在关闭事件之前全部回调（关掉定时出包时靠关闭时 Flush，打开时靠定时器）
+//   - 关闭事件带正确的原因，disconnected 为 true；旧接口先 OnDisconnect 再 OnSessionClosed
+//   - 回收后再发的音频不再回调
+// 占用 ESServer 的固定端口，不能和其他起服务的测试并行。返回 0 表示全部通过
+
+namespace {
+
+constexpr uint8_t kPayloadType = 96;
+constexpr uint32_t kSsrc = 0x11223344;
+constexpr size_t kRtpHeaderSize = 12;
+constexpr uint32_t kSamplesPerPacket = 480;
+constexpr uint16_t kControlPort = 57395;
+
+static bool Check(bool condition, const std::string& name)
+{
+    std::cout << "[SessionReapTest] " << (condition ? "PASS " : "FAIL ") << name << std::endl;
+    return condition;
+}
+
+#ifdef __linux__
+
+static bool BindSource(int fd, const char* sourceIp)
+{
+    sockaddr_in local{};
+    local.sin_family = AF_INET;
+    inet_pton(AF_INET, sourceIp, &local.sin_addr);
+    return bind(fd, reinterpret_cast<sockaddr*>(&local), sizeof(local)) == 0;
+}
+
+static sockaddr_in Loopback(uint16_t port)
+{
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    return addr;
+}
+
+// 模拟发送端：57395 发 client-info，音频数据端口发 RTP；源地址决定 streamId
+class FakeSender {
+public:
+    explicit FakeSender(const char* sourceIp) : m_sourceIp(sourceIp) {}
+
+    ~FakeSender()
+    {
+        if (m_tcp >= 0) {
+            close(m_tcp);
+        }
+        if (m_udp >= 0) {
+            close(m_udp);
+        }
+    }
+
+    bool Connect(const std::string& name)
+    {
+        m_tcp = socket(AF_INET, SOCK_STREAM, 0);
+        const sockaddr_in server = Loopback(kControlPort);
+        if (m_tcp < 0 || !BindSource(m_tcp, m_sourceIp) ||
+            connect(m_tcp, reinterpret_cast<const sockaddr*>(&server), sizeof(server)) != 0) {
+            return false;
+        }
+
+        const std::string line = "{\"clientName\":\"" + name + "\",\"clientType\":\"test\"}\n";
+        if (send(m_tcp, line.data(), line.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(line.size())) {
+            return false;
+        }
+
+        // 等应答，确认会话已经建好
+        char reply[4096];
+        pollfd pfd{ m_tcp, POLLIN, 0 };
+        return poll(&pfd, 1, 2000) > 0 && recv(m_tcp, reply, sizeof(reply), 0) > 0;
+    }
+
+    bool SendAudio(uint16_t dataPort, uint16_t firstSeq, size_t count)
+    {
+        if (m_udp < 0) {
+            m_udp = socket(AF_INET, SOCK_DGRAM, 0);
+            if (m_udp < 0 || !BindSource(m_udp, m_sourceIp)) {
+                return false;
+            }
+        }
+
+        const sockaddr_in server = Loopback(dataPort);
+        for (size_t i = 0; i < count; ++i) {
+            const uint16_t seq = static_cast<uint16_t>(firstSeq + i);
+            const uint32_t ts = static_cast<uint32_t>(seq) * kSamplesPerPacket;
+            uint8_t packet[kRtpHeaderSize + 160];
+            for (uint8_t& b : packet) {
+                b = static_cast<uint8_t>(seq);
+            }
+            packet[0] = 0x80;
+            packet[1] = kPayloadType;
+            packet[2] = static_cast<uint8_t>(seq >> 8);
+            packet[3] = static_cast<uint8_t>(seq);
+            packet[4] = static_cast<uint8_t>(ts >> 24);
+            packet[5] = static_cast<uint8_t>(ts >> 16);
+            packet[6] = static_cast<uint8_t>(ts >> 8);
+            packet[7] = static_cast<uint8_t>(ts);
+            packet[8] = static_cast<uint8_t>(kSsrc >> 24);
+            packet[9] = static_cast<uint8_t>(kSsrc >> 16);
+            packet[10] = static_cast<uint8_t>(kSsrc >> 8);
+            packet[11] = static_cast<uint8_t>(kSsrc);
+            if (sendto(m_udp, packet, sizeof(packet), 0,
+                       reinterpret_cast<const sockaddr*>(&server), sizeof(server)) != sizeof(packet)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // 超时回收会关掉发送端的连接
+    bool WaitPeerClosed(int timeoutMs)
+    {
+        char buf[256];
+        pollfd pfd{ m_tcp, POLLIN, 0 };
+        while (poll(&pfd, 1, timeoutMs) > 0) {
+            const ssize_t n = recv(m_tcp, buf, sizeof(buf), 0);
+            if (n <= 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    uint32_t StreamId() const
+    {
+        in_addr addr{};
+        inet_pton(AF_INET, m_sourceIp, &addr);
+        return ntohl(addr.s_addr);
+    }
+
+private:
+    const char* m_sourceIp;
+    int m_tcp = -1;
+    int m_udp = -1;
+};
+
+// 按回调顺序记事件：open / audio <seq> / close <cause> <disconnected>
+class RecordingCallback : public hhcast::IESServerCallbackV2 {
+public:
+    void OnSessionOpen(const hhcast::ESSessionOpenEvent& event) override
+    {
+        Record("open " + std::to_string(event.streamId));
+    }
+
+    void OnSessionClose(const hhcast::ESSessionCloseEvent& event) override
+    {
+        Record("close " + std::to_string(event.streamId) + " " +
+               std::to_string(static_cast<int>(event.cause)) + " " + (event.disconnected ? "1" : "0"));
+    }
+
+    void OnMediaBatch(const hhcast::ESMediaBatch& batch) override
+    {
+        for (const auto& event : batch.audio) {
+            Record("audio " + std::to_string(event.streamId) + " " + std::to_string(event.info.sequence));
+        }
+    }
+
+    bool WaitFor(const std::string& prefix, int timeoutMs)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        return m_cond.wait_for(lock, std::chrono::milliseconds(timeoutMs), [&]() {
+            for (const std::string& e : m_events) {
+                if (e.compare(0, prefix.size(), prefix) == 0) {
+                    return true;
+                }
+            }
+            return false;
+        });
+    }
+
+    std::vector<std::string> Events()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_events;
+    }
+
+private:
+    void Record(std::string event)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_events.push_back(std::move(event));
+        m_cond.notify_all();
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::vector<std::string> m_events;
+};
+
+class RecordingCallbackV1 : public hhcast::IESServerCallback {
+public:
+    void OnConnect(uint32_t, const std::string&, const std::string&) override {}
+
+    void OnDisconnect(uint32_t streamId) override
+    {
+        Record("disconnect " + std::to_string(streamId));
+    }
+
+    void OnVideoData(uint32_t, const uint8_t*, size_t) override {}
+
+    void OnAudioData(uint32_t streamId, const uint8_t*, size_t) override
+    {
+        Record("audio " + std::to_string(streamId));
+    }
+
+    void OnSessionClosed(uint32_t streamId, hhcast::ESSessionCloseCause cause) override
+    {
+        Record("closed " + std::to_string(streamId) + " " + std::to_string(static_cast<int>(cause)));
+    }
+
+    bool WaitFor(const std::string& prefix, int timeoutMs)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        return m_cond.wait_for(lock, std::chrono::milliseconds(timeoutMs), [&]() {
+            for (const std::string& e : m_events) {
+                if (e.compare(0, prefix.size(), prefix) == 0) {
+                    return true;
+                }
+            }
+            return false;
+        });
+    }
+
+    std::vector<std::string> Events()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_events;
+    }
+
+private:
+    void Record(std::string event)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_events.push_back(std::move(event));
+        m_cond.notify_all();
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::vector<std::string> m_events;
+};
+
+// 关闭事件之前正好是 open + count 个按序的音频，之后没有别的事件
+static bool CheckOrder(const std::vector<std::string>& events, uint32_t streamId, uint16_t firstSeq,
+                       size_t count, const std::string& closeEvent)
+{
+    const std::string id = std::to_string(streamId);
+    if (events.size() != count + 2 || events.front() != "open " + id || events.back() != closeEvent) {
+        return false;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (events[i + 1] != "audio " + id + " " + std::to_string(static_cast<uint16_t>(firstSeq + i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 关掉定时出包，尾包只能靠回收时的 Flush 出来
+static bool RunHeartbeatTimeout()
+{
+    hhcast::ESServerConfig config;
+    config.sessionTimeout.heartbeatTimeoutMs = 500;
+    config.sessionTimeout.tickMs = 20;
+    config.audioJitter.pollIntervalMs = 0;
+
+    auto recorder = std::make_shared<RecordingCallback>();
+    hhcast::ESServer server;
+    server.SetConfig(config);
+    server.SetCallbackV2(recorder);
+    if (!Check(server.StartServer() == 0, "heartbeat: server started")) {
+        return false;
+    }
+
+    bool ok = true;
+    {
+        FakeSender sender("127.0.0.21");
+        const uint32_t streamId = sender.StreamId();
+        const uint16_t firstSeq = 100;
+        const size_t count = 20;
+
+        ok &= Check(sender.Connect("reap-hb"), "heartbeat: client-info accepted");
+        ok &= Check(sender.SendAudio(server.GetAudioDataPort(), firstSeq, count), "heartbeat: audio sent");
+
+        const std::string closeEvent = "close " + std::to_string(streamId) + " " +
+            std::to_string(static_cast<int>(hhcast::ESSessionCloseCause::HeartbeatTimeout)) + " 1";
+        ok &= Check(recorder->WaitFor(closeEvent, 3000), "heartbeat: session reaped with disconnected=1");
+        ok &= Check(sender.WaitPeerClosed(2000), "heartbeat: peer connection closed");
+
+        // 会话已经没了，再来的包直接丢
+        sender.SendAudio(server.GetAudioDataPort(), static_cast<uint16_t>(firstSeq + count), 5);
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+        const std::vector<std::string> events = recorder->Events();
+        ok &= Check(CheckOrder(events, streamId, firstSeq, count, closeEvent),
+                    "heartbeat: whole tail delivered before close, nothing after");
+    }
+
+    server.StopServer();
+    return ok;
+}
+
+// 定时出包打开，尾包在媒体超时之前就按时间放出；走旧接口
+static bool RunMediaTimeoutV1()
+{
+    hhcast::ESServerConfig config;
+    config.sessionTimeout.heartbeatTimeoutMs = 0;
+    config.sessionTimeout.mediaTimeoutMs = 400;
+    config.sessionTimeout.tickMs = 20;
+
+    auto recorder = std::make_shared<RecordingCallbackV1>();
+    hhcast::ESServer server;
+    server.SetConfig(config);
+    server.SetCallback(recorder);
+    if (!Check(server.StartServer() == 0, "media: server started")) {
+        return false;
+    }
+
+    bool ok = true;
+    {
+        FakeSender sender("127.0.0.22");
+        const std::string id = std::to_string(sender.StreamId());
+        const size_t count = 20;
+
+        ok &= Check(sender.Connect("reap-media"), "media: client-info accepted");
+        ok &= Check(sender.SendAudio(server.GetAudioDataPort(), 300, count), "media: audio sent");
+
+        // 还没到媒体超时，定时器已经把尾包放出来了
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+        std::vector<std::string> events = recorder->Events();
+        ok &= Check(events.size() == count, "media: poll timer releases tail while stream is idle");
+
+        const std::string closed = "closed " + id + " " +
+            std::to_string(static_cast<int>(hhcast::ESSessionCloseCause::MediaTimeout));
+        ok &= Check(recorder->WaitFor(closed, 3000), "media: session reaped");
+
+        events = recorder->Events();
+        ok &= Check(events.size() == count + 2 && events[count] == "disconnect " + id && events[count + 1] == closed,
+                    "media: V1 gets OnDisconnect then OnSessionClosed(MediaTimeout)");
+    }
+
+    server.StopServer();
+    return ok;
+}
+
+#endif
+
+} // namespace
+
+int main()
+{
+#ifdef __linux__
+    bool ok = true;
+    ok &= RunHeartbeatTimeout();
+    ok &= RunMediaTimeoutV1();
+
+    std::cout << "[SessionReapTest] " << (ok ? "all passed" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+#else
+    std::cout << "[SessionReapTest] skipped, linux only" << std::endl;
+    return 0;
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,431 @@
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "ESServer.h"
+#include "ESSession.h"
+#include "ESSessionTable.h"
+
+// 会话表并发压测，分两段：
+// 一、直接压 ESSessionTable：插入、移除、查找、快照各自多线程同时跑，检查
+//    1. 查到的会话 streamId 与键一致；
+//    2. 每个插入成功的会话只被 Remove 取到一次（重复关闭即失败）；
+//    3. 结束时 插入数 == 移除数 + 剩余数，Size 与之相符。
+// 二、起一个完整的 ESServer（Linux），多个发送端从 127.0.0.x 反复 client-info 建会话、同一连接上改名、
+//    发音频、断开；回调线程和旁观线程同时读会话的 GetName / GetPeerIp，检查
+//    1. 读到的名字属于该发送端，peerIp 与 streamId 一致；
+//    2. 每个 open 都有对应的 close，结束时会话表为空。
+//    占用 ESServer 的固定端口，不能和其他起服务的测试并行。
+// 配合 ThreadSanitizer 使用：cmake -DCMAKE_CXX_FLAGS=-fsanitize=thread 构建后运行，TSan 报告即视为失败。
+// 用法：esserver_session_table_stress [秒数]。返回 0 表示全部通过
+
+namespace {
+
+constexpr uint32_t kBaseStreamId = 0x0a000000;
+constexpr uint32_t kStreamIdCount = 64;     // 键集合小一些，保证大量碰撞
+constexpr int kInserters = 2;
+constexpr int kRemovers = 2;
+constexpr int kReaders = 4;
+
+static bool Check(bool condition, const char* name)
+{
+    if (!condition) {
+        std::cout << "[SessionTableStress] FAIL " << name << std::endl;
+    }
+    return condition;
+}
+
+static bool RunTableStress(int seconds)
+{
+    hhcast::ESSessionTable table;
+    std::atomic<bool> stop{ false };
+    std::atomic<uint64_t> inserted{ 0 };
+    std::atomic<uint64_t> removed{ 0 };
+    std::atomic<uint64_t> found{ 0 };
+    std::atomic<uint64_t> snapshots{ 0 };
+    std::atomic<uint64_t> mismatched{ 0 };
+    std::atomic<uint64_t> doubleClosed{ 0 };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kInserters; ++i) {
+        threads.emplace_back([&, i]() {
+            uint32_t seq = static_cast<uint32_t>(i);
+            while (!stop.load(std::memory_order_relaxed)) {
+                const uint32_t streamId = kBaseStreamId + (seq++ % kStreamIdCount);
+                auto session = std::make_shared<hhcast::ESSession>(streamId);
+                if (table.Insert(streamId, session) == session) {
+                    inserted.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+
+    for (int i = 0; i < kRemovers; ++i) {
+        threads.emplace_back([&, i]() {
+            uint32_t seq = static_cast<uint32_t>(i * 7);
+            while (!stop.load(std::memory_order_relaxed)) {
+                const uint32_t streamId = kBaseStreamId + (seq++ % kStreamIdCount);
+                hhcast::ESSessionPtr session = table.Remove(streamId);
+                if (!session) {
+                    continue;
+                }
+                if (session->IsClosed()) {
+                    doubleClosed.fetch_add(1, std::memory_order_relaxed);
+                }
+                session->MarkClosed();
+                removed.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    for (int i = 0; i < kReaders; ++i) {
+        threads.emplace_back([&, i]() {
+            uint32_t seq = static_cast<uint32_t>(i);
+            while (!stop.load(std::memory_order_relaxed)) {
+                const uint32_t streamId = kBaseStreamId + (seq++ % kStreamIdCount);
+                hhcast::ESSessionPtr session = table.Find(streamId);
+                if (!session) {
+                    continue;
+                }
+                if (session->GetStreamId() != streamId) {
+                    mismatched.fetch_add(1, std::memory_order_relaxed);
+                }
+                session->IsClosed();
+                found.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    threads.emplace_back([&]() {
+        while (!stop.load(std::memory_order_relaxed)) {
+            for (const auto& entry : table.Snapshot()) {
+                if (entry.second->GetStreamId() != entry.first) {
+                    mismatched.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            table.Size();
+            snapshots.fetch_add(1, std::memory_order_relaxed);
+            std::this_thread::yield();
+        }
+    });
+
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    stop.store(true);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    const size_t remaining = table.Size();
+    const std::vector<hhcast::ESSessionTable::Entry> rest = table.TakeAll();
+
+    std::cout << "[SessionTableStress] " << seconds << "s inserted=" << inserted << " removed=" << removed
+              << " remaining=" << rest.size() << " found=" << found << " snapshots=" << snapshots << std::endl;
+
+    bool ok = true;
+    ok &= Check(mismatched == 0, "found session matches its streamId");
+    ok &= Check(doubleClosed == 0, "each session removed once");
+    ok &= Check(inserted == removed + rest.size(), "inserted == removed + remaining");
+    ok &= Check(remaining == rest.size() && table.Size() == 0, "size matches contents");
+    ok &= Check(inserted > 0 && removed > 0 && found > 0, "all threads made progress");
+
+    return ok;
+}
+#ifdef __linux__
+
+constexpr int kServerSenders = 4;
+constexpr int kRenamesPerConnect = 4;
+constexpr size_t kAudioPerRename = 8;
+constexpr uint16_t kControlPort = 57395;
+
+static std::string SenderIp(int index)
+{
+    return "127.0.0." + std::to_string(40 + index);
+}
+
+static uint32_t ToStreamId(const std::string& ip)
+{
+    in_addr addr{};
+    inet_pton(AF_INET, ip.c_str(), &addr);
+    return ntohl(addr.s_addr);
+}
+
+// 名字格式 stress-<发送端序号>-<轮次>-<改名次数>，只看前缀就能认出归属
+static std::string SenderName(int index, uint32_t round, int rename)
+{
+    return "stress-" + std::to_string(index) + "-" + std::to_string(round) + "-" + std::to_string(rename);
+}
+
+static bool NameBelongsTo(const std::string& name, int index)
+{
+    const std::string prefix = "stress-" + std::to_string(index) + "-";
+    return name.compare(0, prefix.size(), prefix) == 0;
+}
+
+static int OpenSocket(int type, const std::string& sourceIp)
+{
+    const int fd = socket(AF_INET, type, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    sockaddr_in local{};
+    local.sin_family = AF_INET;
+    inet_pton(AF_INET, sourceIp.c_str(), &local.sin_addr);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&local), sizeof(local)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static sockaddr_in Loopback(uint16_t port)
+{
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    return addr;
+}
+
+// 发一行 client-info 并等应答，应答回来说明服务端已经改完名字
+static bool SendClientInfo(int fd, const std::string& name)
+{
+    const std::string line = "{\"clientName\":\"" + name + "\",\"clientType\":\"test\"}\n";
+    if (send(fd, line.data(), line.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(line.size())) {
+        return false;
+    }
+    char reply[4096];
+    pollfd pfd{ fd, POLLIN, 0 };
+    return poll(&pfd, 1, 2000) > 0 && recv(fd, reply, sizeof(reply), 0) > 0;
+}
+
+static void SendAudio(int fd, uint16_t dataPort, uint16_t& seq, size_t count)
+{
+    const sockaddr_in server = Loopback(dataPort);
+    for (size_t i = 0; i < count; ++i, ++seq) {
+        const uint32_t ts = static_cast<uint32_t>(seq) * 480;
+        uint8_t packet[12 + 160] = {};
+        packet[0] = 0x80;
+        packet[1] = 96;
+        packet[2] = static_cast<uint8_t>(seq >> 8);
+        packet[3] = static_cast<uint8_t>(seq);
+        packet[4] = static_cast<uint8_t>(ts >> 24);
+        packet[5] = static_cast<uint8_t>(ts >> 16);
+        packet[6] = static_cast<uint8_t>(ts >> 8);
+        packet[7] = static_cast<uint8_t>(ts);
+        packet[11] = 1;
+        sendto(fd, packet, sizeof(packet), 0, reinterpret_cast<const sockaddr*>(&server), sizeof(server));
+    }
+}
+
+// 回调线程上读会话字符串，打开的会话交给旁观线程继续读
+class StressCallback : public hhcast::IESServerCallbackV2 {
+public:
+    void OnSessionOpen(const hhcast::ESSessionOpenEvent& event) override
+    {
+        CheckSession(event.session, event.streamId);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_opened;
+        m_open[event.streamId] = event.session;
+    }
+
+    void OnSessionClose(const hhcast::ESSessionCloseEvent& event) override
+    {
+        CheckSession(event.session, event.streamId);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_closed;
+        ++m_closedById[event.streamId];
+        m_open.erase(event.streamId);
+        m_cond.notify_all();
+    }
+
+    void OnMediaBatch(const hhcast::ESMediaBatch& batch) override
+    {
+        for (const auto& event : batch.audio) {
+            CheckSession(event.session, event.streamId);
+            m_audio.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // 旁观线程：拿着还开着的会话反复读
+    void Observe()
+    {
+        std::vector<hhcast::ESSessionPtr> sessions;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (const auto& item : m_open) {
+                sessions.push_back(item.second);
+            }
+        }
+        for (const auto& session : sessions) {
+            CheckSession(session, session->GetStreamId());
+            session->IsClosed();
+        }
+        m_observed.fetch_add(sessions.size(), std::memory_order_relaxed);
+    }
+
+    bool WaitClosed(uint32_t streamId, uint64_t count, int timeoutMs)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        return m_cond.wait_for(lock, std::chrono::milliseconds(timeoutMs), [&]() {
+            return m_closedById[streamId] >= count;
+        });
+    }
+
+    uint64_t Opened()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_opened;
+    }
+
+    uint64_t Closed()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_closed;
+    }
+
+    uint64_t Audio() const { return m_audio.load(); }
+    uint64_t Observed() const { return m_observed.load(); }
+    uint64_t Mismatched() const { return m_mismatched.load(); }
+
+private:
+    void CheckSession(const hhcast::ESSessionPtr& session, uint32_t streamId)
+    {
+        const std::string name = session->GetName();
+        const std::string peerIp = session->GetPeerIp();
+        const int index = static_cast<int>(streamId - ToStreamId(SenderIp(0)));
+        if (session->GetStreamId() != streamId || index < 0 || index >= kServerSenders ||
+            peerIp != SenderIp(index) || !NameBelongsTo(name, index)) {
+            m_mismatched.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    uint64_t m_opened = 0;
+    uint64_t m_closed = 0;
+    std::unordered_map<uint32_t, uint64_t> m_closedById;
+    std::unordered_map<uint32_t, hhcast::ESSessionPtr> m_open;
+    std::atomic<uint64_t> m_audio{ 0 };
+    std::atomic<uint64_t> m_observed{ 0 };
+    std::atomic<uint64_t> m_mismatched{ 0 };
+};
+
+static bool RunServerStress(int seconds)
+{
+    hhcast::ESServerConfig config;
+    config.sessionTimeout.heartbeatTimeoutMs = 0;
+    config.sessionTimeout.mediaTimeoutMs = 0;
+
+    auto callback = std::make_shared<StressCallback>();
+    hhcast::ESServer server;
+    server.SetConfig(config);
+    server.SetCallbackV2(callback);
+    if (!Check(server.StartServer() == 0, "server started")) {
+        return false;
+    }
+    const uint16_t dataPort = server.GetAudioDataPort();
+
+    std::atomic<bool> stop{ false };
+    std::atomic<uint64_t> connects{ 0 };
+    std::atomic<uint64_t> failures{ 0 };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kServerSenders; ++i) {
+        threads.emplace_back([&, i]() {
+            const std::string sourceIp = SenderIp(i);
+            const uint32_t streamId = ToStreamId(sourceIp);
+            const int udp = OpenSocket(SOCK_DGRAM, sourceIp);
+            uint16_t seq = 0;
+            uint32_t round = 0;
+            while (udp >= 0 && !stop.load(std::memory_order_relaxed)) {
+                const int tcp = OpenSocket(SOCK_STREAM, sourceIp);
+                const sockaddr_in control = Loopback(kControlPort);
+                bool ok = tcp >= 0 &&
+                    connect(tcp, reinterpret_cast<const sockaddr*>(&control), sizeof(control)) == 0;
+                for (int rename = 0; ok && rename < kRenamesPerConnect; ++rename) {
+                    ok = SendClientInfo(tcp, SenderName(i, round, rename));
+                    SendAudio(udp, dataPort, seq, kAudioPerRename);
+                }
+                if (tcp >= 0) {
+                    close(tcp);
+                }
+                if (!ok) {
+                    failures.fetch_add(1, std::memory_order_relaxed);
+                    break;
+                }
+                connects.fetch_add(1, std::memory_order_relaxed);
+                // 同一源地址的旧连接断开会按 streamId 关会话，等它关完再连，免得关掉新会话
+                if (!callback->WaitClosed(streamId, ++round, 3000)) {
+                    failures.fetch_add(1, std::memory_order_relaxed);
+                    break;
+                }
+            }
+            if (udp >= 0) {
+                close(udp);
+            }
+        });
+    }
+
+    threads.emplace_back([&]() {
+        while (!stop.load(std::memory_order_relaxed)) {
+            callback->Observe();
+            server.GetSessionCount();
+            std::this_thread::yield();
+        }
+    });
+
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    stop.store(true);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::cout << "[SessionTableStress] server " << seconds << "s connects=" << connects
+              << " opened=" << callback->Opened() << " closed=" << callback->Closed()
+              << " audio=" << callback->Audio() << " observed=" << callback->Observed() << std::endl;
+
+    bool ok = true;
+    ok &= Check(failures == 0, "every sender round completed");
+    ok &= Check(callback->Mismatched() == 0, "session name and peerIp match the sender");
+    ok &= Check(callback->Opened() == callback->Closed() && callback->Opened() == connects,
+                "every open has one close");
+    ok &= Check(server.GetSessionCount() == 0, "no session left");
+    ok &= Check(connects > 0 && callback->Audio() > 0 && callback->Observed() > 0, "server threads made progress");
+
+    server.StopServer();
+    return ok;
+}
+
+#endif
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int seconds = (argc > 1) ? std::atoi(argv[1]) : 2;
+
+    bool ok = RunTableStress(seconds);
+#ifdef __linux__
+    ok &= RunServerStress(seconds);
+#endif
+
+    std::cout << "[SessionTableStress] " << (ok ? "all passed" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,426 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "ESServerConfig.h"
+#include "ESSocketTuning.h"
+
+// 51030 套接字调参的本地压测：按 ESPortManager 的方式开 N 个 SO_REUSEPORT 监听（可挂 steering），
+// 监听和接入连接都套用 ESSocketOptions，每个分片一个线程 accept + 读；
+// 多个客户端从不同的 127.0.0.x 源地址连进来灌数据，输出各分片的连接/字节分布、吞吐和读回的实际选项。
+// 不带参数时跑一组对照配置并检查：数据全部收到、PeerIp steering 下同一源地址固定落在同一分片、
+// 缓冲区设置确实生效。也可以用参数跑单个配置：
+//   esserver_socket_load_test shards=4 steering=peer conns=16 mb=64 write=65536 rcvbuf=4194304
+//                             sndbuf=0 nodelay=1 quickack=1 busypoll=0
+// 返回 0 表示全部通过
+
+namespace {
+
+struct LoadConfig {
+    std::string name = "custom";
+    size_t shards = 1;
+    hhcast::ESReusePortSteering steering = hhcast::ESReusePortSteering::Kernel;
+    size_t connections = 8;
+    size_t megabytesPerConnection = 32;
+    size_t writeSize = 64 * 1024;
+    hhcast::ESSocketOptions options;
+};
+
+struct LoadResult {
+    bool ok = true;
+    double seconds = 0.0;
+    uint64_t totalBytes = 0;
+    std::vector<uint64_t> shardBytes;
+    std::vector<uint32_t> shardConnections;
+    std::map<uint32_t, size_t> sourceShard;   // 源地址 -> 分片，出现第二个分片时记为 SIZE_MAX
+    std::string listenerOptions;
+    std::string acceptedOptions;
+};
+
+#ifdef __linux__
+
+constexpr uint16_t kBasePort = 52300;
+constexpr size_t kSourceCount = 8;
+
+static uint32_t SourceAddress(size_t index)
+{
+    return 0x7f000002u + static_cast<uint32_t>(index % kSourceCount);   // 127.0.0.2 起
+}
+
+static int ConnectFrom(uint32_t source, uint16_t port, const hhcast::ESSocketOptions& options)
+{
+    const int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    // 发送端只套用缓冲区大小和 NODELAY，模拟对端的普通设置
+    hhcast::ESSocketOptions clientOptions;
+    clientOptions.sendBufferBytes = options.sendBufferBytes;
+    clientOptions.tcpNoDelay = options.tcpNoDelay;
+    hhcast::ApplySocketOptions(fd, clientOptions, true, "load client");
+
+    sockaddr_in local{};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(source);
+    sockaddr_in remote{};
+    remote.sin_family = AF_INET;
+    remote.sin_port = htons(port);
+    remote.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (bind(fd, reinterpret_cast<sockaddr*>(&local), sizeof(local)) != 0 ||
+        connect(fd, reinterpret_cast<sockaddr*>(&remote), sizeof(remote)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// 一个分片：poll 监听 fd 和已接入的连接，读到的数据直接丢弃
+static void ShardLoop(int listenfd, const hhcast::ESSocketOptions& options, size_t shard,
+                      std::atomic<bool>& running, LoadResult& result, std::mutex& resultMutex)
+{
+    std::vector<pollfd> fds;
+    fds.push_back({ listenfd, POLLIN, 0 });
+    std::vector<char> buffer(256 * 1024);
+
+    while (running.load()) {
+        if (poll(fds.data(), fds.size(), 20) <= 0) {
+            continue;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            sockaddr_in peer{};
+            socklen_t len = sizeof(peer);
+            const int fd = accept(listenfd, reinterpret_cast<sockaddr*>(&peer), &len);
+            if (fd >= 0) {
+                hhcast::ApplySocketOptions(fd, options, true, "load accept");
+                fds.push_back({ fd, POLLIN, 0 });
+
+                std::lock_guard<std::mutex> lock(resultMutex);
+                ++result.shardConnections[shard];
+                const uint32_t source = ntohl(peer.sin_addr.s_addr);
+                auto it = result.sourceShard.find(source);
+                if (it == result.sourceShard.end()) {
+                    result.sourceShard[source] = shard;
+                } else if (it->second != shard) {
+                    it->second = SIZE_MAX;
+                }
+                if (result.acceptedOptions.empty()) {
+                    result.acceptedOptions = hhcast::DescribeSocketOptions(fd, true);
+                }
+            }
+        }
+
+        for (size_t i = 1; i < fds.size();) {
+            if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+                const ssize_t n = recv(fds[i].fd, buffer.data(), buffer.size(), 0);
+                if (n > 0) {
+                    if (options.tcpQuickAck) {
+                        hhcast::RearmTcpQuickAck(fds[i].fd);
+                    }
+                    std::lock_guard<std::mutex> lock(resultMutex);
+                    result.shardBytes[shard] += static_cast<uint64_t>(n);
+                } else {
+                    close(fds[i].fd);
+                    fds.erase(fds.begin() + static_cast<std::ptrdiff_t>(i));
+                    continue;
+                }
+            }
+            ++i;
+        }
+    }
+
+    for (size_t i = 1; i < fds.size(); ++i) {
+        close(fds[i].fd);
+    }
+}
+
+static LoadResult RunLoad(const LoadConfig& config, uint16_t port)
+{
+    LoadResult result;
+    result.shardBytes.assign(config.shards, 0);
+    result.shardConnections.assign(config.shards, 0);
+
+    std::vector<int> listenfds;
+    for (size_t i = 0; i < config.shards; ++i) {
+        const int fd = hhcast::CreateReusePortListener(port, "127.0.0.1");
+        if (fd < 0) {
+            for (int opened : listenfds) {
+                hhcast::CloseSocketFd(opened);
+            }
+            result.ok = false;
+            return result;
+        }
+        hhcast::ApplySocketOptions(fd, config.options, true, "load listen");
+        listenfds.push_back(fd);
+    }
+    result.listenerOptions = hhcast::DescribeSocketOptions(listenfds.front(), true);
+
+    if (config.shards > 1 &&
+        !hhcast::AttachReusePortSteering(listenfds.front(), config.steering, config.shards)) {
+        std::cout << "[SocketLoadTest] steering not attached, kernel hash in use" << std::endl;
+    }
+
+    std::atomic<bool> running{ true };
+    std::mutex resultMutex;
+    std::vector<std::thread> shards;
+    for (size_t i = 0; i < config.shards; ++i) {
+        shards.emplace_back(ShardLoop, listenfds[i], std::cref(config.options), i,
+                            std::ref(running), std::ref(result), std::ref(resultMutex));
+    }
+
+    const uint64_t bytesPerConnection = static_cast<uint64_t>(config.megabytesPerConnection) * 1024 * 1024;
+    const auto begin = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> clients;
+    std::atomic<uint64_t> sent{ 0 };
+    for (size_t c = 0; c < config.connections; ++c) {
+        clients.emplace_back([&, c]() {
+            const int fd = ConnectFrom(SourceAddress(c), port, config.options);
+            if (fd < 0) {
+                return;
+            }
+            std::vector<char> payload(config.writeSize, static_cast<char>(c));
+            uint64_t remain = bytesPerConnection;
+            while (remain > 0) {
+                const size_t chunk = static_cast<size_t>(std::min<uint64_t>(remain, payload.size()));
+                const ssize_t n = send(fd, payload.data(), chunk, MSG_NOSIGNAL);
+                if (n <= 0) {
+                    break;
+                }
+                remain -= static_cast<uint64_t>(n);
+                sent += static_cast<uint64_t>(n);
+            }
+            close(fd);
+        });
+    }
+    for (auto& client : clients) {
+        client.join();
+    }
+
+    // 等服务端读完
+    const uint64_t expected = bytesPerConnection * config.connections;
+    for (int i = 0; i < 500; ++i) {
+        uint64_t received = 0;
+        {
+            std::lock_guard<std::mutex> lock(resultMutex);
+            for (uint64_t bytes : result.shardBytes) {
+                received += bytes;
+            }
+        }
+        if (received >= expected) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    running = false;
+    for (auto& shard : shards) {
+        shard.join();
+    }
+    for (int fd : listenfds) {
+        hhcast::CloseSocketFd(fd);
+    }
+
+    for (uint64_t bytes : result.shardBytes) {
+        result.totalBytes += bytes;
+    }
+    result.ok = (sent.load() == expected && result.totalBytes == expected);
+    return result;
+}
+
+static const char* SteeringName(hhcast::ESReusePortSteering steering)
+{
+    switch (steering) {
+    case hhcast::ESReusePortSteering::PeerIp:
+        return "peer";
+    case hhcast::ESReusePortSteering::Cpu:
+        return "cpu";
+    default:
+        return "kernel";
+    }
+}
+
+static void Report(const LoadConfig& config, const LoadResult& result)
+{
+    const double mb = static_cast<double>(result.totalBytes) / (1024.0 * 1024.0);
+    std::cout << "[SocketLoadTest] " << config.name << ": shards=" << config.shards
+              << " steering=" << SteeringName(config.steering)
+              << " conns=" << config.connections << " write=" << config.writeSize
+              << " -> " << mb << "MB in " << result.seconds << "s, "
+              << (result.seconds > 0 ? mb / result.seconds : 0.0) << "MB/s" << std::endl;
+
+    std::cout << "[SocketLoadTest]   per shard conns/MB:";
+    for (size_t i = 0; i < config.shards; ++i) {
+        std::cout << " " << result.shardConnections[i] << "/"
+                  << static_cast<double>(result.shardBytes[i]) / (1024.0 * 1024.0);
+    }
+    std::cout << std::endl;
+    std::cout << "[SocketLoadTest]   listener " << result.listenerOptions << std::endl;
+    std::cout << "[SocketLoadTest]   accepted " << result.acceptedOptions << std::endl;
+}
+
+static bool ReadIntOption(int fd, int level, int name, int& value)
+{
+    socklen_t len = sizeof(value);
+    return getsockopt(fd, level, name, &value, &len) == 0;
+}
+
+static bool Check(bool condition, const std::string& name)
+{
+    std::cout << "[SocketLoadTest] " << (condition ? "PASS " : "FAIL ") << name << std::endl;
+    return condition;
+}
+
+static bool RunMatrix()
+{
+    bool ok = true;
+    uint16_t port = kBasePort;
+
+    LoadConfig baseline;
+    baseline.name = "single listener, default options";
+    LoadResult result = RunLoad(baseline, port++);
+    Report(baseline, result);
+    ok &= Check(result.ok, baseline.name + ": all bytes received");
+
+    LoadConfig buffers = baseline;
+    buffers.name = "single listener, 4MB rcvbuf + nodelay + quickack";
+    buffers.options.recvBufferBytes = 4 * 1024 * 1024;
+    buffers.options.sendBufferBytes = 1024 * 1024;
+    buffers.options.tcpNoDelay = true;
+    buffers.options.tcpQuickAck = true;
+    result = RunLoad(buffers, port++);
+    Report(buffers, result);
+    ok &= Check(result.ok, buffers.name + ": all bytes received");
+
+    // 设置值受 net.core.rmem_max 限制，只检查确实比默认值大
+    const int probe = socket(AF_INET, SOCK_STREAM, 0);
+    int defaultRcv = 0;
+    int tunedRcv = 0;
+    ReadIntOption(probe, SOL_SOCKET, SO_RCVBUF, defaultRcv);
+    hhcast::ApplySocketOptions(probe, buffers.options, true, "load probe");
+    ReadIntOption(probe, SOL_SOCKET, SO_RCVBUF, tunedRcv);
+    close(probe);
+    ok &= Check(tunedRcv > defaultRcv, "SO_RCVBUF takes effect");
+
+    LoadConfig peer = buffers;
+    peer.name = "4 reuseport shards, peer-ip steering";
+    peer.shards = 4;
+    peer.steering = hhcast::ESReusePortSteering::PeerIp;
+    peer.connections = 16;
+    result = RunLoad(peer, port++);
+    Report(peer, result);
+    ok &= Check(result.ok, peer.name + ": all bytes received");
+    bool sticky = !result.sourceShard.empty();
+    for (const auto& kv : result.sourceShard) {
+        sticky &= (kv.second == kv.first % peer.shards);
+    }
+    ok &= Check(sticky, peer.name + ": each source stays on shard ip % N");
+
+    LoadConfig kernel = peer;
+    kernel.name = "4 reuseport shards, kernel hash";
+    kernel.steering = hhcast::ESReusePortSteering::Kernel;
+    result = RunLoad(kernel, port++);
+    Report(kernel, result);
+    ok &= Check(result.ok, kernel.name + ": all bytes received");
+
+    LoadConfig small = buffers;
+    small.name = "single listener, 1KB writes with nodelay";
+    small.writeSize = 1024;
+    small.megabytesPerConnection = 8;
+    result = RunLoad(small, port++);
+    Report(small, result);
+    ok &= Check(result.ok, small.name + ": all bytes received");
+
+    return ok;
+}
+
+static bool ParseArgs(int argc, char** argv, LoadConfig& config)
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const size_t eq = arg.find('=');
+        if (eq == std::string::npos) {
+            return false;
+        }
+
+        const std::string key = arg.substr(0, eq);
+        const std::string value = arg.substr(eq + 1);
+        const long number = std::strtol(value.c_str(), nullptr, 10);
+        if (key == "shards") {
+            config.shards = static_cast<size_t>(std::max(1L, number));
+        } else if (key == "steering") {
+            config.steering = (value == "peer") ? hhcast::ESReusePortSteering::PeerIp
+                            : (value == "cpu")  ? hhcast::ESReusePortSteering::Cpu
+                                                : hhcast::ESReusePortSteering::Kernel;
+        } else if (key == "conns") {
+            config.connections = static_cast<size_t>(std::max(1L, number));
+        } else if (key == "mb") {
+            config.megabytesPerConnection = static_cast<size_t>(std::max(1L, number));
+        } else if (key == "write") {
+            config.writeSize = static_cast<size_t>(std::max(1L, number));
+        } else if (key == "rcvbuf") {
+            config.options.recvBufferBytes = static_cast<int>(number);
+        } else if (key == "sndbuf") {
+            config.options.sendBufferBytes = static_cast<int>(number);
+        } else if (key == "nodelay") {
+            config.options.tcpNoDelay = number != 0;
+        } else if (key == "quickack") {
+            config.options.tcpQuickAck = number != 0;
+        } else if (key == "busypoll") {
+            config.options.busyPollUs = static_cast<int>(number);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+#endif // __linux__
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+#ifdef __linux__
+    if (argc > 1) {
+        LoadConfig config;
+        if (!ParseArgs(argc, argv, config)) {
+            std::cout << "[SocketLoadTest] usage: shards=N steering=kernel|peer|cpu conns=N mb=N write=N "
+                         "rcvbuf=N sndbuf=N nodelay=0|1 quickack=0|1 busypoll=N" << std::endl;
+            return 1;
+        }
+        const LoadResult result = RunLoad(config, kBasePort);
+        Report(config, result);
+        return result.ok ? 0 : 1;
+    }
+
+    const bool ok = RunMatrix();
+    std::cout << "[SocketLoadTest] " << (ok ? "all passed" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+#else
+    (void)argc;
+    (void)argv;
+    std::cout << "[SocketLoadTest] SO_REUSEPORT sharding is Linux only, skipped" << std::endl;
+    return 0;
+#endif
+}
\ No newline at end of file
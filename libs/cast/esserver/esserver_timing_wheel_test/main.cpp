@@ -0,0 +1,122 @@
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "ESTimingWheel.h"
+
+// 时间轮自测：随机调度/取消/推进，与按到期 tick 记录的简单模型逐步比对，
+// 覆盖各层级联、超出四层范围的长延时、一次推进很多 tick，以及回调里重新调度。返回 0 表示全部通过
+
+namespace {
+
+static bool Check(bool condition, const char* name)
+{
+    if (!condition) {
+        std::cout << "[TimingWheelTest] FAIL " << name << std::endl;
+    }
+    return condition;
+}
+
+static uint64_t DelayTicks(uint64_t delayMs, uint32_t tickMs)
+{
+    const uint64_t ticks = (delayMs + tickMs - 1) / tickMs;
+    return (ticks == 0) ? 1 : ticks;
+}
+
+static bool RunModelRound(std::mt19937_64& rng)
+{
+    const uint32_t tickMs = 1 + static_cast<uint32_t>(rng() % 50);
+    hhcast::ESTimingWheel wheel(tickMs);
+    std::map<uint64_t, uint64_t> model;   // key -> 到期 tick
+
+    const uint64_t startMs = 1000 + rng() % 1000;
+    uint64_t nowMs = startMs;
+    wheel.Advance(nowMs, nullptr);
+
+    for (int step = 0; step < 100000; ++step) {
+        const int op = static_cast<int>(rng() % 10);
+        const uint64_t key = rng() % 500;
+
+        if (op < 4) {
+            uint64_t delayMs = rng() % (tickMs * 200ull);
+            if (rng() % 4 == 0) {
+                delayMs = rng() % (tickMs * 300000ull);
+            } else if (rng() % 64 == 0) {
+                delayMs = rng() % (tickMs * 20000000ull);   // 超过 64^4 个 tick
+            }
+            wheel.Schedule(key, delayMs, nowMs);
+            model[key] = (nowMs - startMs) / tickMs + DelayTicks(delayMs, tickMs);
+        } else if (op < 5) {
+            const bool cancelled = wheel.Cancel(key);
+            if (!Check(cancelled == (model.erase(key) == 1), "cancel result matches model")) {
+                return false;
+            }
+        } else {
+            nowMs += (rng() % 8 == 0) ? rng() % (tickMs * 5000ull) : rng() % (tickMs * 3ull);
+            const uint64_t nowTick = (nowMs - startMs) / tickMs;
+
+            bool ok = true;
+            wheel.Advance(nowMs, [&](uint64_t expired) {
+                auto it = model.find(expired);
+                ok &= (it != model.end() && it->second <= nowTick);
+                if (it != model.end()) {
+                    model.erase(it);
+                }
+            });
+            if (!Check(ok, "expired keys were due")) {
+                return false;
+            }
+            for (const auto& kv : model) {
+                if (!Check(kv.second > nowTick, "no due key left pending")) {
+                    return false;
+                }
+            }
+        }
+
+        if (!Check(wheel.GetPendingCount() == model.size(), "pending count matches model")) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool RunRescheduleInCallback()
+{
+    hhcast::ESTimingWheel wheel(10);
+    uint64_t nowMs = 0;
+    wheel.Schedule(1, 100, nowMs);
+
+    std::vector<uint64_t> fireTimes;
+    for (nowMs = 0; nowMs <= 1000; nowMs += 10) {
+        wheel.Advance(nowMs, [&](uint64_t key) {
+            fireTimes.push_back(nowMs);
+            if (fireTimes.size() < 5) {
+                wheel.Schedule(key, 100, nowMs);
+            }
+        });
+    }
+
+    bool ok = Check(fireTimes.size() == 5, "periodic reschedule fires five times");
+    for (size_t i = 0; ok && i < fireTimes.size(); ++i) {
+        ok &= Check(fireTimes[i] == (i + 1) * 100, "periodic reschedule fires on time");
+    }
+    ok &= Check(wheel.GetPendingCount() == 0, "nothing left after last fire");
+    return ok;
+}
+
+} // namespace
+
+int main()
+{
+    bool ok = true;
+    std::mt19937_64 rng(7);
+    for (int round = 0; round < 10; ++round) {
+        ok &= RunModelRound(rng);
+    }
+    ok &= RunRescheduleInCallback();
+
+    std::cout << "[TimingWheelTest] " << (ok ? "all passed" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
\ No newline at end of file
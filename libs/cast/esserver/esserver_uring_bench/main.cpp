@@ -0,0 +1,314 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "ESConnectionContext.h"
+#include "ESUring.h"
+#include "ESUdpBatchReceiver.h"
+#include "ESUringTcpReceiver.h"
+
+// 收包路径的系统调用计数基准，回环上发固定数量的包，比较每帧/每包花掉的收包系统调用：
+// 1. TCP 51030：epoll_wait + read（hv 的收法）对比 ESUringTcpReceiver（multishot recv，计 io_uring_enter）；
+// 2. UDP 音频：recvfrom 逐包、ESUdpBatchReceiver 的 recvmmsg、以及 io_uring multishot recvmsg。
+// 内核不支持 io_uring（或被 seccomp 禁掉）时跳过对应一行，不算失败。
+// ns/unit 是含发送方在内的墙钟时间，回环上主要反映发送速度，只作参考；要看的是 syscalls/unit。
+// 用法：esserver_uring_bench [TCP 帧数] [帧负载字节] [UDP 包数]。返回 0 表示各路都收齐
+
+namespace {
+
+constexpr size_t kVideoHeaderSize = 128;
+constexpr size_t kDatagramSize = 1024;
+
+struct Result {
+    uint64_t units = 0;
+    uint64_t syscalls = 0;
+    double seconds = 0;
+};
+
+static void Report(const char* name, const Result& result)
+{
+    const double units = static_cast<double>(result.units ? result.units : 1);
+    std::cout << "[UringBench] " << name << " units=" << result.units
+              << " syscalls=" << result.syscalls
+              << " syscalls/unit=" << static_cast<double>(result.syscalls) / units
+              << " ns/unit=" << result.seconds * 1e9 / units << std::endl;
+}
+
+static int CreateTcpListener(uint16_t& port)
+{
+    const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    if (fd < 0 || ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(fd, 16) != 0 ||
+        ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        return -1;
+    }
+    port = ntohs(addr.sin_port);
+    return fd;
+}
+
+// 按 51030 的格式发：128 字节头（小端负载长度 + 类型）+ 负载，一帧一次 write
+static void SendFrames(uint16_t port, int frames, size_t payloadSize)
+{
+    const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return;
+    }
+
+    std::vector<uint8_t> frame(kVideoHeaderSize + payloadSize, 0x5a);
+    const uint32_t payloadLen = static_cast<uint32_t>(payloadSize);
+    const uint32_t kind = 0x00000101;
+    std::memcpy(frame.data(), &payloadLen, 4);
+    std::memcpy(frame.data() + 4, &kind, 4);
+
+    for (int i = 0; i < frames; ++i) {
+        size_t offset = 0;
+        while (offset < frame.size()) {
+            const ssize_t n = ::send(fd, frame.data() + offset, frame.size() - offset, MSG_NOSIGNAL);
+            if (n <= 0) {
+                ::close(fd);
+                return;
+            }
+            offset += static_cast<size_t>(n);
+        }
+    }
+    ::close(fd);
+}
+
+static Result RunTcpEpoll(int frames, size_t payloadSize)
+{
+    Result result;
+    uint16_t port = 0;
+    const int listenfd = CreateTcpListener(port);
+    if (listenfd < 0) {
+        return result;
+    }
+
+    const uint64_t expected = static_cast<uint64_t>(frames) * (kVideoHeaderSize + payloadSize);
+    const auto start = std::chrono::steady_clock::now();
+    std::thread sender(SendFrames, port, frames, payloadSize);
+
+    const int connfd = ::accept4(listenfd, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+    const int epfd = ::epoll_create1(EPOLL_CLOEXEC);
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = connfd;
+    ::epoll_ctl(epfd, EPOLL_CTL_ADD, connfd, &ev);
+
+    // 与 hv 一样：每次可读事件读一次，读缓冲 64KB
+    std::vector<uint8_t> buffer(64 * 1024);
+    uint64_t received = 0;
+    bool open = true;
+    while (open && received < expected) {
+        epoll_event out{};
+        ++result.syscalls;
+        if (::epoll_wait(epfd, &out, 1, 1000) <= 0) {
+            break;
+        }
+        ++result.syscalls;
+        const ssize_t n = ::read(connfd, buffer.data(), buffer.size());
+        if (n > 0) {
+            received += static_cast<uint64_t>(n);
+        } else if (n == 0) {
+            open = false;
+        }
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    sender.join();
+    ::close(epfd);
+    ::close(connfd);
+    ::close(listenfd);
+    result.units = received / (kVideoHeaderSize + payloadSize);
+    return result;
+}
+
+static Result RunTcpUring(int frames, size_t payloadSize)
+{
+    Result result;
+    uint16_t port = 0;
+    const int listenfd = CreateTcpListener(port);
+    if (listenfd < 0) {
+        return result;
+    }
+
+    std::atomic<uint64_t> received{ 0 };
+    hhcast::ESUringTcpReceiver receiver;
+    receiver.SetCallbacks(
+        [](int, uint32_t) {
+            return std::make_shared<hhcast::ESConnectionContext>();
+        },
+        [&received](int, hhcast::ESConnectionContext&, const uint8_t*, size_t size) {
+            received.fetch_add(size, std::memory_order_relaxed);
+            return true;
+        },
+        [](hhcast::ESConnectionContext&) {});
+
+    // 与 ESPortManager 默认的视频缓冲环一致
+    if (receiver.Start(listenfd, 256, 64 * 1024, -1) != 0) {
+        return result;
+    }
+
+    const uint64_t expected = static_cast<uint64_t>(frames) * (kVideoHeaderSize + payloadSize);
+    const auto start = std::chrono::steady_clock::now();
+    SendFrames(port, frames, payloadSize);
+    while (received.load() < expected &&
+           std::chrono::steady_clock::now() - start < std::chrono::seconds(10)) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    receiver.Stop();
+
+    result.syscalls = receiver.GetStats().enterCount;
+    result.units = received.load() / (kVideoHeaderSize + payloadSize);
+    return result;
+}
+
+static void SendDatagrams(uint16_t port, int count)
+{
+    const int fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    std::vector<uint8_t> datagram(kDatagramSize, 0x33);
+    for (int i = 0; i < count; ++i) {
+        ::sendto(fd, datagram.data(), datagram.size(), 0, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        // 回环上发得比收得快，每批稍歇一下，免得 socket 队列溢出把结果变成丢包数
+        if (i % 32 == 31) {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+    ::close(fd);
+}
+
+static Result RunUdpRecvfrom(int count)
+{
+    Result result;
+    const int fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    const int rcvbuf = 4 * 1024 * 1024;
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    timeval timeout{ 0, 200 * 1000 };
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+
+    const uint16_t port = ntohs(addr.sin_port);
+    std::atomic<bool> sent{ false };
+    const auto start = std::chrono::steady_clock::now();
+    std::thread sender([port, count, &sent]() {
+        SendDatagrams(port, count);
+        sent = true;
+    });
+
+    // 超时只说明队列暂时空了；发送方结束后再超时才算收完（其余的被内核丢了）
+    std::vector<uint8_t> buffer(2048);
+    while (result.units < static_cast<uint64_t>(count)) {
+        ++result.syscalls;
+        if (::recvfrom(fd, buffer.data(), buffer.size(), 0, nullptr, nullptr) > 0) {
+            ++result.units;
+        } else if (sent.load()) {
+            break;
+        }
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    sender.join();
+    ::close(fd);
+    return result;
+}
+
+static Result RunUdpBatch(int count, bool useIoUring, bool& usedIoUring)
+{
+    Result result;
+    std::atomic<uint64_t> received{ 0 };
+    hhcast::ESUdpBatchReceiver receiver;
+    receiver.SetCallback([&received](const hhcast::ESUdpDatagram*, size_t n) {
+        received.fetch_add(n, std::memory_order_relaxed);
+    });
+    if (receiver.Start(0, 32, 2048, false, useIoUring) != 0) {
+        return result;
+    }
+    usedIoUring = receiver.IsUsingIoUring();
+
+    const auto start = std::chrono::steady_clock::now();
+    SendDatagrams(receiver.GetLocalPort(), count);
+    while (received.load() < static_cast<uint64_t>(count) &&
+           std::chrono::steady_clock::now() - start < std::chrono::seconds(10)) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    receiver.Stop();
+
+    result.units = received.load();
+    result.syscalls = receiver.GetBatchCount();
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int frames = (argc > 1) ? std::atoi(argv[1]) : 20000;
+    const size_t payloadSize = (argc > 2) ? static_cast<size_t>(std::atoi(argv[2])) : 16 * 1024;
+    const int datagrams = (argc > 3) ? std::atoi(argv[3]) : 50000;
+
+    const bool uringSupported = hhcast::ESUring::IsSupported();
+    std::cout << "[UringBench] io_uring " << (uringSupported ? "supported" : "not supported, uring rows skipped")
+              << ", frames=" << frames << " payload=" << payloadSize << " datagrams=" << datagrams << std::endl;
+
+    bool ok = true;
+
+    const Result tcpEpoll = RunTcpEpoll(frames, payloadSize);
+    Report("tcp epoll+read  ", tcpEpoll);
+    ok &= (tcpEpoll.units == static_cast<uint64_t>(frames));
+
+    if (uringSupported) {
+        const Result tcpUring = RunTcpUring(frames, payloadSize);
+        Report("tcp io_uring    ", tcpUring);
+        ok &= (tcpUring.units == static_cast<uint64_t>(frames));
+    }
+
+    const Result udpRecvfrom = RunUdpRecvfrom(datagrams);
+    Report("udp recvfrom    ", udpRecvfrom);
+
+    bool usedIoUring = false;
+    const Result udpBatch = RunUdpBatch(datagrams, false, usedIoUring);
+    Report("udp recvmmsg    ", udpBatch);
+    ok &= (udpBatch.units > 0);
+
+    if (uringSupported) {
+        const Result udpUring = RunUdpBatch(datagrams, true, usedIoUring);
+        Report(usedIoUring ? "udp io_uring    " : "udp io_uring(fallback)", udpUring);
+        ok &= (udpUring.units > 0);
+    }
+
+    std::cout << "[UringBench] " << (ok ? "all received" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+namespace hhcast {
+
+// 令牌桶限速，0 表示该维度不限
+struct ESRateLimit {
+    uint64_t bytesPerSec = 0;
+    uint64_t burstBytes = 0;           // 0 = 一秒的量
+    uint32_t packetsPerSec = 0;        // TCP 按 read 次数计，UDP 按 datagram 计
+    uint32_t burstPackets = 0;         // 0 = 一秒的量
+
+    bool IsLimited() const { return bytesPerSec > 0 || packetsPerSec > 0; }
+};
+
+enum class ESPortClass {
+    Control,                           // 8700/8121/57395/8600/51040/5202x
+    Video,                             // 51030
+    Udp,                               // 51050、数据/控制 UDP 端口
+};
+
+struct ESAdmissionConfig {
+    bool enabled = true;
+
+    uint32_t maxConnections = 512;     // 所有 TCP 端口合计，0 不限
+    uint32_t maxConnectionsPerIp = 32; // 单个对端 IP 合计，0 不限
+
+    // 按对端 IP 计：TCP 每条连接一个桶，UDP 同一 IP 共用一个桶
+    ESRateLimit control;
+    ESRateLimit video;
+    ESRateLimit udp;
+
+    uint32_t logIntervalMs = 5000;     // 同类拒绝日志的最小间隔，期间的次数汇总到下一条
+};
+
+struct ESAdmissionStats {
+    uint64_t accepted = 0;
+    uint64_t rejectedGlobal = 0;       // 超过 maxConnections
+    uint64_t rejectedPerIp = 0;        // 超过 maxConnectionsPerIp
+    uint64_t closedByRate = 0;         // TCP 超速被断开
+    uint64_t droppedDatagrams = 0;     // UDP 超速丢弃
+    uint64_t droppedBytes = 0;
+    uint32_t activeConnections = 0;
+};
+
+// 不是线程安全的，由持有者（连接上下文、ESAdmissionControl）保证单线程访问
+class ESTokenBucket {
+public:
+    void Configure(uint64_t ratePerSec, uint64_t burst);
+    bool IsLimited() const;
+
+    // 令牌不足时不扣减，返回 false；tokens 超过 burst 时按 burst 计
+    bool Consume(uint64_t tokens, uint64_t nowUs);
+
+private:
+    double m_ratePerUs = 0.0;
+    double m_burst = 0.0;
+    double m_tokens = 0.0;
+    uint64_t m_lastUs = 0;
+};
+
+// 字节和包两个维度，任一不足即拒绝
+class ESRateLimiter {
+public:
+    void Configure(const ESRateLimit& limit);
+    bool IsLimited() const;
+    bool Allow(size_t bytes, uint64_t nowUs);
+
+private:
+    ESTokenBucket m_bytes;
+    ESTokenBucket m_packets;
+};
+
+// 连接数上限 + UDP 按源 IP 限速 + 拒绝计数。可跨线程调用。
+// 在 accept / 收包入口、解析之前调用；TCP 的限速桶放在连接上下文里，用 MakeTcpLimiter 初始化。
+class ESAdmissionControl {
+public:
+    static constexpr size_t kMaxTrackedUdpPeers = 4096;
+
+    // IPv6 或解析失败的对端地址（IPToStreamID 返回 0）。这些对端互不相干，不能共用一个名额，
+    // 所以不受单 IP 连接数和 UDP 单 IP 限速约束，只计入 maxConnections
+    static constexpr uint32_t kUnknownPeerIp = 0;
+
+    void SetConfig(const ESAdmissionConfig& config);
+    const ESAdmissionConfig& GetConfig() const;
+
+    // 成功时调用方在断开时必须 ReleaseConnection
+    bool TryAcquireConnection(uint32_t peerIp, uint16_t localPort, uint64_t nowMs);
+    void ReleaseConnection(uint32_t peerIp);
+
+    ESRateLimiter MakeTcpLimiter(ESPortClass portClass) const;
+    // TCP 超速断开时调用，只做计数和限频日志
+    void OnTcpRateExceeded(uint32_t peerIp, uint16_t localPort, uint64_t nowMs);
+
+    bool AllowDatagram(uint32_t peerIp, uint16_t localPort, size_t bytes, uint64_t nowUs);
+
+    ESAdmissionStats GetStats() const;
+    void Reset();
+
+private:
+    // 同一类拒绝在 logIntervalMs 内只打一条，期间被压下的次数带在下一条里
+    struct LogThrottle {
+        std::atomic<uint64_t> lastMs{ 0 };
+        std::atomic<uint64_t> suppressed{ 0 };
+    };
+
+    void LogRejected(LogThrottle& throttle, const char* reason, uint32_t peerIp, uint16_t localPort, uint64_t nowMs);
+
+private:
+    ESAdmissionConfig m_config;
+
+    mutable std::mutex m_connectionsMutex;
+    std::unordered_map<uint32_t, uint32_t> m_connectionsPerIp;
+    uint32_t m_activeConnections = 0;
+
+    std::mutex m_udpMutex;
+    std::unordered_map<uint32_t, ESRateLimiter> m_udpLimiters;
+
+    std::atomic<uint64_t> m_accepted{ 0 };
+    std::atomic<uint64_t> m_rejectedGlobal{ 0 };
+    std::atomic<uint64_t> m_rejectedPerIp{ 0 };
+    std::atomic<uint64_t> m_closedByRate{ 0 };
+    std::atomic<uint64_t> m_droppedDatagrams{ 0 };
+    std::atomic<uint64_t> m_droppedBytes{ 0 };
+
+    LogThrottle m_logGlobal;
+    LogThrottle m_logPerIp;
+    LogThrottle m_logTcpRate;
+    LogThrottle m_logUdpRate;
+};
+
+} // namespace hhcast
\ No newline at end of file
@@ -23,6 +23,7 @@ public:
     uint64_t GetDroppedDatagramCount() const;
     uint64_t GetSplitPacketCount() const;
     uint64_t GetInputBytes() const;
+    uint64_t GetPredictedSplitCount() const;
 
 private:
     struct RtpHeaderLite {
@@ -40,18 +41,28 @@ private:
     static bool ParseRtpHeaderLite(const uint8_t* data, size_t size, RtpHeaderLite& header);
     static bool IsNextSequence(uint16_t currentSeq, uint16_t nextSeq);
 
+    // 先按上次学到的包长直接验证预测位置，不中再用 SIMD 扫描候选偏移
     size_t FindNextRtpOffset(const uint8_t* data,
                              size_t size,
                              size_t currentOffset,
-                             const RtpHeaderLite& currentHeader) const;
+                             const RtpHeaderLite& currentHeader);
+
+    void LearnPacket(const RtpHeaderLite& header, size_t packetSize);
 
 private:
     ESAudioRtpParser m_rtpParser;
 
+    // 同一会话的 SSRC/PT 基本不变，包长也基本固定
+    bool m_hasLearned = false;
+    uint32_t m_learnedSsrc = 0;
+    uint8_t m_learnedPayloadType = 0;
+    size_t m_learnedPacketSize = 0;
+
     uint64_t m_datagramCount = 0;
     uint64_t m_droppedDatagramCount = 0;
     uint64_t m_splitPacketCount = 0;   // 拆出来的 RTP 包总数
     uint64_t m_inputBytes = 0;
+    uint64_t m_predictedSplitCount = 0;  // 包长预测命中、无需扫描的次数
 };
 
 } // namespace hhcast
\ No newline at end of file
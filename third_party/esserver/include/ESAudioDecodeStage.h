@@ -0,0 +1,140 @@
+#pragma once
+
+#include "ESAudioJitterBuffer.h"
+#include "ESAudioRtpParser.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hhcast {
+
+// 51040 音频 SETUP 只协商端口，streams.type=96 对应固定的 AAC-ELD 参数
+struct ESAudioFormat {
+    uint32_t sampleRate = 44100;
+    uint16_t channels = 2;
+    uint32_t samplesPerFrame = 480;
+    std::vector<uint8_t> extradata = { 0xF8, 0xE8, 0x50, 0x00 };   // AudioSpecificConfig
+};
+
+enum class ESPcmSampleFormat : uint8_t {
+    S16 = 0,   // 交织 int16
+    F32 = 1,   // 交织 float
+};
+
+struct ESAudioDecodeConfig {
+    bool enabled = false;   // 需要编译时带 FFmpeg（ESSERVER_WITH_FFMPEG）
+
+    ESAudioFormat format;
+    ESPcmSampleFormat sampleFormat = ESPcmSampleFormat::S16;
+
+    size_t queueDepth = 32;          // 待解码队列上限，满了丢最旧的；至少为 2
+    size_t maxPayloadSize = 2048;
+    uint32_t concealFadeFrames = 3;  // 丢包时重复上一帧并逐帧减半，超过后输出静音
+};
+
+struct ESPcmFrame {
+    uint16_t sequence = 0;
+    uint32_t timestamp = 0;
+    uint32_t sampleRate = 0;
+    uint16_t channels = 0;
+    uint32_t samples = 0;            // 每声道采样数
+    ESPcmSampleFormat sampleFormat = ESPcmSampleFormat::S16;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    bool concealed = false;          // 丢包隐藏生成的帧
+    uint64_t presentationUs = 0;     // 来自输入 payload，隐藏帧为 0
+};
+
+// 回调在解码线程执行，data 只在回调期间有效
+using ESPcmCallback = std::function<void(const ESPcmFrame& frame)>;
+
+// 每个会话一个解码线程：输入 RTP payload / 丢包事件，输出交织 PCM。
+// 输入槽位、AVPacket/AVFrame、PCM 输出缓冲都在 Start 时分配并循环复用。
+class ESAudioDecodeStage {
+public:
+    ESAudioDecodeStage();
+    ~ESAudioDecodeStage();
+
+    static bool IsAvailable();
+
+    void SetPcmCallback(ESPcmCallback callback);
+
+    int Start(const ESAudioDecodeConfig& config);
+    void Stop();
+    bool IsRunning() const;
+
+    bool PushPayload(const ESAudioPayloadInfo& info);
+    bool PushGap(const ESAudioGapInfo& gap);
+
+    uint64_t GetDecodedFrameCount() const;
+    uint64_t GetConcealedFrameCount() const;
+    uint64_t GetDecodeErrorCount() const;
+    uint64_t GetDroppedInputCount() const;
+
+    // 待解码队列里的负载字节 / Start 时预留的队列和帧缓冲字节
+    size_t GetQueuedBytes() const;
+    size_t GetAllocatedBytes() const;
+    // 解码线程累计的线程 CPU 时间（仅 Linux，其他平台为 0），每处理完一个任务更新
+    uint64_t GetThreadCpuNs() const;
+
+private:
+    struct Job {
+        bool isGap = false;
+        uint16_t sequence = 0;
+        uint32_t timestamp = 0;
+        uint16_t gapCount = 0;
+        uint64_t presentationUs = 0;
+        std::vector<uint8_t> payload;
+    };
+
+    struct DecoderState;
+
+    Job* AcquireJobLocked();
+    void Enqueue(Job* job);
+
+    void WorkLoop();
+    void DecodeJob(const Job& job);
+    void ConcealJob(const Job& job);
+
+    void EmitFloatFrame(const float* interleaved, uint32_t samples,
+                        uint16_t sequence, uint32_t timestamp, bool concealed,
+                        uint64_t presentationUs);
+
+private:
+    ESAudioDecodeConfig m_config;
+    ESPcmCallback m_callback;
+
+    std::atomic<bool> m_running{ false };
+    std::thread m_thread;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cond;
+
+    std::vector<Job> m_jobs;
+    std::vector<Job*> m_freeJobs;
+    std::deque<Job*> m_pendingJobs;
+
+    DecoderState* m_decoder = nullptr;
+
+    // 解码线程独占
+    std::vector<float> m_floatBuffer;   // 交织 float，转换与丢包隐藏共用
+    std::vector<float> m_lastFrame;
+    uint32_t m_lastFrameSamples = 0;
+    uint32_t m_concealRun = 0;
+    std::vector<uint8_t> m_pcmBuffer;
+
+    std::atomic<uint64_t> m_decodedFrameCount{ 0 };
+    std::atomic<uint64_t> m_concealedFrameCount{ 0 };
+    std::atomic<uint64_t> m_decodeErrorCount{ 0 };
+    std::atomic<uint64_t> m_droppedInputCount{ 0 };
+    std::atomic<size_t> m_allocatedBytes{ 0 };
+    std::atomic<uint64_t> m_threadCpuNs{ 0 };
+};
+
+} // namespace hhcast
\ No newline at end of file
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "ESAudioDecodeStage.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace hhcast {
+
+struct ESAudioDriftConfig {
+    bool enabled = false;
+
+    uint32_t sampleRate = 44100;
+    uint16_t channels = 2;
+
+    uint32_t targetFillMs = 60;        // 拉取端看到的目标缓冲水位
+    uint32_t capacityMs = 500;         // 超过后丢最旧的采样
+    uint32_t fillWindowMs = 2000;      // 水位平滑时间常数，滤掉按帧推入造成的锯齿
+
+    double maxCorrectionPpm = 1000.0;  // 最大变速 ±0.1%（约 1.7 音分），听不出
+    double kp = 20.0;                  // 每 ms 水位偏差对应的修正 ppm
+    double ki = 0.1;                   // 积分项，稳态下收敛到两端时钟的实际漂移
+};
+
+struct ESAudioDriftStats {
+    double ratio = 1.0;                // 每输出一个采样消耗的输入采样数
+    double correctionPpm = 0.0;        // 正值表示发送端时钟偏快，正在加速消耗
+    double fillMs = 0.0;
+    double smoothedFillMs = 0.0;
+
+    uint64_t inputSamples = 0;         // 每声道采样数
+    uint64_t outputSamples = 0;
+    uint64_t underruns = 0;
+    uint64_t underrunSamples = 0;      // 因欠载输出的静音
+    uint64_t droppedSamples = 0;       // 因超过 capacityMs 丢弃的输入
+};
+
+// 解码后、播放前的变速重采样：推入端按发送端时钟送 PCM，拉取端按本地设备时钟取 PCM。
+// 用拉取的采样数作为本地时间基准，平滑后的水位经 PI 控制得到微小的变速比，
+// 再用多相加窗 sinc 做分数位置插值。历史采样、相位、控制器状态跨帧保留。
+// Push / Pull 可在不同线程调用。
+class ESAudioDriftResampler {
+public:
+    ESAudioDriftResampler();
+    ~ESAudioDriftResampler();
+
+    int Start(const ESAudioDriftConfig& config);
+    void Stop();
+    bool IsRunning() const;
+
+    void Reset();
+
+    // 只接受与配置一致的采样率/声道数
+    bool PushFrame(const ESPcmFrame& frame);
+    bool Push(const float* interleaved, uint32_t samples);
+
+    // 总是写满 samples 个采样（不足部分为静音），返回其中真实音频的采样数
+    uint32_t Pull(float* interleaved, uint32_t samples);
+    uint32_t PullS16(int16_t* interleaved, uint32_t samples);
+
+    ESAudioDriftStats GetStats() const;
+
+private:
+    bool PushLocked(const float* interleaved, uint32_t samples);
+    uint32_t PullLocked(float* interleaved, uint32_t samples);
+    void CompactLocked();
+    double FillSamplesLocked() const;
+    void UpdateControlLocked(uint32_t pulledSamples);
+
+private:
+    mutable std::mutex m_mutex;
+    ESAudioDriftConfig m_config;
+    bool m_running = false;
+
+    std::vector<float> m_kernel;       // (phases + 1) * taps，相邻相位线性插值
+    std::vector<float> m_taps;         // 当前输出采样的插值系数
+
+    std::vector<float> m_buffer;       // 交织 float，前面保留 taps/2 个历史采样
+    size_t m_bufferFrames = 0;         // 已写入的帧数（每帧 channels 个 float）
+    size_t m_capacityFrames = 0;
+    size_t m_readIndex = 0;            // 当前输出位置的整数部分
+    double m_fraction = 0.0;           // 当前输出位置的小数部分
+    bool m_priming = true;             // 启动或欠载后先攒到目标水位再出声
+
+    std::vector<float> m_convert;      // PushFrame 的 S16 输入转换
+    std::vector<float> m_pullBuffer;   // PullS16 的 float 中间结果，同样只在锁内使用
+
+    double m_smoothedFill = 0.0;
+    double m_integralPpm = 0.0;
+    double m_ratio = 1.0;
+
+    ESAudioDriftStats m_stats;
+};
+
+} // namespace hhcast
\ No newline at end of file
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "ESAudioRtpParser.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace hhcast {
+
+struct ESAudioJitterConfig {
+    bool enabled = true;
+
+    uint32_t clockRate = 44100;        // RTP 时钟，AAC-ELD 与采样率一致
+    uint32_t samplesPerFrame = 480;    // 每个 RTP 包的采样数，用于补算丢包时长
+
+    uint32_t targetDepthMs = 60;       // 初始目标深度
+    uint32_t minDepthMs = 20;          // 自适应下限
+    uint32_t maxDepthMs = 300;         // 超过后强制出包，丢弃更早的空洞
+    bool adaptive = true;              // 按 RFC 3550 抖动估计调整目标深度
+
+    size_t capacity = 128;             // 槽位数，需覆盖 maxDepthMs 对应的包数
+    size_t maxPayloadSize = 2048;
+
+    uint32_t pollIntervalMs = 10;      // ESServer 定时 Poll 的间隔；0 不定时，流停顿时尾包要等关闭才出
+};
+
+// 一段连续丢失的包，交给解码端做丢包隐藏
+struct ESAudioGapInfo {
+    uint16_t firstSequence = 0;
+    uint16_t count = 0;
+    uint32_t timestamp = 0;            // 第一个丢失包的预期时间戳
+    uint32_t durationSamples = 0;
+};
+
+using ESAudioGapCallback = std::function<void(const ESAudioGapInfo& gap)>;
+
+struct ESAudioJitterStats {
+    uint64_t received = 0;
+    uint64_t delivered = 0;
+    uint64_t duplicate = 0;
+    uint64_t reordered = 0;
+    uint64_t late = 0;                 // 到达时已经出过包或已判丢
+    uint64_t lost = 0;                 // 以 gap 形式上报的包数
+    uint64_t overflow = 0;             // 深度超限被强制推进的次数
+    uint64_t resets = 0;               // SSRC 变化或时间戳跳变
+
+    double jitterMs = 0.0;             // RFC 3550 到达间隔抖动
+    uint32_t targetDepthMs = 0;
+    uint32_t depthMs = 0;
+};
+
+// 按 RTP sequence/timestamp 排序的自适应抖动缓冲。
+// 不是线程安全的，调用方需在同一线程 Push/Flush。
+// 回调里的 payload 指针只在回调期间有效。
+class ESAudioJitterBuffer {
+public:
+    ESAudioJitterBuffer();
+    ~ESAudioJitterBuffer();
+
+    void SetConfig(const ESAudioJitterConfig& config);
+    const ESAudioJitterConfig& GetConfig() const;
+
+    void SetPayloadCallback(ESAudioPayloadCallback callback);
+    void SetGapCallback(ESAudioGapCallback callback);
+
+    // arrivalUs: 本地单调时钟，微秒
+    bool Push(const ESAudioPayloadInfo& info, uint64_t arrivalUs);
+
+    // 按时间出包：下一个该出的包在缓冲里等满目标深度就出（前面的空洞照常上报）。
+    // Push 只在新包到达时出包，流停顿或结束时要靠调用方定时调用本函数，才不会一直压着最后几帧
+    void Poll(uint64_t nowUs);
+
+    // 把缓冲里剩余的包全部按序吐出（中间的空洞照常上报）
+    void Flush();
+    void Reset();
+
+    ESAudioJitterStats GetStats() const;
+
+    // 缓冲里待出的负载字节 / 槽位预留的总字节
+    size_t GetStoredBytes() const;
+    size_t GetAllocatedBytes() const;
+
+private:
+    struct Slot {
+        bool used = false;
+        uint8_t payloadType = 0;
+        uint16_t sequence = 0;
+        uint32_t timestamp = 0;
+        uint64_t arrivalUs = 0;
+        std::vector<uint8_t> payload;
+    };
+
+    Slot& SlotFor(uint16_t sequence);
+
+    void Start(const ESAudioPayloadInfo& info);
+    void UpdateJitter(const ESAudioPayloadInfo& info, uint64_t arrivalUs);
+    void UpdateTargetDepth();
+
+    uint32_t GetDepthSamples() const;
+    uint32_t MsToSamples(uint32_t ms) const;
+
+    void Drain(bool flushAll);
+    void DeliverHead();
+    void ReportGapAtHead();
+
+private:
+    ESAudioJitterConfig m_config;
+
+    ESAudioPayloadCallback m_payloadCallback;
+    ESAudioGapCallback m_gapCallback;
+
+    std::vector<Slot> m_slots;
+    size_t m_storedCount = 0;
+    size_t m_storedBytes = 0;
+
+    bool m_started = false;
+    uint32_t m_ssrc = 0;
+    uint16_t m_nextSequence = 0;       // 下一个要出的包
+    uint32_t m_nextTimestamp = 0;      // 下一个要出的包的预期时间戳
+    uint16_t m_highestSequence = 0;
+    uint32_t m_highestTimestamp = 0;
+
+    bool m_hasArrival = false;
+    int64_t m_lastArrival = 0;         // RTP 时钟单位
+    uint32_t m_lastArrivalTimestamp = 0;
+    double m_jitterSamples = 0.0;
+    double m_targetDepthMs = 0.0;
+
+    ESAudioJitterStats m_stats;
+};
+
+} // namespace hhcast
\ No newline at end of file
@@ -13,6 +13,7 @@ struct ESAudioPayloadInfo {
     uint32_t ssrc = 0;
     const uint8_t* payload = nullptr;
     size_t payloadSize = 0;
+    uint64_t presentationUs = 0;   // A/V 同步给出的播放 deadline（steady_clock 微秒），0 表示未知
 };
 
 using ESAudioPayloadCallback = std::function<void(const ESAudioPayloadInfo& info)>;
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+namespace hhcast {
+
+struct ESAvSyncConfig {
+    uint32_t audioClockRate = 44100;
+    uint32_t playoutDelayMs = 120;     // 在两路中较慢的那路之后再留的播放余量
+
+    uint32_t bucketMs = 1000;          // 每个桶取最小传输时延，过滤排队抖动
+    size_t bucketCount = 120;          // 参与漂移拟合的桶数（约 2 分钟）
+
+    uint32_t maxEpochSkewMs = 10000;   // 控制端口 NTP 与视频 32.32 偏差超过该值时认为不同源，丢弃同步包
+};
+
+struct ESAvSyncStats {
+    bool hasVideo = false;
+    bool hasAudio = false;
+    bool hasSyncAnchor = false;        // 是否已由控制端口同步包锚定音频 RTP 时钟
+
+    uint64_t syncPackets = 0;
+    uint64_t rejectedSyncPackets = 0;
+
+    double driftPpm = 0.0;             // 发送端时钟相对本地时钟的漂移，正值表示发送端偏慢
+    double videoTransitMs = 0.0;       // 本地到达时间 - 发送端时间（含未知的时钟基准差）
+    double audioTransitMs = 0.0;
+    double lipSyncOffsetMs = 0.0;      // 音频相对视频晚到的时间，已在 deadline 中补偿
+    uint32_t playoutDelayMs = 0;
+};
+
+// 每个会话一个：把视频 32.32 时间戳和音频 RTP 时间戳映射到同一条发送端时间轴，
+// 再用最小时延滤波 + 线性拟合把发送端时间映射到本地单调时钟，得到每个 unit 的播放 deadline。
+// 所有本地时间都是调用方给的同一时钟（微秒）。线程安全。
+class ESAvSyncEngine {
+public:
+    ESAvSyncEngine();
+    ~ESAvSyncEngine();
+
+    void SetConfig(const ESAvSyncConfig& config);
+    ESAvSyncConfig GetConfig() const;
+
+    void Reset();
+
+    // 控制端口 datagram，识别 0xD4 同步包（RTP 时间戳 + NTP 32.32），其他包返回 false
+    bool InputControlPacket(const uint8_t* data, size_t size, uint64_t localUs);
+    void InputSyncAnchor(uint32_t rtpTimestamp, uint64_t ntp32_32, uint64_t localUs);
+
+    // 到达时调用，返回播放 deadline（本地微秒），信息不足时返回 0
+    uint64_t OnVideoArrival(uint64_t timestamp32_32, uint64_t localUs);
+    uint64_t OnAudioArrival(uint32_t rtpTimestamp, uint64_t localUs);
+
+    // 只查询不更新，用于出队时补算
+    uint64_t GetVideoDeadlineUs(uint64_t timestamp32_32) const;
+    uint64_t GetAudioDeadlineUs(uint32_t rtpTimestamp) const;
+
+    double GetLipSyncOffsetMs() const;
+    ESAvSyncStats GetStats() const;
+
+    static uint64_t Ntp32_32ToUs(uint64_t timestamp32_32);
+
+private:
+    // 发送端时间 -> 本地时间：每个桶取 (local - sender) 最小值，对桶序列做最小二乘
+    class ClockMapper {
+    public:
+        void Configure(uint32_t bucketMs, size_t bucketCount);
+        void Reset();
+
+        void AddSample(int64_t senderUs, int64_t localUs);
+        bool IsValid() const;
+
+        int64_t GetOffsetUs(int64_t localUs) const;   // local - sender
+        double GetDriftPpm() const;
+
+    private:
+        void Refit();
+
+        struct Bucket {
+            int64_t index = 0;
+            int64_t localUs = 0;
+            int64_t offsetUs = 0;
+        };
+
+        int64_t m_bucketUs = 1000000;
+        size_t m_bucketCount = 120;
+
+        std::deque<Bucket> m_buckets;   // 最后一个是当前桶
+        bool m_valid = false;
+
+        double m_slope = 0.0;           // offset 随本地时间的变化率
+        int64_t m_refLocalUs = 0;
+        double m_refOffsetUs = 0.0;
+    };
+
+    int64_t AudioRtpToSenderUsLocked(uint32_t rtpTimestamp) const;
+    int64_t CommonOffsetUsLocked(int64_t localUs) const;
+    uint64_t DeadlineLocked(int64_t senderUs) const;
+
+private:
+    mutable std::mutex m_mutex;
+    ESAvSyncConfig m_config;
+
+    ClockMapper m_videoClock;
+    ClockMapper m_audioClock;
+
+    // 音频 RTP 时间戳到发送端时间轴的锚点
+    bool m_hasAudioAnchor = false;
+    bool m_anchorFromSync = false;
+    uint32_t m_anchorRtp = 0;
+    int64_t m_anchorSenderUs = 0;
+
+    int64_t m_lastLocalUs = 0;
+
+    ESAvSyncStats m_stats;
+};
+
+} // namespace hhcast
\ No newline at end of file
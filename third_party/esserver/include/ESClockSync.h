@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace hhcast {
+
+// 57395 心跳的可选计时字段（整数微秒，各自的单调时钟；对端不认识时忽略）：
+//   sendUs      本条消息发出时间
+//   echoUs      最近收到的对端消息里的 sendUs
+//   echoRecvUs  收到那条对端消息的时间
+// 双方都按同样规则填写，任一端收到带 echo 的消息即可凑齐一次往返的四个时间戳。
+struct ESHeartbeatTiming {
+    int64_t sendUs = 0;
+    int64_t echoUs = 0;
+    int64_t echoRecvUs = 0;
+
+    bool HasEcho() const { return echoUs != 0 && echoRecvUs != 0; }
+};
+
+// 一次往返，NTP 记法：t1 本端发出、t4 本端收到（本端时钟），t2 对端收到、t3 对端发出（对端时钟）
+struct ESClockExchange {
+    int64_t t1Us = 0;
+    int64_t t2Us = 0;
+    int64_t t3Us = 0;
+    int64_t t4Us = 0;
+};
+
+struct ESClockSyncStats {
+    bool valid = false;
+
+    int64_t rttUs = 0;           // 窗口内最小 RTT
+    int64_t offsetUs = 0;        // 对端时钟 - 本端时钟，取窗口内 RTT 最小的样本
+    int64_t smoothedRttUs = 0;   // 1/8 指数平滑
+    int64_t minRttUs = 0;        // 历史最小
+    int64_t lastRttUs = 0;
+    int64_t lastOffsetUs = 0;
+
+    uint64_t sampleCount = 0;
+    uint64_t rejectedCount = 0;  // RTT 为负或超过上限
+};
+
+// 最小 RTT 选择：排队时延只会让 RTT 变大、offset 偏向一侧，窗口内 RTT 最小的样本误差最小。
+// 可跨线程调用。
+class ESClockSync {
+public:
+    static constexpr size_t kWindowSize = 8;
+    static constexpr int64_t kMaxRttUs = 5 * 1000 * 1000;
+
+    // 用收到的对端计时字段凑一次往返；没有 echo 时返回 false
+    static bool MakeExchange(const ESHeartbeatTiming& peer, int64_t localRecvUs, ESClockExchange& exchange);
+
+    bool AddExchange(const ESClockExchange& exchange);
+    ESClockSyncStats GetStats() const;
+    void Reset();
+
+private:
+    struct Sample {
+        int64_t rttUs = 0;
+        int64_t offsetUs = 0;
+    };
+
+    void SelectLocked();
+
+private:
+    mutable std::mutex m_mutex;
+    std::array<Sample, kWindowSize> m_window;
+    size_t m_windowCount = 0;
+    size_t m_windowNext = 0;
+    ESClockSyncStats m_stats;
+};
+
+} // namespace hhcast
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "ESAdmissionControl.h"
+#include "ESJsonLineScanner.h"
+#include "ESRtspLite.h"
+
+namespace hhcast {
+
+class ESSession;
+
+// 挂在 hv 连接上的状态（setContextPtr），连接建立时解析一次对端地址，之后收包不再查表。
+// 只在连接所在的 loop 线程访问。
+struct ESConnectionContext {
+    uint16_t localPort = 0;
+    uint32_t peerIp = 0;               // IPv4 主机字节序，即 streamId；0 表示解析失败
+    std::string peerIpText;            // 日志和 ESServer 接口用
+
+    bool admitted = false;             // 占了 ESAdmissionControl 的连接名额，断开时归还
+    ESRateLimiter limiter;             // 收包入口限速，未配置时直接放行
+
+    // 51030 缓存的会话；会话关闭或未建立时在下一个包重新查找
+    std::weak_ptr<ESSession> session;
+
+    // 各端口的接收状态，只有对应端口会用到
+    std::string recvBuffer8600;
+    ESRtspLiteParser rtspParser;
+    ESJsonLineSplitter jsonSplitter;
+};
+
+using ESConnectionContextPtr = std::shared_ptr<ESConnectionContext>;
+
+} // namespace hhcast
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "hv/EventLoopThreadPool.h"
+
+namespace hhcast {
+
+// 多个监听共用的一组 hv 事件循环，每个 loop 一个线程，可按下标绑核。
+// 监听按轮询挂到 loop 上，同一监听的连接都在它所在的 loop 上处理。
+class ESEventLoopPool {
+public:
+    ESEventLoopPool();
+    ~ESEventLoopPool();
+
+    int Start(size_t loopCount, const std::vector<int>& cpus);
+    // 等所有 loop 线程退出；残留连接的关闭回调在此期间执行
+    void Stop();
+
+    bool IsRunning() const;
+    size_t GetLoopCount() const;
+
+    hv::EventLoopPtr GetLoop(size_t index) const;
+    hv::EventLoopPtr NextLoop();
+
+    // 第 i 个 loop 绑到 cpus[i % cpus.size()]，在各自 loop 线程里执行；cpus 为空不处理
+    static void PinLoops(const std::vector<hv::EventLoopPtr>& loops, const std::vector<int>& cpus);
+
+private:
+    std::unique_ptr<hv::EventLoopThreadPool> m_pool;
+    size_t m_loopCount = 0;
+    size_t m_nextLoop = 0;
+};
+
+} // namespace hhcast
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace hhcast {
+
+enum class ESFecScheme : uint8_t {
+    None        = 0,
+    Xor         = 1,   // 每组 1 个校验包，可恢复组内任意 1 个丢包
+    ReedSolomon = 2,   // GF(256) Cauchy RS，可恢复组内任意 parityShards 个丢包
+};
+
+class ESFecCodec {
+public:
+    static constexpr size_t kMaxShards = 64;
+
+    ESFecCodec();
+    ~ESFecCodec();
+
+    // Xor 模式下 parityShards 固定为 1
+    bool Configure(ESFecScheme scheme, uint8_t dataShards, uint8_t parityShards);
+
+    ESFecScheme GetScheme() const;
+    uint8_t GetDataShards() const;
+    uint8_t GetParityShards() const;
+
+    // data: dataShards 个长度为 shardSize 的分片（不足部分由调用方补零）
+    // parity: parityShards 个输出缓冲，每个至少 shardSize 字节
+    bool Encode(const uint8_t* const* data, size_t shardSize, uint8_t* const* parity) const;
+
+    // shards: dataShards + parityShards 个缓冲，present 标记哪些已收到
+    // 成功时补齐所有缺失的数据分片，并把 present 中对应位置置 true
+    bool Reconstruct(uint8_t* const* shards, bool* present, size_t shardSize) const;
+
+private:
+    uint8_t CauchyCoef(size_t parityRow, size_t dataCol) const;
+
+private:
+    ESFecScheme m_scheme = ESFecScheme::None;
+    uint8_t m_dataShards = 0;
+    uint8_t m_parityShards = 0;
+};
+
+} // namespace hhcast
\ No newline at end of file
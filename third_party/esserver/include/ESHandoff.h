@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace hhcast {
+
+// 不停服升级：新进程通过 Unix 域 socket（SOCK_SEQPACKET + SCM_RIGHTS）从旧进程接手
+// 监听 socket、已建立的连接和会话状态。仅 Linux，其他平台各接口直接返回失败。
+//
+// 流程：新进程 Connect -> SendHello；旧进程 RecvHello 后暂停各 loop、摘下 fd 并快照状态，
+// SendState；新进程 RecvState、恢复会话、接管 fd 后 SendAck；旧进程 RecvAck 后停止接入并退出。
+
+enum class ESHandoffSocketKind : uint8_t {
+    TcpListener = 1,
+    TcpConnection,
+    UdpMouse,
+    UdpData,
+    UdpControl,
+};
+
+struct ESHandoffSocket {
+    ESHandoffSocketKind kind = ESHandoffSocketKind::TcpListener;
+    uint16_t localPort = 0;
+    uint32_t peerIp = 0;               // 仅 TcpConnection，主机字节序
+    std::string pending;               // 仅 TcpConnection：协议解析器里尚未消费的字节
+    int fd = -1;
+};
+
+struct ESHandoffSession {
+    uint32_t streamId = 0;
+    std::string peerIp;
+    std::string name;
+    std::string videoPending;          // 视频解包器里的半帧
+};
+
+// fd 归持有者所有，取走后置 -1；析构时关闭剩下的
+struct ESHandoffState {
+    std::vector<ESHandoffSocket> sockets;
+    std::vector<ESHandoffSession> sessions;
+
+    ESHandoffState() = default;
+    ~ESHandoffState();
+
+    ESHandoffState(const ESHandoffState&) = delete;
+    ESHandoffState& operator=(const ESHandoffState&) = delete;
+
+    size_t CountSockets(ESHandoffSocketKind kind, uint16_t localPort = 0) const;
+    int TakeSocket(ESHandoffSocketKind kind, uint16_t localPort = 0);
+    std::vector<int> TakeListeners(uint16_t localPort);
+    void CloseAll();
+};
+
+// 一条交接连接，析构时关闭
+class ESHandoffLink {
+public:
+    static constexpr uint32_t kVersion = 1;
+
+    explicit ESHandoffLink(int fd = -1);
+    ~ESHandoffLink();
+
+    ESHandoffLink(const ESHandoffLink&) = delete;
+    ESHandoffLink& operator=(const ESHandoffLink&) = delete;
+
+    // 没有旧进程在监听时返回 -1
+    int Connect(const std::string& path);
+    bool IsOpen() const;
+    void Close();
+
+    int SendHello();
+    int RecvHello(uint32_t timeoutMs);
+
+    // state 里的 fd 只是借用，发送后仍由调用方关闭
+    int SendState(const ESHandoffState& state);
+    int RecvState(ESHandoffState& state, uint32_t timeoutMs);
+
+    int SendAck(bool ok);
+    // 对端确认接管返回 0，拒绝或超时返回负数
+    int RecvAck(uint32_t timeoutMs);
+
+private:
+    struct Packet;
+
+    int SendPacket(uint8_t type, const std::string& payload, int fd = -1);
+    int RecvPacket(Packet& packet, uint32_t timeoutMs);
+    int SendBlob(const std::string& blob);
+    int RecvBlob(std::string& blob, size_t size, uint32_t timeoutMs);
+
+private:
+    int m_fd = -1;
+};
+
+// 旧进程一侧：监听交接路径，每个请求在监听线程里同步交给 handler
+class ESHandoffListener {
+public:
+    using Handler = std::function<void(ESHandoffLink& link)>;
+
+    ESHandoffListener();
+    ~ESHandoffListener();
+
+    int Start(const std::string& path, Handler handler);
+    // 可以在 handler 里调用
+    void Stop();
+
+    bool IsRunning() const;
+
+private:
+    void AcceptLoop();
+
+private:
+    std::atomic<bool> m_running{ false };
+    std::thread m_thread;
+
+    int m_listenFd = -1;
+    std::string m_path;
+    uint64_t m_pathInode = 0;          // 退出时只删除自己创建的路径，新进程可能已经重新绑定
+    Handler m_handler;
+};
+
+} // namespace hhcast
\ No newline at end of file
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "ESClockSync.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace hhcast {
+
+enum class ESJsonValueType : uint8_t {
+    String = 0,
+    Number,
+    True,
+    False,
+    Null,
+    Object,   // 嵌套对象/数组不展开，raw 为整段文本
+    Array,
+};
+
+struct ESJsonField {
+    std::string_view key;     // 不含引号，可能带转义
+    std::string_view raw;     // String 不含引号；其他类型为原文
+    ESJsonValueType type = ESJsonValueType::Null;
+    bool keyEscaped = false;
+    bool valueEscaped = false;
+};
+
+// eshare 控制消息都是单层 JSON 对象。就地扫描顶层字段为视图，不分配内存；
+// 键的顺序任意，字符串里的转义在扫描时正确跳过，需要时再解码。
+class ESJsonLineScanner {
+public:
+    static constexpr size_t kMaxFields = 32;   // 超出的字段忽略
+
+    // 成功时字段视图指向 line，line 需在使用期间保持有效
+    bool Parse(std::string_view line);
+
+    size_t GetFieldCount() const;
+    const ESJsonField& GetField(size_t index) const;
+    const ESJsonField* Find(std::string_view key) const;
+    bool Has(std::string_view key) const;
+
+    // 无转义时 out 直接指向原文；有转义时解码到 scratch，scratch 为空则返回 false
+    bool GetString(std::string_view key, std::string_view& out, std::string* scratch = nullptr) const;
+    bool GetInt(std::string_view key, int64_t& out) const;
+
+    // JSON 字符串转义解码（含 \uXXXX 与代理对，输出 UTF-8）
+    static bool Unescape(std::string_view raw, std::string& out);
+
+private:
+    std::array<ESJsonField, kMaxFields> m_fields;
+    size_t m_fieldCount = 0;
+};
+
+// 按 '\n' 就地切行；顶层 JSON 对象闭合时也视为一行结束，发送端不带换行或一次发多个对象都能切开。
+// 扫描状态跨 Append 保留，每个字节只扫描一次。
+class ESJsonLineSplitter {
+public:
+    static constexpr size_t kMaxLineBytes = 64 * 1024;
+
+    void Append(const char* data, size_t size);
+
+    // 返回 true 时 line 有效，直到下一次 Append / Next / Reset；首尾空白已去掉，空行跳过
+    bool Next(std::string_view& line);
+
+    // 未切出的数据超过 kMaxLineBytes 时为 true，调用方应 Reset
+    bool IsOverflowed() const;
+    size_t GetBufferedSize() const;
+    // 尚未切出的原始字节，重新 Append 到新的 splitter 即可恢复扫描状态（进程交接用）
+    std::string_view GetBuffered() const;
+    void Reset();
+
+private:
+    void ConsumePending();
+    bool EmitLine(std::string_view& line);
+
+private:
+    std::string m_buffer;
+    size_t m_begin = 0;
+    size_t m_scanPos = 0;
+    size_t m_consumePending = 0;
+
+    int m_depth = 0;
+    bool m_inString = false;
+    bool m_escape = false;
+};
+
+// 57395 的两类消息
+enum class ESEshareJsonKind : uint8_t {
+    Unknown = 0,
+    ClientInfo,   // 含 clientName / clientType（requireClientType 为 false 时只要求 clientName）
+    Heartbeat,    // 含 heartbeat
+};
+
+struct ESEshareJsonMessage {
+    ESEshareJsonKind kind = ESEshareJsonKind::Unknown;
+    std::string_view clientName;   // 可能指向 scratch
+    std::string_view clientType;
+    int64_t heartbeat = 0;
+    ESHeartbeatTiming timing;      // 可选计时字段，没带时全为 0
+};
+
+// clientName 带转义时解码到 scratch
+bool ParseEshareJsonMessage(const ESJsonLineScanner& scanner, ESEshareJsonMessage& msg,
+                            std::string* scratch = nullptr, bool requireClientType = true);
+
+// 8121 请求：命令 / 发送端名称 / 发送端版本，各占一行
+enum class ESEshareCommand : uint8_t {
+    Unknown = 0,
+    GetServerInfo,
+    DongleConnected,
+};
+
+struct ESEshareCommandRequest {
+    ESEshareCommand command = ESEshareCommand::Unknown;
+    std::string_view commandText;
+    std::string_view senderName;
+    std::string_view senderVersion;
+};
+
+// 命令名默认区分大小写，ignoreCase 时不区分；不足三行非空行时返回 false
+bool ParseEshareCommandRequest(std::string_view text, ESEshareCommandRequest& request,
+                               bool ignoreCase = false);
+
+} // namespace hhcast
\ No newline at end of file
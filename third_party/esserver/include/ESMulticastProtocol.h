@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace hhcast {
+
+// 组播转发报文格式（大端）：
+//
+// [28 字节包头][分片体]
+//
+// 包头：magic "ESMC" | version | packetType | fecScheme | epoch
+//       streamId(4) | seq(4) | groupId(4)
+//       shardIndex | dataShards | parityShards | reserved | shardSize(2) | reserved(2)
+//
+// 数据包的分片体（受 FEC 保护）：
+//       mediaType | reserved | fragLen(2) | unitId(4) | fragIndex(2) | fragCount(2) | unitSize(4)
+//       fragOffset(4) | fragment
+//
+// 校验包的分片体是同组所有数据分片体补零到 shardSize 后的编码结果。
+// unit 内容是可以直接喂给原解析器的字节：视频为 128 字节 ES 头 + payload，音频为完整 RTP 包。
+// epoch 在发送端每次新建一路流时变化，接收端据此识别发送端重连后 seq/unitId 从 0 重新开始。
+
+constexpr uint32_t kEsMulticastMagic = 0x45534D43; // "ESMC"
+constexpr uint8_t kEsMulticastVersion = 1;
+
+constexpr size_t kEsMulticastHeaderSize = 28;
+constexpr size_t kEsMulticastShardHeaderSize = 20;
+
+enum class ESMulticastPacketType : uint8_t {
+    Data   = 0,
+    Parity = 1,
+};
+
+enum class ESMulticastMediaType : uint8_t {
+    Video = 1,
+    Audio = 2,
+};
+
+struct ESMulticastHeader {
+    ESMulticastPacketType packetType = ESMulticastPacketType::Data;
+    uint8_t fecScheme = 0;
+    uint8_t epoch = 0;
+    uint32_t streamId = 0;
+    uint32_t seq = 0;
+    uint32_t groupId = 0;
+    uint8_t shardIndex = 0;
+    uint8_t dataShards = 0;
+    uint8_t parityShards = 0;
+    uint16_t shardSize = 0;
+};
+
+struct ESMulticastShardHeader {
+    ESMulticastMediaType mediaType = ESMulticastMediaType::Video;
+    uint16_t fragLen = 0;
+    uint32_t unitId = 0;
+    uint16_t fragIndex = 0;
+    uint16_t fragCount = 0;
+    uint32_t unitSize = 0;
+    uint32_t fragOffset = 0;
+};
+
+void WriteMulticastHeader(const ESMulticastHeader& header, uint8_t* out);
+bool ReadMulticastHeader(const uint8_t* data, size_t size, ESMulticastHeader& header);
+
+void WriteMulticastShardHeader(const ESMulticastShardHeader& header, uint8_t* out);
+bool ReadMulticastShardHeader(const uint8_t* data, size_t size, ESMulticastShardHeader& header);
+
+} // namespace hhcast
\ No newline at end of file
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "ESAudioRtpParser.h"
+#include "ESFecCodec.h"
+#include "ESMulticastProtocol.h"
+#include "ESServerConfig.h"
+#include "ESVideoDepacketizer.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace hhcast {
+
+// 把会话的视频 unit / 音频 RTP 负载按 MTU 分片后经 UDP 组播转发，
+// 每 dataShards 个数据包追加 parityShards 个 FEC 校验包
+class ESMulticastPublisher {
+public:
+    ESMulticastPublisher();
+    ~ESMulticastPublisher();
+
+    int Start(const ESMulticastConfig& config);
+    void Stop();
+
+    bool IsRunning() const;
+
+    // 可以在任意 hv loop 线程调用
+    void PublishVideoUnit(uint32_t streamId, const ESVideoUnit& unit);
+    void PublishAudioPacket(uint32_t streamId, const ESAudioPayloadInfo& info);
+
+    void RemoveStream(uint32_t streamId);
+
+    uint64_t GetDataPacketCount() const;
+    uint64_t GetParityPacketCount() const;
+    uint64_t GetSendErrorCount() const;
+
+private:
+    struct StreamState {
+        uint8_t epoch = 0;
+        uint32_t nextSeq = 0;
+        uint32_t nextUnitId = 0;
+
+        // 当前 FEC 组已发送的数据分片体，补零后参与编码
+        std::vector<std::vector<uint8_t>> groupShards;
+        size_t groupFill = 0;
+        size_t groupShardSize = 0;
+    };
+
+    // socket 和组地址；发送在锁外进行，Stop 之后由最后一个发送者关闭 socket
+    struct SendTarget {
+        intptr_t socket = -1;
+        std::vector<uint8_t> groupAddr;   // sockaddr_in
+
+        ~SendTarget();
+    };
+
+    // 锁内组好的 datagram，每个调用线程一份
+    struct OutgoingDatagrams;
+
+    static OutgoingDatagrams& GetOutgoing();
+
+    void PublishUnit(uint32_t streamId,
+                     ESMulticastMediaType mediaType,
+                     const uint8_t* head,
+                     size_t headSize,
+                     const uint8_t* payload,
+                     size_t payloadSize);
+
+    void PublishUnitLocked(OutgoingDatagrams& out,
+                           uint32_t streamId,
+                           ESMulticastMediaType mediaType,
+                           const uint8_t* head,
+                           size_t headSize,
+                           const uint8_t* payload,
+                           size_t payloadSize);
+
+    void SendDataShardLocked(OutgoingDatagrams& out, uint32_t streamId, StreamState& stream, size_t shardBodySize);
+    void SendParityLocked(OutgoingDatagrams& out, uint32_t streamId, StreamState& stream, uint32_t groupId);
+
+    void SendOutgoing(const SendTarget& target, const OutgoingDatagrams& out);
+
+private:
+    std::atomic<bool> m_running{ false };
+    std::mutex m_mutex;
+
+    ESMulticastConfig m_config;
+    ESFecCodec m_fec;
+
+    std::shared_ptr<SendTarget> m_target;
+    uint8_t m_nextEpoch = 0;
+
+    std::vector<uint8_t> m_sendBuffer;
+    std::vector<std::vector<uint8_t>> m_parityBuffers;
+
+    std::unordered_map<uint32_t, StreamState> m_streams;
+
+    std::atomic<uint64_t> m_dataPacketCount{ 0 };
+    std::atomic<uint64_t> m_parityPacketCount{ 0 };
+    std::atomic<uint64_t> m_sendErrorCount{ 0 };
+};
+
+} // namespace hhcast
\ No newline at end of file
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "ESAudioRtpParser.h"
+#include "ESFecCodec.h"
+#include "ESMulticastProtocol.h"
+#include "ESServerConfig.h"
+#include "ESSession.h"
+#include "ESVideoDepacketizer.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace hhcast {
+
+// 组播接收端：加组收包，按 FEC 组恢复丢失分片，重组 unit 后按序喂给
+// ESVideoDepacketizer / ESAudioRtpParser，回调与 ESSession 的媒体回调保持一致
+class ESMulticastReceiver {
+public:
+    ESMulticastReceiver();
+    ~ESMulticastReceiver();
+
+    void SetVideoCallback(ESSessionVideoCallback callback);
+    void SetAudioCallback(ESSessionAudioCallback callback);
+
+    // 打开 socket 加组并启动收包线程
+    int Start(const ESMulticastConfig& config);
+    void Stop();
+
+    bool IsRunning() const;
+
+    // 不使用内部线程时，也可以由调用方直接喂 datagram
+    bool InputDatagram(const uint8_t* data, size_t size);
+
+    uint64_t GetPacketCount() const;
+    uint64_t GetRecoveredShardCount() const;
+    uint64_t GetDeliveredUnitCount() const;
+    uint64_t GetLostUnitCount() const;
+    uint64_t GetResyncCount() const;
+
+private:
+    struct GroupState {
+        ESFecScheme scheme = ESFecScheme::None;
+        uint8_t dataShards = 0;
+        uint8_t parityShards = 0;
+        size_t shardSize = 0;
+        std::vector<std::vector<uint8_t>> shards;
+        bool present[ESFecCodec::kMaxShards] = {};
+        bool processed[ESFecCodec::kMaxShards] = {};
+    };
+
+    struct UnitAssembly {
+        ESMulticastMediaType mediaType = ESMulticastMediaType::Video;
+        std::vector<uint8_t> bytes;
+        std::vector<bool> received;
+        uint16_t receivedCount = 0;
+    };
+
+    struct StreamState {
+        ESVideoDepacketizer video;
+        ESAudioRtpParser audio;
+
+        std::map<uint32_t, GroupState> groups;
+        std::map<uint32_t, UnitAssembly> assemblies;
+        size_t pendingBytes = 0;
+
+        bool hasNextUnitId = false;
+        uint32_t nextUnitId = 0;
+
+        bool hasEpoch = false;
+        uint8_t epoch = 0;
+    };
+
+    StreamState& GetStreamLocked(uint32_t streamId);
+    // 发送端重连：丢掉旧一轮的组和未完成的 unit，从下一个收到的 unit 重新开始
+    void ResyncStreamLocked(StreamState& stream);
+
+    void OnParityLocked(StreamState& stream, const ESMulticastHeader& header,
+                        const uint8_t* body, size_t bodySize);
+    void OnDataLocked(StreamState& stream, const ESMulticastHeader& header,
+                      const uint8_t* body, size_t bodySize);
+
+    GroupState* GetGroupLocked(StreamState& stream, const ESMulticastHeader& header);
+    void TryRecoverLocked(StreamState& stream, GroupState& group);
+
+    void ProcessShardLocked(StreamState& stream, const uint8_t* body, size_t bodySize);
+    void DeliverReadyUnitsLocked(StreamState& stream);
+    void DeliverUnitLocked(StreamState& stream, const UnitAssembly& unit);
+
+    void RecvLoop();
+
+private:
+    std::atomic<bool> m_running{ false };
+    std::mutex m_mutex;
+    std::thread m_thread;
+
+    intptr_t m_socket = -1;
+    size_t m_maxUnitSize = ESMulticastConfig().maxUnitSize;
+
+    ESSessionVideoCallback m_videoCallback;
+    ESSessionAudioCallback m_audioCallback;
+
+    std::unordered_map<uint32_t, std::unique_ptr<StreamState>> m_streams;
+
+    std::atomic<uint64_t> m_packetCount{ 0 };
+    std::atomic<uint64_t> m_recoveredShardCount{ 0 };
+    std::atomic<uint64_t> m_deliveredUnitCount{ 0 };
+    std::atomic<uint64_t> m_lostUnitCount{ 0 };
+    std::atomic<uint64_t> m_resyncCount{ 0 };
+};
+
+} // namespace hhcast
\ No newline at end of file
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+
+namespace hhcast {
+
+// 编译期组装的媒体处理链（拆包 → 计数/编号 → 过滤 → 分发）。每一级是一个类型，提供
+//     template <typename Unit, typename Next> void operator()(Unit& unit, Next&& next);
+// 调 next(unit) 交给下一级，不调即到此为止。整条链是一个具体类型，调用处可以一路内联，
+// 没有 std::function 的类型擦除和间接调用；要哪几级由使用方的类型别名决定。
+// 链的源头是拉模式的解析器，例如 ESVideoDepacketizer::DrainUnits(pipeline)
+template <typename... Stages>
+class ESPipeline {
+public:
+    ESPipeline() = default;
+
+    explicit ESPipeline(Stages... stages)
+        : m_stages(std::move(stages)...)
+    {
+    }
+
+    template <typename Unit>
+    void operator()(Unit& unit)
+    {
+        Run<0>(unit);
+    }
+
+    template <size_t I>
+    auto& GetStage()
+    {
+        return std::get<I>(m_stages);
+    }
+
+    template <size_t I>
+    const auto& GetStage() const
+    {
+        return std::get<I>(m_stages);
+    }
+
+private:
+    template <size_t I, typename Unit>
+    void Run(Unit& unit)
+    {
+        if constexpr (I < sizeof...(Stages)) {
+            std::get<I>(m_stages)(unit, [this](Unit& next) {
+                Run<I + 1>(next);
+            });
+        }
+    }
+
+private:
+    std::tuple<Stages...> m_stages;
+};
+
+// 计数/编号：记下经过的单元数和负载字节数（Unit 需有 payloadSize），原样交给下一级
+class ESIndexStage {
+public:
+    template <typename Unit, typename Next>
+    void operator()(Unit& unit, Next&& next)
+    {
+        ++m_unitCount;
+        m_payloadBytes += static_cast<uint64_t>(unit.payloadSize);
+        next(unit);
+    }
+
+    // 已经过的单元数，也是下一个单元的序号（从 0 开始）
+    uint64_t GetUnitCount() const { return m_unitCount; }
+    uint64_t GetPayloadBytes() const { return m_payloadBytes; }
+
+private:
+    uint64_t m_unitCount = 0;
+    uint64_t m_payloadBytes = 0;
+};
+
+// 过滤：pred(unit) 为 false 的单元丢弃
+template <typename Pred>
+class ESFilterStage {
+public:
+    ESFilterStage() = default;
+
+    explicit ESFilterStage(Pred pred)
+        : m_pred(std::move(pred))
+    {
+    }
+
+    template <typename Unit, typename Next>
+    void operator()(Unit& unit, Next&& next)
+    {
+        if (m_pred(static_cast<const Unit&>(unit))) {
+            next(unit);
+        }
+        else {
+            ++m_droppedCount;
+        }
+    }
+
+    uint64_t GetDroppedCount() const { return m_droppedCount; }
+
+private:
+    Pred m_pred;
+    uint64_t m_droppedCount = 0;
+};
+
+// 分发：链的最后一级，把单元交给 fn。需要运行时替换目标时 Fn 用 std::function，只在这一级付出间接调用
+template <typename Fn>
+class ESDispatchStage {
+public:
+    ESDispatchStage() = default;
+
+    explicit ESDispatchStage(Fn fn)
+        : m_fn(std::move(fn))
+    {
+    }
+
+    template <typename Unit, typename Next>
+    void operator()(Unit& unit, Next&&)
+    {
+        m_fn(unit);
+    }
+
+    Fn& GetTarget() { return m_fn; }
+
+private:
+    Fn m_fn;
+};
+
+template <typename... Stages>
+ESPipeline<Stages...> MakeESPipeline(Stages... stages)
+{
+    return ESPipeline<Stages...>(std::move(stages)...);
+}
+
+} // namespace hhcast
\ No newline at end of file
@@ -2,13 +2,22 @@
 
 #include <atomic>
 #include <cstdint>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "hv/TcpServer.h"
 #include "hv/UdpServer.h"
 
+#include "ESEventLoopPool.h"
+#include "ESHandoff.h"
+#include "ESServerConfig.h"
+#include "ESUdpBatchReceiver.h"
+#include "ESUringTcpReceiver.h"
+
 namespace hhcast {
 
 class ESServer;
@@ -21,8 +30,21 @@ public:
     int Start();
     int Stop();
 
+    // 固定端口，多进程时 ESSupervisor 按这份列表预建 reuseport 分组
+    static std::vector<uint16_t> GetFixedTcpPorts();
+    static uint16_t GetDefaultMousePort();
+
     void SetServer(ESServer* server);
 
+    // 需在 Start 之前设置
+    void SetUdpReceiveConfig(const ESUdpReceiveConfig& config);
+    void SetVideoReceiveConfig(const ESVideoReceiveConfig& config);
+    void SetEventLoopConfig(const ESEventLoopConfig& config);
+    void SetSocketConfig(const ESSocketConfig& config);
+    void SetAdmissionConfig(const ESAdmissionConfig& config);
+
+    ESAdmissionStats GetAdmissionStats() const;
+
     bool IsRunning() const;
 
     uint16_t GetVideoPort() const;
@@ -30,14 +52,58 @@ public:
     uint16_t GetDataPort() const;
     uint16_t GetControlPort() const;
 
-private:
-    int StartTcpServer(uint16_t localPort, std::unique_ptr<hv::TcpServer>& server);
-    void StopTcpServer(std::unique_ptr<hv::TcpServer>& server);
+    // 主动关闭某个发送端在控制/视频端口上的连接，可在任意线程调用
+    void ClosePeerConnections(uint32_t streamId);
 
+    // 不停服升级，新进程一侧：Start 前设置，Start 按端口取用其中的监听/UDP socket，
+    // 所有端口就绪后接管已建立的连接。state 只在 Start 期间使用
+    void SetHandoffState(ESHandoffState* state);
+
+    // 旧进程一侧：暂停所有 loop，复制监听和连接 fd 并停止读取；snapshot 在暂停期间调用，用来抓取会话状态
+    int DetachForHandoff(ESHandoffState& state, const std::function<void(ESHandoffState&)>& snapshot);
+    // 交接失败，恢复读取
+    void ResumeAfterHandoff();
+    // 交接成功，关闭本进程的监听引用，不再接受新连接
+    void FinishHandoff();
+
+private:
+    // 不自带线程的 hv 服务端，挂在 m_loopPool 的 loop 上
+    using TcpServer = hv::TcpServerEventLoopTmpl<hv::SocketChannel>;
+    using UdpServer = hv::UdpServerEventLoopTmpl<hv::SocketChannel>;
+
+    int StartTcpServer(uint16_t localPort, std::unique_ptr<TcpServer>& server);
+    void StopTcpServer(std::unique_ptr<TcpServer>& server);
+    // 回调和 socket 参数，listenfd 需已创建
+    void SetupTcpServer(uint16_t localPort, TcpServer& server);
+
+    // 51030：配置了多个分片时走 SO_REUSEPORT，失败回退到单监听 + 工作 loop
+    int StartVideoServers();
+    // adoptedFds 非空时使用接管来的分组，不再创建和挂 steering
+    int StartVideoShards(size_t shards, std::vector<int> adoptedFds = std::vector<int>());
+    void StopVideoShards();
+    // io_uring 收包，每个分片一个 reuseport 监听 + 收包线程
+    int StartUringVideo(size_t shards);
+    void StopUringVideo();
+
+    // 按配置优先用 recvmmsg 批量收包，不可用时回退到 hv::UdpServer
     int StartUdpServer(uint16_t bindPort,
-                       std::unique_ptr<hv::UdpServer>& server,
-                       uint16_t& actualPort);
-    void StopUdpServer(std::unique_ptr<hv::UdpServer>& server);
+                       std::unique_ptr<UdpServer>& server,
+                       std::unique_ptr<ESUdpBatchReceiver>& batchReceiver,
+                       std::atomic<uint16_t>& actualPort,
+                       ESHandoffSocketKind handoffKind);
+    void StopUdpServer(std::unique_ptr<UdpServer>& server,
+                       std::unique_ptr<ESUdpBatchReceiver>& batchReceiver);
+
+    // 关监听 -> 停 loop -> 析构服务端；Start 失败时也走这里
+    void StopServers();
+    size_t GetVideoLoopCount() const;
+    std::vector<hv::EventLoopPtr> CollectLoops() const;
+
+    void AdoptConnections(ESHandoffState& state);
+    void AdoptConnection(ESHandoffSocket socket);
+    hv::EventLoopPtr NextAdoptLoop(uint16_t localPort);
+    std::vector<hv::SocketChannelPtr> GetAdoptedChannels();
+    ESSocketOptions GetSocketOptions(uint16_t localPort, bool tcp) const;
 
     void HandleTcpMessage(uint16_t localPort,
                           const hv::SocketChannelPtr& channel,
@@ -47,32 +113,58 @@ private:
                           const hv::SocketChannelPtr& channel,
                           hv::Buffer* buf);
 
+    void HandleUdpBatch(uint16_t localPort,
+                        const ESUdpDatagram* datagrams,
+                        size_t count);
+
 private:
     ESServer* m_server = nullptr;
     std::atomic<bool> m_running{ false };
 
     uint16_t m_videoPort = 51030;
-    uint16_t m_mousePort = 51050;
-    uint16_t m_dataPort = 0;
-    uint16_t m_controlPort = 0;
-
-    std::unique_ptr<hv::TcpServer> m_tcpServer8700;
-    std::unique_ptr<hv::TcpServer> m_tcpServer8121;
-    std::unique_ptr<hv::TcpServer> m_tcpServer57395;
-    std::unique_ptr<hv::TcpServer> m_tcpServer8600;
-    std::unique_ptr<hv::TcpServer> m_tcpServer51030;
-    std::unique_ptr<hv::TcpServer> m_tcpServer51040;
-
-    std::unique_ptr<hv::TcpServer> m_tcpServer52020;
-    std::unique_ptr<hv::TcpServer> m_tcpServer52025;
-    std::unique_ptr<hv::TcpServer> m_tcpServer52030;
-
-    std::unique_ptr<hv::UdpServer> m_udpServer51050;
-    std::unique_ptr<hv::UdpServer> m_udpServerDataPort;
-    std::unique_ptr<hv::UdpServer> m_udpServerControlPort;
-
-    std::unordered_map<std::string, std::string> m_tcpRecvBuffers8600;
-    std::unordered_map<std::string, std::string> m_tcpRecvBuffers51040;
+    // UDP 收包线程在 StartUdpServer 写回端口前就可能开始调 OnUdpData 读这几个端口
+    std::atomic<uint16_t> m_mousePort{ 51050 };
+    std::atomic<uint16_t> m_dataPort{ 0 };
+    std::atomic<uint16_t> m_controlPort{ 0 };
+
+    std::unique_ptr<TcpServer> m_tcpServer8700;
+    std::unique_ptr<TcpServer> m_tcpServer8121;
+    std::unique_ptr<TcpServer> m_tcpServer57395;
+    std::unique_ptr<TcpServer> m_tcpServer8600;
+    std::vector<std::unique_ptr<TcpServer>> m_tcpServers51030;   // reuseport 时每个分片一个
+    std::unique_ptr<TcpServer> m_tcpServer51040;
+
+    std::unique_ptr<TcpServer> m_tcpServer52020;
+    std::unique_ptr<TcpServer> m_tcpServer52025;
+    std::unique_ptr<TcpServer> m_tcpServer52030;
+
+    std::unique_ptr<UdpServer> m_udpServer51050;
+    std::unique_ptr<UdpServer> m_udpServerDataPort;
+    std::unique_ptr<UdpServer> m_udpServerControlPort;
+
+    ESEventLoopConfig m_eventLoopConfig;
+    ESEventLoopPool m_loopPool;
+    ESEventLoopPool m_videoPool;           // 仅 reuseport 分片时使用
+    ESSocketConfig m_socketConfig;
+    ESAdmissionControl m_admission;
+
+    ESUdpReceiveConfig m_udpReceiveConfig;
+    std::unique_ptr<ESUdpBatchReceiver> m_udpBatch51050;
+    std::unique_ptr<ESUdpBatchReceiver> m_udpBatchDataPort;
+    std::unique_ptr<ESUdpBatchReceiver> m_udpBatchControlPort;
+
+    size_t m_videoWorkerLoops = 0;         // 单监听时 51030 自带的工作 loop 数
+
+    ESVideoReceiveConfig m_videoReceiveConfig;
+    std::vector<std::unique_ptr<ESUringTcpReceiver>> m_uringVideo;
+
+    // 不停服升级
+    ESHandoffState* m_handoffState = nullptr;
+    std::atomic<size_t> m_adoptLoopIndex{ 0 };
+    std::mutex m_adoptedMutex;
+    std::unordered_map<uint32_t, hv::SocketChannelPtr> m_adoptedChannels;
+    std::vector<hv::SocketChannelPtr> m_detachedChannels;
+    std::vector<ESUdpBatchReceiver*> m_pausedReceivers;
 };
 
 } // namespace hhcast
\ No newline at end of file
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "ESClockSync.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace hhcast {
+
+// 影响应答内容的服务端参数，变化后缓存作废
+struct ESReplyParams {
+    uint16_t videoPort = 0;
+    uint16_t dataPort = 0;
+    uint16_t controlPort = 0;
+    uint16_t mousePort = 0;
+
+    int framerate = 30;
+    int width = 3840;
+    int height = 2160;
+    std::string feature = "1";
+    std::string videoFormat = "video:h264";
+
+    bool operator==(const ESReplyParams& other) const;
+    bool operator!=(const ESReplyParams& other) const { return !(*this == other); }
+};
+
+// 51040 / 8700 / 8121 / 57395 的应答预先序列化：
+// - SETUP 的 binary plist 只在首次用 libplist 生成一次模板，记录端口字段偏移，参数变化时原地改写；
+// - 每次请求只拼 CSeq / replyHeartbeat 这类可变部分，其余字节直接拷贝。
+// 可被多个端口的事件循环线程并发调用。
+class ESReplyCache {
+public:
+    ESReplyCache();
+    ~ESReplyCache();
+
+    // 与当前参数相同则什么也不做，调用方可以在每次请求前无条件调用
+    void SetParams(const ESReplyParams& params);
+    ESReplyParams GetParams() const;
+
+    // 51040
+    std::string BuildVideoSetupReply(std::string_view cseq);
+    std::string BuildAudioSetupReply(std::string_view cseq);
+    std::string BuildOptionsReply(std::string_view cseq, std::string_view videoAudio);
+    std::string BuildTeardownReply(std::string_view cseq);
+
+    // 8700
+    std::string BuildProbeReply(std::string_view cseq, bool supported);
+
+    // 8121
+    const std::string& GetServerInfoReply() const;
+    const std::string& GetDongleConnectedReply() const;
+
+    // 57395
+    const std::string& GetClientInfoReply() const;
+    // timing 非空时附带计时字段，只回给带了 sendUs 的发送端
+    std::string BuildHeartbeatReply(int64_t heartbeat, const ESHeartbeatTiming* timing = nullptr) const;
+
+    uint64_t GetRebuildCount() const;   // libplist 完整生成的次数
+    uint64_t GetPatchCount() const;     // 模板原地改写的次数
+
+private:
+    struct PlistTemplate {
+        std::string bytes;
+        size_t portOffsets[3] = { 0, 0, 0 };   // 各端口 2 字节大端值的位置
+        size_t portCount = 0;
+        bool patchable = false;
+    };
+
+    void RefreshLocked();
+    void BuildVideoTemplateLocked();
+    void BuildAudioTemplateLocked();
+
+    static std::string BuildRtspReply(std::string_view statusLine, std::string_view cseq,
+                                      std::string_view headersAndBody);
+    static std::string BuildHeadersAndBody(std::string_view extraHeaders, std::string_view body);
+
+private:
+    mutable std::mutex m_mutex;
+    ESReplyParams m_params;
+    bool m_dirty = true;
+
+    PlistTemplate m_videoTemplate;
+    PlistTemplate m_audioTemplate;
+    int m_videoTemplateFramerate = -1;   // 模板里的非端口字段，变化时需要重新生成
+    int m_videoTemplateWidth = -1;
+    int m_videoTemplateHeight = -1;
+    std::string m_videoTemplateFeature;
+    std::string m_videoTemplateFormat;
+
+    // CSeq 之后的部分（其余头 + Content-Length + 空行 + body）
+    std::string m_videoSetupTail;
+    std::string m_audioSetupTail;
+    std::string m_optionsTail;
+    std::string m_teardownTail;
+    std::string m_probeOkTail;
+    std::string m_probeBadTail;
+
+    std::string m_serverInfo;
+    std::string m_dongleConnected;
+    std::string m_clientInfo;
+
+    uint64_t m_rebuildCount = 0;
+    uint64_t m_patchCount = 0;
+};
+
+} // namespace hhcast
\ No newline at end of file
@@ -1,6 +1,10 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace hhcast {
@@ -19,6 +23,90 @@ struct ESRtspLiteMessage {
     void SetHeader(const std::string& key, const std::string& value);
 };
 
+// 指向接收缓冲内部的只读视图，下一次 Append / Next 之后失效
+struct ESRtspLiteHeaderView {
+    std::string_view key;
+    std::string_view value;
+};
+
+struct ESRtspLiteRequestView {
+    std::string_view raw;          // 整条报文（头 + body）
+    std::string_view startLine;
+    std::string_view method;       // startLine 第一个空格前的部分
+    std::string_view body;         // 51040 SETUP 为 binary plist
+
+    const ESRtspLiteHeaderView* headers = nullptr;
+    size_t headerCount = 0;
+    size_t contentLength = 0;
+
+    // key 大小写不敏感，找不到返回空
+    std::string_view HeaderValue(std::string_view key) const;
+    bool IsMethod(std::string_view name) const;
+};
+
+enum class ESRtspLiteParseResult {
+    NeedMore = 0,
+    Complete = 1,
+    Error    = 2,   // 头部格式错误或超长，调用方应断开/Reset
+};
+
+// 可续传的增量解析器：每个 TCP 连接一个，记住已扫描位置，跨多次读取不重复扫描；
+// 头部就地解析为 string_view，Content-Length 只解析一次。稳态下不分配内存。
+class ESRtspLiteParser {
+public:
+    static constexpr size_t kMaxHeaders = 32;            // 超出时按格式错误处理
+    static constexpr size_t kMaxHeaderBytes = 64 * 1024;
+    static constexpr size_t kMaxBodyBytes = 4 * 1024 * 1024;
+
+    void Append(const char* data, size_t size);
+
+    // 返回 Complete 时 view 有效，直到下一次 Append / Next / Reset
+    ESRtspLiteParseResult Next(ESRtspLiteRequestView& view, std::string* error = nullptr);
+
+    void Reset();
+    size_t GetBufferedSize() const;
+    // 尚未消费的原始字节，重新 Append 到新解析器即可恢复状态（进程交接用）
+    std::string_view GetBuffered() const;
+
+private:
+    friend class ESRtspLiteCodec;
+
+    // 相对报文起点的偏移，缓冲整理/扩容后仍然有效
+    struct HeaderSpan {
+        uint32_t keyOffset = 0;
+        uint32_t keyLength = 0;
+        uint32_t valueOffset = 0;
+        uint32_t valueLength = 0;
+    };
+
+    struct HeadInfo {
+        size_t startLineLength = 0;
+        size_t methodLength = 0;
+        size_t headerCount = 0;
+        size_t contentLength = 0;
+    };
+
+    static bool ParseHead(std::string_view head, HeaderSpan* spans, size_t maxSpans,
+                          HeadInfo& info, std::string* error);
+    static void FillView(std::string_view message, size_t headerSize,
+                         const HeaderSpan* spans, const HeadInfo& info,
+                         ESRtspLiteHeaderView* headers, ESRtspLiteRequestView& view);
+
+    void ConsumePending();
+
+private:
+    std::string m_buffer;
+    size_t m_begin = 0;            // 当前报文起点
+    size_t m_scanPos = 0;          // 头部结束符的续扫位置
+    size_t m_consumePending = 0;   // 上一条 Complete 报文的长度，下次 Next 时再消费
+
+    bool m_headerParsed = false;
+    size_t m_headerSize = 0;       // 含结束空行
+    HeadInfo m_head;
+    std::array<HeaderSpan, kMaxHeaders> m_spans;
+    std::array<ESRtspLiteHeaderView, kMaxHeaders> m_headers;
+};
+
 class ESRtspLiteCodec {
 public:
     // 从 buffer 中尝试解析一条完整消息；成功则消费 buffer 前面的消息字节
@@ -32,6 +120,9 @@ public:
                              ESRtspLiteMessage& msg,
                              std::string* error = nullptr);
 
+    // 视图转成拥有数据的消息，用于需要跨回调保存的场景
+    static void ToMessage(const ESRtspLiteRequestView& view, ESRtspLiteMessage& msg);
+
     static std::string Encode(const ESRtspLiteMessage& msg);
 };
 
@@ -1,18 +1,35 @@
 #pragma once
 
-#include "IESServerCallback.h"
+#include "ESClockSync.h"
+#include "ESServerConfig.h"
+#include "ESSessionTable.h"
+#include "ESTimingWheel.h"
+#include "IESServerCallbackV2.h"
 
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <vector>
+
+namespace hv {
+class EventLoopThread;
+}
 
 namespace hhcast {
 
 class ESSession;
+struct ESConnectionContext;
+struct ESRtspLiteRequestView;
 class ESPortManager;
+class ESMulticastPublisher;
+class ESReplyCache;
+class ESHandoffLink;
+class ESHandoffListener;
+struct ESHandoffState;
 
 class ESServer {
 public:
@@ -22,31 +39,124 @@ public:
     int StartServer();
     int StopServer();
 
+    // 逐条回调，内部经 ESServerCallbackAdapter 转成批量接口
     void SetCallback(std::shared_ptr<IESServerCallback> callback);
+    // 批量回调，与 SetCallback 二选一，后设置的生效
+    void SetCallbackV2(std::shared_ptr<IESServerCallbackV2> callback);
+
+    // 需在 StartServer 之前设置
+    void SetConfig(const ESServerConfig& config);
+    const ESServerConfig& GetConfig() const;
 
     bool IsRunning() const;
 
+    // 音频数据/控制 UDP 端口由系统分配（发送端从 51040 SETUP 应答里拿到），StartServer 成功后有效，否则为 0
+    uint16_t GetAudioDataPort() const;
+    uint16_t GetAudioControlPort() const;
+
+    // 覆盖单个会话的超时（0 不检查），立即按新值重新排期；会话不存在返回 -1
+    int SetSessionTimeout(uint32_t streamId, uint32_t heartbeatTimeoutMs, uint32_t mediaTimeoutMs);
+
+    // 心跳测得的 RTT / 时钟偏差（发送端带了计时字段才有）；会话不存在返回 -1
+    int GetSessionClockSync(uint32_t streamId, ESClockSyncStats& stats);
+
+    // 连接数/限速的拒绝计数
+    ESAdmissionStats GetAdmissionStats() const;
+
+    size_t GetSessionCount() const;
+
+    // 单个会话的资源统计，速率和配额字段是最近一个采样周期的；会话不存在返回 -1
+    int GetSessionResources(uint32_t streamId, ESSessionResourceStats& stats);
+    // 最近一个采样周期的全部会话，sessionQuota.sampleIntervalMs 为 0 时为空
+    std::vector<ESSessionResourceStats> GetResourceSnapshot() const;
+
+    // 需在 StartServer 之前设置：各端口优先使用 state 里预先建好的监听/UDP socket（ESSupervisor 的 worker 用），
+    // 没有的端口照常创建。state 只在 StartServer 期间使用，取走的 fd 归服务端
+    void SetInheritedSockets(ESHandoffState* state);
+
 private:
     friend class ESPortManager;
 
     void OnTcpConnected(uint16_t localPort, const std::string& peerIp);
     void OnTcpDisconnected(uint16_t localPort, const std::string& peerIp);
     std::string HandleTcpRequest(uint16_t localPort, const std::string& peerIp, const std::string& request);
+    // 51040 已解析的请求，req 指向连接接收缓冲，只在调用期间有效
+    std::string HandleRtspRequest(const std::string& peerIp, const ESRtspLiteRequestView& req);
+    // 57395 切好的一行 JSON，line 指向连接接收缓冲，只在调用期间有效
+    std::string HandleEshareJsonLine(const std::string& peerIp, std::string_view line);
 
-    void OnTcpData(uint16_t localPort, const std::string& peerIp, const uint8_t* data, size_t size);
-    void OnUdpData(uint16_t localPort, const std::string& peerIp, const uint8_t* data, size_t size);
+    // 51030 视频数据，会话指针缓存在连接上下文里
+    void OnVideoTcpData(ESConnectionContext& context, const uint8_t* data, size_t size);
+    // peerIp 即 streamId（主机字节序 IPv4），收包路径上不转字符串；rxTimestampUs: 内核收包时间戳，0 表示使用本地时钟
+    void OnUdpData(uint16_t localPort, uint32_t peerIp, const uint8_t* data, size_t size,
+                   uint64_t rxTimestampUs = 0);
 
     std::shared_ptr<ESSession> GetSession(uint32_t streamId);
     std::shared_ptr<ESSession> CreateSession(uint32_t streamId);
-    void RemoveSession(uint32_t streamId);
+    // 移除会话并回调；同一会话只会关闭一次，返回是否由本次调用关闭
+    bool CloseSession(uint32_t streamId, ESSessionCloseCause cause);
     void ClearSessions();
 
+    // 会话超时回收：时间轮在独立的 hv 循环上按 tick 推进，活动时间只在到期时检查
+    void StartSessionReaper();
+    void StopSessionReaper();
+    void ScheduleSessionCheck(uint32_t streamId, uint64_t delayMs);
+    void OnSessionReaperTick();
+    void CheckSessionTimeout(uint32_t streamId, uint64_t nowMs);
+    // 资源采样和配额检查，与超时回收同一个线程
+    void OnResourceSampleTick();
+    // 各会话抖动缓冲按时间出包，同在 reaper 线程；流停顿时尾包靠它放出
+    void OnAudioPollTick();
+
+    // 不停服升级：新进程从旧进程收状态，旧进程在交接线程里处理请求
+    int ReceiveHandoff(ESHandoffLink& link, ESHandoffState& state);
+    void RestoreSessions(const ESHandoffState& state);
+    void SnapshotSessions(ESHandoffState& state);
+    void HandleHandoffRequest(ESHandoffLink& link);
+
+    // 作用域内（同一线程）产生的媒体攒成一批，最外层作用域结束时一次回调；
+    // 作用域外产生的媒体立即按单条批次回调
+    class MediaBatchScope {
+    public:
+        explicit MediaBatchScope(ESServer& server);
+        ~MediaBatchScope();
+
+        MediaBatchScope(const MediaBatchScope&) = delete;
+        MediaBatchScope& operator=(const MediaBatchScope&) = delete;
+
+    private:
+        ESServer& m_server;
+        bool m_active = false;
+    };
+
+    void NotifySessionOpen(const std::shared_ptr<ESSession>& session, const std::string& peerIp, bool restored);
+    void DeliverVideo(ESVideoEvent&& event);
+    void DeliverAudio(ESAudioEvent&& event);
+    void FlushMediaBatch();
+
 private:
     std::atomic<bool> m_running{ false };
-    std::shared_ptr<IESServerCallback> m_callback = nullptr;
+    std::shared_ptr<IESServerCallbackV2> m_callback = nullptr;
+
+    ESServerConfig m_config;
 
     std::unique_ptr<ESPortManager> m_portManager;
-    std::unordered_map<uint32_t, std::shared_ptr<ESSession>> m_sessions;
+    std::unique_ptr<ESMulticastPublisher> m_multicastPublisher;
+    std::unique_ptr<ESReplyCache> m_replyCache;
+    ESSessionTable m_sessions;             // 媒体路径上的查找不拿锁
+    std::mutex m_createMutex;              // 串行化 CreateSession，同一 streamId 只建一次、只通知一次
+
+    std::unique_ptr<hv::EventLoopThread> m_reaperThread;
+    std::mutex m_wheelMutex;
+    ESTimingWheel m_sessionWheel;
+    std::vector<uint64_t> m_reaperExpired;   // 只在 reaper 线程使用
+
+    mutable std::mutex m_resourceMutex;
+    std::vector<ESSessionResourceStats> m_resourceSnapshot;
+
+    ESHandoffState* m_inheritedSockets = nullptr;
+    std::unique_ptr<ESHandoffListener> m_handoffListener;
+    std::atomic<bool> m_handedOff{ false };  // 之后关闭的会话原因都记为 HandedOff
 };
 
 } // namespace hhcast
\ No newline at end of file
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "ESAdmissionControl.h"
+#include "ESAudioDecodeStage.h"
+#include "ESAudioDriftResampler.h"
+#include "ESAudioJitterBuffer.h"
+#include "ESAvSyncEngine.h"
+#include "ESFecCodec.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace hhcast {
+
+struct ESMulticastConfig {
+    bool enabled = false;
+
+    std::string group = "239.255.42.1";
+    uint16_t port = 52100;
+    std::string interfaceIp = "0.0.0.0";   // 发送/加组使用的本地网卡地址
+    int ttl = 1;
+    bool loopback = true;                  // 本机回环，便于同机自测
+
+    size_t maxDatagramSize = 1400;         // 单个 UDP 负载上限（含组播头）
+    size_t maxUnitSize = 8 * 1024 * 1024;  // 单个 unit（ES 头 + 帧 / RTP 包）上限，超过的发送端不发、接收端丢弃
+
+    ESFecScheme fecScheme = ESFecScheme::Xor;
+    uint8_t fecDataShards = 8;
+    uint8_t fecParityShards = 1;           // Xor 时忽略，固定为 1
+};
+
+enum class ESUdpBackend : uint8_t {
+    Hv       = 0,   // hv::UdpServer，每个 datagram 一次 recvfrom
+    RecvMmsg = 1,   // Linux recvmmsg 批量收包，其他平台或启动失败时回退到 Hv
+    IoUring  = 2,   // io_uring multishot recvmsg，内核不支持时依次回退到 RecvMmsg、Hv
+};
+
+// 音频 data / control / mouse 三个 UDP 端口的收包方式
+struct ESUdpReceiveConfig {
+    ESUdpBackend backend = ESUdpBackend::Hv;
+    size_t batchSize = 32;                 // 单次 recvmmsg 最多取的包数；IoUring 时缓冲环为其 4 倍
+    size_t maxDatagramSize = 2048;
+    bool kernelTimestamps = true;          // SO_TIMESTAMPNS，作为音频抖动估计的到达时间
+};
+
+enum class ESVideoBackend : uint8_t {
+    Hv      = 0,    // hv::TcpServer
+    IoUring = 1,    // 每个分片一个 io_uring 线程，multishot accept/recv，数据直接从缓冲环交给拆包；
+                    // 内核不支持时回退到 Hv。不支持不停服升级，handoff.enabled 时忽略
+};
+
+// 51030 的收包方式，分片数沿用 socket.videoReusePortShards（不足 1 按 1）
+struct ESVideoReceiveConfig {
+    ESVideoBackend backend = ESVideoBackend::Hv;
+    uint32_t bufferCount = 512;            // 每个分片的提供缓冲个数，向上取 2 的幂
+    uint32_t bufferSize = 32 * 1024;
+};
+
+// 会话存活判定。发送端静默消失（如 Wi-Fi 掉线）时 TCP 不一定断开，靠超时回收
+struct ESSessionTimeoutConfig {
+    bool enabled = true;
+    uint32_t heartbeatTimeoutMs = 15000;   // 57395 心跳（含 client-info）间隔上限，0 不检查
+    uint32_t mediaTimeoutMs = 0;           // 收到过媒体后媒体中断的上限，0 不检查
+    uint32_t tickMs = 250;                 // 时间轮精度，整个服务共用
+};
+
+enum class ESQuotaAction : uint8_t {
+    None       = 0,    // 只记录、上报
+    Degrade    = 1,    // 释放空闲缓冲，暂停音频解码和组播转发；媒体照常回调
+    Disconnect = 2,    // 关闭会话，原因 QuotaExceeded
+};
+
+// 单会话资源统计与配额。每个采样周期算一次 CPU 占用和码率，检查配额并回调快照；
+// 限制值为 0 表示不检查该项
+struct ESSessionQuotaConfig {
+    uint32_t sampleIntervalMs = 0;         // 0 关闭统计（不再读线程 CPU 时钟）
+    size_t softMemoryBytes = 0;            // 按 ESSessionResourceStats::allocatedBytes
+    size_t hardMemoryBytes = 0;
+    uint32_t softCpuPermille = 0;          // 一个周期内占单核的千分比
+    uint32_t hardCpuPermille = 0;
+    uint64_t softBytesPerSec = 0;          // 各端口入流量合计
+    uint64_t hardBytesPerSec = 0;
+    ESQuotaAction softAction = ESQuotaAction::Degrade;
+    ESQuotaAction hardAction = ESQuotaAction::Disconnect;
+    uint32_t hardGraceIntervals = 2;       // 连续这么多个周期超过硬配额才执行，躲开瞬时尖峰
+};
+
+enum class ESLoopBalance {
+    RoundRobin,
+    LeastConnections,
+};
+
+// hv 事件循环：所有 TCP/UDP 监听共用 sharedLoops 个 loop，51030 的连接另分到 videoLoops 个工作 loop
+struct ESEventLoopConfig {
+    size_t sharedLoops = 2;
+    size_t videoLoops = 0;                 // 0 = 按 CPU 核数自动，最多 4 个
+    ESLoopBalance videoBalance = ESLoopBalance::LeastConnections;
+    std::vector<int> sharedCpus;           // 绑核，按 loop 下标循环取；空则不绑（仅 Linux）
+    std::vector<int> videoCpus;
+};
+
+// 单个端口的 socket 参数，0/false 表示保持系统默认
+struct ESSocketOptions {
+    int recvBufferBytes = 0;               // SO_RCVBUF（Linux 读回值是设置值的 2 倍）
+    int sendBufferBytes = 0;               // SO_SNDBUF
+    bool tcpNoDelay = false;               // TCP_NODELAY
+    bool tcpQuickAck = false;              // TCP_QUICKACK，每次读完数据后重新打开（仅 Linux）
+    int busyPollUs = 0;                    // SO_BUSY_POLL，超过 net.core.busy_read 需要 CAP_NET_ADMIN（仅 Linux）
+};
+
+enum class ESReusePortSteering {
+    Kernel,                                // 内核默认的四元组哈希
+    PeerIp,                                // 源 IP 取模，同一发送端的连接固定落在同一分片
+    Cpu,                                   // 收包 CPU 取模，配合 eventLoop.videoCpus 把分片 i 绑到 CPU i
+};
+
+struct ESSocketConfig {
+    ESSocketOptions video;                 // 51030 监听及其连接
+    ESSocketOptions control;               // 其余 TCP 端口
+    ESSocketOptions udp;                   // 51050 和动态分配的数据/控制 UDP 端口，含 recvmmsg 后端
+    std::map<uint16_t, ESSocketOptions> ports;   // 按本地端口整体覆盖上面的分组
+
+    // >1 时 51030 开 N 个 SO_REUSEPORT 监听，各占一个视频 loop，代替 eventLoop.videoLoops（仅 Linux）
+    size_t videoReusePortShards = 0;
+    ESReusePortSteering videoSteering = ESReusePortSteering::Kernel;
+};
+
+// 不停服升级（仅 Linux）：StartServer 先连 socketPath，有旧进程就接手它的监听、连接和会话，
+// 之后自己在 socketPath 上等下一个进程。timeoutMs 是交接中每一步的等待上限
+struct ESHandoffConfig {
+    bool enabled = false;
+    std::string socketPath = "/tmp/esserver-handoff.sock";
+    uint32_t timeoutMs = 3000;
+};
+
+struct ESServerConfig {
+    ESMulticastConfig multicast;
+    ESAudioJitterConfig audioJitter;
+    ESAudioDecodeConfig audioDecode;
+    ESAudioDriftConfig audioDrift;         // 需同时打开 audioDecode
+    ESAvSyncConfig avSync;
+    ESUdpReceiveConfig udpReceive;
+    ESVideoReceiveConfig videoReceive;
+    ESSessionTimeoutConfig sessionTimeout; // 单个会话可用 ESServer::SetSessionTimeout 覆盖
+    ESSessionQuotaConfig sessionQuota;
+    ESEventLoopConfig eventLoop;
+    ESSocketConfig socket;
+    ESAdmissionConfig admission;
+    ESHandoffConfig handoff;
+};
+
+} // namespace hhcast
\ No newline at end of file
@@ -1,11 +1,22 @@
 #pragma once
 
 #include "ESAudioDatagramParser.h"
+#include "ESAudioDecodeStage.h"
+#include "ESAudioDriftResampler.h"
+#include "ESAudioJitterBuffer.h"
+#include "ESAvSyncEngine.h"
+#include "ESClockSync.h"
+#include "ESPipeline.h"
+#include "ESServerConfig.h"
+#include "ESSessionAccounting.h"
 #include "ESVideoDepacketizer.h"
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
 
 namespace hhcast {
@@ -22,6 +33,18 @@ using ESSessionAudioCallback = std::function<void(
     size_t size,
     const ESAudioPayloadInfo& info)>;
 
+using ESSessionAudioGapCallback = std::function<void(
+    uint32_t streamId,
+    const ESAudioGapInfo& gap)>;
+
+using ESSessionAudioPcmCallback = std::function<void(
+    uint32_t streamId,
+    const ESPcmFrame& frame)>;
+
+using ESSessionAvSyncCallback = std::function<void(
+    uint32_t streamId,
+    const ESAvSyncStats& stats)>;
+
 class ESSession {
 public:
     explicit ESSession(uint32_t streamId);
@@ -29,34 +52,140 @@ public:
 
     uint32_t GetStreamId() const;
 
+    // client-info 重连时会在 57395 的 loop 上改写，回调和 SnapshotSessions 在别的线程读，返回拷贝
     void SetPeerIp(const std::string& peerIp);
-    const std::string& GetPeerIp() const;
+    std::string GetPeerIp() const;
 
     void SetName(const std::string& name);
-    const std::string& GetName() const;
+    std::string GetName() const;
 
     void SetVideoCallback(ESSessionVideoCallback callback);
     void SetAudioCallback(ESSessionAudioCallback callback);
+    void SetAudioGapCallback(ESSessionAudioGapCallback callback);
+
+    // 音频 RTP 先进抖动缓冲排序去重，再回调；enabled=false 时按到达顺序直通
+    void SetAudioJitterConfig(const ESAudioJitterConfig& config);
+    ESAudioJitterStats GetAudioJitterStats() const;
+
+    // 抖动缓冲只在新包到达时出包，流停顿时由定时器 PollAudio 按时间放出；关闭前 FlushAudio 吐出剩余的包。
+    // 两者与 InputAudioUdpDatagram 可以在不同线程，音频回调在本会话的音频锁内发生，回调里不要再调本会话的音频接口
+    void PollAudio(uint64_t nowUs);
+    void FlushAudio();
+
+    // 抖动缓冲输出再送到独立线程解码，PCM 在解码线程回调
+    int EnableAudioDecode(const ESAudioDecodeConfig& config, ESSessionAudioPcmCallback callback);
+    void DisableAudioDecode();
+
+    // 解码输出再进变速重采样，播放端按本地时钟从返回的对象 Pull；需在 EnableAudioDecode 之前调用
+    std::shared_ptr<ESAudioDriftResampler> EnableAudioDriftCompensation(const ESAudioDriftConfig& config);
+    ESAudioDriftStats GetAudioDriftStats() const;
+
+    // 视频/音频回调里的 presentationUs 由此计算；控制端口同步包用于锚定音频 RTP 时钟
+    void SetAvSyncConfig(const ESAvSyncConfig& config);
+    void SetAvSyncCallback(ESSessionAvSyncCallback callback);
+    ESAvSyncStats GetAvSyncStats() const;
+    bool InputAudioControlDatagram(const uint8_t* data, size_t size);
 
     bool InputVideoTcpData(const uint8_t* data, size_t size);
-    bool InputAudioUdpDatagram(const uint8_t* data, size_t size);
+    // arrivalUs 必须是 steady_clock 微秒（GetSteadyTimeUs 的时基），为 0 时取当前时间；会话已关闭时丢弃
+    bool InputAudioUdpDatagram(const uint8_t* data, size_t size, uint64_t arrivalUs = 0);
 
     void ResetMediaState();
 
+    // 存活判定用的最近活动时间（steady 毫秒），媒体在各 Input 接口里自动记录；可跨线程读取
+    void SetTimeoutConfig(const ESSessionTimeoutConfig& config);
+    ESSessionTimeoutConfig GetTimeoutConfig() const;
+    void MarkHeartbeat();
+    uint64_t GetLastHeartbeatMs() const;
+    uint64_t GetLastMediaMs() const;   // 0 表示还没收到过媒体
+
+    // ESServer 移除会话时标记，连接上缓存的会话指针据此失效
+    void MarkClosed();
+    bool IsClosed() const;
+
+    // 视频解包器里残留的半帧，调用方需保证视频输入线程此时没有在写（进程交接时各 loop 已暂停）
+    std::string GetVideoPendingBytes() const;
+
+    // 心跳计时字段凑成的往返样本；发送端重连（client-info）时 Reset
+    bool InputClockExchange(const ESClockExchange& exchange);
+    ESClockSyncStats GetClockSyncStats() const;
+    void ResetClockSync();
+
+    // 需在收媒体之前设置；关闭时不读线程 CPU 时钟，只计端口流量和缓冲量
+    void SetAccountingEnabled(bool enabled);
+    void AddDispatchCpuNs(uint64_t ns);
+    ESQuotaLevel GetQuotaLevel() const;
+    bool IsDegraded() const;
+    // 可跨线程读取；速率和配额字段是最近一次 SampleResources 的结果
+    void GetResourceStats(ESSessionResourceStats& stats) const;
+    // 只在采样线程调用：采样、检查配额，返回需要执行的动作。进入降级时释放空闲缓冲，
+    // 降级期间不送音频解码；组播转发由 ESServer 按 IsDegraded 跳过
+    ESQuotaAction SampleResources(const ESSessionQuotaConfig& config, uint64_t nowMs, ESSessionResourceStats& stats);
+
 private:
+    // 视频链：解包器拉出的单元 → 去掉未知类型和空单元 → OnVideoUnitReady，整条链内联
+    struct KnownVideoUnit {
+        bool operator()(const ESVideoUnit& unit) const
+        {
+            return (unit.kind == ESVideoUnitKind::Config || unit.kind == ESVideoUnitKind::Frame) &&
+                   unit.payloadSize > 0;
+        }
+    };
+
+    struct VideoUnitTarget {
+        ESSession* session;
+
+        void operator()(const ESVideoUnit& unit) const
+        {
+            session->OnVideoUnitReady(unit);
+        }
+    };
+
+    using VideoPipeline = ESPipeline<ESFilterStage<KnownVideoUnit>, ESDispatchStage<VideoUnitTarget>>;
+
     void OnVideoUnitReady(const ESVideoUnit& unit);
     void OnAudioPayloadReady(const ESAudioPayloadInfo& info);
+    void OnAudioGap(const ESAudioGapInfo& gap);
+    void MaybeReportAvSync(uint64_t nowUs);
+    // 各在自己的输入线程上调用，只读本路的状态；音频的在音频锁内调用
+    void UpdateVideoGauges();
+    void UpdateAudioGauges();
 
 private:
     uint32_t m_streamId = 0;
+    mutable std::mutex m_infoMutex;    // 只保护 m_peerIp / m_name
     std::string m_peerIp;
     std::string m_name;
 
     ESVideoDepacketizer m_videoDepacketizer;
+    VideoPipeline m_videoPipeline;
+    mutable std::mutex m_audioMutex;   // 音频输入线程和定时出包线程共用解析器与抖动缓冲
     ESAudioDatagramParser m_audioDatagramParser;
+    ESAudioJitterBuffer m_audioJitterBuffer;
+    std::unique_ptr<ESAudioDecodeStage> m_audioDecodeStage;
+    std::shared_ptr<ESAudioDriftResampler> m_audioDrift;
+    ESAvSyncEngine m_avSync;
+    ESClockSync m_clockSync;
 
     ESSessionVideoCallback m_videoCallback;
     ESSessionAudioCallback m_audioCallback;
+    ESSessionAudioGapCallback m_audioGapCallback;
+    ESSessionAvSyncCallback m_avSyncCallback;
+
+    uint64_t m_audioArrivalUs = 0;   // 当前 datagram 的到达时间，拆出的多个 RTP 包共用
+    uint64_t m_audioLocalUs = 0;     // 同上，但固定用 steady_clock，与视频同一时钟
+    uint64_t m_videoLocalUs = 0;
+    std::atomic<uint64_t> m_lastAvSyncReportUs{ 0 };   // 视频循环和音频线程都会上报，用 CAS 抢上报名额
+
+    std::atomic<uint32_t> m_heartbeatTimeoutMs{ 0 };
+    std::atomic<uint32_t> m_mediaTimeoutMs{ 0 };
+    std::atomic<uint64_t> m_lastHeartbeatMs{ 0 };
+    std::atomic<uint64_t> m_lastMediaMs{ 0 };
+    std::atomic<bool> m_closed{ false };
+
+    ESSessionAccounting m_accounting;
+    bool m_accountingEnabled = false;
+    std::atomic<bool> m_releasePending{ false };   // 刚进入降级，下次视频输入时归还解包器多余容量
 };
 
 } // namespace hhcast
\ No newline at end of file
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "ESServerConfig.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace hhcast {
+
+struct ESTrafficCounter {
+    uint64_t packets = 0;                  // TCP 为读次数，UDP 为 datagram 数
+    uint64_t bytes = 0;
+};
+
+enum class ESQuotaLevel : uint8_t {
+    Normal = 0,
+    Soft   = 1,
+    Hard   = 2,
+};
+
+struct ESSessionResourceStats {
+    uint32_t streamId = 0;
+    uint64_t sampledMs = 0;                // 采样时的 steady 毫秒
+
+    // buffered 是收到但还没交出去的数据；allocated 另含各缓冲预留的容量
+    size_t videoBufferedBytes = 0;         // 视频解包器里的半个单元
+    size_t audioBufferedBytes = 0;         // 抖动缓冲 + 解码队列
+    size_t allocatedBytes = 0;
+
+    // 线程 CPU 时间累计值，统计关闭或平台不支持时为 0
+    uint64_t parseCpuNs = 0;               // 会话 Input 接口内：拆包、抖动缓冲、入批
+    uint64_t dispatchCpuNs = 0;            // 批量回调按事件数分摊到各会话
+    uint64_t decodeCpuNs = 0;              // 音频解码线程
+
+    ESTrafficCounter video;                // 51030
+    ESTrafficCounter audioData;            // 数据 UDP 端口
+    ESTrafficCounter audioControl;         // 控制 UDP 端口
+
+    // 以下按最近一个采样周期计算
+    uint32_t cpuPermille = 0;              // 三项 CPU 合计占单核的千分比
+    uint64_t bytesPerSec = 0;              // 三路入流量合计
+
+    ESQuotaLevel level = ESQuotaLevel::Normal;
+    bool degraded = false;
+    uint32_t softViolations = 0;           // 从正常进入超配额的次数
+    uint32_t hardViolations = 0;           // 超过硬配额的周期数
+};
+
+// 会话的资源计数。Add / Set 在媒体输入线程调用，Sample 只在采样线程调用，Fill 任意线程。
+// 视频和音频的缓冲量各由自己的输入线程写，互不读对方的状态，Fill 时再合计 allocated
+class ESSessionAccounting {
+public:
+    enum class Port : uint8_t {
+        Video,
+        AudioData,
+        AudioControl,
+    };
+
+    void AddTraffic(Port port, size_t bytes);
+    void AddParseCpuNs(uint64_t ns);
+    void AddDispatchCpuNs(uint64_t ns);
+    void SetVideoBuffered(size_t buffered, size_t allocated);
+    void SetAudioBuffered(size_t buffered, size_t allocated);
+
+    // 累计值和最近一次 Sample 算出的速率
+    void Fill(ESSessionResourceStats& stats) const;
+
+    // stats 需已填好累计值（含 decodeCpuNs），与上一次采样相比算出速率，写回 stats 并记下
+    void Sample(uint64_t nowMs, ESSessionResourceStats& stats);
+
+    // 紧接 Sample 调用：按配置判定本周期的配额级别，更新 stats 里的配额字段，返回需要执行的动作。
+    // 软配额的动作持续到回落为止；硬配额连续 hardGraceIntervals 个周期才执行硬动作，之前按软配额处理
+    ESQuotaAction CheckQuota(const ESSessionQuotaConfig& config, ESSessionResourceStats& stats);
+    ESQuotaLevel GetQuotaLevel() const;
+    bool IsDegraded() const;
+
+private:
+    struct Counter {
+        std::atomic<uint64_t> packets{ 0 };
+        std::atomic<uint64_t> bytes{ 0 };
+    };
+
+    Counter m_video;
+    Counter m_audioData;
+    Counter m_audioControl;
+
+    std::atomic<uint64_t> m_parseCpuNs{ 0 };
+    std::atomic<uint64_t> m_dispatchCpuNs{ 0 };
+
+    std::atomic<size_t> m_videoBuffered{ 0 };
+    std::atomic<size_t> m_videoAllocated{ 0 };
+    std::atomic<size_t> m_audioBuffered{ 0 };
+    std::atomic<size_t> m_audioAllocated{ 0 };
+
+    std::atomic<uint32_t> m_cpuPermille{ 0 };
+    std::atomic<uint64_t> m_bytesPerSec{ 0 };
+    std::atomic<uint8_t> m_level{ 0 };
+    std::atomic<bool> m_degraded{ false };
+    std::atomic<uint32_t> m_softViolations{ 0 };
+    std::atomic<uint32_t> m_hardViolations{ 0 };
+
+    // 只在采样线程使用
+    uint64_t m_lastSampleMs = 0;
+    uint64_t m_lastCpuNs = 0;
+    uint64_t m_lastBytes = 0;
+    uint32_t m_hardRun = 0;
+};
+
+} // namespace hhcast
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace hhcast {
+
+class ESSession;
+
+using ESSessionPtr = std::shared_ptr<ESSession>;
+
+// 按 streamId 分片的会话表。每个分片持有一份只读快照（shared_ptr 指向的 map），
+// 查找取快照再查，不拿分片的写锁，写者复制 map 期间读者不等；增删在写锁内复制快照、修改后整体替换（写少读多）。
+// 注意查找并非无锁：C++17 的 std::atomic_load(shared_ptr*) 在 libstdc++/libc++ 里按地址取全局哈希自旋锁，
+// 且每次 Find 对快照控制块做一次加减引用计数、对会话控制块加一次，同分片的读者在这几个缓存行上互相争用。
+// TCP 视频在连接上缓存会话指针，只在首包或会话换代（见 IsClosed）时 Find；UDP 音频每个 datagram 仍 Find 一次。
+// 取到的 ESSessionPtr 自带引用计数，会话被移除后手里的指针在回调期间依旧有效，
+// 调用方用 ESSession::IsClosed 判断是否已关闭。
+class ESSessionTable {
+public:
+    static constexpr size_t kShardCount = 16;
+
+    using Entry = std::pair<uint32_t, ESSessionPtr>;
+
+    ESSessionTable();
+
+    ESSessionPtr Find(uint32_t streamId) const;
+
+    // 已存在时不覆盖，返回表里的那个；插入成功返回 session 本身
+    ESSessionPtr Insert(uint32_t streamId, ESSessionPtr session);
+
+    // 返回被移除的会话，不存在返回空
+    ESSessionPtr Remove(uint32_t streamId);
+
+    // 取走全部会话，表清空
+    std::vector<Entry> TakeAll();
+
+    // 各分片快照的拼接，不保证跨分片的一致性
+    std::vector<Entry> Snapshot() const;
+
+    size_t Size() const;
+
+private:
+    using Map = std::unordered_map<uint32_t, ESSessionPtr>;
+    using MapPtr = std::shared_ptr<const Map>;
+
+    struct Shard {
+        std::mutex writeMutex;     // 只串行化写者
+        MapPtr map;                // 经 std::atomic_load/atomic_store 访问（内部是全局锁池，不是无锁）
+    };
+
+    Shard& GetShard(uint32_t streamId);
+    const Shard& GetShard(uint32_t streamId) const;
+
+private:
+    std::array<Shard, kShardCount> m_shards;
+    std::atomic<size_t> m_size{ 0 };
+};
+
+} // namespace hhcast
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "ESServerConfig.h"
+
+namespace hhcast {
+
+// 按 options 设置 fd，tcp 为 false 时跳过 TCP 专有选项。返回设置失败的选项个数，失败原因打日志
+int ApplySocketOptions(int fd, const ESSocketOptions& options, bool tcp, const std::string& tag);
+
+// TCP_QUICKACK 不是持久状态，内核回到延迟确认后会清掉，读完一批数据后调用
+void RearmTcpQuickAck(int fd);
+
+// 读回实际生效的值，调参时和压测结果对照
+std::string DescribeSocketOptions(int fd, bool tcp);
+
+// 带 SO_REUSEADDR + SO_REUSEPORT 的 IPv4 监听 socket，已 listen；失败返回 -1（非 Linux 直接失败）
+int CreateReusePortListener(uint16_t port, const char* host = "0.0.0.0");
+// 同上，UDP，已 bind
+int CreateReusePortUdpSocket(uint16_t port, const char* host = "0.0.0.0");
+
+// 给 reuseport 组挂 CBPF 分片选择程序，组内任一 fd 调用一次即可；Kernel 时不做处理
+bool AttachReusePortSteering(int fd, ESReusePortSteering steering, size_t shardCount);
+
+void CloseSocketFd(int fd);
+
+} // namespace hhcast
\ No newline at end of file
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "ESAdmissionControl.h"
+#include "ESServerConfig.h"
+
+namespace hhcast {
+
+class ESServer;
+
+struct ESSupervisorConfig {
+    size_t workers = 0;                    // 0 = CPU 核数，最多 8 个
+    uint32_t restartDelayMs = 500;         // worker 退出后的重启等待，连续崩溃时翻倍
+    uint32_t maxRestartDelayMs = 10000;
+    uint32_t stableUptimeMs = 30000;       // 运行超过该时长再退出，重启等待回到初值
+    uint32_t statsIntervalMs = 2000;       // worker 上报和汇总回调的间隔
+    uint32_t stopTimeoutMs = 5000;         // 停止时等 worker 自行退出的上限，超时 SIGKILL
+};
+
+struct ESWorkerStats {
+    size_t index = 0;
+    int pid = 0;                           // 0 表示当前没有进程
+    bool running = false;
+    uint32_t restartCount = 0;
+    int lastExitStatus = 0;                // waitpid 的原始 status
+    uint64_t startedMs = 0;                // supervisor 单调时钟
+    uint64_t reportedMs = 0;               // 最近一次收到上报
+
+    uint64_t sessionCount = 0;
+    ESAdmissionStats admission;
+};
+
+struct ESSupervisorStats {
+    std::vector<ESWorkerStats> workers;
+    size_t runningWorkers = 0;
+    uint64_t sessionCount = 0;
+    uint64_t restartCount = 0;
+    ESAdmissionStats admission;            // 各 worker 相加
+};
+
+// 多进程接收端（仅 Linux）：supervisor 预先为每个固定端口建 N 个 SO_REUSEPORT socket，
+// 挂按源 IP 取模的 steering 后 fork 出 N 个 ESServer worker，worker i 只用每组里的第 i 个。
+// 同一发送端（streamId 即源 IP）的控制、视频、鼠标连接都落在同一个 worker 上；
+// 一个 worker 崩溃只影响分到它的发送端，supervisor 持有全部 socket，组内下标不变，
+// 期间到达的连接在 backlog 里排队，重启后的 worker 接着 accept。
+// 数据/控制 UDP 端口是每个 worker 动态分配的，随 SETUP 应答告诉发送端，不需要分组。
+class ESSupervisor {
+public:
+    // 在 worker 进程里、StartServer 之前调用，用来设置回调等；workerIndex 从 0 开始
+    using WorkerSetup = std::function<void(ESServer& server, size_t workerIndex)>;
+    // 在 Run 所在线程调用
+    using StatsCallback = std::function<void(const ESSupervisorStats& stats)>;
+
+    ESSupervisor();
+    ~ESSupervisor();
+
+    ESSupervisor(const ESSupervisor&) = delete;
+    ESSupervisor& operator=(const ESSupervisor&) = delete;
+
+    // 需在 Run 之前设置。worker 里 handoff 总是关闭（交接路径会互相冲突）
+    void SetConfig(const ESSupervisorConfig& config, const ESServerConfig& serverConfig);
+    void SetWorkerSetup(WorkerSetup setup);
+    void SetStatsCallback(StatsCallback callback);
+
+    // 阻塞直到 RequestStop。fork 要求调用时进程里没有其他线程，应在 main 里最先调用。
+    // 只在 supervisor 进程返回，worker 进程以 _exit 结束
+    int Run();
+
+    // 可在信号处理函数里调用
+    void RequestStop();
+
+    ESSupervisorStats GetStats() const;
+
+private:
+    struct Worker;
+
+    int CreateSockets();
+    void CloseSockets();
+    int SpawnWorker(size_t index);
+    [[noreturn]] void RunWorker(size_t index, int reportFd);
+    void ReapWorkers(uint64_t nowMs);
+    void ReadReports(const std::vector<size_t>& readable, uint64_t nowMs);
+    void StopWorkers();
+    void ReportStats();
+
+private:
+    ESSupervisorConfig m_config;
+    ESServerConfig m_serverConfig;
+    WorkerSetup m_setup;
+    StatsCallback m_statsCallback;
+
+    size_t m_workerCount = 0;
+    int m_stopPipe[2] = { -1, -1 };
+
+    // 每个端口一组，组内下标即 worker 下标
+    struct SocketGroup {
+        uint16_t port = 0;
+        bool tcp = true;
+        std::vector<int> fds;
+    };
+    std::vector<SocketGroup> m_groups;
+
+    mutable std::mutex m_mutex;
+    std::vector<Worker> m_workers;
+};
+
+} // namespace hhcast
\ No newline at end of file
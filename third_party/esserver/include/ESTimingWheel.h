@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace hhcast {
+
+// 分层时间轮：4 层 × 64 槽，按 tick 推进，调度/取消 O(1)。
+// 同一 key 只保留最后一次调度；取消和重调度都是惰性的，旧槽位里的记录在轮转到时丢弃。
+// 非线程安全，调用方自行加锁。
+class ESTimingWheel {
+public:
+    using ExpireCallback = std::function<void(uint64_t key)>;
+
+    static constexpr uint32_t kSlotBits = 6;
+    static constexpr uint32_t kSlotCount = 1u << kSlotBits;
+    static constexpr uint32_t kLevelCount = 4;
+
+    explicit ESTimingWheel(uint32_t tickMs = 100);
+
+    // nowMs 为调用方的单调时钟；第一次调用 Schedule/Advance 时作为起点
+    void Schedule(uint64_t key, uint64_t delayMs, uint64_t nowMs);
+    bool Cancel(uint64_t key);
+    bool Contains(uint64_t key) const;
+
+    // 推进到 nowMs，到期的 key 依次回调；回调里可以再次 Schedule。返回到期个数
+    size_t Advance(uint64_t nowMs, const ExpireCallback& onExpire);
+
+    void Clear();
+
+    uint32_t GetTickMs() const;
+    size_t GetPendingCount() const;
+
+private:
+    struct Entry {
+        uint64_t expireTick = 0;
+        uint32_t generation = 0;
+    };
+
+    using Slot = std::vector<std::pair<uint64_t, uint32_t>>;   // key, generation
+
+    void SyncStart(uint64_t nowMs);
+    void Place(uint64_t key, const Entry& entry);
+    void Cascade(uint32_t level);
+
+private:
+    uint32_t m_tickMs = 100;
+    bool m_started = false;
+    uint64_t m_startMs = 0;
+    uint64_t m_currentTick = 0;
+    uint32_t m_nextGeneration = 0;
+
+    std::array<std::array<Slot, kSlotCount>, kLevelCount> m_slots;
+    std::unordered_map<uint64_t, Entry> m_entries;
+    std::vector<uint64_t> m_expired;
+};
+
+} // namespace hhcast
\ No newline at end of file
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+
+namespace hhcast {
+
+struct ESUdpDatagram {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    uint32_t peerIp = 0;               // IPv4，主机字节序
+    uint16_t peerPort = 0;
+    uint64_t kernelTimestampUs = 0;    // SO_TIMESTAMPNS 换算到 steady_clock 的微秒，0 表示内核没给
+    bool truncated = false;            // 超过 maxDatagramSize 被截断
+};
+
+// 回调在收包线程执行，datagrams 指向的内存只在回调期间有效
+using ESUdpBatchCallback = std::function<void(const ESUdpDatagram* datagrams, size_t count)>;
+
+// Linux recvmmsg 批量收包：一次系统调用最多取 batchSize 个 datagram，
+// 缓冲区和 mmsghdr 在 Start 时一次性分配。其他平台 Start 直接返回失败，由调用方回退到 hv::UdpServer。
+// useIoUring 时改用 io_uring multishot recvmsg + 提供缓冲环，一次 enter 收割所有已到的包；
+// 运行时探测不可用则仍走 recvmmsg。
+class ESUdpBatchReceiver {
+public:
+    ESUdpBatchReceiver();
+    ~ESUdpBatchReceiver();
+
+    static bool IsSupported();
+
+    void SetCallback(ESUdpBatchCallback callback);
+
+    int Start(uint16_t bindPort, size_t batchSize, size_t maxDatagramSize, bool kernelTimestamps,
+              bool useIoUring = false);
+    // 使用已绑定的 socket（例如不停服升级时从旧进程接手的），fd 的所有权转给本对象，失败时也会关闭
+    int StartWithSocket(int fd, size_t batchSize, size_t maxDatagramSize, bool kernelTimestamps,
+                        bool useIoUring = false);
+    void Stop();
+
+    // 暂停后收包线程不再调用 recvmmsg，socket 保持打开；等到收包线程确认后才返回（最多约一个超时周期）
+    void SetPaused(bool paused);
+
+    bool IsRunning() const;
+    bool IsUsingIoUring() const;
+    uint16_t GetLocalPort() const;
+    int GetSocket() const;
+
+    uint64_t GetBatchCount() const;        // 收包系统调用次数（recvmmsg 或 io_uring_enter）
+    uint64_t GetDatagramCount() const;
+    uint64_t GetTruncatedCount() const;
+    uint64_t GetKernelDropCount() const;   // SO_RXQ_OVFL 报告的 socket 队列溢出累计值
+
+private:
+    struct BatchStorage;
+    struct UringStorage;
+
+    void RecvLoop();
+    void UringLoop();
+
+private:
+    std::atomic<bool> m_running{ false };
+    std::atomic<bool> m_paused{ false };
+    std::atomic<bool> m_pauseAcked{ false };
+    std::thread m_thread;
+
+    int m_socket = -1;
+    uint16_t m_localPort = 0;
+
+    ESUdpBatchCallback m_callback;
+    std::unique_ptr<BatchStorage> m_storage;
+    std::unique_ptr<UringStorage> m_uring;
+
+    std::atomic<uint64_t> m_batchCount{ 0 };
+    std::atomic<uint64_t> m_datagramCount{ 0 };
+    std::atomic<uint64_t> m_truncatedCount{ 0 };
+    std::atomic<uint64_t> m_kernelDropCount{ 0 };
+};
+
+} // namespace hhcast
\ No newline at end of file
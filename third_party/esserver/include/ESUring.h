@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+struct io_uring_sqe;
+struct io_uring_buf_ring;
+struct msghdr;
+
+namespace hhcast {
+
+struct ESUringCompletion {
+    uint64_t userData = 0;
+    int32_t result = 0;
+    uint32_t flags = 0;
+
+    bool HasMore() const;              // multishot 请求仍在挂着
+    bool HasBuffer() const;            // 用了提供缓冲环里的缓冲，用完须 Recycle
+    uint16_t GetBufferId() const;
+};
+
+// multishot recvmsg 写进缓冲的内容：固定头 + 地址 + 控制消息 + 载荷，前两段按提交时 msghdr 的长度占位
+struct ESUringRecvMsgView {
+    const uint8_t* name = nullptr;
+    uint32_t nameLen = 0;
+    const uint8_t* control = nullptr;
+    uint32_t controlLen = 0;
+    const uint8_t* payload = nullptr;
+    size_t payloadLen = 0;
+    bool truncated = false;
+};
+
+// io_uring 的最小封装：原始系统调用 + 共享内存环，不依赖 liburing。
+// 提交和收割都在拥有它的线程里。没有 ESSERVER_WITH_IO_URING 时 Init 直接失败，调用方回退到 epoll 路径
+class ESUring {
+public:
+    ESUring();
+    ~ESUring();
+
+    ESUring(const ESUring&) = delete;
+    ESUring& operator=(const ESUring&) = delete;
+
+    // 运行时探测 multishot recvmsg + 提供缓冲环（内核 6.0+，且没被 seccomp 禁掉），结果缓存
+    static bool IsSupported();
+
+    static size_t GetRecvMsgHeaderSize();
+    // size 为完成项的 result；msg 为提交时用的那个
+    static bool ParseRecvMsg(const uint8_t* buffer, size_t size, const msghdr& msg, ESUringRecvMsgView& view);
+
+    int Init(uint32_t entries);
+    void Close();
+    bool IsOpen() const;
+    int GetFd() const;
+
+    // 队列满时先把已填好的提交出去再取；失败返回 false
+    bool PrepRecvMultishot(int fd, uint16_t bufferGroup, uint64_t userData);
+    bool PrepRecvMsgMultishot(int fd, msghdr* msg, uint16_t bufferGroup, uint64_t userData);
+    bool PrepAcceptMultishot(int fd, uint64_t userData);
+    bool PrepCancel(uint64_t targetUserData, uint64_t userData);
+
+    // 提交已填好的请求，最多等 timeoutMs 直到至少 waitNr 个完成；超时不算错误，返回 0
+    int Submit(uint32_t waitNr, uint32_t timeoutMs);
+
+    // 依次交出已完成项并归还给内核，返回个数
+    size_t DrainCompletions(const std::function<void(const ESUringCompletion&)>& fn);
+
+    uint64_t GetEnterCount() const;    // io_uring_enter 调用次数
+    uint64_t GetCompletionCount() const;
+
+private:
+    io_uring_sqe* GetSqe();
+
+private:
+    int m_fd = -1;
+
+    void* m_ringPtr = nullptr;
+    size_t m_ringBytes = 0;
+    io_uring_sqe* m_sqes = nullptr;
+    size_t m_sqesBytes = 0;
+
+    uint32_t* m_sqHead = nullptr;
+    uint32_t* m_sqTail = nullptr;
+    uint32_t m_sqMask = 0;
+    uint32_t m_sqEntries = 0;
+    uint32_t m_sqeTail = 0;            // 本地已填好的位置，Submit 时发布
+    uint32_t m_sqeSubmitted = 0;
+
+    uint32_t* m_cqHead = nullptr;
+    uint32_t* m_cqTail = nullptr;
+    uint32_t m_cqMask = 0;
+    void* m_cqes = nullptr;
+
+    uint64_t m_enterCount = 0;
+    uint64_t m_completionCount = 0;
+};
+
+// 提供缓冲环：内核收包时从这里挑缓冲，完成项带回缓冲编号
+class ESUringBufferRing {
+public:
+    ESUringBufferRing();
+    ~ESUringBufferRing();
+
+    ESUringBufferRing(const ESUringBufferRing&) = delete;
+    ESUringBufferRing& operator=(const ESUringBufferRing&) = delete;
+
+    // count 向上取 2 的幂，最多 32768；所有缓冲注册后即交给内核
+    int Register(ESUring& uring, uint16_t groupId, uint32_t count, uint32_t bufferSize);
+    void Unregister();
+
+    uint16_t GetGroupId() const;
+    uint32_t GetBufferCount() const;
+    uint32_t GetBufferSize() const;
+    uint8_t* GetBuffer(uint16_t bufferId);
+
+    // 用完的缓冲放回环上，Commit 后内核才看得到
+    void Recycle(uint16_t bufferId);
+    void Commit();
+
+private:
+    ESUring* m_uring = nullptr;
+    io_uring_buf_ring* m_ring = nullptr;
+    size_t m_ringBytes = 0;
+
+    uint16_t m_groupId = 0;
+    uint32_t m_count = 0;
+    uint32_t m_bufferSize = 0;
+    uint16_t m_tail = 0;
+    std::vector<uint8_t> m_buffers;
+};
+
+} // namespace hhcast
\ No newline at end of file
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include "ESConnectionContext.h"
+
+namespace hhcast {
+
+// 回调都在收包线程执行
+// 接受连接：返回空表示拒绝，fd 由本对象关闭
+using ESUringAcceptCallback = std::function<ESConnectionContextPtr(int fd, uint32_t peerIp)>;
+// data 只在回调期间有效；返回 false 断开该连接
+using ESUringDataCallback = std::function<bool(int fd, ESConnectionContext& context, const uint8_t* data, size_t size)>;
+using ESUringCloseCallback = std::function<void(ESConnectionContext& context)>;
+
+struct ESUringTcpStats {
+    uint64_t enterCount = 0;           // io_uring_enter 次数，即收包路径上的系统调用数
+    uint64_t completionCount = 0;
+    uint64_t recvBytes = 0;
+    size_t connectionCount = 0;
+};
+
+// 只收不发的 TCP 监听（51030 视频）：一个线程一个 io_uring，multishot accept +
+// 每个连接一个 multishot recv，数据落在提供缓冲环里直接交给回调，不经 hv 的读缓冲。
+// 内核不支持时 Start 失败，调用方回退到 hv::TcpServer。
+class ESUringTcpReceiver {
+public:
+    ESUringTcpReceiver();
+    ~ESUringTcpReceiver();
+
+    void SetCallbacks(ESUringAcceptCallback onAccept, ESUringDataCallback onData, ESUringCloseCallback onClose);
+
+    // listenfd 需已 listen，所有权转给本对象，失败时也会关闭；cpu < 0 不绑核
+    int Start(int listenfd, uint32_t bufferCount, uint32_t bufferSize, int cpu);
+    // 收包线程退出后，对剩下的连接逐个回调 onClose 再关闭
+    void Stop();
+
+    bool IsRunning() const;
+    int GetListenFd() const;
+
+    // 按对端断开，可在任意线程调用；连接在收包线程里收尾
+    void CloseConnections(uint32_t peerIp);
+
+    ESUringTcpStats GetStats() const;
+
+private:
+    struct Connection {
+        int fd = -1;
+        uint32_t peerIp = 0;
+        ESConnectionContextPtr context;
+        std::atomic<bool> closing{ false };
+    };
+
+    struct RingStorage;
+
+    void RecvLoop();
+    void AcceptConnection(int fd);
+    void ReleaseConnection(uint32_t id);
+
+private:
+    std::atomic<bool> m_running{ false };
+    std::thread m_thread;
+    int m_listenFd = -1;
+    int m_cpu = -1;
+
+    ESUringAcceptCallback m_onAccept;
+    ESUringDataCallback m_onData;
+    ESUringCloseCallback m_onClose;
+
+    std::unique_ptr<RingStorage> m_ring;
+
+    // 增删只在收包线程，CloseConnections 跨线程读，都在锁内
+    mutable std::mutex m_mutex;
+    std::unordered_map<uint32_t, std::unique_ptr<Connection>> m_connections;
+    uint32_t m_nextId = 0;
+
+    std::atomic<uint64_t> m_enterCount{ 0 };
+    std::atomic<uint64_t> m_completionCount{ 0 };
+    std::atomic<uint64_t> m_recvBytes{ 0 };
+};
+
+} // namespace hhcast
\ No newline at end of file
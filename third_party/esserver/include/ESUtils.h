@@ -7,4 +7,10 @@ namespace hhcast {
 
 uint32_t IPToStreamID(const std::string& ipAddress);
 
+// steady_clock 微秒，会话内各路媒体的本地时间统一用它
+uint64_t GetSteadyTimeUs();
+
+// 当前线程累计的 CPU 时间（用户态 + 内核态）纳秒，不支持的平台返回 0
+uint64_t GetThreadCpuTimeNs();
+
 } // namespace hhcast
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <string_view>
 #include <vector>
 
 namespace hhcast {
@@ -20,6 +21,7 @@ struct ESVideoUnit {
     uint64_t timestamp32_32 = 0;
     const uint8_t* payload = nullptr;
     size_t payloadSize = 0;
+    uint64_t presentationUs = 0;   // A/V 同步给出的播放 deadline（steady_clock 微秒），0 表示未知
 };
 
 using ESVideoUnitCallback = std::function<void(const ESVideoUnit& unit)>;
@@ -31,20 +33,49 @@ public:
 
     void SetCallback(ESVideoUnitCallback callback);
 
+    // 推模式：切出的已知类型、非空单元交给 SetCallback 设置的回调
     bool PushBytes(const uint8_t* data, size_t size);
     void Reset();
 
+    // 拉模式：Append 之后用 NextUnit / DrainUnits 逐个取出，不经过回调。
+    // 取出的是全部完整单元（含 Unknown 类型和空负载），过滤交给调用方；payload 到下一次 Append 前有效
+    bool Append(const uint8_t* data, size_t size);
+    bool NextUnit(ESVideoUnit& unit);
+
+    // sink 可以是 ESPipeline 或任意接受 ESVideoUnit& 的可调用对象，调用处可内联；返回取出的单元数
+    template <typename Sink>
+    size_t DrainUnits(Sink& sink)
+    {
+        size_t count = 0;
+        ESVideoUnit unit;
+        while (NextUnit(unit)) {
+            sink(unit);
+            ++count;
+        }
+        return count;
+    }
+
     uint64_t GetUnitCount() const;
     uint64_t GetDroppedUnitCount() const;
     uint64_t GetInputBytes() const;
 
+    // 未凑满一个单元的字节，重新 PushBytes 即可恢复（进程交接用）
+    size_t GetBufferedSize() const;
+    std::string_view GetBuffered() const;
+
+    // 缓冲的容量，曾经的最大单元会一直占着
+    size_t GetAllocatedBytes() const;
+    // 移走已交出的单元并归还多余容量；之前交出的 payload 随即失效，与 PushBytes 相同
+    void ReleaseSpare();
+
 private:
     static uint32_t ReadLe32(const uint8_t* p);
     static uint64_t ReadLe64(const uint8_t* p);
-    void ProcessBuffer();
 
 private:
+    // 已交出的单元在下一次 PushBytes 时才移走：同一次输入切出的各单元 payload 到那时都有效
     std::vector<uint8_t> m_buffer;
+    size_t m_readOffset = 0;
     ESVideoUnitCallback m_callback;
 
     uint64_t m_inputBytes = 0;
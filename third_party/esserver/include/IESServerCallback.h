@@ -1,11 +1,26 @@
 #pragma once
 
+#include "ESAudioDecodeStage.h"
+#include "ESAudioDriftResampler.h"
+#include "ESAudioJitterBuffer.h"
+#include "ESAvSyncEngine.h"
+
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <string>
 
 namespace hhcast {
 
+enum class ESSessionCloseCause : uint8_t {
+    PeerClosed = 0,      // 57395 连接断开
+    HeartbeatTimeout,    // 超时未收到心跳
+    MediaTimeout,        // 媒体中断超时
+    ServerStopped,
+    HandedOff,           // 已交给新进程，连接仍在，只是本进程不再处理
+    QuotaExceeded,       // 超过硬配额被断开
+};
+
 class IESServerCallback {
 public:
     virtual ~IESServerCallback() = default;
@@ -15,6 +30,46 @@ public:
 
     virtual void OnVideoData(uint32_t streamId, const uint8_t* data, size_t size) = 0;
     virtual void OnAudioData(uint32_t streamId, const uint8_t* data, size_t size) = 0;
+
+    // 抖动缓冲判定丢包后上报，解码端据此做丢包隐藏；默认忽略
+    virtual void OnAudioGap(uint32_t streamId, const ESAudioGapInfo& gap)
+    {
+        (void)streamId;
+        (void)gap;
+    }
+
+    // 开启 audioDecode 后的 PCM 输出，在该会话的解码线程回调；默认忽略
+    virtual void OnAudioPcm(uint32_t streamId, const ESPcmFrame& frame)
+    {
+        (void)streamId;
+        (void)frame;
+    }
+
+    // 打开 audioDrift 时每个会话创建一次；播放端持有它，在设备回调里 Pull
+    virtual void OnAudioOutputReady(uint32_t streamId, std::shared_ptr<ESAudioDriftResampler> output)
+    {
+        (void)streamId;
+        (void)output;
+    }
+
+    // A/V 同步状态（漂移、唇音偏差），每个会话约每秒一次；默认忽略
+    virtual void OnAvSyncReport(uint32_t streamId, const ESAvSyncStats& stats)
+    {
+        (void)streamId;
+        (void)stats;
+    }
+
+    // 会话移除时回调一次并带上原因；对端断开和超时会先回调 OnDisconnect，停止、交接、配额断开不会。默认忽略
+    virtual void OnSessionClosed(uint32_t streamId, ESSessionCloseCause cause)
+    {
+        (void)streamId;
+        (void)cause;
+    }
+
+    // 新进程已确认接管（见 ESHandoffConfig），在交接线程回调；之后调用 StopServer 退出即可。默认忽略
+    virtual void OnHandedOff()
+    {
+    }
 };
 
 } // namespace hhcast
\ No newline at end of file
@@ -0,0 +1,182 @@
+#pragma once
+
+#include "IESServerCallback.h"
+#include "ESAudioRtpParser.h"
+#include "ESSessionAccounting.h"
+#include "ESSessionTable.h"
+#include "ESVideoDepacketizer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+namespace hhcast {
+
+// 只读视图，不持有数据
+template <typename T>
+class ESSpan {
+public:
+    ESSpan() = default;
+    ESSpan(const T* data, size_t size) : m_data(data), m_size(size) {}
+
+    const T* Data() const { return m_data; }
+    size_t Size() const { return m_size; }
+    bool Empty() const { return m_size == 0; }
+    const T& operator[](size_t index) const { return m_data[index]; }
+
+    const T* begin() const { return m_data; }
+    const T* end() const { return m_data + m_size; }
+
+private:
+    const T* m_data = nullptr;
+    size_t m_size = 0;
+};
+
+// 以下事件里的 session 是带引用计数的句柄，可以留到回调之外；
+// payload / frame 等指针只在回调期间有效，要留用须自行拷贝
+
+struct ESSessionOpenEvent {
+    ESSessionPtr session;
+    uint32_t streamId = 0;
+    std::string_view name;
+    std::string_view peerIp;
+    bool restored = false;                 // 从旧进程接手的会话
+};
+
+struct ESSessionCloseEvent {
+    ESSessionPtr session;
+    uint32_t streamId = 0;
+    ESSessionCloseCause cause = ESSessionCloseCause::PeerClosed;
+    bool disconnected = false;             // 由 cause 决定，见 IsDisconnectCause
+};
+
+// 对端断开或超时才算断开（旧接口据此回调 OnDisconnect）；服务停止、交接、配额断开都不算
+inline bool IsDisconnectCause(ESSessionCloseCause cause)
+{
+    return cause == ESSessionCloseCause::PeerClosed ||
+           cause == ESSessionCloseCause::HeartbeatTimeout ||
+           cause == ESSessionCloseCause::MediaTimeout;
+}
+
+struct ESVideoEvent {
+    ESSessionPtr session;
+    uint32_t streamId = 0;
+    ESVideoUnit unit;
+};
+
+struct ESAudioEvent {
+    ESSessionPtr session;
+    uint32_t streamId = 0;
+    ESAudioPayloadInfo info;
+};
+
+// 一次 loop 迭代（一次 TCP 读、一批 UDP 收包）切出的全部媒体，可能含多个会话，各自保持到达顺序
+struct ESMediaBatch {
+    ESSpan<ESVideoEvent> video;
+    ESSpan<ESAudioEvent> audio;
+};
+
+struct ESAudioGapEvent {
+    ESSessionPtr session;
+    uint32_t streamId = 0;
+    ESAudioGapInfo gap;
+};
+
+struct ESAudioPcmEvent {
+    ESSessionPtr session;
+    uint32_t streamId = 0;
+    const ESPcmFrame* frame = nullptr;
+};
+
+struct ESAudioOutputEvent {
+    ESSessionPtr session;
+    uint32_t streamId = 0;
+    std::shared_ptr<ESAudioDriftResampler> output;
+};
+
+struct ESAvSyncEvent {
+    ESSessionPtr session;
+    uint32_t streamId = 0;
+    ESAvSyncStats stats;
+};
+
+// 会话的配额级别变化（含回落到 Normal）时上报；action 为 Disconnect 时随后会有 OnSessionClose
+struct ESSessionQuotaEvent {
+    ESSessionPtr session;
+    uint32_t streamId = 0;
+    ESQuotaAction action = ESQuotaAction::None;
+    ESSessionResourceStats stats;
+};
+
+// 每个采样周期一次，包含当时所有会话
+struct ESResourceSnapshot {
+    uint64_t sampledMs = 0;
+    ESSpan<ESSessionResourceStats> sessions;
+};
+
+// 批量回调接口：媒体按批投递，会话一次一个虚调用。回调线程与 IESServerCallback 相同；
+// 流停顿时抖动缓冲按时间放出的音频在会话回收线程回调（见 ESAudioJitterConfig::pollIntervalMs）
+class IESServerCallbackV2 {
+public:
+    virtual ~IESServerCallbackV2() = default;
+
+    virtual void OnSessionOpen(const ESSessionOpenEvent& event) = 0;
+    virtual void OnSessionClose(const ESSessionCloseEvent& event) = 0;
+    virtual void OnMediaBatch(const ESMediaBatch& batch) = 0;
+
+    virtual void OnAudioGap(const ESAudioGapEvent& event)
+    {
+        (void)event;
+    }
+
+    virtual void OnAudioPcm(const ESAudioPcmEvent& event)
+    {
+        (void)event;
+    }
+
+    virtual void OnAudioOutputReady(const ESAudioOutputEvent& event)
+    {
+        (void)event;
+    }
+
+    virtual void OnAvSyncReport(const ESAvSyncEvent& event)
+    {
+        (void)event;
+    }
+
+    virtual void OnHandedOff()
+    {
+    }
+
+    // 以下两个在采样线程回调，需打开 ESSessionQuotaConfig::sampleIntervalMs
+    virtual void OnSessionQuota(const ESSessionQuotaEvent& event)
+    {
+        (void)event;
+    }
+
+    virtual void OnResourceSnapshot(const ESResourceSnapshot& snapshot)
+    {
+        (void)snapshot;
+    }
+};
+
+// 把批量事件拆回 IESServerCallback 的逐条调用，ESServer::SetCallback 内部使用
+class ESServerCallbackAdapter : public IESServerCallbackV2 {
+public:
+    explicit ESServerCallbackAdapter(std::shared_ptr<IESServerCallback> callback);
+
+    void OnSessionOpen(const ESSessionOpenEvent& event) override;
+    void OnSessionClose(const ESSessionCloseEvent& event) override;
+    void OnMediaBatch(const ESMediaBatch& batch) override;
+    void OnAudioGap(const ESAudioGapEvent& event) override;
+    void OnAudioPcm(const ESAudioPcmEvent& event) override;
+    void OnAudioOutputReady(const ESAudioOutputEvent& event) override;
+    void OnAvSyncReport(const ESAvSyncEvent& event) override;
+    void OnHandedOff() override;
+
+private:
+    std::shared_ptr<IESServerCallback> m_callback;
+};
+
+} // namespace hhcast
\ No newline at end of file
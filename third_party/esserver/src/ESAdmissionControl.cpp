@@ -0,0 +1,238 @@
+#include "ESAdmissionControl.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace hhcast {
+
+namespace {
+
+void PrintIp(std::ostream& os, uint32_t ip)
+{
+    os << ((ip >> 24) & 0xFF) << '.' << ((ip >> 16) & 0xFF) << '.'
+       << ((ip >> 8) & 0xFF) << '.' << (ip & 0xFF);
+}
+
+} // namespace
+
+void ESTokenBucket::Configure(uint64_t ratePerSec, uint64_t burst)
+{
+    m_ratePerUs = static_cast<double>(ratePerSec) / 1000000.0;
+    m_burst = static_cast<double>(burst > 0 ? burst : ratePerSec);
+    m_tokens = m_burst;
+    m_lastUs = 0;
+}
+
+bool ESTokenBucket::IsLimited() const
+{
+    return m_ratePerUs > 0.0;
+}
+
+bool ESTokenBucket::Consume(uint64_t tokens, uint64_t nowUs)
+{
+    if (!IsLimited()) {
+        return true;
+    }
+
+    if (m_lastUs != 0 && nowUs > m_lastUs) {
+        m_tokens = std::min(m_burst, m_tokens + static_cast<double>(nowUs - m_lastUs) * m_ratePerUs);
+    }
+    m_lastUs = nowUs;
+
+    // 单次超过桶容量的按容量计，否则这种包永远过不去；桶满时放行并清空
+    const double need = std::min(static_cast<double>(tokens), m_burst);
+    if (m_tokens < need) {
+        return false;
+    }
+
+    m_tokens -= need;
+    return true;
+}
+
+void ESRateLimiter::Configure(const ESRateLimit& limit)
+{
+    m_bytes.Configure(limit.bytesPerSec, limit.burstBytes);
+    m_packets.Configure(limit.packetsPerSec, limit.burstPackets);
+}
+
+bool ESRateLimiter::IsLimited() const
+{
+    return m_bytes.IsLimited() || m_packets.IsLimited();
+}
+
+bool ESRateLimiter::Allow(size_t bytes, uint64_t nowUs)
+{
+    // 包维度先判，失败时不扣字节
+    if (!m_packets.Consume(1, nowUs)) {
+        return false;
+    }
+    return m_bytes.Consume(bytes, nowUs);
+}
+
+void ESAdmissionControl::SetConfig(const ESAdmissionConfig& config)
+{
+    m_config = config;
+
+    std::lock_guard<std::mutex> lock(m_udpMutex);
+    m_udpLimiters.clear();
+}
+
+const ESAdmissionConfig& ESAdmissionControl::GetConfig() const
+{
+    return m_config;
+}
+
+bool ESAdmissionControl::TryAcquireConnection(uint32_t peerIp, uint16_t localPort, uint64_t nowMs)
+{
+    bool global = false;
+    {
+        std::lock_guard<std::mutex> lock(m_connectionsMutex);
+
+        if (m_config.enabled && m_config.maxConnections > 0 && m_activeConnections >= m_config.maxConnections) {
+            global = true;
+        } else {
+            auto it = m_connectionsPerIp.find(peerIp);
+            const uint32_t current = (it != m_connectionsPerIp.end()) ? it->second : 0;
+            if (!m_config.enabled || m_config.maxConnectionsPerIp == 0 || peerIp == kUnknownPeerIp ||
+                current < m_config.maxConnectionsPerIp) {
+                ++m_connectionsPerIp[peerIp];
+                ++m_activeConnections;
+                m_accepted.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+    }
+
+    // 日志在锁外打
+    if (global) {
+        m_rejectedGlobal.fetch_add(1, std::memory_order_relaxed);
+        LogRejected(m_logGlobal, "connection limit", peerIp, localPort, nowMs);
+    } else {
+        m_rejectedPerIp.fetch_add(1, std::memory_order_relaxed);
+        LogRejected(m_logPerIp, "per-ip connection limit", peerIp, localPort, nowMs);
+    }
+    return false;
+}
+
+void ESAdmissionControl::ReleaseConnection(uint32_t peerIp)
+{
+    std::lock_guard<std::mutex> lock(m_connectionsMutex);
+
+    auto it = m_connectionsPerIp.find(peerIp);
+    if (it == m_connectionsPerIp.end() || it->second == 0) {
+        return;
+    }
+
+    if (--it->second == 0) {
+        m_connectionsPerIp.erase(it);
+    }
+    if (m_activeConnections > 0) {
+        --m_activeConnections;
+    }
+}
+
+ESRateLimiter ESAdmissionControl::MakeTcpLimiter(ESPortClass portClass) const
+{
+    ESRateLimiter limiter;
+    if (!m_config.enabled) {
+        return limiter;
+    }
+
+    limiter.Configure(portClass == ESPortClass::Video ? m_config.video : m_config.control);
+    return limiter;
+}
+
+void ESAdmissionControl::OnTcpRateExceeded(uint32_t peerIp, uint16_t localPort, uint64_t nowMs)
+{
+    m_closedByRate.fetch_add(1, std::memory_order_relaxed);
+    LogRejected(m_logTcpRate, "tcp rate limit, close", peerIp, localPort, nowMs);
+}
+
+bool ESAdmissionControl::AllowDatagram(uint32_t peerIp, uint16_t localPort, size_t bytes, uint64_t nowUs)
+{
+    if (!m_config.enabled || !m_config.udp.IsLimited() || peerIp == kUnknownPeerIp) {
+        return true;
+    }
+
+    bool allowed = false;
+    {
+        std::lock_guard<std::mutex> lock(m_udpMutex);
+
+        auto it = m_udpLimiters.find(peerIp);
+        if (it == m_udpLimiters.end()) {
+            // 伪造源地址刷满表时整体清空，合法发送端只是重新拿到一次突发额度
+            if (m_udpLimiters.size() >= kMaxTrackedUdpPeers) {
+                m_udpLimiters.clear();
+            }
+            it = m_udpLimiters.emplace(peerIp, ESRateLimiter()).first;
+            it->second.Configure(m_config.udp);
+        }
+
+        allowed = it->second.Allow(bytes, nowUs);
+    }
+
+    if (!allowed) {
+        m_droppedDatagrams.fetch_add(1, std::memory_order_relaxed);
+        m_droppedBytes.fetch_add(bytes, std::memory_order_relaxed);
+        LogRejected(m_logUdpRate, "udp rate limit, drop", peerIp, localPort, nowUs / 1000);
+    }
+    return allowed;
+}
+
+ESAdmissionStats ESAdmissionControl::GetStats() const
+{
+    ESAdmissionStats stats;
+    stats.accepted = m_accepted.load(std::memory_order_relaxed);
+    stats.rejectedGlobal = m_rejectedGlobal.load(std::memory_order_relaxed);
+    stats.rejectedPerIp = m_rejectedPerIp.load(std::memory_order_relaxed);
+    stats.closedByRate = m_closedByRate.load(std::memory_order_relaxed);
+    stats.droppedDatagrams = m_droppedDatagrams.load(std::memory_order_relaxed);
+    stats.droppedBytes = m_droppedBytes.load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(m_connectionsMutex);
+    stats.activeConnections = m_activeConnections;
+    return stats;
+}
+
+void ESAdmissionControl::Reset()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_connectionsMutex);
+        m_connectionsPerIp.clear();
+        m_activeConnections = 0;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_udpMutex);
+        m_udpLimiters.clear();
+    }
+}
+
+void ESAdmissionControl::LogRejected(LogThrottle& throttle,
+                                     const char* reason,
+                                     uint32_t peerIp,
+                                     uint16_t localPort,
+                                     uint64_t nowMs)
+{
+    uint64_t last = throttle.lastMs.load(std::memory_order_relaxed);
+    if (last != 0 && nowMs < last + m_config.logIntervalMs) {
+        throttle.suppressed.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // 多个线程同时到期时只有一个打印
+    if (!throttle.lastMs.compare_exchange_strong(last, std::max<uint64_t>(nowMs, 1))) {
+        throttle.suppressed.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    const uint64_t suppressed = throttle.suppressed.exchange(0, std::memory_order_relaxed);
+
+    std::cout << "[ESAdmissionControl] " << reason << ", port=" << localPort << ", peer=";
+    PrintIp(std::cout, peerIp);
+    if (suppressed > 0) {
+        std::cout << ", suppressed " << suppressed << " more";
+    }
+    std::cout << std::endl;
+}
+
+} // namespace hhcast
\ No newline at end of file
@@ -1,10 +1,205 @@
 #include "ESAudioDatagramParser.h"
 
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define ES_RTP_SCAN_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define ES_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define ES_TARGET_AVX2
+#endif
+
 namespace hhcast {
 
 namespace {
 constexpr size_t kRtpFixedHeaderSize = 12;
 constexpr size_t kMinCandidateRemainSize = 12;
+
+// 下一个 RTP 头应满足：V=2、PT 相同、seq+1、SSRC 相同。
+// SIMD 一次比较 16/32 个起始偏移的 byte0/byte1/seq/ssrc 首字节，命中位再做完整校验。
+struct RtpCandidatePattern {
+    uint8_t payloadType = 0;
+    uint8_t seqHi = 0;
+    uint8_t seqLo = 0;
+    uint8_t ssrc[4] = {};
+};
+
+static bool MatchCandidate(const uint8_t* data, size_t size, size_t pos, const RtpCandidatePattern& pattern)
+{
+    const uint8_t* p = data + pos;
+    if ((p[0] & 0xC0) != 0x80 || (p[1] & 0x7F) != pattern.payloadType ||
+        p[2] != pattern.seqHi || p[3] != pattern.seqLo ||
+        p[8] != pattern.ssrc[0] || p[9] != pattern.ssrc[1] ||
+        p[10] != pattern.ssrc[2] || p[11] != pattern.ssrc[3]) {
+        return false;
+    }
+
+    const size_t minHeaderLen = kRtpFixedHeaderSize + static_cast<size_t>(p[0] & 0x0F) * 4;
+    return size - pos >= minHeaderLen;
+}
+
+static size_t ScanCandidatesScalar(const uint8_t* data, size_t size, size_t pos,
+                                   const RtpCandidatePattern& pattern)
+{
+    for (; pos + kMinCandidateRemainSize <= size; ++pos) {
+        if (MatchCandidate(data, size, pos, pattern)) {
+            return pos;
+        }
+    }
+
+    return size;
+}
+
+#ifdef ES_RTP_SCAN_X86
+
+static int CountTrailingZeros(uint32_t mask)
+{
+#ifdef _MSC_VER
+    unsigned long index = 0;
+    _BitScanForward(&index, mask);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+static size_t ScanCandidatesSse2(const uint8_t* data, size_t size, size_t pos,
+                                 const RtpCandidatePattern& pattern)
+{
+    const __m128i versionMask = _mm_set1_epi8(static_cast<char>(0xC0));
+    const __m128i version2 = _mm_set1_epi8(static_cast<char>(0x80));
+    const __m128i ptMask = _mm_set1_epi8(0x7F);
+    const __m128i pt = _mm_set1_epi8(static_cast<char>(pattern.payloadType));
+    const __m128i seqHi = _mm_set1_epi8(static_cast<char>(pattern.seqHi));
+    const __m128i seqLo = _mm_set1_epi8(static_cast<char>(pattern.seqLo));
+    const __m128i ssrc0 = _mm_set1_epi8(static_cast<char>(pattern.ssrc[0]));
+
+    // 最后一个候选 pos+15 需要 12 字节，ssrc 首字节那一路读到 pos+23
+    while (pos + 16 + kMinCandidateRemainSize - 1 <= size) {
+        const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + 1));
+        const __m128i b2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + 2));
+        const __m128i b3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + 3));
+        const __m128i b8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + 8));
+
+        __m128i hit = _mm_cmpeq_epi8(_mm_and_si128(b0, versionMask), version2);
+        hit = _mm_and_si128(hit, _mm_cmpeq_epi8(_mm_and_si128(b1, ptMask), pt));
+        hit = _mm_and_si128(hit, _mm_cmpeq_epi8(b2, seqHi));
+        hit = _mm_and_si128(hit, _mm_cmpeq_epi8(b3, seqLo));
+        hit = _mm_and_si128(hit, _mm_cmpeq_epi8(b8, ssrc0));
+
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(hit));
+        while (mask != 0) {
+            const size_t candidate = pos + static_cast<size_t>(CountTrailingZeros(mask));
+            if (MatchCandidate(data, size, candidate, pattern)) {
+                return candidate;
+            }
+            mask &= mask - 1;
+        }
+
+        pos += 16;
+    }
+
+    return ScanCandidatesScalar(data, size, pos, pattern);
+}
+
+ES_TARGET_AVX2
+static size_t ScanCandidatesAvx2(const uint8_t* data, size_t size, size_t pos,
+                                 const RtpCandidatePattern& pattern)
+{
+    const __m256i versionMask = _mm256_set1_epi8(static_cast<char>(0xC0));
+    const __m256i version2 = _mm256_set1_epi8(static_cast<char>(0x80));
+    const __m256i ptMask = _mm256_set1_epi8(0x7F);
+    const __m256i pt = _mm256_set1_epi8(static_cast<char>(pattern.payloadType));
+    const __m256i seqHi = _mm256_set1_epi8(static_cast<char>(pattern.seqHi));
+    const __m256i seqLo = _mm256_set1_epi8(static_cast<char>(pattern.seqLo));
+    const __m256i ssrc0 = _mm256_set1_epi8(static_cast<char>(pattern.ssrc[0]));
+
+    while (pos + 32 + kMinCandidateRemainSize - 1 <= size) {
+        const __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        const __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos + 1));
+        const __m256i b2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos + 2));
+        const __m256i b3 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos + 3));
+        const __m256i b8 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos + 8));
+
+        __m256i hit = _mm256_cmpeq_epi8(_mm256_and_si256(b0, versionMask), version2);
+        hit = _mm256_and_si256(hit, _mm256_cmpeq_epi8(_mm256_and_si256(b1, ptMask), pt));
+        hit = _mm256_and_si256(hit, _mm256_cmpeq_epi8(b2, seqHi));
+        hit = _mm256_and_si256(hit, _mm256_cmpeq_epi8(b3, seqLo));
+        hit = _mm256_and_si256(hit, _mm256_cmpeq_epi8(b8, ssrc0));
+
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(hit));
+        while (mask != 0) {
+            const size_t candidate = pos + static_cast<size_t>(CountTrailingZeros(mask));
+            if (MatchCandidate(data, size, candidate, pattern)) {
+                return candidate;
+            }
+            mask &= mask - 1;
+        }
+
+        pos += 32;
+    }
+
+    return ScanCandidatesSse2(data, size, pos, pattern);
+}
+
+static bool CpuSupportsAvx2()
+{
+#ifdef _MSC_VER
+    int info[4] = {};
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx) {
+        return false;
+    }
+
+    // OS 需要保存 YMM 寄存器状态
+    if ((_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+#endif // ES_RTP_SCAN_X86
+
+using ScanCandidatesFn = size_t (*)(const uint8_t*, size_t, size_t, const RtpCandidatePattern&);
+
+static ScanCandidatesFn SelectScanCandidates()
+{
+#ifdef ES_RTP_SCAN_X86
+    if (CpuSupportsAvx2()) {
+        return &ScanCandidatesAvx2;
+    }
+    return &ScanCandidatesSse2;
+#else
+    return &ScanCandidatesScalar;
+#endif
+}
+
+static size_t ScanCandidates(const uint8_t* data, size_t size, size_t pos,
+                             const RtpCandidatePattern& pattern)
+{
+    static const ScanCandidatesFn fn = SelectScanCandidates();
+    return fn(data, size, pos, pattern);
+}
+
 } // namespace
 
 ESAudioDatagramParser::ESAudioDatagramParser() = default;
@@ -54,6 +249,10 @@ bool ESAudioDatagramParser::ParseDatagram(const uint8_t* data, size_t size)
         ++m_splitPacketCount;
         parsedAnyPacket = true;
 
+        if (nextOffset != size) {
+            LearnPacket(currentHeader, packetSize);
+        }
+
         if (nextOffset == size) {
             break;
         }
@@ -71,6 +270,12 @@ void ESAudioDatagramParser::Reset()
     m_droppedDatagramCount = 0;
     m_splitPacketCount = 0;
     m_inputBytes = 0;
+    m_predictedSplitCount = 0;
+
+    m_hasLearned = false;
+    m_learnedSsrc = 0;
+    m_learnedPayloadType = 0;
+    m_learnedPacketSize = 0;
 }
 
 uint64_t ESAudioDatagramParser::GetDatagramCount() const
@@ -93,6 +298,11 @@ uint64_t ESAudioDatagramParser::GetInputBytes() const
     return m_inputBytes;
 }
 
+uint64_t ESAudioDatagramParser::GetPredictedSplitCount() const
+{
+    return m_predictedSplitCount;
+}
+
 bool ESAudioDatagramParser::ParseRtpHeaderLite(const uint8_t* data, size_t size, RtpHeaderLite& header)
 {
     if (data == nullptr || size < kRtpFixedHeaderSize) {
@@ -139,36 +349,47 @@ bool ESAudioDatagramParser::IsNextSequence(uint16_t currentSeq, uint16_t nextSeq
 size_t ESAudioDatagramParser::FindNextRtpOffset(const uint8_t* data,
                                                 size_t size,
                                                 size_t currentOffset,
-                                                const RtpHeaderLite& currentHeader) const
+                                                const RtpHeaderLite& currentHeader)
 {
     const size_t scanBegin = currentOffset + currentHeader.minHeaderLen;
     if (scanBegin + kMinCandidateRemainSize > size) {
         return size;
     }
 
-    for (size_t pos = scanBegin; pos + kMinCandidateRemainSize <= size; ++pos) {
-        RtpHeaderLite candidate;
-        if (!ParseRtpHeaderLite(data + pos, size - pos, candidate)) {
-            continue;
-        }
-
-        // 这几个条件用于降低把 payload 内字节误判成 RTP 头的概率
-        if (candidate.payloadType != currentHeader.payloadType) {
-            continue;
+    // 这几个条件用于降低把 payload 内字节误判成 RTP 头的概率
+    RtpCandidatePattern pattern;
+    const uint16_t nextSeq = static_cast<uint16_t>(currentHeader.sequence + 1);
+    pattern.payloadType = currentHeader.payloadType;
+    pattern.seqHi = static_cast<uint8_t>(nextSeq >> 8);
+    pattern.seqLo = static_cast<uint8_t>(nextSeq);
+    pattern.ssrc[0] = static_cast<uint8_t>(currentHeader.ssrc >> 24);
+    pattern.ssrc[1] = static_cast<uint8_t>(currentHeader.ssrc >> 16);
+    pattern.ssrc[2] = static_cast<uint8_t>(currentHeader.ssrc >> 8);
+    pattern.ssrc[3] = static_cast<uint8_t>(currentHeader.ssrc);
+
+    // 快路径：同一流包长基本固定，先直接验证预测位置。
+    // payload 里同时撞上 V/PT/seq+1/SSRC 的概率可以忽略，命中即认为是包边界。
+    if (m_hasLearned &&
+        m_learnedSsrc == currentHeader.ssrc &&
+        m_learnedPayloadType == currentHeader.payloadType) {
+        const size_t predicted = currentOffset + m_learnedPacketSize;
+        if (predicted >= scanBegin &&
+            predicted + kMinCandidateRemainSize <= size &&
+            MatchCandidate(data, size, predicted, pattern)) {
+            ++m_predictedSplitCount;
+            return predicted;
         }
-
-        if (candidate.ssrc != currentHeader.ssrc) {
-            continue;
-        }
-
-        if (!IsNextSequence(currentHeader.sequence, candidate.sequence)) {
-            continue;
-        }
-
-        return pos;
     }
 
-    return size;
+    return ScanCandidates(data, size, scanBegin, pattern);
+}
+
+void ESAudioDatagramParser::LearnPacket(const RtpHeaderLite& header, size_t packetSize)
+{
+    m_hasLearned = true;
+    m_learnedSsrc = header.ssrc;
+    m_learnedPayloadType = header.payloadType;
+    m_learnedPacketSize = packetSize;
 }
 
 } // namespace hhcast
\ No newline at end of file
@@ -0,0 +1,530 @@
+#include "ESAudioDecodeStage.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#ifdef __linux__
+#include <time.h>
+#endif
+
+#ifdef ESSERVER_WITH_FFMPEG
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/buffer.h>
+#include <libavutil/channel_layout.h>
+#include <libavutil/mem.h>
+}
+#endif
+
+namespace hhcast {
+
+#ifdef ESSERVER_WITH_FFMPEG
+
+struct ESAudioDecodeStage::DecoderState {
+    AVCodecContext* context = nullptr;
+    AVPacket* packet = nullptr;
+    AVFrame* frame = nullptr;
+    AVBufferPool* packetPool = nullptr;   // 包数据走 pool，send_packet 只加引用不拷贝
+
+    ~DecoderState()
+    {
+        av_frame_free(&frame);
+        av_packet_free(&packet);
+        avcodec_free_context(&context);
+        av_buffer_pool_uninit(&packetPool);
+    }
+
+    bool Open(const ESAudioDecodeConfig& config)
+    {
+        // 与 apps/ffmpeg_test 一致，用 FFmpeg 原生 aac 解码器处理 ELD
+        const AVCodec* codec = avcodec_find_decoder_by_name("aac");
+        if (codec == nullptr) {
+            codec = avcodec_find_decoder(AV_CODEC_ID_AAC);
+        }
+        if (codec == nullptr) {
+            return false;
+        }
+
+        context = avcodec_alloc_context3(codec);
+        if (context == nullptr) {
+            return false;
+        }
+
+        const ESAudioFormat& format = config.format;
+        if (!format.extradata.empty()) {
+            context->extradata = static_cast<uint8_t*>(
+                av_mallocz(format.extradata.size() + AV_INPUT_BUFFER_PADDING_SIZE));
+            if (context->extradata == nullptr) {
+                return false;
+            }
+            std::memcpy(context->extradata, format.extradata.data(), format.extradata.size());
+            context->extradata_size = static_cast<int>(format.extradata.size());
+        }
+
+        av_channel_layout_default(&context->ch_layout, format.channels);
+        context->sample_rate = static_cast<int>(format.sampleRate);
+
+        if (avcodec_open2(context, codec, nullptr) < 0) {
+            return false;
+        }
+
+        packet = av_packet_alloc();
+        frame = av_frame_alloc();
+        packetPool = av_buffer_pool_init(
+            config.maxPayloadSize + AV_INPUT_BUFFER_PADDING_SIZE, av_buffer_allocz);
+
+        return packet != nullptr && frame != nullptr && packetPool != nullptr;
+    }
+};
+
+// 把解码输出（常见为 FLTP）转成交织 float，返回每声道采样数，不支持的格式返回 0
+static uint32_t FrameToInterleavedFloat(const AVFrame* frame, uint16_t outChannels, std::vector<float>& out)
+{
+    const uint32_t samples = static_cast<uint32_t>(frame->nb_samples);
+    const int inChannels = frame->ch_layout.nb_channels;
+    if (samples == 0 || inChannels <= 0 || outChannels == 0) {
+        return 0;
+    }
+
+    const size_t needed = static_cast<size_t>(samples) * outChannels;
+    if (out.size() < needed) {
+        out.resize(needed);
+    }
+
+    for (uint16_t c = 0; c < outChannels; ++c) {
+        // 声道数不一致时（比如解出单声道），多出来的输出声道复制最后一个输入声道
+        const int src = std::min<int>(c, inChannels - 1);
+        float* dst = out.data() + c;
+
+        switch (frame->format) {
+        case AV_SAMPLE_FMT_FLTP: {
+            const float* in = reinterpret_cast<const float*>(frame->extended_data[src]);
+            for (uint32_t i = 0; i < samples; ++i) {
+                dst[i * outChannels] = in[i];
+            }
+            break;
+        }
+        case AV_SAMPLE_FMT_FLT: {
+            const float* in = reinterpret_cast<const float*>(frame->extended_data[0]);
+            for (uint32_t i = 0; i < samples; ++i) {
+                dst[i * outChannels] = in[i * inChannels + src];
+            }
+            break;
+        }
+        case AV_SAMPLE_FMT_S16P: {
+            const int16_t* in = reinterpret_cast<const int16_t*>(frame->extended_data[src]);
+            for (uint32_t i = 0; i < samples; ++i) {
+                dst[i * outChannels] = in[i] / 32768.0f;
+            }
+            break;
+        }
+        case AV_SAMPLE_FMT_S16: {
+            const int16_t* in = reinterpret_cast<const int16_t*>(frame->extended_data[0]);
+            for (uint32_t i = 0; i < samples; ++i) {
+                dst[i * outChannels] = in[i * inChannels + src] / 32768.0f;
+            }
+            break;
+        }
+        default:
+            return 0;
+        }
+    }
+
+    return samples;
+}
+
+#else
+
+struct ESAudioDecodeStage::DecoderState {
+};
+
+#endif // ESSERVER_WITH_FFMPEG
+
+ESAudioDecodeStage::ESAudioDecodeStage() = default;
+
+ESAudioDecodeStage::~ESAudioDecodeStage()
+{
+    Stop();
+}
+
+bool ESAudioDecodeStage::IsAvailable()
+{
+#ifdef ESSERVER_WITH_FFMPEG
+    return true;
+#else
+    return false;
+#endif
+}
+
+void ESAudioDecodeStage::SetPcmCallback(ESPcmCallback callback)
+{
+    m_callback = std::move(callback);
+}
+
+int ESAudioDecodeStage::Start(const ESAudioDecodeConfig& config)
+{
+    if (m_running.load()) {
+        return 0;
+    }
+
+    if (!IsAvailable()) {
+        std::cout << "[ESAudioDecodeStage] built without FFmpeg, decode disabled" << std::endl;
+        return -1;
+    }
+
+    // 工作线程解码时手里拿着一个 job，至少还要留一个给输入侧，否则队列满时没有旧输入可丢
+    if (config.format.channels == 0 || config.format.sampleRate == 0 || config.queueDepth < 2) {
+        return -2;
+    }
+
+    m_config = config;
+
+    m_decoder = new DecoderState();
+#ifdef ESSERVER_WITH_FFMPEG
+    if (!m_decoder->Open(m_config)) {
+        std::cout << "[ESAudioDecodeStage] open aac decoder failed" << std::endl;
+        delete m_decoder;
+        m_decoder = nullptr;
+        return -3;
+    }
+#endif
+
+    m_jobs.clear();
+    m_jobs.resize(m_config.queueDepth);
+    m_freeJobs.clear();
+    m_pendingJobs.clear();
+    for (Job& job : m_jobs) {
+        job.payload.reserve(m_config.maxPayloadSize);
+        m_freeJobs.push_back(&job);
+    }
+
+    // AAC-ELD 一帧 480/512 采样，按两倍预留，稳态下不再扩容
+    const size_t frameFloats =
+        static_cast<size_t>(m_config.format.samplesPerFrame) * 2 * m_config.format.channels;
+    m_floatBuffer.assign(frameFloats, 0.0f);
+    m_lastFrame.assign(frameFloats, 0.0f);
+    m_pcmBuffer.assign(frameFloats * sizeof(float), 0);
+    m_lastFrameSamples = 0;
+    m_concealRun = 0;
+
+    m_decodedFrameCount = 0;
+    m_concealedFrameCount = 0;
+    m_decodeErrorCount = 0;
+    m_droppedInputCount = 0;
+    m_threadCpuNs = 0;
+    m_allocatedBytes = m_jobs.size() * (sizeof(Job) + m_config.maxPayloadSize) +
+                       (m_floatBuffer.size() + m_lastFrame.size()) * sizeof(float) +
+                       m_pcmBuffer.size();
+
+    m_running = true;
+    m_thread = std::thread(&ESAudioDecodeStage::WorkLoop, this);
+    return 0;
+}
+
+void ESAudioDecodeStage::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running.exchange(false)) {
+            return;
+        }
+    }
+
+    m_cond.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    delete m_decoder;
+    m_decoder = nullptr;
+
+    m_pendingJobs.clear();
+    m_freeJobs.clear();
+    m_jobs.clear();
+    m_allocatedBytes = 0;
+}
+
+bool ESAudioDecodeStage::IsRunning() const
+{
+    return m_running.load();
+}
+
+bool ESAudioDecodeStage::PushPayload(const ESAudioPayloadInfo& info)
+{
+    if (!m_running.load() || info.payload == nullptr || info.payloadSize == 0 ||
+        info.payloadSize > m_config.maxPayloadSize) {
+        return false;
+    }
+
+    Job* job = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        job = AcquireJobLocked();
+        job->isGap = false;
+        job->sequence = info.sequence;
+        job->timestamp = info.timestamp;
+        job->gapCount = 0;
+        job->presentationUs = info.presentationUs;
+        job->payload.assign(info.payload, info.payload + info.payloadSize);
+        m_pendingJobs.push_back(job);
+    }
+
+    m_cond.notify_one();
+    return true;
+}
+
+bool ESAudioDecodeStage::PushGap(const ESAudioGapInfo& gap)
+{
+    if (!m_running.load() || gap.count == 0) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Job* job = AcquireJobLocked();
+        job->isGap = true;
+        job->sequence = gap.firstSequence;
+        job->timestamp = gap.timestamp;
+        job->gapCount = gap.count;
+        job->presentationUs = 0;
+        job->payload.clear();
+        m_pendingJobs.push_back(job);
+    }
+
+    m_cond.notify_one();
+    return true;
+}
+
+uint64_t ESAudioDecodeStage::GetDecodedFrameCount() const
+{
+    return m_decodedFrameCount.load();
+}
+
+uint64_t ESAudioDecodeStage::GetConcealedFrameCount() const
+{
+    return m_concealedFrameCount.load();
+}
+
+uint64_t ESAudioDecodeStage::GetDecodeErrorCount() const
+{
+    return m_decodeErrorCount.load();
+}
+
+uint64_t ESAudioDecodeStage::GetDroppedInputCount() const
+{
+    return m_droppedInputCount.load();
+}
+
+size_t ESAudioDecodeStage::GetQueuedBytes() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    size_t bytes = 0;
+    for (const Job* job : m_pendingJobs) {
+        bytes += job->payload.size();
+    }
+    return bytes;
+}
+
+size_t ESAudioDecodeStage::GetAllocatedBytes() const
+{
+    return m_allocatedBytes.load();
+}
+
+uint64_t ESAudioDecodeStage::GetThreadCpuNs() const
+{
+    return m_threadCpuNs.load();
+}
+
+ESAudioDecodeStage::Job* ESAudioDecodeStage::AcquireJobLocked()
+{
+    if (!m_freeJobs.empty()) {
+        Job* job = m_freeJobs.back();
+        m_freeJobs.pop_back();
+        return job;
+    }
+
+    // 解码跟不上时丢最旧的输入，保证延迟有上限
+    Job* job = m_pendingJobs.front();
+    m_pendingJobs.pop_front();
+    ++m_droppedInputCount;
+    return job;
+}
+
+void ESAudioDecodeStage::WorkLoop()
+{
+    while (true) {
+        Job* job = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait(lock, [this]() {
+                return !m_running.load() || !m_pendingJobs.empty();
+            });
+
+            if (!m_running.load()) {
+                return;
+            }
+
+            job = m_pendingJobs.front();
+            m_pendingJobs.pop_front();
+        }
+
+        if (job->isGap) {
+            ConcealJob(*job);
+        } else {
+            DecodeJob(*job);
+        }
+
+#ifdef __linux__
+        timespec cpu = {};
+        if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu) == 0) {
+            m_threadCpuNs.store(static_cast<uint64_t>(cpu.tv_sec) * 1000000000ULL +
+                                static_cast<uint64_t>(cpu.tv_nsec));
+        }
+#endif
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_freeJobs.push_back(job);
+    }
+}
+
+void ESAudioDecodeStage::DecodeJob(const Job& job)
+{
+#ifdef ESSERVER_WITH_FFMPEG
+    AVPacket* packet = m_decoder->packet;
+    AVFrame* frame = m_decoder->frame;
+
+    packet->buf = av_buffer_pool_get(m_decoder->packetPool);
+    if (packet->buf == nullptr) {
+        ++m_decodeErrorCount;
+        return;
+    }
+
+    std::memcpy(packet->buf->data, job.payload.data(), job.payload.size());
+    std::memset(packet->buf->data + job.payload.size(), 0, AV_INPUT_BUFFER_PADDING_SIZE);
+    packet->data = packet->buf->data;
+    packet->size = static_cast<int>(job.payload.size());
+    packet->pts = job.timestamp;
+
+    const int sendRet = avcodec_send_packet(m_decoder->context, packet);
+    av_packet_unref(packet);
+    if (sendRet < 0) {
+        ++m_decodeErrorCount;
+        ConcealJob(Job{ true, job.sequence, job.timestamp, 1, job.presentationUs, {} });
+        return;
+    }
+
+    while (true) {
+        const int ret = avcodec_receive_frame(m_decoder->context, frame);
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+            break;
+        }
+        if (ret < 0) {
+            ++m_decodeErrorCount;
+            break;
+        }
+
+        const uint32_t samples = FrameToInterleavedFloat(frame, m_config.format.channels, m_floatBuffer);
+        av_frame_unref(frame);
+
+        if (samples == 0) {
+            ++m_decodeErrorCount;
+            continue;
+        }
+
+        const size_t floats = static_cast<size_t>(samples) * m_config.format.channels;
+        if (m_lastFrame.size() < floats) {
+            m_lastFrame.resize(floats);
+        }
+        std::copy(m_floatBuffer.begin(), m_floatBuffer.begin() + floats, m_lastFrame.begin());
+        m_lastFrameSamples = samples;
+        m_concealRun = 0;
+
+        ++m_decodedFrameCount;
+        EmitFloatFrame(m_floatBuffer.data(), samples, job.sequence, job.timestamp, false,
+                       job.presentationUs);
+    }
+#else
+    (void)job;
+#endif
+}
+
+void ESAudioDecodeStage::ConcealJob(const Job& job)
+{
+    // AAC 解码器没有 PLC 接口：重复上一帧并逐帧衰减，淡出后补静音，保持时间轴连续
+    const uint32_t samples =
+        (m_lastFrameSamples != 0) ? m_lastFrameSamples : m_config.format.samplesPerFrame;
+    const size_t floats = static_cast<size_t>(samples) * m_config.format.channels;
+    if (m_floatBuffer.size() < floats) {
+        m_floatBuffer.resize(floats);
+    }
+
+    for (uint16_t i = 0; i < job.gapCount; ++i) {
+        float gain = 0.0f;
+        if (m_lastFrameSamples != 0 && m_concealRun < m_config.concealFadeFrames) {
+            gain = 1.0f / static_cast<float>(2u << m_concealRun);
+        }
+
+        if (gain > 0.0f) {
+            for (size_t k = 0; k < floats; ++k) {
+                m_floatBuffer[k] = m_lastFrame[k] * gain;
+            }
+        } else {
+            std::fill(m_floatBuffer.begin(), m_floatBuffer.begin() + floats, 0.0f);
+        }
+
+        ++m_concealRun;
+        ++m_concealedFrameCount;
+
+        EmitFloatFrame(m_floatBuffer.data(), samples,
+                       static_cast<uint16_t>(job.sequence + i),
+                       job.timestamp + static_cast<uint32_t>(i) * samples,
+                       true,
+                       job.presentationUs);
+    }
+}
+
+void ESAudioDecodeStage::EmitFloatFrame(const float* interleaved, uint32_t samples,
+                                        uint16_t sequence, uint32_t timestamp, bool concealed,
+                                        uint64_t presentationUs)
+{
+    if (!m_callback) {
+        return;
+    }
+
+    const size_t floats = static_cast<size_t>(samples) * m_config.format.channels;
+
+    ESPcmFrame frame;
+    frame.sequence = sequence;
+    frame.timestamp = timestamp;
+    frame.sampleRate = m_config.format.sampleRate;
+    frame.channels = m_config.format.channels;
+    frame.samples = samples;
+    frame.sampleFormat = m_config.sampleFormat;
+    frame.concealed = concealed;
+    frame.presentationUs = presentationUs;
+
+    if (m_config.sampleFormat == ESPcmSampleFormat::F32) {
+        frame.data = reinterpret_cast<const uint8_t*>(interleaved);
+        frame.size = floats * sizeof(float);
+    } else {
+        const size_t bytes = floats * sizeof(int16_t);
+        if (m_pcmBuffer.size() < bytes) {
+            m_pcmBuffer.resize(bytes);
+        }
+
+        int16_t* out = reinterpret_cast<int16_t*>(m_pcmBuffer.data());
+        for (size_t i = 0; i < floats; ++i) {
+            const float v = std::min(1.0f, std::max(-1.0f, interleaved[i]));
+            out[i] = static_cast<int16_t>(v * 32767.0f);
+        }
+
+        frame.data = m_pcmBuffer.data();
+        frame.size = bytes;
+    }
+
+    m_callback(frame);
+}
+
+} // namespace hhcast
\ No newline at end of file
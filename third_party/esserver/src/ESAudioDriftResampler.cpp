@@ -0,0 +1,375 @@
+#include "ESAudioDriftResampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace hhcast {
+
+namespace {
+
+constexpr size_t kTaps = 16;           // 每个输出采样用 16 个输入采样
+constexpr size_t kHalfTaps = kTaps / 2;
+constexpr size_t kPhases = 128;
+constexpr double kCutoff = 0.9;        // 相对奈奎斯特频率，留出过渡带
+constexpr double kPi = 3.14159265358979323846;
+
+// 第 p 个相位对应小数位置 p / kPhases，第 k 个系数作用于输入 base - (kHalfTaps - 1) + k
+void BuildKernel(std::vector<float>& kernel)
+{
+    kernel.assign((kPhases + 1) * kTaps, 0.0f);
+
+    for (size_t p = 0; p <= kPhases; ++p) {
+        const double frac = static_cast<double>(p) / kPhases;
+        float* row = kernel.data() + p * kTaps;
+
+        double sum = 0.0;
+        for (size_t k = 0; k < kTaps; ++k) {
+            const double t = static_cast<double>(k) - (kHalfTaps - 1) - frac;
+            const double x = kPi * kCutoff * t;
+            const double sinc = (std::fabs(x) < 1e-9) ? 1.0 : std::sin(x) / x;
+
+            // Blackman 窗，支撑区间 (-kHalfTaps, kHalfTaps)
+            const double w = 0.42 + 0.5 * std::cos(kPi * t / kHalfTaps) +
+                             0.08 * std::cos(2.0 * kPi * t / kHalfTaps);
+
+            row[k] = static_cast<float>(sinc * w);
+            sum += row[k];
+        }
+
+        // 每个相位直流增益归一，避免变速时音量起伏
+        for (size_t k = 0; k < kTaps; ++k) {
+            row[k] = static_cast<float>(row[k] / sum);
+        }
+    }
+}
+
+} // namespace
+
+ESAudioDriftResampler::ESAudioDriftResampler() = default;
+
+ESAudioDriftResampler::~ESAudioDriftResampler() = default;
+
+int ESAudioDriftResampler::Start(const ESAudioDriftConfig& config)
+{
+    if (config.sampleRate == 0 || config.channels == 0 || config.capacityMs <= config.targetFillMs) {
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_config = config;
+    if (m_config.fillWindowMs == 0) {
+        m_config.fillWindowMs = 1;
+    }
+
+    if (m_kernel.empty()) {
+        BuildKernel(m_kernel);
+    }
+    m_taps.assign(kTaps, 0.0f);
+
+    m_capacityFrames = static_cast<size_t>(m_config.sampleRate) * m_config.capacityMs / 1000;
+    // 额外留出历史 + 前瞻，以及一次推入的余量，稳态下不扩容
+    m_buffer.assign((m_capacityFrames * 2 + kTaps) * m_config.channels, 0.0f);
+
+    m_running = true;
+    m_stats = ESAudioDriftStats{};
+
+    // 开头补 taps/2 - 1 个静音作为历史
+    m_bufferFrames = kHalfTaps - 1;
+    m_readIndex = kHalfTaps - 1;
+    m_fraction = 0.0;
+    m_priming = true;
+    m_smoothedFill = 0.0;
+    m_integralPpm = 0.0;
+    m_ratio = 1.0;
+    return 0;
+}
+
+void ESAudioDriftResampler::Stop()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_running = false;
+    m_buffer.clear();
+    m_convert.clear();
+    m_pullBuffer.clear();
+}
+
+bool ESAudioDriftResampler::IsRunning() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_running;
+}
+
+void ESAudioDriftResampler::Reset()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_running) {
+        return;
+    }
+
+    std::fill(m_buffer.begin(), m_buffer.end(), 0.0f);
+    m_bufferFrames = kHalfTaps - 1;
+    m_readIndex = kHalfTaps - 1;
+    m_fraction = 0.0;
+    m_priming = true;
+    m_smoothedFill = 0.0;
+    m_integralPpm = 0.0;
+    m_ratio = 1.0;
+}
+
+bool ESAudioDriftResampler::PushFrame(const ESPcmFrame& frame)
+{
+    if (frame.data == nullptr || frame.samples == 0) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_running || frame.sampleRate != m_config.sampleRate || frame.channels != m_config.channels) {
+        return false;
+    }
+
+    const size_t floats = static_cast<size_t>(frame.samples) * frame.channels;
+
+    if (frame.sampleFormat == ESPcmSampleFormat::F32) {
+        if (frame.size < floats * sizeof(float)) {
+            return false;
+        }
+        // data 来自解码线程内部缓冲，按 float 对齐
+        return PushLocked(reinterpret_cast<const float*>(frame.data), frame.samples);
+    }
+
+    if (frame.size < floats * sizeof(int16_t)) {
+        return false;
+    }
+
+    if (m_convert.size() < floats) {
+        m_convert.resize(floats);
+    }
+
+    const int16_t* in = reinterpret_cast<const int16_t*>(frame.data);
+    for (size_t i = 0; i < floats; ++i) {
+        m_convert[i] = in[i] / 32768.0f;
+    }
+
+    return PushLocked(m_convert.data(), frame.samples);
+}
+
+bool ESAudioDriftResampler::Push(const float* interleaved, uint32_t samples)
+{
+    if (interleaved == nullptr || samples == 0) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_running) {
+        return false;
+    }
+
+    return PushLocked(interleaved, samples);
+}
+
+bool ESAudioDriftResampler::PushLocked(const float* interleaved, uint32_t samples)
+{
+    const size_t channels = m_config.channels;
+
+    // 单次推入超过容量时只保留最新的部分
+    if (samples > m_capacityFrames) {
+        const size_t skip = samples - m_capacityFrames;
+        m_stats.droppedSamples += skip;
+        interleaved += skip * channels;
+        samples = static_cast<uint32_t>(m_capacityFrames);
+    }
+
+    // 超过容量时丢最旧的输入，读位置直接前移
+    const double fill = FillSamplesLocked();
+    if (fill + samples > static_cast<double>(m_capacityFrames)) {
+        const size_t drop = static_cast<size_t>(std::ceil(fill + samples - m_capacityFrames));
+        m_readIndex += drop;
+        m_stats.droppedSamples += drop;
+    }
+
+    if ((m_bufferFrames + samples) * channels > m_buffer.size()) {
+        CompactLocked();
+    }
+
+    std::memcpy(m_buffer.data() + m_bufferFrames * channels, interleaved,
+                static_cast<size_t>(samples) * channels * sizeof(float));
+    m_bufferFrames += samples;
+    m_stats.inputSamples += samples;
+    return true;
+}
+
+// 把 readIndex 之前 taps/2 个历史采样及之后的数据挪到缓冲开头
+void ESAudioDriftResampler::CompactLocked()
+{
+    const size_t channels = m_config.channels;
+    const size_t keepFrom = (m_readIndex >= kHalfTaps - 1) ? m_readIndex - (kHalfTaps - 1) : 0;
+    if (keepFrom == 0) {
+        return;
+    }
+
+    const size_t keepFrames = (m_bufferFrames > keepFrom) ? m_bufferFrames - keepFrom : 0;
+    if (keepFrames > 0) {
+        std::memmove(m_buffer.data(), m_buffer.data() + keepFrom * channels,
+                     keepFrames * channels * sizeof(float));
+    }
+
+    m_bufferFrames = keepFrames;
+    m_readIndex -= keepFrom;
+
+    // 丢弃数据后 readIndex 可能越过已写入的位置，补静音保持历史窗口完整
+    if (m_readIndex + 1 > m_bufferFrames) {
+        std::fill(m_buffer.data() + m_bufferFrames * channels,
+                  m_buffer.data() + (m_readIndex + 1) * channels, 0.0f);
+        m_bufferFrames = m_readIndex + 1;
+    }
+}
+
+double ESAudioDriftResampler::FillSamplesLocked() const
+{
+    const double pos = static_cast<double>(m_readIndex) + m_fraction;
+    const double fill = static_cast<double>(m_bufferFrames) - pos;
+    return std::max(0.0, fill);
+}
+
+uint32_t ESAudioDriftResampler::Pull(float* interleaved, uint32_t samples)
+{
+    if (interleaved == nullptr || samples == 0) {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return PullLocked(interleaved, samples);
+}
+
+uint32_t ESAudioDriftResampler::PullLocked(float* interleaved, uint32_t samples)
+{
+    const size_t channels = m_config.channels;
+    if (!m_running) {
+        std::fill(interleaved, interleaved + static_cast<size_t>(samples) * channels, 0.0f);
+        return 0;
+    }
+
+    const double targetSamples = static_cast<double>(m_config.sampleRate) * m_config.targetFillMs / 1000.0;
+    if (m_priming && FillSamplesLocked() >= targetSamples) {
+        m_priming = false;
+        m_smoothedFill = FillSamplesLocked();
+    }
+
+    const bool wasPlaying = !m_priming;
+    uint32_t produced = 0;
+    while (!m_priming && produced < samples) {
+        // 需要 readIndex + kHalfTaps 处的前瞻采样
+        if (m_readIndex + kHalfTaps >= m_bufferFrames) {
+            ++m_stats.underruns;
+            m_priming = true;
+            break;
+        }
+
+        const double phasePos = m_fraction * kPhases;
+        const size_t phase = std::min(static_cast<size_t>(phasePos), kPhases - 1);
+        const float mix = static_cast<float>(phasePos - phase);
+        const float* row0 = m_kernel.data() + phase * kTaps;
+        const float* row1 = row0 + kTaps;
+        for (size_t k = 0; k < kTaps; ++k) {
+            m_taps[k] = row0[k] + (row1[k] - row0[k]) * mix;
+        }
+
+        const float* src = m_buffer.data() + (m_readIndex - (kHalfTaps - 1)) * channels;
+        float* dst = interleaved + static_cast<size_t>(produced) * channels;
+        for (size_t c = 0; c < channels; ++c) {
+            float acc = 0.0f;
+            for (size_t k = 0; k < kTaps; ++k) {
+                acc += src[k * channels + c] * m_taps[k];
+            }
+            dst[c] = acc;
+        }
+
+        m_fraction += m_ratio;
+        const double whole = std::floor(m_fraction);
+        m_readIndex += static_cast<size_t>(whole);
+        m_fraction -= whole;
+        ++produced;
+    }
+
+    if (produced < samples) {
+        std::fill(interleaved + static_cast<size_t>(produced) * channels,
+                  interleaved + static_cast<size_t>(samples) * channels, 0.0f);
+        if (wasPlaying) {
+            m_stats.underrunSamples += samples - produced;
+        }
+    }
+
+    m_stats.outputSamples += produced;
+
+    // 写入位置离缓冲末尾不足一个容量时提前整理
+    if ((m_bufferFrames + m_capacityFrames) * channels > m_buffer.size()) {
+        CompactLocked();
+    }
+
+    if (!m_priming) {
+        UpdateControlLocked(samples);
+    }
+
+    return produced;
+}
+
+uint32_t ESAudioDriftResampler::PullS16(int16_t* interleaved, uint32_t samples)
+{
+    if (interleaved == nullptr || samples == 0) {
+        return 0;
+    }
+
+    // m_pullBuffer 会被 Stop 清空，整个转换都在锁内完成
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const size_t floats = static_cast<size_t>(samples) * m_config.channels;
+    if (m_pullBuffer.size() < floats) {
+        m_pullBuffer.resize(floats);
+    }
+
+    const uint32_t produced = PullLocked(m_pullBuffer.data(), samples);
+    for (size_t i = 0; i < floats; ++i) {
+        const float v = std::min(1.0f, std::max(-1.0f, m_pullBuffer[i]));
+        interleaved[i] = static_cast<int16_t>(v * 32767.0f);
+    }
+
+    return produced;
+}
+
+// 以拉取的采样数为本地时钟推进控制器
+void ESAudioDriftResampler::UpdateControlLocked(uint32_t pulledSamples)
+{
+    const double rate = static_cast<double>(m_config.sampleRate);
+    const double dtSec = pulledSamples / rate;
+    const double fill = FillSamplesLocked();
+
+    const double alpha = std::min(1.0, dtSec * 1000.0 / m_config.fillWindowMs);
+    m_smoothedFill += (fill - m_smoothedFill) * alpha;
+
+    const double errorMs = (m_smoothedFill / rate - m_config.targetFillMs / 1000.0) * 1000.0;
+    const double limit = m_config.maxCorrectionPpm;
+
+    m_integralPpm += m_config.ki * errorMs * dtSec;
+    m_integralPpm = std::min(limit, std::max(-limit, m_integralPpm));
+
+    double correction = m_config.kp * errorMs + m_integralPpm;
+    correction = std::min(limit, std::max(-limit, correction));
+
+    m_ratio = 1.0 + correction * 1e-6;
+
+    m_stats.ratio = m_ratio;
+    m_stats.correctionPpm = correction;
+    m_stats.fillMs = fill * 1000.0 / rate;
+    m_stats.smoothedFillMs = m_smoothedFill * 1000.0 / rate;
+}
+
+ESAudioDriftStats ESAudioDriftResampler::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ESAudioDriftStats stats = m_stats;
+    stats.fillMs = FillSamplesLocked() * 1000.0 / m_config.sampleRate;
+    return stats;
+}
+
+} // namespace hhcast
\ No newline at end of file
@@ -0,0 +1,379 @@
+#include "ESAudioJitterBuffer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace hhcast {
+
+ESAudioJitterBuffer::ESAudioJitterBuffer()
+{
+    SetConfig(ESAudioJitterConfig{});
+}
+
+ESAudioJitterBuffer::~ESAudioJitterBuffer() = default;
+
+void ESAudioJitterBuffer::SetConfig(const ESAudioJitterConfig& config)
+{
+    m_config = config;
+    if (m_config.clockRate == 0) {
+        m_config.clockRate = 44100;
+    }
+    if (m_config.samplesPerFrame == 0) {
+        m_config.samplesPerFrame = 480;
+    }
+    if (m_config.capacity < 2) {
+        m_config.capacity = 2;
+    }
+    // sequence 差值按 int16 判断前后，槽位数不能超过半个序号空间
+    m_config.capacity = std::min<size_t>(m_config.capacity, 0x4000);
+    m_config.maxDepthMs = std::max(m_config.maxDepthMs, m_config.minDepthMs);
+
+    m_slots.assign(m_config.capacity, Slot{});
+    for (Slot& slot : m_slots) {
+        slot.payload.reserve(m_config.maxPayloadSize);
+    }
+
+    Reset();
+}
+
+const ESAudioJitterConfig& ESAudioJitterBuffer::GetConfig() const
+{
+    return m_config;
+}
+
+void ESAudioJitterBuffer::SetPayloadCallback(ESAudioPayloadCallback callback)
+{
+    m_payloadCallback = std::move(callback);
+}
+
+void ESAudioJitterBuffer::SetGapCallback(ESAudioGapCallback callback)
+{
+    m_gapCallback = std::move(callback);
+}
+
+bool ESAudioJitterBuffer::Push(const ESAudioPayloadInfo& info, uint64_t arrivalUs)
+{
+    if (info.payload == nullptr || info.payloadSize == 0) {
+        return false;
+    }
+
+    if (!m_config.enabled) {
+        if (m_payloadCallback) {
+            m_payloadCallback(info);
+        }
+        return true;
+    }
+
+    if (info.payloadSize > m_config.maxPayloadSize) {
+        return false;
+    }
+
+    ++m_stats.received;
+
+    if (!m_started) {
+        Start(info);
+    }
+    else if (info.ssrc != m_ssrc) {
+        Flush();
+        ++m_stats.resets;
+        Start(info);
+    }
+
+    UpdateJitter(info, arrivalUs);
+
+    const int16_t offset = static_cast<int16_t>(info.sequence - m_nextSequence);
+    if (offset < 0) {
+        ++m_stats.late;
+        return false;
+    }
+
+    // 序号一次跳出整个窗口，多半是发送端重启，按新流处理
+    if (static_cast<size_t>(offset) >= m_slots.size()) {
+        Flush();
+        ++m_stats.resets;
+        Start(info);
+    }
+
+    Slot& slot = SlotFor(info.sequence);
+    if (slot.used) {
+        ++m_stats.duplicate;
+        return false;
+    }
+
+    if (static_cast<int16_t>(info.sequence - m_highestSequence) < 0) {
+        ++m_stats.reordered;
+    }
+    else {
+        m_highestSequence = info.sequence;
+        m_highestTimestamp = info.timestamp;
+    }
+
+    slot.used = true;
+    slot.payloadType = info.payloadType;
+    slot.sequence = info.sequence;
+    slot.timestamp = info.timestamp;
+    slot.arrivalUs = arrivalUs;
+    slot.payload.assign(info.payload, info.payload + info.payloadSize);
+    ++m_storedCount;
+    m_storedBytes += info.payloadSize;
+
+    UpdateTargetDepth();
+    Drain(false);
+    return true;
+}
+
+void ESAudioJitterBuffer::Poll(uint64_t nowUs)
+{
+    if (!m_config.enabled) {
+        return;
+    }
+
+    const uint64_t holdUs = static_cast<uint64_t>(m_targetDepthMs * 1000.0 + 0.5);
+
+    while (m_storedCount > 0) {
+        // 下一个该出的包：从 m_nextSequence 往后第一个已收到的
+        const Slot* next = nullptr;
+        uint16_t sequence = m_nextSequence;
+        for (size_t i = 0; i < m_slots.size(); ++i, ++sequence) {
+            const Slot& slot = SlotFor(sequence);
+            if (slot.used && slot.sequence == sequence) {
+                next = &slot;
+                break;
+            }
+        }
+
+        if (next == nullptr || nowUs < next->arrivalUs + holdUs) {
+            break;
+        }
+
+        const Slot& head = SlotFor(m_nextSequence);
+        if (head.used && head.sequence == m_nextSequence) {
+            DeliverHead();
+        }
+        else {
+            ReportGapAtHead();
+        }
+    }
+}
+
+void ESAudioJitterBuffer::Flush()
+{
+    Drain(true);
+}
+
+void ESAudioJitterBuffer::Reset()
+{
+    for (Slot& slot : m_slots) {
+        slot.used = false;
+        slot.payload.clear();
+    }
+
+    m_storedCount = 0;
+    m_storedBytes = 0;
+    m_started = false;
+    m_ssrc = 0;
+    m_nextSequence = 0;
+    m_nextTimestamp = 0;
+    m_highestSequence = 0;
+    m_highestTimestamp = 0;
+
+    m_hasArrival = false;
+    m_lastArrival = 0;
+    m_lastArrivalTimestamp = 0;
+    m_jitterSamples = 0.0;
+    m_targetDepthMs = static_cast<double>(
+        std::min(std::max(m_config.targetDepthMs, m_config.minDepthMs), m_config.maxDepthMs));
+
+    m_stats = ESAudioJitterStats{};
+}
+
+ESAudioJitterStats ESAudioJitterBuffer::GetStats() const
+{
+    ESAudioJitterStats stats = m_stats;
+    stats.jitterMs = m_jitterSamples * 1000.0 / m_config.clockRate;
+    stats.targetDepthMs = static_cast<uint32_t>(m_targetDepthMs + 0.5);
+    stats.depthMs = static_cast<uint32_t>(
+        static_cast<uint64_t>(GetDepthSamples()) * 1000 / m_config.clockRate);
+    return stats;
+}
+
+size_t ESAudioJitterBuffer::GetStoredBytes() const
+{
+    return m_storedBytes;
+}
+
+size_t ESAudioJitterBuffer::GetAllocatedBytes() const
+{
+    return m_slots.size() * (sizeof(Slot) + m_config.maxPayloadSize);
+}
+
+ESAudioJitterBuffer::Slot& ESAudioJitterBuffer::SlotFor(uint16_t sequence)
+{
+    return m_slots[sequence % m_slots.size()];
+}
+
+void ESAudioJitterBuffer::Start(const ESAudioPayloadInfo& info)
+{
+    m_started = true;
+    m_ssrc = info.ssrc;
+    m_nextSequence = info.sequence;
+    m_nextTimestamp = info.timestamp;
+    m_highestSequence = info.sequence;
+    m_highestTimestamp = info.timestamp;
+    m_hasArrival = false;
+}
+
+void ESAudioJitterBuffer::UpdateJitter(const ESAudioPayloadInfo& info, uint64_t arrivalUs)
+{
+    // RFC 3550 A.8：D = (Rj - Ri) - (Sj - Si)，J += (|D| - J) / 16
+    const int64_t arrival = static_cast<int64_t>(
+        arrivalUs / 1000 * m_config.clockRate / 1000 +
+        arrivalUs % 1000 * m_config.clockRate / 1000000);
+
+    if (m_hasArrival) {
+        const int64_t transitDelta =
+            (arrival - m_lastArrival) -
+            static_cast<int32_t>(info.timestamp - m_lastArrivalTimestamp);
+        const double d = std::fabs(static_cast<double>(transitDelta));
+        m_jitterSamples += (d - m_jitterSamples) / 16.0;
+    }
+
+    m_hasArrival = true;
+    m_lastArrival = arrival;
+    m_lastArrivalTimestamp = info.timestamp;
+}
+
+void ESAudioJitterBuffer::UpdateTargetDepth()
+{
+    if (!m_config.adaptive) {
+        return;
+    }
+
+    // 目标 = 一帧 + 4 倍抖动；抖动变大时立即跟上，变小时缓慢回落，避免来回拉伸
+    const double frameMs = m_config.samplesPerFrame * 1000.0 / m_config.clockRate;
+    const double jitterMs = m_jitterSamples * 1000.0 / m_config.clockRate;
+    double desired = frameMs + 4.0 * jitterMs;
+    desired = std::min<double>(std::max<double>(desired, m_config.minDepthMs), m_config.maxDepthMs);
+
+    if (desired > m_targetDepthMs) {
+        m_targetDepthMs = desired;
+    }
+    else {
+        m_targetDepthMs += (desired - m_targetDepthMs) / 64.0;
+    }
+}
+
+uint32_t ESAudioJitterBuffer::GetDepthSamples() const
+{
+    if (m_storedCount == 0) {
+        return 0;
+    }
+
+    const int32_t span = static_cast<int32_t>(m_highestTimestamp - m_nextTimestamp);
+    if (span < 0) {
+        return m_config.samplesPerFrame;
+    }
+
+    return static_cast<uint32_t>(span) + m_config.samplesPerFrame;
+}
+
+uint32_t ESAudioJitterBuffer::MsToSamples(uint32_t ms) const
+{
+    return static_cast<uint32_t>(static_cast<uint64_t>(ms) * m_config.clockRate / 1000);
+}
+
+void ESAudioJitterBuffer::Drain(bool flushAll)
+{
+    const uint32_t targetSamples = MsToSamples(static_cast<uint32_t>(m_targetDepthMs + 0.5));
+    const uint32_t maxSamples = MsToSamples(m_config.maxDepthMs);
+    bool overflowed = false;
+
+    while (m_storedCount > 0) {
+        if (!flushAll) {
+            const uint32_t depth = GetDepthSamples();
+            if (depth > maxSamples) {
+                overflowed = true;
+            }
+            else if (depth < targetSamples) {
+                break;
+            }
+        }
+
+        const Slot& head = SlotFor(m_nextSequence);
+        if (head.used && head.sequence == m_nextSequence) {
+            DeliverHead();
+        }
+        else {
+            ReportGapAtHead();
+        }
+    }
+
+    if (overflowed) {
+        ++m_stats.overflow;
+    }
+}
+
+void ESAudioJitterBuffer::DeliverHead()
+{
+    Slot& slot = SlotFor(m_nextSequence);
+
+    ESAudioPayloadInfo info;
+    info.payloadType = slot.payloadType;
+    info.sequence = slot.sequence;
+    info.timestamp = slot.timestamp;
+    info.ssrc = m_ssrc;
+    info.payload = slot.payload.data();
+    info.payloadSize = slot.payload.size();
+
+    m_nextTimestamp = slot.timestamp + m_config.samplesPerFrame;
+    ++m_nextSequence;
+    --m_storedCount;
+    m_storedBytes -= slot.payload.size();
+    ++m_stats.delivered;
+
+    if (m_payloadCallback) {
+        m_payloadCallback(info);
+    }
+
+    slot.used = false;
+    slot.payload.clear();
+}
+
+void ESAudioJitterBuffer::ReportGapAtHead()
+{
+    // 调用前保证缓冲里至少还有一个包，所以一定能在窗口内找到下一个已收到的包
+    uint16_t count = 0;
+    uint16_t sequence = m_nextSequence;
+    while (count < m_slots.size()) {
+        const Slot& slot = SlotFor(sequence);
+        if (slot.used && slot.sequence == sequence) {
+            break;
+        }
+        ++count;
+        ++sequence;
+    }
+
+    ESAudioGapInfo gap;
+    gap.firstSequence = m_nextSequence;
+    gap.count = count;
+    gap.timestamp = m_nextTimestamp;
+    gap.durationSamples = static_cast<uint32_t>(count) * m_config.samplesPerFrame;
+
+    const Slot& next = SlotFor(sequence);
+    if (next.used && next.sequence == sequence) {
+        const int32_t span = static_cast<int32_t>(next.timestamp - m_nextTimestamp);
+        if (span > 0) {
+            gap.durationSamples = static_cast<uint32_t>(span);
+        }
+    }
+
+    m_nextSequence = sequence;
+    m_nextTimestamp += gap.durationSamples;
+    m_stats.lost += count;
+
+    if (m_gapCallback) {
+        m_gapCallback(gap);
+    }
+}
+
+} // namespace hhcast
\ No newline at end of file
@@ -0,0 +1,347 @@
+#include "ESAvSyncEngine.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace hhcast {
+
+namespace {
+
+constexpr uint8_t kSyncPayloadType = 0x54;   // 控制端口同步包 0x80/0x90 0xD4
+constexpr size_t kSyncPacketSize = 20;
+
+static uint32_t ReadBe32(const uint8_t* p)
+{
+    return (static_cast<uint32_t>(p[0]) << 24) |
+           (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8)  |
+           (static_cast<uint32_t>(p[3]));
+}
+
+} // namespace
+
+// ---------------- ClockMapper ----------------
+
+void ESAvSyncEngine::ClockMapper::Configure(uint32_t bucketMs, size_t bucketCount)
+{
+    m_bucketUs = static_cast<int64_t>(std::max<uint32_t>(bucketMs, 1)) * 1000;
+    m_bucketCount = std::max<size_t>(bucketCount, 2);
+    Reset();
+}
+
+void ESAvSyncEngine::ClockMapper::Reset()
+{
+    m_buckets.clear();
+    m_valid = false;
+    m_slope = 0.0;
+    m_refLocalUs = 0;
+    m_refOffsetUs = 0.0;
+}
+
+void ESAvSyncEngine::ClockMapper::AddSample(int64_t senderUs, int64_t localUs)
+{
+    const int64_t offset = localUs - senderUs;
+    const int64_t index = localUs / m_bucketUs;
+
+    if (m_buckets.empty() || m_buckets.back().index != index) {
+        Bucket bucket;
+        bucket.index = index;
+        bucket.localUs = localUs;
+        bucket.offsetUs = offset;
+        m_buckets.push_back(bucket);
+
+        while (m_buckets.size() > m_bucketCount) {
+            m_buckets.pop_front();
+        }
+    } else if (offset < m_buckets.back().offsetUs) {
+        m_buckets.back().localUs = localUs;
+        m_buckets.back().offsetUs = offset;
+    } else {
+        return;
+    }
+
+    Refit();
+}
+
+bool ESAvSyncEngine::ClockMapper::IsValid() const
+{
+    return m_valid;
+}
+
+int64_t ESAvSyncEngine::ClockMapper::GetOffsetUs(int64_t localUs) const
+{
+    return static_cast<int64_t>(m_refOffsetUs + m_slope * static_cast<double>(localUs - m_refLocalUs));
+}
+
+double ESAvSyncEngine::ClockMapper::GetDriftPpm() const
+{
+    return m_slope * 1e6;
+}
+
+void ESAvSyncEngine::ClockMapper::Refit()
+{
+    m_valid = !m_buckets.empty();
+    if (!m_valid) {
+        return;
+    }
+
+    const Bucket& last = m_buckets.back();
+    m_refLocalUs = last.localUs;
+
+    // 桶太少时斜率不可信，直接用最近的最小值
+    if (m_buckets.size() < 3) {
+        m_slope = 0.0;
+        m_refOffsetUs = static_cast<double>(last.offsetUs);
+        return;
+    }
+
+    // 以最后一个桶为原点做最小二乘，避免大数相减丢精度
+    double sumX = 0.0;
+    double sumY = 0.0;
+    for (const Bucket& bucket : m_buckets) {
+        sumX += static_cast<double>(bucket.localUs - last.localUs);
+        sumY += static_cast<double>(bucket.offsetUs - last.offsetUs);
+    }
+
+    const double n = static_cast<double>(m_buckets.size());
+    const double meanX = sumX / n;
+    const double meanY = sumY / n;
+
+    double sxx = 0.0;
+    double sxy = 0.0;
+    for (const Bucket& bucket : m_buckets) {
+        const double dx = static_cast<double>(bucket.localUs - last.localUs) - meanX;
+        const double dy = static_cast<double>(bucket.offsetUs - last.offsetUs) - meanY;
+        sxx += dx * dx;
+        sxy += dx * dy;
+    }
+
+    m_slope = (sxx > 0.0) ? (sxy / sxx) : 0.0;
+    m_refOffsetUs = static_cast<double>(last.offsetUs) + meanY + m_slope * (0.0 - meanX);
+}
+
+// ---------------- ESAvSyncEngine ----------------
+
+ESAvSyncEngine::ESAvSyncEngine()
+{
+    SetConfig(ESAvSyncConfig{});
+}
+
+ESAvSyncEngine::~ESAvSyncEngine() = default;
+
+void ESAvSyncEngine::SetConfig(const ESAvSyncConfig& config)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_config = config;
+    if (m_config.audioClockRate == 0) {
+        m_config.audioClockRate = 44100;
+    }
+
+    m_videoClock.Configure(m_config.bucketMs, m_config.bucketCount);
+    m_audioClock.Configure(m_config.bucketMs, m_config.bucketCount);
+
+    m_hasAudioAnchor = false;
+    m_anchorFromSync = false;
+    m_lastLocalUs = 0;
+    m_stats = ESAvSyncStats{};
+}
+
+ESAvSyncConfig ESAvSyncEngine::GetConfig() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_config;
+}
+
+void ESAvSyncEngine::Reset()
+{
+    SetConfig(GetConfig());
+}
+
+bool ESAvSyncEngine::InputControlPacket(const uint8_t* data, size_t size, uint64_t localUs)
+{
+    if (data == nullptr || size < kSyncPacketSize) {
+        return false;
+    }
+
+    if (((data[0] >> 6) & 0x03) != 2 || (data[1] & 0x7F) != kSyncPayloadType) {
+        return false;
+    }
+
+    // [4] 当前 RTP 时间戳 - 延迟 | [8] NTP 32.32 | [16] 与 NTP 对应的当前 RTP 时间戳
+    const uint64_t ntp = (static_cast<uint64_t>(ReadBe32(data + 8)) << 32) | ReadBe32(data + 12);
+    const uint32_t rtpNow = ReadBe32(data + 16);
+
+    InputSyncAnchor(rtpNow, ntp, localUs);
+    return true;
+}
+
+void ESAvSyncEngine::InputSyncAnchor(uint32_t rtpTimestamp, uint64_t ntp32_32, uint64_t localUs)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const int64_t senderUs = static_cast<int64_t>(Ntp32_32ToUs(ntp32_32));
+    const int64_t local = static_cast<int64_t>(localUs);
+    m_lastLocalUs = std::max(m_lastLocalUs, local);
+
+    // 同步包里的 NTP 与视频 32.32 必须是同一个发送端时钟，否则不能拿来对齐
+    if (m_videoClock.IsValid()) {
+        const int64_t videoSenderNow = local - m_videoClock.GetOffsetUs(local);
+        const int64_t skewUs = senderUs - videoSenderNow;
+        if (std::llabs(skewUs) > static_cast<int64_t>(m_config.maxEpochSkewMs) * 1000) {
+            ++m_stats.rejectedSyncPackets;
+            return;
+        }
+    }
+
+    if (!m_anchorFromSync) {
+        // 由回退锚点切换到同步包锚点，之前的音频时延样本基准不同，需要丢掉
+        m_audioClock.Reset();
+    }
+
+    m_hasAudioAnchor = true;
+    m_anchorFromSync = true;
+    m_anchorRtp = rtpTimestamp;
+    m_anchorSenderUs = senderUs;
+    ++m_stats.syncPackets;
+}
+
+uint64_t ESAvSyncEngine::OnVideoArrival(uint64_t timestamp32_32, uint64_t localUs)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const int64_t senderUs = static_cast<int64_t>(Ntp32_32ToUs(timestamp32_32));
+    const int64_t local = static_cast<int64_t>(localUs);
+    m_lastLocalUs = std::max(m_lastLocalUs, local);
+
+    m_videoClock.AddSample(senderUs, local);
+    m_stats.hasVideo = true;
+
+    return DeadlineLocked(senderUs);
+}
+
+uint64_t ESAvSyncEngine::OnAudioArrival(uint32_t rtpTimestamp, uint64_t localUs)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const int64_t local = static_cast<int64_t>(localUs);
+    m_lastLocalUs = std::max(m_lastLocalUs, local);
+
+    // 没有同步包时的回退：假设首个音频包与同一时刻到达的视频传输时延相同，
+    // 用视频的时钟映射给音频 RTP 定锚；视频还没到时先用本地时间，视频就绪后重新定锚
+    const bool anchorFromLocal = m_hasAudioAnchor && !m_anchorFromSync && !m_stats.hasAudio;
+    if (!m_hasAudioAnchor || (anchorFromLocal && m_videoClock.IsValid())) {
+        m_anchorRtp = rtpTimestamp;
+        m_anchorSenderUs = m_videoClock.IsValid()
+            ? local - m_videoClock.GetOffsetUs(local)
+            : local;
+        m_hasAudioAnchor = true;
+        m_anchorFromSync = false;
+        m_audioClock.Reset();
+    }
+
+    const int64_t senderUs = AudioRtpToSenderUsLocked(rtpTimestamp);
+    m_audioClock.AddSample(senderUs, local);
+
+    // 视频就绪后才算真正锚定到公共时间轴
+    if (m_anchorFromSync || m_videoClock.IsValid()) {
+        m_stats.hasAudio = true;
+    }
+
+    return DeadlineLocked(senderUs);
+}
+
+uint64_t ESAvSyncEngine::GetVideoDeadlineUs(uint64_t timestamp32_32) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return DeadlineLocked(static_cast<int64_t>(Ntp32_32ToUs(timestamp32_32)));
+}
+
+uint64_t ESAvSyncEngine::GetAudioDeadlineUs(uint32_t rtpTimestamp) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_hasAudioAnchor) {
+        return 0;
+    }
+
+    return DeadlineLocked(AudioRtpToSenderUsLocked(rtpTimestamp));
+}
+
+double ESAvSyncEngine::GetLipSyncOffsetMs() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_videoClock.IsValid() || !m_audioClock.IsValid()) {
+        return 0.0;
+    }
+
+    return static_cast<double>(m_audioClock.GetOffsetUs(m_lastLocalUs) -
+                               m_videoClock.GetOffsetUs(m_lastLocalUs)) / 1000.0;
+}
+
+ESAvSyncStats ESAvSyncEngine::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    ESAvSyncStats stats = m_stats;
+    stats.hasSyncAnchor = m_anchorFromSync;
+    stats.playoutDelayMs = m_config.playoutDelayMs;
+
+    if (m_videoClock.IsValid()) {
+        stats.videoTransitMs = static_cast<double>(m_videoClock.GetOffsetUs(m_lastLocalUs)) / 1000.0;
+        stats.driftPpm = m_videoClock.GetDriftPpm();
+    } else if (m_audioClock.IsValid()) {
+        stats.driftPpm = m_audioClock.GetDriftPpm();
+    }
+
+    if (m_audioClock.IsValid()) {
+        stats.audioTransitMs = static_cast<double>(m_audioClock.GetOffsetUs(m_lastLocalUs)) / 1000.0;
+    }
+
+    if (m_videoClock.IsValid() && m_audioClock.IsValid()) {
+        stats.lipSyncOffsetMs = stats.audioTransitMs - stats.videoTransitMs;
+    }
+
+    return stats;
+}
+
+uint64_t ESAvSyncEngine::Ntp32_32ToUs(uint64_t timestamp32_32)
+{
+    const uint64_t seconds = timestamp32_32 >> 32;
+    const uint64_t fraction = timestamp32_32 & 0xFFFFFFFFull;
+    return seconds * 1000000ull + ((fraction * 1000000ull) >> 32);
+}
+
+int64_t ESAvSyncEngine::AudioRtpToSenderUsLocked(uint32_t rtpTimestamp) const
+{
+    // int32 差值在 44.1kHz 下可覆盖 ±13 小时，锚点随同步包持续刷新，不需要展开成 64 位
+    const int32_t deltaTicks = static_cast<int32_t>(rtpTimestamp - m_anchorRtp);
+    return m_anchorSenderUs +
+           static_cast<int64_t>(deltaTicks) * 1000000 / static_cast<int64_t>(m_config.audioClockRate);
+}
+
+int64_t ESAvSyncEngine::CommonOffsetUsLocked(int64_t localUs) const
+{
+    // 两路共用同一个偏移：取较慢的那路，保证 deadline 时两路数据都已到达
+    const bool hasVideo = m_videoClock.IsValid();
+    const bool hasAudio = m_audioClock.IsValid() && m_stats.hasAudio;
+
+    if (hasVideo && hasAudio) {
+        return std::max(m_videoClock.GetOffsetUs(localUs), m_audioClock.GetOffsetUs(localUs));
+    }
+    if (hasVideo) {
+        return m_videoClock.GetOffsetUs(localUs);
+    }
+    return m_audioClock.GetOffsetUs(localUs);
+}
+
+uint64_t ESAvSyncEngine::DeadlineLocked(int64_t senderUs) const
+{
+    if (!m_videoClock.IsValid() && !m_audioClock.IsValid()) {
+        return 0;
+    }
+
+    const int64_t deadline = senderUs + CommonOffsetUsLocked(m_lastLocalUs) +
+                             static_cast<int64_t>(m_config.playoutDelayMs) * 1000;
+    return deadline > 0 ? static_cast<uint64_t>(deadline) : 0;
+}
+
+} // namespace hhcast
\ No newline at end of file
@@ -0,0 +1,82 @@
+#include "ESClockSync.h"
+
+namespace hhcast {
+
+bool ESClockSync::MakeExchange(const ESHeartbeatTiming& peer, int64_t localRecvUs, ESClockExchange& exchange)
+{
+    if (!peer.HasEcho() || peer.sendUs == 0 || localRecvUs == 0) {
+        return false;
+    }
+
+    exchange.t1Us = peer.echoUs;
+    exchange.t2Us = peer.echoRecvUs;
+    exchange.t3Us = peer.sendUs;
+    exchange.t4Us = localRecvUs;
+    return true;
+}
+
+bool ESClockSync::AddExchange(const ESClockExchange& exchange)
+{
+    // 对端处理耗时 (t3 - t2) 不计入网络往返
+    const int64_t rttUs = (exchange.t4Us - exchange.t1Us) - (exchange.t3Us - exchange.t2Us);
+    const int64_t offsetUs = ((exchange.t2Us - exchange.t1Us) + (exchange.t3Us - exchange.t4Us)) / 2;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (rttUs < 0 || rttUs > kMaxRttUs || exchange.t4Us < exchange.t1Us) {
+        ++m_stats.rejectedCount;
+        return false;
+    }
+
+    m_window[m_windowNext] = { rttUs, offsetUs };
+    m_windowNext = (m_windowNext + 1) % kWindowSize;
+    if (m_windowCount < kWindowSize) {
+        ++m_windowCount;
+    }
+
+    m_stats.lastRttUs = rttUs;
+    m_stats.lastOffsetUs = offsetUs;
+    if (m_stats.sampleCount == 0) {
+        m_stats.smoothedRttUs = rttUs;
+        m_stats.minRttUs = rttUs;
+    } else {
+        m_stats.smoothedRttUs += (rttUs - m_stats.smoothedRttUs) / 8;
+        if (rttUs < m_stats.minRttUs) {
+            m_stats.minRttUs = rttUs;
+        }
+    }
+    ++m_stats.sampleCount;
+
+    SelectLocked();
+    return true;
+}
+
+void ESClockSync::SelectLocked()
+{
+    size_t best = 0;
+    for (size_t i = 1; i < m_windowCount; ++i) {
+        if (m_window[i].rttUs < m_window[best].rttUs) {
+            best = i;
+        }
+    }
+
+    m_stats.rttUs = m_window[best].rttUs;
+    m_stats.offsetUs = m_window[best].offsetUs;
+    m_stats.valid = true;
+}
+
+ESClockSyncStats ESClockSync::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void ESClockSync::Reset()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_windowCount = 0;
+    m_windowNext = 0;
+    m_stats = ESClockSyncStats{};
+}
+
+} // namespace hhcast
\ No newline at end of file
@@ -0,0 +1,137 @@
+#include "ESEventLoopPool.h"
+
+#include <iostream>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace hhcast {
+
+namespace {
+
+bool PinCurrentThread(int cpu)
+{
+#ifdef __linux__
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        return false;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+} // namespace
+
+ESEventLoopPool::ESEventLoopPool() = default;
+
+ESEventLoopPool::~ESEventLoopPool()
+{
+    Stop();
+}
+
+int ESEventLoopPool::Start(size_t loopCount, const std::vector<int>& cpus)
+{
+    if (m_pool) {
+        return 0;
+    }
+
+    if (loopCount == 0) {
+        loopCount = 1;
+    }
+
+    m_pool = std::make_unique<hv::EventLoopThreadPool>(static_cast<int>(loopCount));
+    m_pool->start(true);
+
+    m_loopCount = loopCount;
+    m_nextLoop = 0;
+
+    std::vector<hv::EventLoopPtr> loops;
+    for (size_t i = 0; i < m_loopCount; ++i) {
+        hv::EventLoopPtr loop = GetLoop(i);
+        if (loop == nullptr) {
+            std::cout << "[ESEventLoopPool] loop " << i << " not started" << std::endl;
+            Stop();
+            return -1;
+        }
+        loops.push_back(loop);
+    }
+
+    PinLoops(loops, cpus);
+
+    std::cout << "[ESEventLoopPool] started, loops=" << m_loopCount << std::endl;
+    return 0;
+}
+
+void ESEventLoopPool::Stop()
+{
+    if (!m_pool) {
+        return;
+    }
+
+    m_pool->stop(true);
+    m_pool.reset();
+
+    m_loopCount = 0;
+    m_nextLoop = 0;
+}
+
+bool ESEventLoopPool::IsRunning() const
+{
+    return m_pool != nullptr;
+}
+
+size_t ESEventLoopPool::GetLoopCount() const
+{
+    return m_loopCount;
+}
+
+hv::EventLoopPtr ESEventLoopPool::GetLoop(size_t index) const
+{
+    if (!m_pool || index >= m_loopCount) {
+        return nullptr;
+    }
+
+    return m_pool->loop(static_cast<int>(index));
+}
+
+hv::EventLoopPtr ESEventLoopPool::NextLoop()
+{
+    if (!m_pool || m_loopCount == 0) {
+        return nullptr;
+    }
+
+    // 监听数量固定且在 Start 时一次分完，轮询即可均匀铺开
+    hv::EventLoopPtr loop = GetLoop(m_nextLoop);
+    m_nextLoop = (m_nextLoop + 1) % m_loopCount;
+    return loop;
+}
+
+void ESEventLoopPool::PinLoops(const std::vector<hv::EventLoopPtr>& loops, const std::vector<int>& cpus)
+{
+    if (cpus.empty()) {
+        return;
+    }
+
+    for (size_t i = 0; i < loops.size(); ++i) {
+        if (loops[i] == nullptr) {
+            continue;
+        }
+
+        const int cpu = cpus[i % cpus.size()];
+        loops[i]->runInLoop([i, cpu]() {
+            if (!PinCurrentThread(cpu)) {
+                std::cout << "[ESEventLoopPool] pin loop " << i << " to cpu " << cpu << " failed" << std::endl;
+            }
+        });
+    }
+}
+
+} // namespace hhcast
\ No newline at end of file
@@ -0,0 +1,269 @@
+#include "ESFecCodec.h"
+
+#include <cstring>
+
+namespace hhcast {
+
+namespace {
+
+// GF(2^8)，本原多项式 x^8 + x^4 + x^3 + x^2 + 1 (0x11D)
+struct GfTables {
+    uint8_t exp[512];
+    uint8_t log[256];
+
+    GfTables()
+    {
+        uint32_t x = 1;
+        for (int i = 0; i < 255; ++i) {
+            exp[i] = static_cast<uint8_t>(x);
+            log[x] = static_cast<uint8_t>(i);
+            x <<= 1;
+            if (x & 0x100) {
+                x ^= 0x11D;
+            }
+        }
+        for (int i = 255; i < 512; ++i) {
+            exp[i] = exp[i - 255];
+        }
+        log[0] = 0;
+    }
+};
+
+static const GfTables& Gf()
+{
+    static const GfTables tables;
+    return tables;
+}
+
+static uint8_t GfMul(uint8_t a, uint8_t b)
+{
+    if (a == 0 || b == 0) {
+        return 0;
+    }
+    const GfTables& gf = Gf();
+    return gf.exp[gf.log[a] + gf.log[b]];
+}
+
+static uint8_t GfInv(uint8_t a)
+{
+    const GfTables& gf = Gf();
+    return gf.exp[255 - gf.log[a]];
+}
+
+// dst ^= coef * src
+static void GfMulAdd(uint8_t* dst, const uint8_t* src, uint8_t coef, size_t size)
+{
+    if (coef == 0) {
+        return;
+    }
+
+    if (coef == 1) {
+        for (size_t i = 0; i < size; ++i) {
+            dst[i] ^= src[i];
+        }
+        return;
+    }
+
+    const GfTables& gf = Gf();
+    const uint32_t logCoef = gf.log[coef];
+    for (size_t i = 0; i < size; ++i) {
+        const uint8_t s = src[i];
+        if (s != 0) {
+            dst[i] ^= gf.exp[gf.log[s] + logCoef];
+        }
+    }
+}
+
+static void GfScale(uint8_t* dst, uint8_t coef, size_t size)
+{
+    for (size_t i = 0; i < size; ++i) {
+        dst[i] = GfMul(dst[i], coef);
+    }
+}
+
+} // namespace
+
+ESFecCodec::ESFecCodec() = default;
+ESFecCodec::~ESFecCodec() = default;
+
+bool ESFecCodec::Configure(ESFecScheme scheme, uint8_t dataShards, uint8_t parityShards)
+{
+    if (scheme == ESFecScheme::None) {
+        m_scheme = scheme;
+        m_dataShards = dataShards;
+        m_parityShards = 0;
+        return true;
+    }
+
+    if (scheme == ESFecScheme::Xor) {
+        parityShards = 1;
+    }
+
+    if (dataShards == 0 || parityShards == 0 ||
+        static_cast<size_t>(dataShards) + parityShards > kMaxShards) {
+        return false;
+    }
+
+    m_scheme = scheme;
+    m_dataShards = dataShards;
+    m_parityShards = parityShards;
+    return true;
+}
+
+ESFecScheme ESFecCodec::GetScheme() const
+{
+    return m_scheme;
+}
+
+uint8_t ESFecCodec::GetDataShards() const
+{
+    return m_dataShards;
+}
+
+uint8_t ESFecCodec::GetParityShards() const
+{
+    return m_parityShards;
+}
+
+uint8_t ESFecCodec::CauchyCoef(size_t parityRow, size_t dataCol) const
+{
+    // x_j = j, y_i = parityShards + i，两组取值互不相同，保证任意方阵子阵可逆
+    const uint8_t x = static_cast<uint8_t>(parityRow);
+    const uint8_t y = static_cast<uint8_t>(m_parityShards + dataCol);
+    return GfInv(static_cast<uint8_t>(x ^ y));
+}
+
+bool ESFecCodec::Encode(const uint8_t* const* data, size_t shardSize, uint8_t* const* parity) const
+{
+    if (m_scheme == ESFecScheme::None || data == nullptr || parity == nullptr || shardSize == 0) {
+        return false;
+    }
+
+    for (size_t j = 0; j < m_parityShards; ++j) {
+        std::memset(parity[j], 0, shardSize);
+    }
+
+    if (m_scheme == ESFecScheme::Xor) {
+        for (size_t i = 0; i < m_dataShards; ++i) {
+            GfMulAdd(parity[0], data[i], 1, shardSize);
+        }
+        return true;
+    }
+
+    for (size_t j = 0; j < m_parityShards; ++j) {
+        for (size_t i = 0; i < m_dataShards; ++i) {
+            GfMulAdd(parity[j], data[i], CauchyCoef(j, i), shardSize);
+        }
+    }
+    return true;
+}
+
+bool ESFecCodec::Reconstruct(uint8_t* const* shards, bool* present, size_t shardSize) const
+{
+    if (m_scheme == ESFecScheme::None || shards == nullptr || present == nullptr || shardSize == 0) {
+        return false;
+    }
+
+    size_t missing[kMaxShards];
+    size_t missingCount = 0;
+    for (size_t i = 0; i < m_dataShards; ++i) {
+        if (!present[i]) {
+            missing[missingCount++] = i;
+        }
+    }
+
+    if (missingCount == 0) {
+        return true;
+    }
+
+    size_t parityRows[kMaxShards];
+    size_t parityCount = 0;
+    for (size_t j = 0; j < m_parityShards && parityCount < missingCount; ++j) {
+        if (present[m_dataShards + j]) {
+            parityRows[parityCount++] = j;
+        }
+    }
+
+    if (parityCount < missingCount) {
+        return false;
+    }
+
+    if (m_scheme == ESFecScheme::Xor) {
+        uint8_t* out = shards[missing[0]];
+        std::memcpy(out, shards[m_dataShards], shardSize);
+        for (size_t i = 0; i < m_dataShards; ++i) {
+            if (i != missing[0]) {
+                GfMulAdd(out, shards[i], 1, shardSize);
+            }
+        }
+        present[missing[0]] = true;
+        return true;
+    }
+
+    // 右侧：P_j - sum(已知数据分片)，直接写进缺失分片的缓冲里
+    for (size_t r = 0; r < missingCount; ++r) {
+        uint8_t* rhs = shards[missing[r]];
+        const size_t j = parityRows[r];
+        std::memcpy(rhs, shards[m_dataShards + j], shardSize);
+        for (size_t i = 0; i < m_dataShards; ++i) {
+            if (present[i]) {
+                GfMulAdd(rhs, shards[i], CauchyCoef(j, i), shardSize);
+            }
+        }
+    }
+
+    // 在 missingCount x missingCount 的 Cauchy 子阵上做高斯消元，行变换同步作用到 rhs
+    uint8_t matrix[kMaxShards][kMaxShards];
+    for (size_t r = 0; r < missingCount; ++r) {
+        for (size_t c = 0; c < missingCount; ++c) {
+            matrix[r][c] = CauchyCoef(parityRows[r], missing[c]);
+        }
+    }
+
+    for (size_t col = 0; col < missingCount; ++col) {
+        size_t pivot = col;
+        while (pivot < missingCount && matrix[pivot][col] == 0) {
+            ++pivot;
+        }
+        if (pivot == missingCount) {
+            return false;
+        }
+
+        if (pivot != col) {
+            for (size_t c = 0; c < missingCount; ++c) {
+                const uint8_t tmp = matrix[col][c];
+                matrix[col][c] = matrix[pivot][c];
+                matrix[pivot][c] = tmp;
+            }
+            for (size_t b = 0; b < shardSize; ++b) {
+                const uint8_t tmp = shards[missing[col]][b];
+                shards[missing[col]][b] = shards[missing[pivot]][b];
+                shards[missing[pivot]][b] = tmp;
+            }
+        }
+
+        const uint8_t inv = GfInv(matrix[col][col]);
+        for (size_t c = 0; c < missingCount; ++c) {
+            matrix[col][c] = GfMul(matrix[col][c], inv);
+        }
+        GfScale(shards[missing[col]], inv, shardSize);
+
+        for (size_t r = 0; r < missingCount; ++r) {
+            if (r == col || matrix[r][col] == 0) {
+                continue;
+            }
+            const uint8_t factor = matrix[r][col];
+            for (size_t c = 0; c < missingCount; ++c) {
+                matrix[r][c] ^= GfMul(factor, matrix[col][c]);
+            }
+            GfMulAdd(shards[missing[r]], shards[missing[col]], factor, shardSize);
+        }
+    }
+
+    for (size_t r = 0; r < missingCount; ++r) {
+        present[missing[r]] = true;
+    }
+    return true;
+}
+
+} // namespace hhcast
\ No newline at end of file
@@ -0,0 +1,665 @@
+#include "ESHandoff.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace hhcast {
+
+namespace {
+
+constexpr uint32_t kMagic = 0x4f485345;        // "ESHO"
+constexpr size_t kHeaderSize = 12;
+constexpr size_t kChunkBytes = 32 * 1024;      // 单条记录的最大负载，大块数据拆成多条 Chunk
+constexpr size_t kMaxBlobBytes = 64 * 1024 * 1024;
+
+enum RecordType : uint8_t {
+    kRecordHello = 1,
+    kRecordSocket,
+    kRecordSession,
+    kRecordChunk,
+    kRecordEnd,
+    kRecordAck,
+};
+
+void PutU8(std::string& out, uint8_t v)
+{
+    out.push_back(static_cast<char>(v));
+}
+
+void PutU16(std::string& out, uint16_t v)
+{
+    PutU8(out, static_cast<uint8_t>(v >> 8));
+    PutU8(out, static_cast<uint8_t>(v));
+}
+
+void PutU32(std::string& out, uint32_t v)
+{
+    PutU16(out, static_cast<uint16_t>(v >> 16));
+    PutU16(out, static_cast<uint16_t>(v));
+}
+
+void PutString(std::string& out, const std::string& s)
+{
+    const size_t len = s.size() < 0xffff ? s.size() : 0xffff;
+    PutU16(out, static_cast<uint16_t>(len));
+    out.append(s, 0, len);
+}
+
+class Reader {
+public:
+    explicit Reader(const std::string& data) : m_data(data) {}
+
+    bool U8(uint8_t& v)
+    {
+        if (m_pos + 1 > m_data.size()) {
+            return false;
+        }
+        v = static_cast<uint8_t>(m_data[m_pos++]);
+        return true;
+    }
+
+    bool U16(uint16_t& v)
+    {
+        uint8_t hi = 0;
+        uint8_t lo = 0;
+        if (!U8(hi) || !U8(lo)) {
+            return false;
+        }
+        v = static_cast<uint16_t>((hi << 8) | lo);
+        return true;
+    }
+
+    bool U32(uint32_t& v)
+    {
+        uint16_t hi = 0;
+        uint16_t lo = 0;
+        if (!U16(hi) || !U16(lo)) {
+            return false;
+        }
+        v = (static_cast<uint32_t>(hi) << 16) | lo;
+        return true;
+    }
+
+    bool String(std::string& s)
+    {
+        uint16_t len = 0;
+        if (!U16(len) || m_pos + len > m_data.size()) {
+            return false;
+        }
+        s.assign(m_data, m_pos, len);
+        m_pos += len;
+        return true;
+    }
+
+private:
+    const std::string& m_data;
+    size_t m_pos = 0;
+};
+
+#ifdef __linux__
+bool FillAddress(const std::string& path, sockaddr_un& addr)
+{
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+        return false;
+    }
+    std::memcpy(addr.sun_path, path.c_str(), path.size());
+    return true;
+}
+
+uint64_t PathInode(const std::string& path)
+{
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) {
+        return 0;
+    }
+    return static_cast<uint64_t>(st.st_ino);
+}
+
+void CloseFd(int& fd)
+{
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+#endif
+
+} // namespace
+
+//
+// ESHandoffState
+//
+
+ESHandoffState::~ESHandoffState()
+{
+    CloseAll();
+}
+
+size_t ESHandoffState::CountSockets(ESHandoffSocketKind kind, uint16_t localPort) const
+{
+    size_t count = 0;
+    for (const auto& socket : sockets) {
+        if (socket.fd >= 0 && socket.kind == kind && (localPort == 0 || socket.localPort == localPort)) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+int ESHandoffState::TakeSocket(ESHandoffSocketKind kind, uint16_t localPort)
+{
+    for (auto& socket : sockets) {
+        if (socket.fd < 0 || socket.kind != kind) {
+            continue;
+        }
+        if (localPort != 0 && socket.localPort != localPort) {
+            continue;
+        }
+        const int fd = socket.fd;
+        socket.fd = -1;
+        return fd;
+    }
+    return -1;
+}
+
+std::vector<int> ESHandoffState::TakeListeners(uint16_t localPort)
+{
+    std::vector<int> fds;
+    for (;;) {
+        const int fd = TakeSocket(ESHandoffSocketKind::TcpListener, localPort);
+        if (fd < 0) {
+            break;
+        }
+        fds.push_back(fd);
+    }
+    return fds;
+}
+
+void ESHandoffState::CloseAll()
+{
+#ifdef __linux__
+    for (auto& socket : sockets) {
+        CloseFd(socket.fd);
+    }
+#endif
+}
+
+//
+// ESHandoffLink
+//
+
+struct ESHandoffLink::Packet {
+    uint8_t type = 0;
+    std::string payload;
+    int fd = -1;
+};
+
+ESHandoffLink::ESHandoffLink(int fd)
+    : m_fd(fd)
+{
+}
+
+ESHandoffLink::~ESHandoffLink()
+{
+    Close();
+}
+
+bool ESHandoffLink::IsOpen() const
+{
+    return m_fd >= 0;
+}
+
+void ESHandoffLink::Close()
+{
+#ifdef __linux__
+    CloseFd(m_fd);
+#endif
+}
+
+int ESHandoffLink::Connect(const std::string& path)
+{
+#ifdef __linux__
+    Close();
+
+    sockaddr_un addr;
+    if (!FillAddress(path, addr)) {
+        std::cout << "[ESHandoff] invalid socket path: " << path << std::endl;
+        return -1;
+    }
+
+    m_fd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (m_fd < 0) {
+        return -1;
+    }
+
+    if (::connect(m_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        Close();
+        return -1;
+    }
+    return 0;
+#else
+    (void)path;
+    return -1;
+#endif
+}
+
+int ESHandoffLink::SendPacket(uint8_t type, const std::string& payload, int fd)
+{
+#ifdef __linux__
+    if (m_fd < 0 || payload.size() > kChunkBytes) {
+        return -1;
+    }
+
+    std::string header;
+    header.reserve(kHeaderSize);
+    PutU32(header, kMagic);
+    PutU8(header, type);
+    PutU8(header, fd >= 0 ? 1 : 0);
+    PutU16(header, 0);
+    PutU32(header, static_cast<uint32_t>(payload.size()));
+
+    iovec iov[2];
+    iov[0].iov_base = const_cast<char*>(header.data());
+    iov[0].iov_len = header.size();
+    iov[1].iov_base = const_cast<char*>(payload.data());
+    iov[1].iov_len = payload.size();
+
+    msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = payload.empty() ? 1 : 2;
+
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+    if (fd >= 0) {
+        std::memset(control, 0, sizeof(control));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        std::memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+    }
+
+    ssize_t n = -1;
+    do {
+        n = ::sendmsg(m_fd, &msg, MSG_NOSIGNAL);
+    } while (n < 0 && errno == EINTR);
+
+    return n == static_cast<ssize_t>(header.size() + payload.size()) ? 0 : -1;
+#else
+    (void)type;
+    (void)payload;
+    (void)fd;
+    return -1;
+#endif
+}
+
+int ESHandoffLink::RecvPacket(Packet& packet, uint32_t timeoutMs)
+{
+#ifdef __linux__
+    packet.type = 0;
+    packet.payload.clear();
+    CloseFd(packet.fd);
+
+    if (m_fd < 0) {
+        return -1;
+    }
+
+    pollfd pfd{ m_fd, POLLIN, 0 };
+    int ready = -1;
+    do {
+        ready = ::poll(&pfd, 1, static_cast<int>(timeoutMs));
+    } while (ready < 0 && errno == EINTR);
+    if (ready <= 0) {
+        return -2;
+    }
+
+    std::string buffer(kHeaderSize + kChunkBytes, '\0');
+    iovec iov{ &buffer[0], buffer.size() };
+
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+    msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t n = -1;
+    do {
+        n = ::recvmsg(m_fd, &msg, MSG_CMSG_CLOEXEC);
+    } while (n < 0 && errno == EINTR);
+
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS &&
+            cmsg->cmsg_len >= CMSG_LEN(sizeof(int))) {
+            std::memcpy(&packet.fd, CMSG_DATA(cmsg), sizeof(int));
+        }
+    }
+
+    if (n < static_cast<ssize_t>(kHeaderSize) || (msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) != 0) {
+        CloseFd(packet.fd);
+        return -1;
+    }
+
+    buffer.resize(static_cast<size_t>(n));
+    Reader header(buffer);
+    uint32_t magic = 0;
+    uint8_t flags = 0;
+    uint16_t reserved = 0;
+    uint32_t length = 0;
+    header.U32(magic);
+    header.U8(packet.type);
+    header.U8(flags);
+    header.U16(reserved);
+    header.U32(length);
+
+    const bool wantFd = (flags & 1) != 0;
+    if (magic != kMagic || length != buffer.size() - kHeaderSize || wantFd != (packet.fd >= 0)) {
+        CloseFd(packet.fd);
+        return -1;
+    }
+
+    packet.payload.assign(buffer, kHeaderSize, length);
+    return 0;
+#else
+    (void)packet;
+    (void)timeoutMs;
+    return -1;
+#endif
+}
+
+int ESHandoffLink::SendBlob(const std::string& blob)
+{
+    for (size_t offset = 0; offset < blob.size(); offset += kChunkBytes) {
+        if (SendPacket(kRecordChunk, blob.substr(offset, kChunkBytes)) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int ESHandoffLink::RecvBlob(std::string& blob, size_t size, uint32_t timeoutMs)
+{
+    blob.clear();
+    if (size > kMaxBlobBytes) {
+        return -1;
+    }
+    blob.reserve(size);
+
+    Packet packet;
+    while (blob.size() < size) {
+        if (RecvPacket(packet, timeoutMs) != 0 || packet.type != kRecordChunk ||
+            packet.fd >= 0 || blob.size() + packet.payload.size() > size) {
+            return -1;
+        }
+        blob += packet.payload;
+    }
+    return 0;
+}
+
+int ESHandoffLink::SendHello()
+{
+    std::string payload;
+    PutU32(payload, kVersion);
+    return SendPacket(kRecordHello, payload);
+}
+
+int ESHandoffLink::RecvHello(uint32_t timeoutMs)
+{
+    Packet packet;
+    if (RecvPacket(packet, timeoutMs) != 0 || packet.type != kRecordHello) {
+        return -1;
+    }
+
+    Reader reader(packet.payload);
+    uint32_t version = 0;
+    if (!reader.U32(version) || version != kVersion) {
+        std::cout << "[ESHandoff] unsupported version: " << version << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+int ESHandoffLink::SendState(const ESHandoffState& state)
+{
+    uint32_t socketCount = 0;
+    for (const auto& socket : state.sockets) {
+        if (socket.fd < 0) {
+            continue;
+        }
+
+        std::string payload;
+        PutU8(payload, static_cast<uint8_t>(socket.kind));
+        PutU16(payload, socket.localPort);
+        PutU32(payload, socket.peerIp);
+        PutU32(payload, static_cast<uint32_t>(socket.pending.size()));
+        if (SendPacket(kRecordSocket, payload, socket.fd) != 0 || SendBlob(socket.pending) != 0) {
+            return -1;
+        }
+        ++socketCount;
+    }
+
+    for (const auto& session : state.sessions) {
+        std::string payload;
+        PutU32(payload, session.streamId);
+        PutString(payload, session.peerIp);
+        PutString(payload, session.name);
+        PutU32(payload, static_cast<uint32_t>(session.videoPending.size()));
+        if (SendPacket(kRecordSession, payload) != 0 || SendBlob(session.videoPending) != 0) {
+            return -1;
+        }
+    }
+
+    std::string end;
+    PutU32(end, socketCount);
+    PutU32(end, static_cast<uint32_t>(state.sessions.size()));
+    return SendPacket(kRecordEnd, end);
+}
+
+int ESHandoffLink::RecvState(ESHandoffState& state, uint32_t timeoutMs)
+{
+    state.CloseAll();
+    state.sockets.clear();
+    state.sessions.clear();
+
+    Packet packet;
+    for (;;) {
+        if (RecvPacket(packet, timeoutMs) != 0) {
+            return -1;
+        }
+
+        Reader reader(packet.payload);
+        if (packet.type == kRecordSocket) {
+            ESHandoffSocket socket;
+            socket.fd = packet.fd;
+            packet.fd = -1;
+
+            uint8_t kind = 0;
+            uint32_t pendingSize = 0;
+            const bool ok = reader.U8(kind) && reader.U16(socket.localPort) &&
+                            reader.U32(socket.peerIp) && reader.U32(pendingSize);
+            socket.kind = static_cast<ESHandoffSocketKind>(kind);
+            state.sockets.push_back(std::move(socket));
+            if (!ok || RecvBlob(state.sockets.back().pending, pendingSize, timeoutMs) != 0) {
+                return -1;
+            }
+        } else if (packet.type == kRecordSession) {
+            ESHandoffSession session;
+            uint32_t pendingSize = 0;
+            if (packet.fd >= 0 ||
+                !reader.U32(session.streamId) || !reader.String(session.peerIp) ||
+                !reader.String(session.name) || !reader.U32(pendingSize) ||
+                RecvBlob(session.videoPending, pendingSize, timeoutMs) != 0) {
+                return -1;
+            }
+            state.sessions.push_back(std::move(session));
+        } else if (packet.type == kRecordEnd) {
+            uint32_t socketCount = 0;
+            uint32_t sessionCount = 0;
+            if (!reader.U32(socketCount) || !reader.U32(sessionCount) ||
+                socketCount != state.sockets.size() || sessionCount != state.sessions.size()) {
+                return -1;
+            }
+            return 0;
+        } else {
+            return -1;
+        }
+    }
+}
+
+int ESHandoffLink::SendAck(bool ok)
+{
+    std::string payload;
+    PutU8(payload, ok ? 1 : 0);
+    return SendPacket(kRecordAck, payload);
+}
+
+int ESHandoffLink::RecvAck(uint32_t timeoutMs)
+{
+    Packet packet;
+    if (RecvPacket(packet, timeoutMs) != 0 || packet.type != kRecordAck) {
+        return -1;
+    }
+
+    Reader reader(packet.payload);
+    uint8_t ok = 0;
+    if (!reader.U8(ok) || ok == 0) {
+        return -2;
+    }
+    return 0;
+}
+
+//
+// ESHandoffListener
+//
+
+ESHandoffListener::ESHandoffListener()
+{
+}
+
+ESHandoffListener::~ESHandoffListener()
+{
+    Stop();
+}
+
+bool ESHandoffListener::IsRunning() const
+{
+    return m_running.load();
+}
+
+int ESHandoffListener::Start(const std::string& path, Handler handler)
+{
+#ifdef __linux__
+    if (m_running) {
+        return 0;
+    }
+
+    sockaddr_un addr;
+    if (!FillAddress(path, addr)) {
+        std::cout << "[ESHandoff] invalid socket path: " << path << std::endl;
+        return -1;
+    }
+
+    m_listenFd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (m_listenFd < 0) {
+        return -1;
+    }
+
+    // 旧进程已经交接完或异常退出，路径上留下的是无人监听的文件
+    ::unlink(path.c_str());
+    // 交接会传出所有连接的 fd：listen 之前先把 socket 文件改成只有属主可连（0600），
+    // bind 到 listen 之间 connect 会被拒绝，没有窗口期；accept 后再按 SO_PEERCRED 校验 uid
+    if (::bind(m_listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::chmod(path.c_str(), S_IRUSR | S_IWUSR) != 0 ||
+        ::listen(m_listenFd, 1) != 0) {
+        std::cout << "[ESHandoff] listen failed: " << path << " errno=" << errno << std::endl;
+        CloseFd(m_listenFd);
+        return -1;
+    }
+
+    m_path = path;
+    m_pathInode = PathInode(path);
+    m_handler = std::move(handler);
+    m_running = true;
+    m_thread = std::thread(&ESHandoffListener::AcceptLoop, this);
+
+    std::cout << "[ESHandoff] listening on " << path << std::endl;
+    return 0;
+#else
+    (void)path;
+    (void)handler;
+    return -1;
+#endif
+}
+
+void ESHandoffListener::Stop()
+{
+#ifdef __linux__
+    if (!m_running.exchange(false)) {
+        return;
+    }
+
+    if (m_thread.joinable()) {
+        if (m_thread.get_id() == std::this_thread::get_id()) {
+            m_thread.detach();
+        } else {
+            m_thread.join();
+        }
+    }
+
+    CloseFd(m_listenFd);
+    if (m_pathInode != 0 && PathInode(m_path) == m_pathInode) {
+        ::unlink(m_path.c_str());
+    }
+    m_pathInode = 0;
+#endif
+}
+
+void ESHandoffListener::AcceptLoop()
+{
+#ifdef __linux__
+    const int listenFd = m_listenFd;
+
+    while (m_running) {
+        pollfd pfd{ listenFd, POLLIN, 0 };
+        if (::poll(&pfd, 1, 200) <= 0) {
+            continue;
+        }
+
+        int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+
+        ucred cred{};
+        socklen_t credLen = sizeof(cred);
+        if (::getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &credLen) != 0 || cred.uid != ::geteuid()) {
+            std::cout << "[ESHandoff] reject peer pid=" << cred.pid << " uid=" << cred.uid << std::endl;
+            CloseFd(fd);
+            continue;
+        }
+
+        ESHandoffLink link(fd);
+        if (m_handler) {
+            m_handler(link);
+        }
+    }
+#endif
+}
+
+} // namespace hhcast
\ No newline at end of file
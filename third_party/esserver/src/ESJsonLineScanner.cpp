@@ -0,0 +1,646 @@
+#include "ESJsonLineScanner.h"
+
+#include <limits>
+
+namespace hhcast {
+
+namespace {
+
+static bool IsSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static std::string_view Trim(std::string_view value)
+{
+    while (!value.empty() && IsSpace(value.front())) {
+        value.remove_prefix(1);
+    }
+    while (!value.empty() && IsSpace(value.back())) {
+        value.remove_suffix(1);
+    }
+    return value;
+}
+
+static bool IEquals(std::string_view a, std::string_view b)
+{
+    if (a.size() != b.size()) {
+        return false;
+    }
+
+    for (size_t i = 0; i < a.size(); ++i) {
+        char x = a[i];
+        char y = b[i];
+        if (x >= 'A' && x <= 'Z') x = static_cast<char>(x - 'A' + 'a');
+        if (y >= 'A' && y <= 'Z') y = static_cast<char>(y - 'A' + 'a');
+        if (x != y) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void SkipSpace(std::string_view text, size_t& pos)
+{
+    while (pos < text.size() && IsSpace(text[pos])) {
+        ++pos;
+    }
+}
+
+static int HexValue(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static bool ReadHex4(std::string_view raw, size_t pos, uint32_t& value)
+{
+    if (pos + 4 > raw.size()) {
+        return false;
+    }
+
+    value = 0;
+    for (size_t i = 0; i < 4; ++i) {
+        const int h = HexValue(raw[pos + i]);
+        if (h < 0) {
+            return false;
+        }
+        value = (value << 4) | static_cast<uint32_t>(h);
+    }
+    return true;
+}
+
+static size_t EncodeUtf8(uint32_t cp, char out[4])
+{
+    if (cp < 0x80) {
+        out[0] = static_cast<char>(cp);
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = static_cast<char>(0xC0 | (cp >> 6));
+        out[1] = static_cast<char>(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = static_cast<char>(0xE0 | (cp >> 12));
+        out[1] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = static_cast<char>(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = static_cast<char>(0xF0 | (cp >> 18));
+    out[1] = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = static_cast<char>(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+// 从 raw[pos] 解出一个字符（UTF-8 字节序列），pos 前移；非法转义返回 false
+static bool DecodeNext(std::string_view raw, size_t& pos, char out[4], size_t& outSize)
+{
+    const char c = raw[pos];
+    if (c != '\\') {
+        out[0] = c;
+        outSize = 1;
+        ++pos;
+        return true;
+    }
+
+    if (pos + 1 >= raw.size()) {
+        return false;
+    }
+
+    const char e = raw[pos + 1];
+    pos += 2;
+    outSize = 1;
+
+    switch (e) {
+    case '"':  out[0] = '"';  return true;
+    case '\\': out[0] = '\\'; return true;
+    case '/':  out[0] = '/';  return true;
+    case 'b':  out[0] = '\b'; return true;
+    case 'f':  out[0] = '\f'; return true;
+    case 'n':  out[0] = '\n'; return true;
+    case 'r':  out[0] = '\r'; return true;
+    case 't':  out[0] = '\t'; return true;
+    case 'u':  break;
+    default:   return false;
+    }
+
+    uint32_t cp = 0;
+    if (!ReadHex4(raw, pos, cp)) {
+        return false;
+    }
+    pos += 4;
+
+    if (cp >= 0xD800 && cp <= 0xDBFF) {
+        // 高位代理后面必须紧跟低位代理
+        uint32_t low = 0;
+        if (pos + 6 > raw.size() || raw[pos] != '\\' || raw[pos + 1] != 'u' ||
+            !ReadHex4(raw, pos + 2, low) || low < 0xDC00 || low > 0xDFFF) {
+            return false;
+        }
+        pos += 6;
+        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+    } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+        return false;
+    }
+
+    outSize = EncodeUtf8(cp, out);
+    return true;
+}
+
+// 带转义的原文与明文逐字符比较，不分配内存
+static bool EscapedEquals(std::string_view raw, std::string_view text)
+{
+    size_t pos = 0;
+    size_t matched = 0;
+    char buf[4];
+    size_t n = 0;
+
+    while (pos < raw.size()) {
+        if (!DecodeNext(raw, pos, buf, n)) {
+            return false;
+        }
+        if (matched + n > text.size() || text.compare(matched, n, buf, n) != 0) {
+            return false;
+        }
+        matched += n;
+    }
+    return matched == text.size();
+}
+
+// text[pos] 为起始引号；成功时 pos 指向结束引号之后
+static bool ScanString(std::string_view text, size_t& pos, std::string_view& body, bool& escaped)
+{
+    const size_t begin = ++pos;
+    escaped = false;
+
+    while (pos < text.size()) {
+        const char c = text[pos];
+        if (c == '"') {
+            body = text.substr(begin, pos - begin);
+            ++pos;
+            return true;
+        }
+        if (c == '\\') {
+            escaped = true;
+            pos += 2;
+            continue;
+        }
+        if (static_cast<unsigned char>(c) < 0x20) {
+            return false;
+        }
+        ++pos;
+    }
+    return false;
+}
+
+// 跳过嵌套对象/数组，只做括号配对和字符串识别
+static bool SkipNested(std::string_view text, size_t& pos)
+{
+    constexpr int kMaxDepth = 64;
+    int depth = 0;
+
+    while (pos < text.size()) {
+        const char c = text[pos];
+        if (c == '"') {
+            std::string_view body;
+            bool escaped = false;
+            if (!ScanString(text, pos, body, escaped)) {
+                return false;
+            }
+            continue;
+        }
+
+        if (c == '{' || c == '[') {
+            if (++depth > kMaxDepth) {
+                return false;
+            }
+        } else if (c == '}' || c == ']') {
+            if (--depth == 0) {
+                ++pos;
+                return true;
+            }
+        }
+        ++pos;
+    }
+    return false;
+}
+
+static bool ScanLiteral(std::string_view text, size_t& pos, std::string_view literal)
+{
+    if (text.compare(pos, literal.size(), literal) != 0) {
+        return false;
+    }
+    pos += literal.size();
+    return true;
+}
+
+static bool ScanNumber(std::string_view text, size_t& pos)
+{
+    const size_t begin = pos;
+    while (pos < text.size()) {
+        const char c = text[pos];
+        if ((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E') {
+            ++pos;
+            continue;
+        }
+        break;
+    }
+    return pos > begin;
+}
+
+} // namespace
+
+bool ESJsonLineScanner::Parse(std::string_view line)
+{
+    m_fieldCount = 0;
+
+    size_t pos = 0;
+    SkipSpace(line, pos);
+    if (pos >= line.size() || line[pos] != '{') {
+        return false;
+    }
+    ++pos;
+
+    SkipSpace(line, pos);
+    if (pos < line.size() && line[pos] == '}') {
+        ++pos;
+        SkipSpace(line, pos);
+        return pos == line.size();
+    }
+
+    while (true) {
+        SkipSpace(line, pos);
+        if (pos >= line.size() || line[pos] != '"') {
+            return false;
+        }
+
+        ESJsonField field;
+        if (!ScanString(line, pos, field.key, field.keyEscaped)) {
+            return false;
+        }
+
+        SkipSpace(line, pos);
+        if (pos >= line.size() || line[pos] != ':') {
+            return false;
+        }
+        ++pos;
+        SkipSpace(line, pos);
+        if (pos >= line.size()) {
+            return false;
+        }
+
+        const size_t valueBegin = pos;
+        const char c = line[pos];
+        if (c == '"') {
+            field.type = ESJsonValueType::String;
+            if (!ScanString(line, pos, field.raw, field.valueEscaped)) {
+                return false;
+            }
+        } else {
+            bool ok = false;
+            if (c == '{' || c == '[') {
+                field.type = (c == '{') ? ESJsonValueType::Object : ESJsonValueType::Array;
+                ok = SkipNested(line, pos);
+            } else if (c == 't') {
+                field.type = ESJsonValueType::True;
+                ok = ScanLiteral(line, pos, "true");
+            } else if (c == 'f') {
+                field.type = ESJsonValueType::False;
+                ok = ScanLiteral(line, pos, "false");
+            } else if (c == 'n') {
+                field.type = ESJsonValueType::Null;
+                ok = ScanLiteral(line, pos, "null");
+            } else {
+                field.type = ESJsonValueType::Number;
+                ok = ScanNumber(line, pos);
+            }
+
+            if (!ok) {
+                return false;
+            }
+            field.raw = line.substr(valueBegin, pos - valueBegin);
+        }
+
+        if (m_fieldCount < kMaxFields) {
+            m_fields[m_fieldCount++] = field;
+        }
+
+        SkipSpace(line, pos);
+        if (pos >= line.size()) {
+            return false;
+        }
+        if (line[pos] == ',') {
+            ++pos;
+            continue;
+        }
+        if (line[pos] == '}') {
+            ++pos;
+            break;
+        }
+        return false;
+    }
+
+    SkipSpace(line, pos);
+    return pos == line.size();
+}
+
+size_t ESJsonLineScanner::GetFieldCount() const
+{
+    return m_fieldCount;
+}
+
+const ESJsonField& ESJsonLineScanner::GetField(size_t index) const
+{
+    return m_fields[index];
+}
+
+const ESJsonField* ESJsonLineScanner::Find(std::string_view key) const
+{
+    // 重复的键以最后一个为准，和 QJsonDocument 一致
+    for (size_t i = m_fieldCount; i > 0; --i) {
+        const ESJsonField& field = m_fields[i - 1];
+        if (field.keyEscaped ? EscapedEquals(field.key, key) : field.key == key) {
+            return &field;
+        }
+    }
+    return nullptr;
+}
+
+bool ESJsonLineScanner::Has(std::string_view key) const
+{
+    return Find(key) != nullptr;
+}
+
+bool ESJsonLineScanner::GetString(std::string_view key, std::string_view& out, std::string* scratch) const
+{
+    const ESJsonField* field = Find(key);
+    if (field == nullptr || field->type != ESJsonValueType::String) {
+        return false;
+    }
+
+    if (!field->valueEscaped) {
+        out = field->raw;
+        return true;
+    }
+
+    if (scratch == nullptr || !Unescape(field->raw, *scratch)) {
+        return false;
+    }
+    out = *scratch;
+    return true;
+}
+
+bool ESJsonLineScanner::GetInt(std::string_view key, int64_t& out) const
+{
+    const ESJsonField* field = Find(key);
+    if (field == nullptr || field->type != ESJsonValueType::Number) {
+        return false;
+    }
+
+    std::string_view text = field->raw;
+    bool negative = false;
+    if (!text.empty() && (text.front() == '-' || text.front() == '+')) {
+        negative = text.front() == '-';
+        text.remove_prefix(1);
+    }
+
+    uint64_t value = 0;
+    size_t digits = 0;
+    const uint64_t limit = negative
+        ? static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) + 1
+        : static_cast<uint64_t>(std::numeric_limits<int64_t>::max());
+
+    while (digits < text.size() && text[digits] >= '0' && text[digits] <= '9') {
+        const uint64_t d = static_cast<uint64_t>(text[digits] - '0');
+        if (value > (limit - d) / 10) {
+            return false;
+        }
+        value = value * 10 + d;
+        ++digits;
+    }
+
+    if (digits == 0) {
+        return false;
+    }
+
+    // 允许 "5.0" 这类整数值，其他小数和指数不接受
+    text.remove_prefix(digits);
+    if (!text.empty()) {
+        if (text.front() != '.' || text.size() == 1) {
+            return false;
+        }
+        for (size_t i = 1; i < text.size(); ++i) {
+            if (text[i] != '0') {
+                return false;
+            }
+        }
+    }
+
+    out = negative ? static_cast<int64_t>(0 - value) : static_cast<int64_t>(value);
+    return true;
+}
+
+bool ESJsonLineScanner::Unescape(std::string_view raw, std::string& out)
+{
+    out.clear();
+    out.reserve(raw.size());
+
+    size_t pos = 0;
+    char buf[4];
+    size_t n = 0;
+    while (pos < raw.size()) {
+        if (!DecodeNext(raw, pos, buf, n)) {
+            return false;
+        }
+        out.append(buf, n);
+    }
+    return true;
+}
+
+void ESJsonLineSplitter::ConsumePending()
+{
+    if (m_consumePending == 0) {
+        return;
+    }
+
+    m_begin += m_consumePending;
+    m_consumePending = 0;
+}
+
+void ESJsonLineSplitter::Append(const char* data, size_t size)
+{
+    ConsumePending();
+
+    // 已消费的前缀超过一半时整理，复用原有容量
+    if (m_begin > 0 && m_begin >= m_buffer.size() / 2) {
+        m_buffer.erase(0, m_begin);
+        m_scanPos -= m_begin;
+        m_begin = 0;
+    }
+
+    if (data != nullptr && size > 0) {
+        m_buffer.append(data, size);
+    }
+}
+
+bool ESJsonLineSplitter::Next(std::string_view& line)
+{
+    ConsumePending();
+
+    while (m_scanPos < m_buffer.size()) {
+        const char c = m_buffer[m_scanPos++];
+
+        if (m_inString) {
+            if (m_escape) {
+                m_escape = false;
+            } else if (c == '\\') {
+                m_escape = true;
+            } else if (c == '"') {
+                m_inString = false;
+            } else if (c == '\n') {
+                // 字符串里不会有裸换行，按行尾处理以便重新同步
+                m_inString = false;
+                m_depth = 0;
+            }
+            if (m_inString || c != '\n') {
+                continue;
+            }
+        } else if (c == '"') {
+            m_inString = true;
+            continue;
+        } else if (c == '{' || c == '[') {
+            ++m_depth;
+            continue;
+        } else if (c == '}' || c == ']') {
+            // 顶层对象闭合即为一条消息，不依赖发送端补换行
+            if (m_depth > 0 && --m_depth == 0) {
+                if (EmitLine(line)) {
+                    return true;
+                }
+            }
+            continue;
+        } else if (c != '\n' || m_depth > 0) {
+            // 格式化输出的多行 JSON 在括号内换行，继续累积
+            continue;
+        }
+
+        if (EmitLine(line)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool ESJsonLineSplitter::EmitLine(std::string_view& line)
+{
+    const size_t size = m_scanPos - m_begin;
+    line = Trim(std::string_view(m_buffer.data() + m_begin, size));
+    m_consumePending = size;
+    m_depth = 0;
+
+    if (line.empty()) {
+        // 对象之后残留的 "\r\n"、空行直接丢弃
+        ConsumePending();
+        return false;
+    }
+    return true;
+}
+
+bool ESJsonLineSplitter::IsOverflowed() const
+{
+    return m_scanPos - m_begin > kMaxLineBytes;
+}
+
+size_t ESJsonLineSplitter::GetBufferedSize() const
+{
+    return m_buffer.size() - m_begin - m_consumePending;
+}
+
+std::string_view ESJsonLineSplitter::GetBuffered() const
+{
+    return std::string_view(m_buffer).substr(m_begin + m_consumePending);
+}
+
+void ESJsonLineSplitter::Reset()
+{
+    m_buffer.clear();
+    m_begin = 0;
+    m_scanPos = 0;
+    m_consumePending = 0;
+    m_depth = 0;
+    m_inString = false;
+    m_escape = false;
+}
+
+bool ParseEshareJsonMessage(const ESJsonLineScanner& scanner, ESEshareJsonMessage& msg,
+                            std::string* scratch, bool requireClientType)
+{
+    msg = ESEshareJsonMessage{};
+
+    // 第一条是 client-info，后续是 heartbeat
+    if (scanner.Has("clientName") && (!requireClientType || scanner.Has("clientType"))) {
+        if (!scanner.GetString("clientName", msg.clientName, scratch)) {
+            return false;
+        }
+        scanner.GetString("clientType", msg.clientType);
+        msg.kind = ESEshareJsonKind::ClientInfo;
+        return true;
+    }
+
+    if (scanner.Has("heartbeat")) {
+        if (!scanner.GetInt("heartbeat", msg.heartbeat)) {
+            return false;
+        }
+        scanner.GetInt("sendUs", msg.timing.sendUs);
+        scanner.GetInt("echoUs", msg.timing.echoUs);
+        scanner.GetInt("echoRecvUs", msg.timing.echoRecvUs);
+        msg.kind = ESEshareJsonKind::Heartbeat;
+        return true;
+    }
+
+    return false;
+}
+
+bool ParseEshareCommandRequest(std::string_view text, ESEshareCommandRequest& request, bool ignoreCase)
+{
+    request = ESEshareCommandRequest{};
+
+    std::string_view* const slots[3] = { &request.commandText, &request.senderName, &request.senderVersion };
+    size_t count = 0;
+    size_t lineBegin = 0;
+
+    while (lineBegin < text.size() && count < 3) {
+        size_t lineEnd = text.find('\n', lineBegin);
+        if (lineEnd == std::string_view::npos) {
+            lineEnd = text.size();
+        }
+
+        const std::string_view line = Trim(text.substr(lineBegin, lineEnd - lineBegin));
+        if (!line.empty()) {
+            *slots[count++] = line;
+        }
+        lineBegin = lineEnd + 1;
+    }
+
+    if (count < 3) {
+        return false;
+    }
+
+    auto matches = [&](std::string_view name) {
+        return ignoreCase ? IEquals(request.commandText, name) : request.commandText == name;
+    };
+
+    if (matches("getServerInfo")) {
+        request.command = ESEshareCommand::GetServerInfo;
+    } else if (matches("dongleConnected")) {
+        request.command = ESEshareCommand::DongleConnected;
+    }
+    return true;
+}
+
+} // namespace hhcast
\ No newline at end of file
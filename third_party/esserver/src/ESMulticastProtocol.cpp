@@ -0,0 +1,122 @@
+#include "ESMulticastProtocol.h"
+
+namespace hhcast {
+
+namespace {
+
+static void WriteBe16(uint8_t* p, uint16_t v)
+{
+    p[0] = static_cast<uint8_t>(v >> 8);
+    p[1] = static_cast<uint8_t>(v);
+}
+
+static void WriteBe32(uint8_t* p, uint32_t v)
+{
+    p[0] = static_cast<uint8_t>(v >> 24);
+    p[1] = static_cast<uint8_t>(v >> 16);
+    p[2] = static_cast<uint8_t>(v >> 8);
+    p[3] = static_cast<uint8_t>(v);
+}
+
+static uint16_t ReadBe16(const uint8_t* p)
+{
+    return (static_cast<uint16_t>(p[0]) << 8) |
+           (static_cast<uint16_t>(p[1]));
+}
+
+static uint32_t ReadBe32(const uint8_t* p)
+{
+    return (static_cast<uint32_t>(p[0]) << 24) |
+           (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8)  |
+           (static_cast<uint32_t>(p[3]));
+}
+
+} // namespace
+
+void WriteMulticastHeader(const ESMulticastHeader& header, uint8_t* out)
+{
+    WriteBe32(out + 0, kEsMulticastMagic);
+    out[4] = kEsMulticastVersion;
+    out[5] = static_cast<uint8_t>(header.packetType);
+    out[6] = header.fecScheme;
+    out[7] = header.epoch;
+    WriteBe32(out + 8, header.streamId);
+    WriteBe32(out + 12, header.seq);
+    WriteBe32(out + 16, header.groupId);
+    out[20] = header.shardIndex;
+    out[21] = header.dataShards;
+    out[22] = header.parityShards;
+    out[23] = 0;
+    WriteBe16(out + 24, header.shardSize);
+    WriteBe16(out + 26, 0);
+}
+
+bool ReadMulticastHeader(const uint8_t* data, size_t size, ESMulticastHeader& header)
+{
+    if (data == nullptr || size < kEsMulticastHeaderSize) {
+        return false;
+    }
+
+    if (ReadBe32(data) != kEsMulticastMagic || data[4] != kEsMulticastVersion) {
+        return false;
+    }
+
+    if (data[5] != static_cast<uint8_t>(ESMulticastPacketType::Data) &&
+        data[5] != static_cast<uint8_t>(ESMulticastPacketType::Parity)) {
+        return false;
+    }
+
+    header.packetType = static_cast<ESMulticastPacketType>(data[5]);
+    header.fecScheme = data[6];
+    header.epoch = data[7];
+    header.streamId = ReadBe32(data + 8);
+    header.seq = ReadBe32(data + 12);
+    header.groupId = ReadBe32(data + 16);
+    header.shardIndex = data[20];
+    header.dataShards = data[21];
+    header.parityShards = data[22];
+    header.shardSize = ReadBe16(data + 24);
+    return true;
+}
+
+void WriteMulticastShardHeader(const ESMulticastShardHeader& header, uint8_t* out)
+{
+    out[0] = static_cast<uint8_t>(header.mediaType);
+    out[1] = 0;
+    WriteBe16(out + 2, header.fragLen);
+    WriteBe32(out + 4, header.unitId);
+    WriteBe16(out + 8, header.fragIndex);
+    WriteBe16(out + 10, header.fragCount);
+    WriteBe32(out + 12, header.unitSize);
+    WriteBe32(out + 16, header.fragOffset);
+}
+
+bool ReadMulticastShardHeader(const uint8_t* data, size_t size, ESMulticastShardHeader& header)
+{
+    if (data == nullptr || size < kEsMulticastShardHeaderSize) {
+        return false;
+    }
+
+    if (data[0] != static_cast<uint8_t>(ESMulticastMediaType::Video) &&
+        data[0] != static_cast<uint8_t>(ESMulticastMediaType::Audio)) {
+        return false;
+    }
+
+    header.mediaType = static_cast<ESMulticastMediaType>(data[0]);
+    header.fragLen = ReadBe16(data + 2);
+    header.unitId = ReadBe32(data + 4);
+    header.fragIndex = ReadBe16(data + 8);
+    header.fragCount = ReadBe16(data + 10);
+    header.unitSize = ReadBe32(data + 12);
+    header.fragOffset = ReadBe32(data + 16);
+
+    if (header.fragCount == 0 || header.fragIndex >= header.fragCount ||
+        static_cast<uint64_t>(header.fragOffset) + header.fragLen > header.unitSize) {
+        return false;
+    }
+
+    return size >= kEsMulticastShardHeaderSize + header.fragLen;
+}
+
+} // namespace hhcast
\ No newline at end of file
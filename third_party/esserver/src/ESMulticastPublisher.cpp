@@ -0,0 +1,470 @@
+#include "ESMulticastPublisher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace hhcast {
+
+namespace {
+
+constexpr size_t kEsVideoHeaderSize = 128;
+constexpr size_t kRtpFixedHeaderSize = 12;
+
+static void CloseSocket(intptr_t fd)
+{
+    if (fd < 0) {
+        return;
+    }
+#ifdef _WIN32
+    closesocket(static_cast<SOCKET>(fd));
+#else
+    close(static_cast<int>(fd));
+#endif
+}
+
+static void WriteLe32(uint8_t* p, uint32_t v)
+{
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+    p[2] = static_cast<uint8_t>(v >> 16);
+    p[3] = static_cast<uint8_t>(v >> 24);
+}
+
+static void WriteLe64(uint8_t* p, uint64_t v)
+{
+    for (int i = 0; i < 8; ++i) {
+        p[i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+}
+
+static void WriteBe16(uint8_t* p, uint16_t v)
+{
+    p[0] = static_cast<uint8_t>(v >> 8);
+    p[1] = static_cast<uint8_t>(v);
+}
+
+static void WriteBe32(uint8_t* p, uint32_t v)
+{
+    p[0] = static_cast<uint8_t>(v >> 24);
+    p[1] = static_cast<uint8_t>(v >> 16);
+    p[2] = static_cast<uint8_t>(v >> 8);
+    p[3] = static_cast<uint8_t>(v);
+}
+
+// unit 由 head + payload 两段组成，这里按偏移拷贝，避免先拼成一整块
+static void CopyUnitRange(const uint8_t* head, size_t headSize,
+                          const uint8_t* payload, size_t payloadSize,
+                          size_t offset, size_t len, uint8_t* out)
+{
+    (void)payloadSize;
+
+    if (offset < headSize) {
+        const size_t n = (std::min)(len, headSize - offset);
+        std::memcpy(out, head + offset, n);
+        out += n;
+        len -= n;
+        offset = headSize;
+    }
+
+    if (len > 0) {
+        std::memcpy(out, payload + (offset - headSize), len);
+    }
+}
+
+} // namespace
+
+struct ESMulticastPublisher::OutgoingDatagrams {
+    std::vector<uint8_t> bytes;
+    std::vector<size_t> ends;       // 每个 datagram 在 bytes 中的结束偏移
+    std::vector<uint8_t> parity;    // 对应 datagram 是否为校验包
+
+    void Clear()
+    {
+        bytes.clear();
+        ends.clear();
+        parity.clear();
+    }
+
+    void Add(const uint8_t* data, size_t size, bool isParity)
+    {
+        bytes.insert(bytes.end(), data, data + size);
+        ends.push_back(bytes.size());
+        parity.push_back(isParity ? 1 : 0);
+    }
+};
+
+ESMulticastPublisher::SendTarget::~SendTarget()
+{
+    CloseSocket(socket);
+}
+
+ESMulticastPublisher::OutgoingDatagrams& ESMulticastPublisher::GetOutgoing()
+{
+    thread_local OutgoingDatagrams out;
+    out.Clear();
+    return out;
+}
+
+ESMulticastPublisher::ESMulticastPublisher() = default;
+
+ESMulticastPublisher::~ESMulticastPublisher()
+{
+    Stop();
+}
+
+int ESMulticastPublisher::Start(const ESMulticastConfig& config)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_running.load()) {
+        return 0;
+    }
+
+    if (config.maxDatagramSize <= kEsMulticastHeaderSize + kEsMulticastShardHeaderSize ||
+        config.maxDatagramSize > 65000) {
+        std::cout << "[ESMulticastPublisher] invalid maxDatagramSize="
+                  << config.maxDatagramSize << std::endl;
+        return -1;
+    }
+
+    if (!m_fec.Configure(config.fecScheme, config.fecDataShards, config.fecParityShards)) {
+        std::cout << "[ESMulticastPublisher] invalid fec config, data="
+                  << static_cast<int>(config.fecDataShards)
+                  << ", parity=" << static_cast<int>(config.fecParityShards) << std::endl;
+        return -2;
+    }
+
+    sockaddr_in groupAddr;
+    std::memset(&groupAddr, 0, sizeof(groupAddr));
+    groupAddr.sin_family = AF_INET;
+    groupAddr.sin_port = htons(config.port);
+    if (inet_pton(AF_INET, config.group.c_str(), &groupAddr.sin_addr) != 1) {
+        std::cout << "[ESMulticastPublisher] invalid group: " << config.group << std::endl;
+        return -3;
+    }
+
+    const intptr_t fd = static_cast<intptr_t>(socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP));
+    if (fd < 0) {
+        std::cout << "[ESMulticastPublisher] create socket failed" << std::endl;
+        return -4;
+    }
+
+    const unsigned char ttl = static_cast<unsigned char>(config.ttl);
+    const unsigned char loop = config.loopback ? 1 : 0;
+    setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL,
+               reinterpret_cast<const char*>(&ttl), sizeof(ttl));
+    setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP,
+               reinterpret_cast<const char*>(&loop), sizeof(loop));
+
+    in_addr ifaceAddr;
+    if (inet_pton(AF_INET, config.interfaceIp.c_str(), &ifaceAddr) == 1 &&
+        ifaceAddr.s_addr != htonl(INADDR_ANY)) {
+        setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF,
+                   reinterpret_cast<const char*>(&ifaceAddr), sizeof(ifaceAddr));
+    }
+
+    auto target = std::make_shared<SendTarget>();
+    target->socket = fd;
+    target->groupAddr.assign(reinterpret_cast<const uint8_t*>(&groupAddr),
+                             reinterpret_cast<const uint8_t*>(&groupAddr) + sizeof(groupAddr));
+
+    m_config = config;
+    m_target = std::move(target);
+    // 进程重启后 epoch 也要和上一轮不同
+    m_nextEpoch = static_cast<uint8_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+
+    m_sendBuffer.assign(config.maxDatagramSize, 0);
+    m_parityBuffers.assign(m_fec.GetParityShards(),
+                           std::vector<uint8_t>(config.maxDatagramSize - kEsMulticastHeaderSize, 0));
+    m_streams.clear();
+
+    m_running = true;
+
+    std::cout << "[ESMulticastPublisher] started, group=" << config.group
+              << ":" << config.port
+              << ", fec=" << static_cast<int>(config.fecScheme)
+              << " (" << static_cast<int>(m_fec.GetDataShards())
+              << "+" << static_cast<int>(m_fec.GetParityShards()) << ")" << std::endl;
+    return 0;
+}
+
+void ESMulticastPublisher::Stop()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!m_running.load()) {
+        return;
+    }
+
+    m_target.reset();
+    m_streams.clear();
+    m_running = false;
+
+    std::cout << "[ESMulticastPublisher] stopped, data=" << m_dataPacketCount.load()
+              << ", parity=" << m_parityPacketCount.load() << std::endl;
+}
+
+bool ESMulticastPublisher::IsRunning() const
+{
+    return m_running.load();
+}
+
+void ESMulticastPublisher::PublishVideoUnit(uint32_t streamId, const ESVideoUnit& unit)
+{
+    if (!m_running.load() || unit.payload == nullptr || unit.payloadSize == 0) {
+        return;
+    }
+
+    uint8_t head[kEsVideoHeaderSize];
+    std::memset(head, 0, sizeof(head));
+    WriteLe32(head + 0x00, static_cast<uint32_t>(unit.payloadSize));
+    WriteLe32(head + 0x04, unit.rawKind);
+    WriteLe64(head + 0x08, unit.timestamp32_32);
+
+    PublishUnit(streamId, ESMulticastMediaType::Video,
+                head, sizeof(head), unit.payload, unit.payloadSize);
+}
+
+void ESMulticastPublisher::PublishAudioPacket(uint32_t streamId, const ESAudioPayloadInfo& info)
+{
+    if (!m_running.load() || info.payload == nullptr || info.payloadSize == 0) {
+        return;
+    }
+
+    uint8_t head[kRtpFixedHeaderSize];
+    head[0] = 0x80;
+    head[1] = info.payloadType & 0x7F;
+    WriteBe16(head + 2, info.sequence);
+    WriteBe32(head + 4, info.timestamp);
+    WriteBe32(head + 8, info.ssrc);
+
+    PublishUnit(streamId, ESMulticastMediaType::Audio,
+                head, sizeof(head), info.payload, info.payloadSize);
+}
+
+void ESMulticastPublisher::RemoveStream(uint32_t streamId)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_streams.erase(streamId);
+}
+
+uint64_t ESMulticastPublisher::GetDataPacketCount() const
+{
+    return m_dataPacketCount.load();
+}
+
+uint64_t ESMulticastPublisher::GetParityPacketCount() const
+{
+    return m_parityPacketCount.load();
+}
+
+uint64_t ESMulticastPublisher::GetSendErrorCount() const
+{
+    return m_sendErrorCount.load();
+}
+
+void ESMulticastPublisher::PublishUnit(uint32_t streamId,
+                                       ESMulticastMediaType mediaType,
+                                       const uint8_t* head,
+                                       size_t headSize,
+                                       const uint8_t* payload,
+                                       size_t payloadSize)
+{
+    OutgoingDatagrams& out = GetOutgoing();
+    std::shared_ptr<SendTarget> target;
+
+    // 锁内只分配 seq/unitId、组包和算校验，sendto 放到锁外，一路流发送慢不会挡住其他 loop
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_target) {
+            return;
+        }
+
+        target = m_target;
+        PublishUnitLocked(out, streamId, mediaType, head, headSize, payload, payloadSize);
+    }
+
+    SendOutgoing(*target, out);
+}
+
+void ESMulticastPublisher::PublishUnitLocked(OutgoingDatagrams& out,
+                                             uint32_t streamId,
+                                             ESMulticastMediaType mediaType,
+                                             const uint8_t* head,
+                                             size_t headSize,
+                                             const uint8_t* payload,
+                                             size_t payloadSize)
+{
+    const size_t unitSize = headSize + payloadSize;
+    if (unitSize > m_config.maxUnitSize) {
+        ++m_sendErrorCount;
+        return;
+    }
+
+    const size_t maxFragLen =
+        m_config.maxDatagramSize - kEsMulticastHeaderSize - kEsMulticastShardHeaderSize;
+    const size_t fragCount = (unitSize + maxFragLen - 1) / maxFragLen;
+    if (fragCount > 0xFFFF) {
+        ++m_sendErrorCount;
+        return;
+    }
+
+    auto it = m_streams.find(streamId);
+    if (it == m_streams.end()) {
+        it = m_streams.emplace(streamId, StreamState()).first;
+        it->second.epoch = m_nextEpoch++;
+    }
+
+    StreamState& stream = it->second;
+    const uint32_t unitId = stream.nextUnitId++;
+
+    for (size_t fragIndex = 0; fragIndex < fragCount; ++fragIndex) {
+        const size_t offset = fragIndex * maxFragLen;
+        const size_t fragLen = (std::min)(maxFragLen, unitSize - offset);
+
+        ESMulticastShardHeader shard;
+        shard.mediaType = mediaType;
+        shard.fragLen = static_cast<uint16_t>(fragLen);
+        shard.unitId = unitId;
+        shard.fragIndex = static_cast<uint16_t>(fragIndex);
+        shard.fragCount = static_cast<uint16_t>(fragCount);
+        shard.unitSize = static_cast<uint32_t>(unitSize);
+        shard.fragOffset = static_cast<uint32_t>(offset);
+
+        uint8_t* body = m_sendBuffer.data() + kEsMulticastHeaderSize;
+        WriteMulticastShardHeader(shard, body);
+        CopyUnitRange(head, headSize, payload, payloadSize,
+                      offset, fragLen, body + kEsMulticastShardHeaderSize);
+
+        SendDataShardLocked(out, streamId, stream, kEsMulticastShardHeaderSize + fragLen);
+    }
+}
+
+void ESMulticastPublisher::SendDataShardLocked(OutgoingDatagrams& out,
+                                               uint32_t streamId,
+                                               StreamState& stream,
+                                               size_t shardBodySize)
+{
+    const bool useFec = m_fec.GetScheme() != ESFecScheme::None;
+    const size_t dataShards = useFec ? m_fec.GetDataShards() : 1;
+
+    const uint32_t seq = stream.nextSeq++;
+    const uint32_t groupId = static_cast<uint32_t>(seq / dataShards);
+
+    ESMulticastHeader header;
+    header.packetType = ESMulticastPacketType::Data;
+    header.fecScheme = static_cast<uint8_t>(m_fec.GetScheme());
+    header.epoch = stream.epoch;
+    header.streamId = streamId;
+    header.seq = seq;
+    header.groupId = groupId;
+    header.shardIndex = static_cast<uint8_t>(seq % dataShards);
+    header.dataShards = useFec ? m_fec.GetDataShards() : 0;
+    header.parityShards = m_fec.GetParityShards();
+    header.shardSize = static_cast<uint16_t>(shardBodySize);
+    WriteMulticastHeader(header, m_sendBuffer.data());
+
+    out.Add(m_sendBuffer.data(), kEsMulticastHeaderSize + shardBodySize, false);
+
+    if (!useFec) {
+        return;
+    }
+
+    const size_t shardCapacity = m_config.maxDatagramSize - kEsMulticastHeaderSize;
+    if (stream.groupShards.size() != dataShards) {
+        stream.groupShards.assign(dataShards, std::vector<uint8_t>(shardCapacity, 0));
+    }
+
+    std::vector<uint8_t>& slot = stream.groupShards[stream.groupFill];
+    std::memcpy(slot.data(), m_sendBuffer.data() + kEsMulticastHeaderSize, shardBodySize);
+    std::memset(slot.data() + shardBodySize, 0, shardCapacity - shardBodySize);
+
+    stream.groupShardSize = (std::max)(stream.groupShardSize, shardBodySize);
+    ++stream.groupFill;
+
+    if (stream.groupFill == dataShards) {
+        SendParityLocked(out, streamId, stream, groupId);
+        stream.groupFill = 0;
+        stream.groupShardSize = 0;
+    }
+}
+
+void ESMulticastPublisher::SendParityLocked(OutgoingDatagrams& out,
+                                            uint32_t streamId,
+                                            StreamState& stream,
+                                            uint32_t groupId)
+{
+    const size_t dataShards = m_fec.GetDataShards();
+    const size_t parityShards = m_fec.GetParityShards();
+    const size_t shardSize = stream.groupShardSize;
+
+    const uint8_t* data[ESFecCodec::kMaxShards];
+    uint8_t* parity[ESFecCodec::kMaxShards];
+    for (size_t i = 0; i < dataShards; ++i) {
+        data[i] = stream.groupShards[i].data();
+    }
+    for (size_t j = 0; j < parityShards; ++j) {
+        parity[j] = m_parityBuffers[j].data();
+    }
+
+    if (!m_fec.Encode(data, shardSize, parity)) {
+        ++m_sendErrorCount;
+        return;
+    }
+
+    for (size_t j = 0; j < parityShards; ++j) {
+        ESMulticastHeader header;
+        header.packetType = ESMulticastPacketType::Parity;
+        header.fecScheme = static_cast<uint8_t>(m_fec.GetScheme());
+        header.epoch = stream.epoch;
+        header.streamId = streamId;
+        header.seq = static_cast<uint32_t>(groupId * dataShards);
+        header.groupId = groupId;
+        header.shardIndex = static_cast<uint8_t>(dataShards + j);
+        header.dataShards = static_cast<uint8_t>(dataShards);
+        header.parityShards = static_cast<uint8_t>(parityShards);
+        header.shardSize = static_cast<uint16_t>(shardSize);
+
+        WriteMulticastHeader(header, m_sendBuffer.data());
+        std::memcpy(m_sendBuffer.data() + kEsMulticastHeaderSize, parity[j], shardSize);
+
+        out.Add(m_sendBuffer.data(), kEsMulticastHeaderSize + shardSize, true);
+    }
+}
+
+void ESMulticastPublisher::SendOutgoing(const SendTarget& target, const OutgoingDatagrams& out)
+{
+    size_t begin = 0;
+    for (size_t i = 0; i < out.ends.size(); ++i) {
+        const size_t size = out.ends[i] - begin;
+        const auto sent = sendto(target.socket,
+                                 reinterpret_cast<const char*>(out.bytes.data() + begin),
+                                 static_cast<int>(size),
+                                 0,
+                                 reinterpret_cast<const sockaddr*>(target.groupAddr.data()),
+                                 static_cast<socklen_t>(target.groupAddr.size()));
+        begin = out.ends[i];
+
+        if (sent < 0 || static_cast<size_t>(sent) != size) {
+            ++m_sendErrorCount;
+        } else if (out.parity[i]) {
+            ++m_parityPacketCount;
+        } else {
+            ++m_dataPacketCount;
+        }
+    }
+}
+
+} // namespace hhcast
\ No newline at end of file
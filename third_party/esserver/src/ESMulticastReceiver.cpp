@@ -0,0 +1,497 @@
+#include "ESMulticastReceiver.h"
+
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+namespace hhcast {
+
+namespace {
+
+constexpr size_t kMaxPendingUnits = 64;   // 乱序/等待恢复的 unit 上限，超过后跳过缺口
+constexpr size_t kMaxGroups = 32;         // 每路流保留的 FEC 组数
+// unitId / groupId 回退超过该距离（远大于等待窗口）视为发送端重新开始计数，而不是迟到的旧包
+constexpr uint32_t kResyncDistance = 1024;
+constexpr size_t kRecvBufferSize = 65536;
+
+static void CloseSocket(intptr_t fd)
+{
+    if (fd < 0) {
+        return;
+    }
+#ifdef _WIN32
+    closesocket(static_cast<SOCKET>(fd));
+#else
+    close(static_cast<int>(fd));
+#endif
+}
+
+} // namespace
+
+ESMulticastReceiver::ESMulticastReceiver() = default;
+
+ESMulticastReceiver::~ESMulticastReceiver()
+{
+    Stop();
+}
+
+void ESMulticastReceiver::SetVideoCallback(ESSessionVideoCallback callback)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_videoCallback = std::move(callback);
+}
+
+void ESMulticastReceiver::SetAudioCallback(ESSessionAudioCallback callback)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_audioCallback = std::move(callback);
+}
+
+int ESMulticastReceiver::Start(const ESMulticastConfig& config)
+{
+    if (m_running.load()) {
+        return 0;
+    }
+
+    const intptr_t fd = static_cast<intptr_t>(socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP));
+    if (fd < 0) {
+        std::cout << "[ESMulticastReceiver] create socket failed" << std::endl;
+        return -1;
+    }
+
+    const int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR,
+               reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+    sockaddr_in bindAddr;
+    std::memset(&bindAddr, 0, sizeof(bindAddr));
+    bindAddr.sin_family = AF_INET;
+    bindAddr.sin_port = htons(config.port);
+    bindAddr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(fd, reinterpret_cast<const sockaddr*>(&bindAddr), sizeof(bindAddr)) != 0) {
+        std::cout << "[ESMulticastReceiver] bind " << config.port << " failed" << std::endl;
+        CloseSocket(fd);
+        return -2;
+    }
+
+    ip_mreq mreq;
+    std::memset(&mreq, 0, sizeof(mreq));
+    if (inet_pton(AF_INET, config.group.c_str(), &mreq.imr_multiaddr) != 1 ||
+        inet_pton(AF_INET, config.interfaceIp.c_str(), &mreq.imr_interface) != 1) {
+        std::cout << "[ESMulticastReceiver] invalid group/interface: "
+                  << config.group << "/" << config.interfaceIp << std::endl;
+        CloseSocket(fd);
+        return -3;
+    }
+
+    if (setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP,
+                   reinterpret_cast<const char*>(&mreq), sizeof(mreq)) != 0) {
+        std::cout << "[ESMulticastReceiver] join group " << config.group << " failed" << std::endl;
+        CloseSocket(fd);
+        return -4;
+    }
+
+    // 收包线程靠超时轮询 m_running 退出
+#ifdef _WIN32
+    const DWORD timeoutMs = 200;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO,
+               reinterpret_cast<const char*>(&timeoutMs), sizeof(timeoutMs));
+#else
+    timeval tv;
+    tv.tv_sec = 0;
+    tv.tv_usec = 200 * 1000;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+#endif
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_maxUnitSize = config.maxUnitSize;
+    }
+
+    m_socket = fd;
+    m_running = true;
+    m_thread = std::thread(&ESMulticastReceiver::RecvLoop, this);
+
+    std::cout << "[ESMulticastReceiver] joined " << config.group << ":" << config.port << std::endl;
+    return 0;
+}
+
+void ESMulticastReceiver::Stop()
+{
+    if (!m_running.exchange(false)) {
+        return;
+    }
+
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    CloseSocket(m_socket);
+    m_socket = -1;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_streams.clear();
+
+    std::cout << "[ESMulticastReceiver] stopped, packets=" << m_packetCount.load()
+              << ", recovered=" << m_recoveredShardCount.load()
+              << ", delivered=" << m_deliveredUnitCount.load()
+              << ", lost=" << m_lostUnitCount.load()
+              << ", resync=" << m_resyncCount.load() << std::endl;
+}
+
+bool ESMulticastReceiver::IsRunning() const
+{
+    return m_running.load();
+}
+
+uint64_t ESMulticastReceiver::GetPacketCount() const
+{
+    return m_packetCount.load();
+}
+
+uint64_t ESMulticastReceiver::GetRecoveredShardCount() const
+{
+    return m_recoveredShardCount.load();
+}
+
+uint64_t ESMulticastReceiver::GetDeliveredUnitCount() const
+{
+    return m_deliveredUnitCount.load();
+}
+
+uint64_t ESMulticastReceiver::GetLostUnitCount() const
+{
+    return m_lostUnitCount.load();
+}
+
+uint64_t ESMulticastReceiver::GetResyncCount() const
+{
+    return m_resyncCount.load();
+}
+
+void ESMulticastReceiver::RecvLoop()
+{
+    std::vector<uint8_t> buffer(kRecvBufferSize);
+
+    while (m_running.load()) {
+        const auto n = recv(m_socket, reinterpret_cast<char*>(buffer.data()),
+                            static_cast<int>(buffer.size()), 0);
+        if (n <= 0) {
+            continue;
+        }
+
+        InputDatagram(buffer.data(), static_cast<size_t>(n));
+    }
+}
+
+bool ESMulticastReceiver::InputDatagram(const uint8_t* data, size_t size)
+{
+    ESMulticastHeader header;
+    if (!ReadMulticastHeader(data, size, header)) {
+        return false;
+    }
+
+    ++m_packetCount;
+
+    const uint8_t* body = data + kEsMulticastHeaderSize;
+    const size_t bodySize = size - kEsMulticastHeaderSize;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    StreamState& stream = GetStreamLocked(header.streamId);
+
+    if (!stream.hasEpoch) {
+        stream.hasEpoch = true;
+        stream.epoch = header.epoch;
+    } else if (header.epoch != stream.epoch) {
+        ResyncStreamLocked(stream);
+        stream.hasEpoch = true;
+        stream.epoch = header.epoch;
+    }
+
+    if (header.packetType == ESMulticastPacketType::Parity) {
+        OnParityLocked(stream, header, body, bodySize);
+    } else {
+        OnDataLocked(stream, header, body, bodySize);
+    }
+
+    DeliverReadyUnitsLocked(stream);
+    return true;
+}
+
+ESMulticastReceiver::StreamState& ESMulticastReceiver::GetStreamLocked(uint32_t streamId)
+{
+    auto it = m_streams.find(streamId);
+    if (it != m_streams.end()) {
+        return *it->second;
+    }
+
+    auto stream = std::make_unique<StreamState>();
+
+    stream->video.SetCallback(
+        [this, streamId](const ESVideoUnit& unit) {
+            if (m_videoCallback) {
+                m_videoCallback(streamId, unit.payload, unit.payloadSize, unit);
+            }
+        });
+
+    stream->audio.SetCallback(
+        [this, streamId](const ESAudioPayloadInfo& info) {
+            if (m_audioCallback) {
+                m_audioCallback(streamId, info.payload, info.payloadSize, info);
+            }
+        });
+
+    StreamState& ref = *stream;
+    m_streams[streamId] = std::move(stream);
+    return ref;
+}
+
+void ESMulticastReceiver::ResyncStreamLocked(StreamState& stream)
+{
+    ++m_resyncCount;
+
+    stream.groups.clear();
+    stream.assemblies.clear();
+    stream.pendingBytes = 0;
+    stream.hasNextUnitId = false;
+    stream.nextUnitId = 0;
+
+    stream.video.Reset();
+    stream.audio.Reset();
+}
+
+ESMulticastReceiver::GroupState* ESMulticastReceiver::GetGroupLocked(StreamState& stream,
+                                                                     const ESMulticastHeader& header)
+{
+    if (header.dataShards == 0 || header.parityShards == 0 ||
+        static_cast<size_t>(header.dataShards) + header.parityShards > ESFecCodec::kMaxShards ||
+        header.shardIndex >= header.dataShards + header.parityShards) {
+        return nullptr;
+    }
+
+    auto it = stream.groups.find(header.groupId);
+    if (it == stream.groups.end()) {
+        if (!stream.groups.empty() && header.groupId + kMaxGroups < stream.groups.rbegin()->first) {
+            // 回退太远是发送端重新计数，清掉旧组；否则是过了恢复窗口的旧包
+            if (stream.groups.rbegin()->first - header.groupId <= kResyncDistance) {
+                return nullptr;
+            }
+            stream.groups.clear();
+        }
+
+        GroupState group;
+        group.scheme = static_cast<ESFecScheme>(header.fecScheme);
+        group.dataShards = header.dataShards;
+        group.parityShards = header.parityShards;
+        group.shards.resize(static_cast<size_t>(header.dataShards) + header.parityShards);
+        it = stream.groups.emplace(header.groupId, std::move(group)).first;
+
+        while (stream.groups.size() > kMaxGroups) {
+            stream.groups.erase(stream.groups.begin());
+        }
+    }
+
+    return &it->second;
+}
+
+void ESMulticastReceiver::OnParityLocked(StreamState& stream,
+                                         const ESMulticastHeader& header,
+                                         const uint8_t* body,
+                                         size_t bodySize)
+{
+    if (bodySize < header.shardSize) {
+        return;
+    }
+
+    GroupState* group = GetGroupLocked(stream, header);
+    if (group == nullptr || group->present[header.shardIndex]) {
+        return;
+    }
+
+    group->shardSize = header.shardSize;
+    group->shards[header.shardIndex].assign(body, body + header.shardSize);
+    group->present[header.shardIndex] = true;
+
+    TryRecoverLocked(stream, *group);
+}
+
+void ESMulticastReceiver::OnDataLocked(StreamState& stream,
+                                       const ESMulticastHeader& header,
+                                       const uint8_t* body,
+                                       size_t bodySize)
+{
+    if (header.fecScheme == static_cast<uint8_t>(ESFecScheme::None) || header.dataShards == 0) {
+        ProcessShardLocked(stream, body, bodySize);
+        return;
+    }
+
+    GroupState* group = GetGroupLocked(stream, header);
+    if (group == nullptr) {
+        ProcessShardLocked(stream, body, bodySize);
+        return;
+    }
+
+    if (group->present[header.shardIndex]) {
+        return;   // 重复包
+    }
+
+    group->shards[header.shardIndex].assign(body, body + bodySize);
+    group->present[header.shardIndex] = true;
+    group->processed[header.shardIndex] = true;
+
+    ProcessShardLocked(stream, body, bodySize);
+    TryRecoverLocked(stream, *group);
+}
+
+void ESMulticastReceiver::TryRecoverLocked(StreamState& stream, GroupState& group)
+{
+    if (group.shardSize == 0) {
+        return;   // 还没收到任何校验包
+    }
+
+    size_t missing = 0;
+    size_t parityPresent = 0;
+    for (size_t i = 0; i < group.dataShards; ++i) {
+        if (!group.present[i]) {
+            ++missing;
+        }
+    }
+    for (size_t j = 0; j < group.parityShards; ++j) {
+        if (group.present[group.dataShards + j]) {
+            ++parityPresent;
+        }
+    }
+
+    if (missing == 0 || parityPresent < missing) {
+        return;
+    }
+
+    ESFecCodec codec;
+    if (!codec.Configure(group.scheme, group.dataShards, group.parityShards)) {
+        return;
+    }
+
+    uint8_t* shards[ESFecCodec::kMaxShards];
+    for (size_t i = 0; i < group.shards.size(); ++i) {
+        group.shards[i].resize(group.shardSize, 0);
+        shards[i] = group.shards[i].data();
+    }
+
+    if (!codec.Reconstruct(shards, group.present, group.shardSize)) {
+        return;
+    }
+
+    for (size_t i = 0; i < group.dataShards; ++i) {
+        if (group.processed[i]) {
+            continue;
+        }
+
+        group.processed[i] = true;
+        ++m_recoveredShardCount;
+        ProcessShardLocked(stream, group.shards[i].data(), group.shards[i].size());
+    }
+}
+
+void ESMulticastReceiver::ProcessShardLocked(StreamState& stream, const uint8_t* body, size_t bodySize)
+{
+    ESMulticastShardHeader shard;
+    if (!ReadMulticastShardHeader(body, bodySize, shard)) {
+        return;
+    }
+
+    if (!stream.hasNextUnitId) {
+        stream.hasNextUnitId = true;
+        stream.nextUnitId = shard.unitId;
+    }
+
+    if (shard.unitId < stream.nextUnitId) {
+        if (stream.nextUnitId - shard.unitId <= kResyncDistance) {
+            return;   // 已交付或已放弃
+        }
+
+        // 发送端重连后 unitId 从 0 重新开始（epoch 相同的情况），丢掉旧的未完成 unit 从这里接上。
+        // 这里可能处在某个 FEC 组的恢复过程中，组留给 GetGroupLocked 处理
+        ++m_resyncCount;
+        stream.assemblies.clear();
+        stream.pendingBytes = 0;
+        stream.nextUnitId = shard.unitId;
+    }
+
+    // unitSize 来自网络，先按上限检查再分配
+    if (shard.unitSize == 0 || shard.unitSize > m_maxUnitSize) {
+        return;
+    }
+
+    UnitAssembly& unit = stream.assemblies[shard.unitId];
+    if (unit.received.empty()) {
+        unit.mediaType = shard.mediaType;
+        unit.bytes.resize(shard.unitSize);
+        unit.received.assign(shard.fragCount, false);
+        stream.pendingBytes += shard.unitSize;
+    }
+
+    if (shard.fragCount != unit.received.size() || shard.unitSize != unit.bytes.size() ||
+        unit.received[shard.fragIndex]) {
+        return;
+    }
+
+    std::memcpy(unit.bytes.data() + shard.fragOffset, body + kEsMulticastShardHeaderSize, shard.fragLen);
+    unit.received[shard.fragIndex] = true;
+    ++unit.receivedCount;
+}
+
+void ESMulticastReceiver::DeliverReadyUnitsLocked(StreamState& stream)
+{
+    while (!stream.assemblies.empty()) {
+        auto it = stream.assemblies.begin();
+
+        if (it->first == stream.nextUnitId &&
+            it->second.receivedCount == it->second.received.size()) {
+            DeliverUnitLocked(stream, it->second);
+            stream.pendingBytes -= it->second.bytes.size();
+            stream.assemblies.erase(it);
+            ++stream.nextUnitId;
+            continue;
+        }
+
+        // 等待中的 unit 个数和字节数都有上限，伪造的大 unit 不会一直占着内存
+        if (stream.assemblies.size() <= kMaxPendingUnits &&
+            stream.pendingBytes <= 2 * m_maxUnitSize) {
+            break;
+        }
+
+        // 等待窗口用尽：放弃队首的缺口，继续往后交付
+        if (it->first != stream.nextUnitId) {
+            m_lostUnitCount += it->first - stream.nextUnitId;
+            stream.nextUnitId = it->first;
+        } else {
+            ++m_lostUnitCount;
+            stream.pendingBytes -= it->second.bytes.size();
+            stream.assemblies.erase(it);
+            ++stream.nextUnitId;
+        }
+    }
+}
+
+void ESMulticastReceiver::DeliverUnitLocked(StreamState& stream, const UnitAssembly& unit)
+{
+    ++m_deliveredUnitCount;
+
+    if (unit.mediaType == ESMulticastMediaType::Video) {
+        stream.video.PushBytes(unit.bytes.data(), unit.bytes.size());
+    } else {
+        stream.audio.ParsePacket(unit.bytes.data(), unit.bytes.size());
+    }
+}
+
+} // namespace hhcast
\ No newline at end of file
@@ -1,17 +1,25 @@
 #include "ESPortManager.h"
 
-#include "ESRtspLite.h"
+#include "ESConnectionContext.h"
 #include "ESServer.h"
+#include "ESSocketTuning.h"
+#include "ESUring.h"
+#include "ESUtils.h"
 
 #include <algorithm>
+#include <chrono>
+#include <condition_variable>
 #include <cstring>
 #include <iostream>
 #include <string>
+#include <thread>
+#include <vector>
 
 #ifdef _WIN32
 #include <winsock2.h>
 #else
 #include <arpa/inet.h>
+#include <fcntl.h>
 #include <sys/socket.h>
 #endif
 
@@ -29,6 +37,17 @@ static std::string ExtractPeerIp(const std::string& peerAddr)
     return peerAddr.substr(0, pos);
 }
 
+// hv 的 UDP channel 上对端地址是最近一个 datagram 的来源，直接读 sockaddr，不经字符串
+static uint32_t GetDatagramPeerIp(const hv::SocketChannelPtr& channel)
+{
+    const sockaddr* addr = hio_peeraddr(channel->io());
+    if (addr == nullptr || addr->sa_family != AF_INET) {
+        return 0;
+    }
+
+    return ntohl(reinterpret_cast<const sockaddr_in*>(addr)->sin_addr.s_addr);
+}
+
 static void TrimLeadingCrlf(std::string& text)
 {
     while (!text.empty() && (text[0] == '\r' || text[0] == '\n')) {
@@ -49,6 +68,67 @@ static uint16_t GetLocalPortByFd(int fd)
     return ntohs(addr.sin_port);
 }
 
+static std::string StreamIDToIP(uint32_t peerIp)
+{
+    in_addr addr;
+    addr.s_addr = htonl(peerIp);
+
+    char text[INET_ADDRSTRLEN] = {};
+    inet_ntop(AF_INET, &addr, text, sizeof(text));
+    return text;
+}
+
+constexpr uint32_t kHandoffParkTimeoutMs = 1000;
+
+// 让一组 loop 各自停在一个排队任务里直到 Release，期间可以在 loop 外读写连接状态。
+// 任务持有共享状态，超时返回后迟到的任务也能安全退出
+class LoopParking {
+public:
+    ~LoopParking()
+    {
+        Release();
+    }
+
+    bool Park(const std::vector<hv::EventLoopPtr>& loops, uint32_t timeoutMs)
+    {
+        std::shared_ptr<State> state = m_state;
+        size_t expected = 0;
+        for (const auto& loop : loops) {
+            if (!loop) {
+                continue;
+            }
+            ++expected;
+            loop->queueInLoop([state]() {
+                std::unique_lock<std::mutex> lock(state->mutex);
+                ++state->parked;
+                state->cv.notify_all();
+                state->cv.wait(lock, [&state]() { return state->released; });
+            });
+        }
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+        return state->cv.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                                  [&state, expected]() { return state->parked >= expected; });
+    }
+
+    void Release()
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        m_state->released = true;
+        m_state->cv.notify_all();
+    }
+
+private:
+    struct State {
+        std::mutex mutex;
+        std::condition_variable cv;
+        size_t parked = 0;
+        bool released = false;
+    };
+
+    std::shared_ptr<State> m_state = std::make_shared<State>();
+};
+
 } // namespace
 
 ESPortManager::ESPortManager()
@@ -71,135 +151,52 @@ int ESPortManager::Start()
         return -1;
     }
 
-    int ret = StartTcpServer(8700, m_tcpServer8700);
-    if (ret != 0) return ret;
-
-    ret = StartTcpServer(8121, m_tcpServer8121);
+    int ret = m_loopPool.Start(m_eventLoopConfig.sharedLoops, m_eventLoopConfig.sharedCpus);
     if (ret != 0) {
-        StopTcpServer(m_tcpServer8700);
+        std::cout << "[ESPortManager] start event loops failed, ret=" << ret << std::endl;
         return ret;
     }
 
-    ret = StartTcpServer(57395, m_tcpServer57395);
-    if (ret != 0) {
-        StopTcpServer(m_tcpServer8700);
-        StopTcpServer(m_tcpServer8121);
-        return ret;
-    }
-
-    ret = StartTcpServer(8600, m_tcpServer8600);
-    if (ret != 0) {
-        StopTcpServer(m_tcpServer8700);
-        StopTcpServer(m_tcpServer8121);
-        StopTcpServer(m_tcpServer57395);
-        return ret;
-    }
-
-    ret = StartTcpServer(m_videoPort, m_tcpServer51030);
-    if (ret != 0) {
-        StopTcpServer(m_tcpServer8700);
-        StopTcpServer(m_tcpServer8121);
-        StopTcpServer(m_tcpServer57395);
-        StopTcpServer(m_tcpServer8600);
-        return ret;
-    }
-
-    ret = StartTcpServer(51040, m_tcpServer51040);
-    if (ret != 0) {
-        StopTcpServer(m_tcpServer8700);
-        StopTcpServer(m_tcpServer8121);
-        StopTcpServer(m_tcpServer57395);
-        StopTcpServer(m_tcpServer8600);
-        StopTcpServer(m_tcpServer51030);
-        return ret;
-    }
+    ret = StartTcpServer(8700, m_tcpServer8700);
+    if (ret == 0) ret = StartTcpServer(8121, m_tcpServer8121);
+    if (ret == 0) ret = StartTcpServer(57395, m_tcpServer57395);
+    if (ret == 0) ret = StartTcpServer(8600, m_tcpServer8600);
+    if (ret == 0) ret = StartVideoServers();
+    if (ret == 0) ret = StartTcpServer(51040, m_tcpServer51040);
+    if (ret == 0) ret = StartTcpServer(52020, m_tcpServer52020);
+    if (ret == 0) ret = StartTcpServer(52025, m_tcpServer52025);
+    if (ret == 0) ret = StartTcpServer(52030, m_tcpServer52030);
+    if (ret == 0) ret = StartUdpServer(m_mousePort, m_udpServer51050, m_udpBatch51050, m_mousePort,
+                                       ESHandoffSocketKind::UdpMouse);
+    if (ret == 0) ret = StartUdpServer(0, m_udpServerDataPort, m_udpBatchDataPort, m_dataPort,
+                                       ESHandoffSocketKind::UdpData);
+    if (ret == 0) ret = StartUdpServer(0, m_udpServerControlPort, m_udpBatchControlPort, m_controlPort,
+                                       ESHandoffSocketKind::UdpControl);
 
-    ret = StartTcpServer(52020, m_tcpServer52020);
     if (ret != 0) {
-        StopTcpServer(m_tcpServer8700);
-        StopTcpServer(m_tcpServer8121);
-        StopTcpServer(m_tcpServer57395);
-        StopTcpServer(m_tcpServer8600);
-        StopTcpServer(m_tcpServer51030);
-        StopTcpServer(m_tcpServer51040);
+        m_handoffState = nullptr;
+        StopServers();
+        m_mousePort = 51050;
+        m_dataPort = 0;
+        m_controlPort = 0;
         return ret;
     }
 
-    ret = StartTcpServer(52025, m_tcpServer52025);
-    if (ret != 0) {
-        StopTcpServer(m_tcpServer8700);
-        StopTcpServer(m_tcpServer8121);
-        StopTcpServer(m_tcpServer57395);
-        StopTcpServer(m_tcpServer8600);
-        StopTcpServer(m_tcpServer51030);
-        StopTcpServer(m_tcpServer51040);
-        StopTcpServer(m_tcpServer52020);
-        return ret;
-    }
-
-    ret = StartTcpServer(52030, m_tcpServer52030);
-    if (ret != 0) {
-        StopTcpServer(m_tcpServer8700);
-        StopTcpServer(m_tcpServer8121);
-        StopTcpServer(m_tcpServer57395);
-        StopTcpServer(m_tcpServer8600);
-        StopTcpServer(m_tcpServer51030);
-        StopTcpServer(m_tcpServer51040);
-        StopTcpServer(m_tcpServer52020);
-        StopTcpServer(m_tcpServer52025);
-        return ret;
-    }
-
-    ret = StartUdpServer(m_mousePort, m_udpServer51050, m_mousePort);
-    if (ret != 0) {
-        StopTcpServer(m_tcpServer8700);
-        StopTcpServer(m_tcpServer8121);
-        StopTcpServer(m_tcpServer57395);
-        StopTcpServer(m_tcpServer8600);
-        StopTcpServer(m_tcpServer51030);
-        StopTcpServer(m_tcpServer51040);
-        StopTcpServer(m_tcpServer52020);
-        StopTcpServer(m_tcpServer52025);
-        StopTcpServer(m_tcpServer52030);
-        return ret;
-    }
-
-    ret = StartUdpServer(0, m_udpServerDataPort, m_dataPort);
-    if (ret != 0) {
-        StopTcpServer(m_tcpServer8700);
-        StopTcpServer(m_tcpServer8121);
-        StopTcpServer(m_tcpServer57395);
-        StopTcpServer(m_tcpServer8600);
-        StopTcpServer(m_tcpServer51030);
-        StopTcpServer(m_tcpServer51040);
-        StopTcpServer(m_tcpServer52020);
-        StopTcpServer(m_tcpServer52025);
-        StopTcpServer(m_tcpServer52030);
-        StopUdpServer(m_udpServer51050);
-        return ret;
-    }
+    m_running = true;
 
-    ret = StartUdpServer(0, m_udpServerControlPort, m_controlPort);
-    if (ret != 0) {
-        StopTcpServer(m_tcpServer8700);
-        StopTcpServer(m_tcpServer8121);
-        StopTcpServer(m_tcpServer57395);
-        StopTcpServer(m_tcpServer8600);
-        StopTcpServer(m_tcpServer51030);
-        StopTcpServer(m_tcpServer51040);
-        StopTcpServer(m_tcpServer52020);
-        StopTcpServer(m_tcpServer52025);
-        StopTcpServer(m_tcpServer52030);
-        StopUdpServer(m_udpServer51050);
-        StopUdpServer(m_udpServerDataPort);
-        return ret;
+    // 连接要挂到已经在跑的 loop 上，放在所有端口就绪之后
+    if (m_handoffState) {
+        AdoptConnections(*m_handoffState);
+        m_handoffState = nullptr;
     }
 
-    m_running = true;
-
     std::cout << "[ESPortManager] udp ports ready, mousePort=" << m_mousePort
               << ", dataPort=" << m_dataPort
-              << ", controlPort=" << m_controlPort << std::endl;
+              << ", controlPort=" << m_controlPort
+              << ", sharedLoops=" << m_loopPool.GetLoopCount()
+              << ", videoLoops=" << GetVideoLoopCount()
+              << ", videoShards=" << (m_uringVideo.empty() ? m_tcpServers51030.size() : m_uringVideo.size())
+              << (m_uringVideo.empty() ? "" : " (io_uring)") << std::endl;
 
     return 0;
 }
@@ -210,38 +207,65 @@ int ESPortManager::Stop()
         return 0;
     }
 
-    StopTcpServer(m_tcpServer8700);
-    StopTcpServer(m_tcpServer8121);
-    StopTcpServer(m_tcpServer57395);
-    StopTcpServer(m_tcpServer8600);
-    StopTcpServer(m_tcpServer51030);
-    StopTcpServer(m_tcpServer51040);
-    StopTcpServer(m_tcpServer52020);
-    StopTcpServer(m_tcpServer52025);
-    StopTcpServer(m_tcpServer52030);
-
-    StopUdpServer(m_udpServer51050);
-    StopUdpServer(m_udpServerDataPort);
-    StopUdpServer(m_udpServerControlPort);
+    StopServers();
+    m_admission.Reset();
 
     m_mousePort = 51050;
     m_dataPort = 0;
     m_controlPort = 0;
 
-    m_tcpRecvBuffers8600.clear();
-    m_tcpRecvBuffers51040.clear();
-
     m_running = false;
     std::cout << "[ESPortManager] stopped" << std::endl;
 
     return 0;
 }
 
+std::vector<uint16_t> ESPortManager::GetFixedTcpPorts()
+{
+    // 与 Start 里的顺序一致
+    return { 8700, 8121, 57395, 8600, 51030, 51040, 52020, 52025, 52030 };
+}
+
+uint16_t ESPortManager::GetDefaultMousePort()
+{
+    return 51050;
+}
+
 void ESPortManager::SetServer(ESServer* server)
 {
     m_server = server;
 }
 
+void ESPortManager::SetUdpReceiveConfig(const ESUdpReceiveConfig& config)
+{
+    m_udpReceiveConfig = config;
+}
+
+void ESPortManager::SetVideoReceiveConfig(const ESVideoReceiveConfig& config)
+{
+    m_videoReceiveConfig = config;
+}
+
+void ESPortManager::SetEventLoopConfig(const ESEventLoopConfig& config)
+{
+    m_eventLoopConfig = config;
+}
+
+void ESPortManager::SetSocketConfig(const ESSocketConfig& config)
+{
+    m_socketConfig = config;
+}
+
+void ESPortManager::SetAdmissionConfig(const ESAdmissionConfig& config)
+{
+    m_admission.SetConfig(config);
+}
+
+ESAdmissionStats ESPortManager::GetAdmissionStats() const
+{
+    return m_admission.GetStats();
+}
+
 bool ESPortManager::IsRunning() const
 {
     return m_running.load();
@@ -267,63 +291,397 @@ uint16_t ESPortManager::GetControlPort() const
     return m_controlPort;
 }
 
-int ESPortManager::StartTcpServer(uint16_t localPort, std::unique_ptr<hv::TcpServer>& server)
+int ESPortManager::StartTcpServer(uint16_t localPort, std::unique_ptr<TcpServer>& server)
 {
-    server = std::make_unique<hv::TcpServer>();
-
-    int listenfd = server->createsocket(localPort);
+    server = std::make_unique<TcpServer>(m_loopPool.NextLoop());
+
+    int listenfd = m_handoffState ? m_handoffState->TakeSocket(ESHandoffSocketKind::TcpListener, localPort) : -1;
+    const bool adopted = (listenfd >= 0);
+    if (adopted) {
+        server->listenfd = listenfd;
+        server->port = localPort;
+        server->host = "0.0.0.0";
+    } else {
+        listenfd = server->createsocket(localPort);
+    }
     if (listenfd < 0) {
         std::cout << "[ESPortManager] create tcp " << localPort << " socket failed" << std::endl;
         server.reset();
         return -100 - static_cast<int>(localPort);
     }
 
-    server->onConnection = [this, localPort](const hv::SocketChannelPtr& channel) {
-        std::string peerAddr = channel->peeraddr();
-        std::string peerIp = ExtractPeerIp(peerAddr);
+    SetupTcpServer(localPort, *server);
+
+    // 视频连接分到独立的工作 loop，其余端口的连接直接在监听所在的共享 loop 上处理
+    const bool video = (localPort == m_videoPort);
+    const size_t workerLoops = video ? GetVideoLoopCount() : 0;
+    server->setThreadNum(static_cast<int>(workerLoops));
+    if (video) {
+        m_videoWorkerLoops = workerLoops;
+        server->setLoadBalance(m_eventLoopConfig.videoBalance == ESLoopBalance::RoundRobin
+                                   ? LB_RoundRobin
+                                   : LB_LeastConnections);
+    }
+
+    server->start();
+
+    if (workerLoops > 0) {
+        std::vector<hv::EventLoopPtr> loops;
+        for (size_t i = 0; i < workerLoops; ++i) {
+            loops.push_back(server->loop(static_cast<int>(i)));
+        }
+        ESEventLoopPool::PinLoops(loops, m_eventLoopConfig.videoCpus);
+    }
+
+    std::cout << "[ESPortManager] tcp " << localPort << (adopted ? " adopted" : " listening")
+              << ", fd=" << listenfd
+              << ", workerLoops=" << workerLoops
+              << ", " << DescribeSocketOptions(listenfd, true) << std::endl;
+    return 0;
+}
 
+void ESPortManager::SetupTcpServer(uint16_t localPort, TcpServer& server)
+{
+    const ESSocketOptions options = GetSocketOptions(localPort, true);
+    const std::string tag = "tcp " + std::to_string(localPort);
+
+    // 缓冲区要在握手前设到监听 socket 上，窗口扩大因子才会按它协商；连接会继承
+    ApplySocketOptions(server.listenfd, options, true, tag);
+
+    server.onConnection = [this, localPort, options, tag](const hv::SocketChannelPtr& channel) {
         if (channel->isConnected()) {
+            std::string peerIpText = ExtractPeerIp(channel->peeraddr());
+            const uint32_t peerIp = IPToStreamID(peerIpText);
+
+            // 超出连接数直接关掉，不分配上下文；断开回调里没有上下文即不归还名额
+            if (!m_admission.TryAcquireConnection(peerIp, localPort, GetSteadyTimeUs() / 1000)) {
+                channel->close(true);
+                return;
+            }
+
+            // 不是所有选项都从监听 socket 继承（QUICKACK、BUSY_POLL），连接上再设一遍
+            ApplySocketOptions(channel->fd(), options, true, tag);
+
+            auto context = std::make_shared<ESConnectionContext>();
+            context->localPort = localPort;
+            context->peerIp = peerIp;
+            context->peerIpText = std::move(peerIpText);
+            context->admitted = true;
+            context->limiter = m_admission.MakeTcpLimiter(
+                localPort == m_videoPort ? ESPortClass::Video : ESPortClass::Control);
+            channel->setContextPtr(context);
+
             if (m_server) {
-                m_server->OnTcpConnected(localPort, peerIp);
+                m_server->OnTcpConnected(localPort, context->peerIpText);
             }
         } else {
-            if (localPort == 8600) {
-                m_tcpRecvBuffers8600.erase(peerAddr);
+            // 接收缓冲随上下文和连接一起释放
+            auto context = channel->getContextPtr<ESConnectionContext>();
+            if (!context) {
+                return;
             }
-            if (localPort == 51040) {
-                m_tcpRecvBuffers51040.erase(peerAddr);
+
+            if (context->admitted) {
+                m_admission.ReleaseConnection(context->peerIp);
+                context->admitted = false;
             }
 
             if (m_server) {
-                m_server->OnTcpDisconnected(localPort, peerIp);
+                m_server->OnTcpDisconnected(localPort, context->peerIpText);
             }
         }
     };
 
-    server->onMessage = [this, localPort](const hv::SocketChannelPtr& channel, hv::Buffer* buf) {
+    const bool quickAck = options.tcpQuickAck;
+    server.onMessage = [this, localPort, quickAck](const hv::SocketChannelPtr& channel, hv::Buffer* buf) {
+        if (quickAck) {
+            RearmTcpQuickAck(channel->fd());
+        }
         HandleTcpMessage(localPort, channel, buf);
     };
+}
 
-    server->setThreadNum(1);
-    server->start();
+int ESPortManager::StartVideoServers()
+{
+    // 继承了 51030 监听就一律接管，分片数以旧进程为准，忽略 videoReusePortShards：
+    // 否则新建的分组和继承的 fd 抢同一个端口，继承 fd 上排队的连接会丢
+    const size_t inherited = m_handoffState ?
+        m_handoffState->CountSockets(ESHandoffSocketKind::TcpListener, m_videoPort) : 0;
+    if (inherited == 1) {
+        m_tcpServers51030.emplace_back();
+        return StartTcpServer(m_videoPort, m_tcpServers51030.back());
+    }
+
+    if (inherited > 1) {
+        std::vector<int> adoptedFds = m_handoffState->TakeListeners(m_videoPort);
+        const size_t shards = adoptedFds.size();
+        int ret = StartVideoShards(shards, std::move(adoptedFds));
+        if (ret != 0) {
+            std::cout << "[ESPortManager] tcp " << m_videoPort << " adopt reuseport shards failed, ret=" << ret << std::endl;
+            StopVideoShards();
+        }
+        return ret;
+    }
+
+    const size_t shards = m_socketConfig.videoReusePortShards;
+    if (m_videoReceiveConfig.backend == ESVideoBackend::IoUring && !m_handoffState) {
+        if (ESUring::IsSupported()) {
+            int ret = StartUringVideo(std::max<size_t>(shards, 1));
+            if (ret == 0) {
+                return 0;
+            }
+
+            std::cout << "[ESPortManager] tcp " << m_videoPort << " io_uring failed, ret=" << ret
+                      << ", fallback to hv" << std::endl;
+            StopUringVideo();
+        } else {
+            std::cout << "[ESPortManager] io_uring not supported, tcp " << m_videoPort << " uses hv" << std::endl;
+        }
+    }
+
+    if (shards > 1) {
+        int ret = StartVideoShards(shards);
+        if (ret == 0) {
+            return 0;
+        }
+
+        std::cout << "[ESPortManager] tcp " << m_videoPort << " reuseport shards failed, ret=" << ret
+                  << ", fallback to single listener" << std::endl;
+        StopVideoShards();
+    }
+
+    m_tcpServers51030.emplace_back();
+    return StartTcpServer(m_videoPort, m_tcpServers51030.back());
+}
+
+int ESPortManager::StartVideoShards(size_t shards, std::vector<int> adoptedFds)
+{
+    const bool adopted = !adoptedFds.empty();
+
+    // 失败时还没 start 的分片，监听 fd 没交给 loop，hv 停止/析构都不会关，只能自己关；
+    // 接管来的 fd 中还没放进分片的那部分一并关掉
+    auto abandon = [this, &adoptedFds](size_t from) {
+        for (auto& server : m_tcpServers51030) {
+            CloseSocketFd(server->listenfd);
+            server->listenfd = -1;
+        }
+        m_tcpServers51030.clear();
+
+        for (size_t i = from; i < adoptedFds.size(); ++i) {
+            CloseSocketFd(adoptedFds[i]);
+        }
+    };
+
+    int ret = m_videoPool.Start(shards, m_eventLoopConfig.videoCpus);
+    if (ret != 0) {
+        abandon(0);
+        return ret;
+    }
+
+    // 组内下标按 bind 顺序，分片 i 对应视频 loop i；每个分片自己 accept，连接留在本 loop
+    for (size_t i = 0; i < shards; ++i) {
+        int listenfd = adopted ? adoptedFds[i] : CreateReusePortListener(m_videoPort);
+        if (listenfd < 0) {
+            abandon(i + 1);
+            return -100 - static_cast<int>(m_videoPort);
+        }
+
+        auto server = std::make_unique<TcpServer>(m_videoPool.GetLoop(i));
+        server->listenfd = listenfd;
+        server->port = m_videoPort;
+        server->host = "0.0.0.0";
+        server->setThreadNum(0);
+        SetupTcpServer(m_videoPort, *server);
+        m_tcpServers51030.push_back(std::move(server));
+    }
+
+    // 接管来的分组沿用旧进程挂好的 steering 程序
+    if (!adopted &&
+        !AttachReusePortSteering(m_tcpServers51030.front()->listenfd, m_socketConfig.videoSteering, shards)) {
+        std::cout << "[ESPortManager] tcp " << m_videoPort << " steering not attached, use kernel hash" << std::endl;
+    }
+
+    for (auto& server : m_tcpServers51030) {
+        server->start();
+    }
+
+    std::cout << "[ESPortManager] tcp " << m_videoPort << (adopted ? " adopted" : " listening")
+              << ", reuseport shards=" << shards
+              << ", " << DescribeSocketOptions(m_tcpServers51030.front()->listenfd, true) << std::endl;
+    return 0;
+}
 
-    std::cout << "[ESPortManager] tcp " << localPort << " listening, fd=" << listenfd << std::endl;
+void ESPortManager::StopVideoShards()
+{
+    for (auto& server : m_tcpServers51030) {
+        StopTcpServer(server);
+    }
+    m_videoPool.Stop();
+    m_tcpServers51030.clear();
+}
+
+int ESPortManager::StartUringVideo(size_t shards)
+{
+    const ESSocketOptions options = GetSocketOptions(m_videoPort, true);
+    const std::string tag = "tcp " + std::to_string(m_videoPort);
+
+    // 先建好整组监听再挂 steering、起线程，免得前几个分片先把连接收走
+    std::vector<int> listenfds;
+    for (size_t i = 0; i < shards; ++i) {
+        int listenfd = CreateReusePortListener(m_videoPort);
+        if (listenfd < 0) {
+            for (int fd : listenfds) {
+                CloseSocketFd(fd);
+            }
+            return -100 - static_cast<int>(m_videoPort);
+        }
+        ApplySocketOptions(listenfd, options, true, tag);
+        listenfds.push_back(listenfd);
+    }
+
+    if (shards > 1 &&
+        !AttachReusePortSteering(listenfds.front(), m_socketConfig.videoSteering, shards)) {
+        std::cout << "[ESPortManager] tcp " << m_videoPort << " steering not attached, use kernel hash" << std::endl;
+    }
+
+    const std::string description = DescribeSocketOptions(listenfds.front(), true);
+    const bool quickAck = options.tcpQuickAck;
+    const std::vector<int>& cpus = m_eventLoopConfig.videoCpus;
+
+    for (size_t i = 0; i < shards; ++i) {
+        auto receiver = std::make_unique<ESUringTcpReceiver>();
+
+        // 和 SetupTcpServer 的连接/断开/收包处理一致，只是跑在收包线程上
+        receiver->SetCallbacks(
+            [this, options, tag](int fd, uint32_t peerIp) -> ESConnectionContextPtr {
+                if (!m_admission.TryAcquireConnection(peerIp, m_videoPort, GetSteadyTimeUs() / 1000)) {
+                    return nullptr;
+                }
+
+                ApplySocketOptions(fd, options, true, tag);
+
+                auto context = std::make_shared<ESConnectionContext>();
+                context->localPort = m_videoPort;
+                context->peerIp = peerIp;
+                context->peerIpText = StreamIDToIP(peerIp);
+                context->admitted = true;
+                context->limiter = m_admission.MakeTcpLimiter(ESPortClass::Video);
+
+                if (m_server) {
+                    m_server->OnTcpConnected(m_videoPort, context->peerIpText);
+                }
+                return context;
+            },
+            [this, quickAck](int fd, ESConnectionContext& context, const uint8_t* data, size_t size) {
+                if (quickAck) {
+                    RearmTcpQuickAck(fd);
+                }
+
+                if (context.limiter.IsLimited() && !context.limiter.Allow(size, GetSteadyTimeUs())) {
+                    m_admission.OnTcpRateExceeded(context.peerIp, m_videoPort, GetSteadyTimeUs() / 1000);
+                    return false;
+                }
+
+                if (m_server) {
+                    m_server->OnVideoTcpData(context, data, size);
+                }
+                return true;
+            },
+            [this](ESConnectionContext& context) {
+                if (context.admitted) {
+                    m_admission.ReleaseConnection(context.peerIp);
+                    context.admitted = false;
+                }
+
+                if (m_server) {
+                    m_server->OnTcpDisconnected(m_videoPort, context.peerIpText);
+                }
+            });
+
+        const int cpu = cpus.empty() ? -1 : cpus[i % cpus.size()];
+        int ret = receiver->Start(listenfds[i], m_videoReceiveConfig.bufferCount,
+                                  m_videoReceiveConfig.bufferSize, cpu);
+        if (ret != 0) {
+            for (size_t j = i + 1; j < shards; ++j) {
+                CloseSocketFd(listenfds[j]);
+            }
+            return ret;
+        }
+        m_uringVideo.push_back(std::move(receiver));
+    }
+
+    std::cout << "[ESPortManager] tcp " << m_videoPort << " listening (io_uring), shards=" << shards
+              << ", buffers=" << m_videoReceiveConfig.bufferCount << "x" << m_videoReceiveConfig.bufferSize
+              << ", " << description << std::endl;
     return 0;
 }
 
-void ESPortManager::StopTcpServer(std::unique_ptr<hv::TcpServer>& server)
+void ESPortManager::StopUringVideo()
 {
+    for (auto& receiver : m_uringVideo) {
+        receiver->Stop();
+    }
+    m_uringVideo.clear();
+}
+
+void ESPortManager::StopTcpServer(std::unique_ptr<TcpServer>& server)
+{
+    // 只关监听和自带的工作 loop，对象留到共享 loop 停下后再析构
     if (server) {
         server->stop();
-        server.reset();
     }
 }
 
 int ESPortManager::StartUdpServer(uint16_t bindPort,
-                                  std::unique_ptr<hv::UdpServer>& server,
-                                  uint16_t& actualPort)
+                                  std::unique_ptr<UdpServer>& server,
+                                  std::unique_ptr<ESUdpBatchReceiver>& batchReceiver,
+                                  std::atomic<uint16_t>& actualPort,
+                                  ESHandoffSocketKind handoffKind)
 {
-    server = std::make_unique<hv::UdpServer>();
+    // 接管来的 socket 只能走 recvmmsg，hv::UdpServer 没有挂接现成 fd 的入口
+    const int adoptedFd = m_handoffState ? m_handoffState->TakeSocket(handoffKind) : -1;
+
+    const bool useIoUring = m_udpReceiveConfig.backend == ESUdpBackend::IoUring;
+    if (adoptedFd >= 0 ||
+        ((m_udpReceiveConfig.backend == ESUdpBackend::RecvMmsg || useIoUring) && ESUdpBatchReceiver::IsSupported())) {
+        batchReceiver = std::make_unique<ESUdpBatchReceiver>();
+
+        // 端口在 Start 之后才知道（bindPort 可能为 0），回调里读 receiver 自己记录的端口
+        ESUdpBatchReceiver* receiver = batchReceiver.get();
+        batchReceiver->SetCallback([this, receiver](const ESUdpDatagram* datagrams, size_t count) {
+            HandleUdpBatch(receiver->GetLocalPort(), datagrams, count);
+        });
+
+        int ret = (adoptedFd >= 0)
+            ? batchReceiver->StartWithSocket(adoptedFd,
+                                             m_udpReceiveConfig.batchSize,
+                                             m_udpReceiveConfig.maxDatagramSize,
+                                             m_udpReceiveConfig.kernelTimestamps,
+                                             useIoUring)
+            : batchReceiver->Start(bindPort,
+                                   m_udpReceiveConfig.batchSize,
+                                   m_udpReceiveConfig.maxDatagramSize,
+                                   m_udpReceiveConfig.kernelTimestamps,
+                                   useIoUring);
+        if (ret == 0) {
+            const uint16_t localPort = batchReceiver->GetLocalPort();
+            actualPort = localPort;
+            ApplySocketOptions(batchReceiver->GetSocket(), GetSocketOptions(localPort, false),
+                               false, "udp " + std::to_string(localPort));
+            std::cout << "[ESPortManager] udp " << localPort
+                      << (adoptedFd >= 0 ? " adopted" : " listening")
+                      << (batchReceiver->IsUsingIoUring() ? " (io_uring)" : " (recvmmsg)") << ", fd="
+                      << batchReceiver->GetSocket()
+                      << ", " << DescribeSocketOptions(batchReceiver->GetSocket(), false) << std::endl;
+            return 0;
+        }
+
+        std::cout << "[ESPortManager] recvmmsg udp " << bindPort
+                  << " start failed, ret=" << ret << ", fallback to hv" << std::endl;
+        batchReceiver.reset();
+    }
+
+    server = std::make_unique<UdpServer>(m_loopPool.NextLoop());
 
     int sockfd = server->createsocket(bindPort);
     if (sockfd < 0) {
@@ -332,31 +690,516 @@ int ESPortManager::StartUdpServer(uint16_t bindPort,
         return -200 - static_cast<int>(bindPort);
     }
 
-    actualPort = GetLocalPortByFd(sockfd);
-    if (actualPort == 0) {
+    const uint16_t localPort = GetLocalPortByFd(sockfd);
+    if (localPort == 0) {
         std::cout << "[ESPortManager] get udp local port failed, bindPort=" << bindPort << std::endl;
         server.reset();
         return -300 - static_cast<int>(bindPort);
     }
 
-    server->onMessage = [this, actualPort](const hv::SocketChannelPtr& channel, hv::Buffer* buf) {
-        HandleUdpMessage(actualPort, channel, buf);
+    ApplySocketOptions(sockfd, GetSocketOptions(localPort, false), false, "udp " + std::to_string(localPort));
+
+    server->onMessage = [this, localPort](const hv::SocketChannelPtr& channel, hv::Buffer* buf) {
+        HandleUdpMessage(localPort, channel, buf);
     };
 
+    // 端口先写回再开收，hv 的 loop 线程一收到包就会读它
+    actualPort = localPort;
     server->start();
 
-    std::cout << "[ESPortManager] udp " << actualPort << " listening, fd=" << sockfd << std::endl;
+    std::cout << "[ESPortManager] udp " << localPort << " listening, fd=" << sockfd
+              << ", " << DescribeSocketOptions(sockfd, false) << std::endl;
     return 0;
 }
 
-void ESPortManager::StopUdpServer(std::unique_ptr<hv::UdpServer>& server)
+void ESPortManager::StopUdpServer(std::unique_ptr<UdpServer>& server,
+                                  std::unique_ptr<ESUdpBatchReceiver>& batchReceiver)
 {
     if (server) {
         server->stop();
-        server.reset();
+    }
+
+    if (batchReceiver) {
+        batchReceiver->Stop();
+        batchReceiver.reset();
     }
 }
 
+void ESPortManager::StopServers()
+{
+    StopTcpServer(m_tcpServer8700);
+    StopTcpServer(m_tcpServer8121);
+    StopTcpServer(m_tcpServer57395);
+    StopTcpServer(m_tcpServer8600);
+    for (auto& server : m_tcpServers51030) {
+        StopTcpServer(server);
+    }
+    StopTcpServer(m_tcpServer51040);
+    StopTcpServer(m_tcpServer52020);
+    StopTcpServer(m_tcpServer52025);
+    StopTcpServer(m_tcpServer52030);
+
+    StopUdpServer(m_udpServer51050, m_udpBatch51050);
+    StopUdpServer(m_udpServerDataPort, m_udpBatchDataPort);
+    StopUdpServer(m_udpServerControlPort, m_udpBatchControlPort);
+
+    // 收包线程里会回调 ESServer，在 loop 停下之前收掉
+    StopUringVideo();
+
+    // 共享 loop 退出时才真正关闭残留连接，回调里还会用到服务端对象
+    m_videoPool.Stop();
+    m_loopPool.Stop();
+    m_videoWorkerLoops = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(m_adoptedMutex);
+        m_adoptedChannels.clear();
+    }
+    m_detachedChannels.clear();
+    m_pausedReceivers.clear();
+
+    m_tcpServer8700.reset();
+    m_tcpServer8121.reset();
+    m_tcpServer57395.reset();
+    m_tcpServer8600.reset();
+    m_tcpServers51030.clear();
+    m_tcpServer51040.reset();
+    m_tcpServer52020.reset();
+    m_tcpServer52025.reset();
+    m_tcpServer52030.reset();
+
+    m_udpServer51050.reset();
+    m_udpServerDataPort.reset();
+    m_udpServerControlPort.reset();
+}
+
+size_t ESPortManager::GetVideoLoopCount() const
+{
+    if (m_videoPool.IsRunning()) {
+        return m_videoPool.GetLoopCount();
+    }
+
+    if (m_eventLoopConfig.videoLoops > 0) {
+        return m_eventLoopConfig.videoLoops;
+    }
+
+    const unsigned int cores = std::thread::hardware_concurrency();
+    return std::min<size_t>(std::max(cores, 1u), 4);
+}
+
+ESSocketOptions ESPortManager::GetSocketOptions(uint16_t localPort, bool tcp) const
+{
+    auto it = m_socketConfig.ports.find(localPort);
+    if (it != m_socketConfig.ports.end()) {
+        return it->second;
+    }
+
+    if (!tcp) {
+        return m_socketConfig.udp;
+    }
+
+    return (localPort == m_videoPort) ? m_socketConfig.video : m_socketConfig.control;
+}
+
+void ESPortManager::ClosePeerConnections(uint32_t streamId)
+{
+    if (!m_running.load() || streamId == 0) {
+        return;
+    }
+
+    // 断开事件照常走 onConnection，接收缓冲在那里清理
+    auto closeMatched = [streamId](const hv::SocketChannelPtr& channel) {
+        if (IPToStreamID(ExtractPeerIp(channel->peeraddr())) == streamId) {
+            channel->close(true);
+        }
+    };
+
+    for (auto* server : { &m_tcpServer57395, &m_tcpServer51040 }) {
+        if (*server) {
+            (*server)->foreachChannel(closeMatched);
+        }
+    }
+
+    for (auto& server : m_tcpServers51030) {
+        if (server) {
+            server->foreachChannel(closeMatched);
+        }
+    }
+
+    for (auto& receiver : m_uringVideo) {
+        receiver->CloseConnections(streamId);
+    }
+
+    // 接管来的连接不在 hv 服务端的表里，上下文在接管时就已设好，直接按上下文比对
+    for (const auto& channel : GetAdoptedChannels()) {
+        auto context = channel->getContextPtr<ESConnectionContext>();
+        if (context && context->peerIp == streamId &&
+            (context->localPort == 57395 || context->localPort == 51040 || context->localPort == m_videoPort)) {
+            channel->close(true);
+        }
+    }
+}
+
+std::vector<hv::EventLoopPtr> ESPortManager::CollectLoops() const
+{
+    std::vector<hv::EventLoopPtr> loops;
+    for (size_t i = 0; i < m_loopPool.GetLoopCount(); ++i) {
+        loops.push_back(m_loopPool.GetLoop(i));
+    }
+
+    if (m_videoPool.IsRunning()) {
+        for (size_t i = 0; i < m_videoPool.GetLoopCount(); ++i) {
+            loops.push_back(m_videoPool.GetLoop(i));
+        }
+    } else if (m_videoWorkerLoops > 0 && !m_tcpServers51030.empty() && m_tcpServers51030.front()) {
+        for (size_t i = 0; i < m_videoWorkerLoops; ++i) {
+            loops.push_back(m_tcpServers51030.front()->loop(static_cast<int>(i)));
+        }
+    }
+
+    return loops;
+}
+
+void ESPortManager::SetHandoffState(ESHandoffState* state)
+{
+    m_handoffState = state;
+}
+
+int ESPortManager::DetachForHandoff(ESHandoffState& state, const std::function<void(ESHandoffState&)>& snapshot)
+{
+#ifdef __linux__
+    if (!m_running.load()) {
+        return -1;
+    }
+
+    if (!m_detachedChannels.empty() || !m_pausedReceivers.empty()) {
+        std::cout << "[ESPortManager] handoff already in progress" << std::endl;
+        return -2;
+    }
+
+    if (!m_uringVideo.empty()) {
+        std::cout << "[ESPortManager] video on io_uring, handoff not supported" << std::endl;
+        return -3;
+    }
+
+    auto addSocket = [&state](ESHandoffSocketKind kind, uint16_t localPort, int fd) -> ESHandoffSocket* {
+        const int copy = (fd >= 0) ? fcntl(fd, F_DUPFD_CLOEXEC, 0) : -1;
+        if (copy < 0) {
+            return nullptr;
+        }
+
+        ESHandoffSocket socket;
+        socket.kind = kind;
+        socket.localPort = localPort;
+        socket.fd = copy;
+        state.sockets.push_back(std::move(socket));
+        return &state.sockets.back();
+    };
+
+    // 收包线程不是 loop，先单独停下，免得拖长 loop 的暂停时间
+    for (auto* receiver : { m_udpBatch51050.get(), m_udpBatchDataPort.get(), m_udpBatchControlPort.get() }) {
+        if (receiver && receiver->IsRunning()) {
+            receiver->SetPaused(true);
+            m_pausedReceivers.push_back(receiver);
+        }
+    }
+
+    LoopParking parking;
+    if (!parking.Park(CollectLoops(), kHandoffParkTimeoutMs)) {
+        parking.Release();
+        for (auto* receiver : m_pausedReceivers) {
+            receiver->SetPaused(false);
+        }
+        m_pausedReceivers.clear();
+        std::cout << "[ESPortManager] handoff park loops timeout" << std::endl;
+        return -3;
+    }
+
+    std::vector<std::pair<uint16_t, TcpServer*>> servers = {
+        { 8700, m_tcpServer8700.get() },
+        { 8121, m_tcpServer8121.get() },
+        { 57395, m_tcpServer57395.get() },
+        { 8600, m_tcpServer8600.get() },
+        { 51040, m_tcpServer51040.get() },
+        { 52020, m_tcpServer52020.get() },
+        { 52025, m_tcpServer52025.get() },
+        { 52030, m_tcpServer52030.get() },
+    };
+    for (auto& server : m_tcpServers51030) {
+        servers.emplace_back(m_videoPort, server.get());
+    }
+
+    // 连接上未消费的字节随 fd 一起交出去；51030 的半帧在会话的解包器里，由 snapshot 带走
+    auto detachChannel = [this, &addSocket](const hv::SocketChannelPtr& channel) {
+        auto context = channel->getContextPtr<ESConnectionContext>();
+        if (!context || channel->isClosed()) {
+            return;
+        }
+
+        ESHandoffSocket* socket = addSocket(ESHandoffSocketKind::TcpConnection, context->localPort, channel->fd());
+        if (socket == nullptr) {
+            return;
+        }
+
+        socket->peerIp = context->peerIp;
+        if (context->localPort == 51040) {
+            socket->pending = std::string(context->rtspParser.GetBuffered());
+        } else if (context->localPort == 57395) {
+            socket->pending = std::string(context->jsonSplitter.GetBuffered());
+        } else if (context->localPort == 8600) {
+            socket->pending = context->recvBuffer8600;
+        }
+
+        hio_del(channel->io(), HV_READ);
+        m_detachedChannels.push_back(channel);
+    };
+
+    for (auto& item : servers) {
+        if (item.second == nullptr) {
+            continue;
+        }
+        addSocket(ESHandoffSocketKind::TcpListener, item.first, item.second->listenfd);
+        item.second->foreachChannel(detachChannel);
+    }
+
+    for (const auto& channel : GetAdoptedChannels()) {
+        detachChannel(channel);
+    }
+
+    struct UdpEntry {
+        ESHandoffSocketKind kind;
+        uint16_t port;
+        UdpServer* server;
+        ESUdpBatchReceiver* receiver;
+    };
+    const UdpEntry udpEntries[] = {
+        { ESHandoffSocketKind::UdpMouse, m_mousePort, m_udpServer51050.get(), m_udpBatch51050.get() },
+        { ESHandoffSocketKind::UdpData, m_dataPort, m_udpServerDataPort.get(), m_udpBatchDataPort.get() },
+        { ESHandoffSocketKind::UdpControl, m_controlPort, m_udpServerControlPort.get(), m_udpBatchControlPort.get() },
+    };
+    for (const auto& entry : udpEntries) {
+        if (entry.receiver) {
+            addSocket(entry.kind, entry.port, entry.receiver->GetSocket());
+        } else if (entry.server && entry.server->channel) {
+            addSocket(entry.kind, entry.port, entry.server->channel->fd());
+            hio_del(entry.server->channel->io(), HV_READ);
+            m_detachedChannels.push_back(entry.server->channel);
+        }
+    }
+
+    if (snapshot) {
+        snapshot(state);
+    }
+
+    parking.Release();
+
+    std::cout << "[ESPortManager] detached for handoff, sockets=" << state.sockets.size()
+              << ", sessions=" << state.sessions.size() << std::endl;
+    return 0;
+#else
+    (void)state;
+    (void)snapshot;
+    return -1;
+#endif
+}
+
+void ESPortManager::ResumeAfterHandoff()
+{
+#ifdef __linux__
+    LoopParking parking;
+    if (!parking.Park(CollectLoops(), kHandoffParkTimeoutMs)) {
+        std::cout << "[ESPortManager] handoff resume park loops timeout" << std::endl;
+    }
+
+    for (const auto& channel : m_detachedChannels) {
+        if (channel->isClosed()) {
+            continue;
+        }
+
+        // 对端可能已经把共享的文件描述改成阻塞（UDP 接管走 recvmmsg），hv 需要非阻塞
+        const int flags = fcntl(channel->fd(), F_GETFL, 0);
+        if (flags >= 0 && (flags & O_NONBLOCK) == 0) {
+            fcntl(channel->fd(), F_SETFL, flags | O_NONBLOCK);
+        }
+        channel->startRead();
+    }
+    m_detachedChannels.clear();
+
+    parking.Release();
+
+    for (auto* receiver : m_pausedReceivers) {
+        receiver->SetPaused(false);
+    }
+    m_pausedReceivers.clear();
+
+    std::cout << "[ESPortManager] handoff aborted, resumed" << std::endl;
+#endif
+}
+
+void ESPortManager::FinishHandoff()
+{
+#ifdef __linux__
+    // 监听 socket 此时由新进程共同持有，这里只释放本进程的引用
+    LoopParking parking;
+    if (!parking.Park(CollectLoops(), kHandoffParkTimeoutMs)) {
+        std::cout << "[ESPortManager] handoff finish park loops timeout" << std::endl;
+    }
+
+    for (auto* server : { &m_tcpServer8700, &m_tcpServer8121, &m_tcpServer57395, &m_tcpServer8600,
+                          &m_tcpServer51040, &m_tcpServer52020, &m_tcpServer52025, &m_tcpServer52030 }) {
+        if (*server) {
+            (*server)->closesocket();
+        }
+    }
+    for (auto& server : m_tcpServers51030) {
+        if (server) {
+            server->closesocket();
+        }
+    }
+
+    parking.Release();
+
+    std::cout << "[ESPortManager] handoff finished, listeners released" << std::endl;
+#endif
+}
+
+void ESPortManager::AdoptConnections(ESHandoffState& state)
+{
+    size_t count = 0;
+    for (auto& socket : state.sockets) {
+        if (socket.kind != ESHandoffSocketKind::TcpConnection || socket.fd < 0) {
+            continue;
+        }
+
+        ESHandoffSocket adopted = std::move(socket);
+        socket.fd = -1;
+        AdoptConnection(std::move(adopted));
+        ++count;
+    }
+
+    std::cout << "[ESPortManager] adopting " << count << " connections" << std::endl;
+}
+
+hv::EventLoopPtr ESPortManager::NextAdoptLoop(uint16_t localPort)
+{
+    if (localPort == m_videoPort) {
+        if (m_videoPool.IsRunning()) {
+            return m_videoPool.NextLoop();
+        }
+
+        if (m_videoWorkerLoops > 0 && !m_tcpServers51030.empty() && m_tcpServers51030.front()) {
+            const size_t index = m_adoptLoopIndex++ % m_videoWorkerLoops;
+            return m_tcpServers51030.front()->loop(static_cast<int>(index));
+        }
+    }
+
+    return m_loopPool.NextLoop();
+}
+
+void ESPortManager::AdoptConnection(ESHandoffSocket socket)
+{
+    hv::EventLoopPtr loop = NextAdoptLoop(socket.localPort);
+    if (!loop) {
+        CloseSocketFd(socket.fd);
+        return;
+    }
+
+    auto adopted = std::make_shared<ESHandoffSocket>(std::move(socket));
+    loop->runInLoop([this, loop, adopted]() {
+        hio_t* io = hio_get(loop->loop(), adopted->fd);
+        if (io == nullptr) {
+            CloseSocketFd(adopted->fd);
+            return;
+        }
+
+        const uint16_t localPort = adopted->localPort;
+        const ESSocketOptions options = GetSocketOptions(localPort, true);
+
+        auto context = std::make_shared<ESConnectionContext>();
+        context->localPort = localPort;
+        context->peerIp = adopted->peerIp;
+        context->peerIpText = StreamIDToIP(adopted->peerIp);
+        // 旧进程已经放行过，名额不够也照常接管，只是不记账
+        context->admitted = m_admission.TryAcquireConnection(context->peerIp, localPort, GetSteadyTimeUs() / 1000);
+        context->limiter = m_admission.MakeTcpLimiter(
+            localPort == m_videoPort ? ESPortClass::Video : ESPortClass::Control);
+
+        const std::string& pending = adopted->pending;
+        if (localPort == 51040) {
+            context->rtspParser.Append(pending.data(), pending.size());
+        } else if (localPort == 57395) {
+            context->jsonSplitter.Append(pending.data(), pending.size());
+        } else if (localPort == 8600) {
+            context->recvBuffer8600 = pending;
+        }
+
+        auto channel = std::make_shared<hv::SocketChannel>(io);
+        channel->setContextPtr(context);
+
+        std::weak_ptr<hv::SocketChannel> weak = channel;
+        const bool quickAck = options.tcpQuickAck;
+        channel->onread = [this, localPort, quickAck, weak](hv::Buffer* buf) {
+            hv::SocketChannelPtr self = weak.lock();
+            if (!self) {
+                return;
+            }
+            if (quickAck) {
+                RearmTcpQuickAck(self->fd());
+            }
+            HandleTcpMessage(localPort, self, buf);
+        };
+
+        // 不能在自己的关闭回调里析构自己：表项投递回所属 loop，等回调返回后再删
+        // onclose 只会在所属 loop 里触发，捕获裸指针即可，不让 channel 反过来持有 loop
+        const uint32_t channelId = channel->id();
+        hv::EventLoop* owner = loop.get();
+        channel->onclose = [this, localPort, weak, owner, channelId]() {
+            owner->queueInLoop([this, channelId]() {
+                std::lock_guard<std::mutex> lock(m_adoptedMutex);
+                m_adoptedChannels.erase(channelId);
+            });
+
+            hv::SocketChannelPtr self = weak.lock();
+            auto ctx = self ? self->getContextPtr<ESConnectionContext>() : nullptr;
+            if (!ctx) {
+                return;
+            }
+
+            if (ctx->admitted) {
+                m_admission.ReleaseConnection(ctx->peerIp);
+                ctx->admitted = false;
+            }
+
+            if (m_server) {
+                m_server->OnTcpDisconnected(localPort, ctx->peerIpText);
+            }
+        };
+
+        {
+            std::lock_guard<std::mutex> lock(m_adoptedMutex);
+            m_adoptedChannels[channelId] = channel;
+        }
+
+        channel->startRead();
+
+        if (m_server) {
+            m_server->OnTcpConnected(localPort, context->peerIpText);
+        }
+    });
+}
+
+std::vector<hv::SocketChannelPtr> ESPortManager::GetAdoptedChannels()
+{
+    std::vector<hv::SocketChannelPtr> channels;
+
+    std::lock_guard<std::mutex> lock(m_adoptedMutex);
+    channels.reserve(m_adoptedChannels.size());
+    for (const auto& item : m_adoptedChannels) {
+        channels.push_back(item.second);
+    }
+    return channels;
+}
+
 void ESPortManager::HandleTcpMessage(uint16_t localPort,
                                      const hv::SocketChannelPtr& channel,
                                      hv::Buffer* buf)
@@ -365,17 +1208,25 @@ void ESPortManager::HandleTcpMessage(uint16_t localPort,
         return;
     }
 
-    std::string peerAddr = channel->peeraddr();
-    std::string peerIp = ExtractPeerIp(peerAddr);
-    std::string chunk(reinterpret_cast<const char*>(buf->data()), buf->size());
+    ESConnectionContextPtr context = channel->getContextPtr<ESConnectionContext>();
+    if (!context) {
+        return;
+    }
+    const std::string& peerIp = context->peerIpText;
 
-    if (localPort == 51030) {
+    // 限速在任何解析之前；TCP 不能丢字节，超速直接断开
+    if (context->limiter.IsLimited() && !context->limiter.Allow(buf->size(), GetSteadyTimeUs())) {
+        m_admission.OnTcpRateExceeded(context->peerIp, localPort, GetSteadyTimeUs() / 1000);
+        channel->close(true);
+        return;
+    }
+
+    if (localPort == m_videoPort) {
         std::cout << "[ESPortManager][TCP][51030] recv " << buf->size()
         << " bytes from " << peerIp << std::endl;
 
-        m_server->OnTcpData(
-            localPort,
-            peerIp,
+        m_server->OnVideoTcpData(
+            *context,
             reinterpret_cast<const uint8_t*>(buf->data()),
             static_cast<size_t>(buf->size()));
         return;
@@ -388,28 +1239,55 @@ void ESPortManager::HandleTcpMessage(uint16_t localPort,
     }
 
     if (localPort == 51040) {
-        std::string& cache = m_tcpRecvBuffers51040[peerAddr];
-        cache += chunk;
+        ESRtspLiteParser& parser = context->rtspParser;
+        parser.Append(reinterpret_cast<const char*>(buf->data()), buf->size());
 
         while (true) {
-            ESRtspLiteMessage msg;
-            std::string rawMsg;
+            ESRtspLiteRequestView req;
             std::string error;
-            if (!ESRtspLiteCodec::TryDecode(cache, msg, &rawMsg, &error)) {
+            const ESRtspLiteParseResult result = parser.Next(req, &error);
+            if (result == ESRtspLiteParseResult::NeedMore) {
+                break;
+            }
+
+            if (result == ESRtspLiteParseResult::Error) {
+                std::cout << "[ESPortManager][TCP][51040] bad request from " << peerIp
+                          << ": " << error << ", drop " << parser.GetBufferedSize() << " bytes" << std::endl;
+                parser.Reset();
                 break;
             }
 
-            std::string response = m_server->HandleTcpRequest(localPort, peerIp, rawMsg);
+            std::string response = m_server->HandleRtspRequest(peerIp, req);
+            if (!response.empty()) {
+                channel->write(response);
+            }
+        }
+        return;
+    }
+
+    if (localPort == 57395) {
+        ESJsonLineSplitter& splitter = context->jsonSplitter;
+        splitter.Append(reinterpret_cast<const char*>(buf->data()), buf->size());
+
+        std::string_view line;
+        while (splitter.Next(line)) {
+            std::string response = m_server->HandleEshareJsonLine(peerIp, line);
             if (!response.empty()) {
                 channel->write(response);
             }
         }
+
+        if (splitter.IsOverflowed()) {
+            std::cout << "[ESPortManager][TCP][57395] line too long from " << peerIp
+                      << ", drop " << splitter.GetBufferedSize() << " bytes" << std::endl;
+            splitter.Reset();
+        }
         return;
     }
 
     if (localPort == 8600) {
-        std::string& cache = m_tcpRecvBuffers8600[peerAddr];
-        cache += chunk;
+        std::string& cache = context->recvBuffer8600;
+        cache.append(reinterpret_cast<const char*>(buf->data()), buf->size());
 
         const std::string cmdAvailability = "CameraAvailabilityCheck";
         const std::string cmdState = "CameraStateCheck";
@@ -468,6 +1346,7 @@ void ESPortManager::HandleTcpMessage(uint16_t localPort,
         return;
     }
 
+    std::string chunk(reinterpret_cast<const char*>(buf->data()), buf->size());
     std::string response = m_server->HandleTcpRequest(localPort, peerIp, chunk);
     if (!response.empty()) {
         channel->write(response);
@@ -482,11 +1361,43 @@ void ESPortManager::HandleUdpMessage(uint16_t localPort,
         return;
     }
 
-    std::string peerIp = ExtractPeerIp(channel->peeraddr());
+    const uint32_t peerIp = GetDatagramPeerIp(channel);
+    if (!m_admission.AllowDatagram(peerIp, localPort, buf->size(), GetSteadyTimeUs())) {
+        return;
+    }
+
     m_server->OnUdpData(localPort,
                         peerIp,
                         reinterpret_cast<const uint8_t*>(buf->data()),
                         static_cast<size_t>(buf->size()));
 }
 
+void ESPortManager::HandleUdpBatch(uint16_t localPort,
+                                   const ESUdpDatagram* datagrams,
+                                   size_t count)
+{
+    if (m_server == nullptr || datagrams == nullptr) {
+        return;
+    }
+
+    // 一次收包批次里切出的媒体合成一次回调
+    ESServer::MediaBatchScope batchScope(*m_server);
+
+    const uint64_t nowUs = GetSteadyTimeUs();
+
+    for (size_t i = 0; i < count; ++i) {
+        const ESUdpDatagram& datagram = datagrams[i];
+        if (datagram.size == 0 || datagram.truncated) {
+            continue;
+        }
+
+        if (!m_admission.AllowDatagram(datagram.peerIp, localPort, datagram.size, nowUs)) {
+            continue;
+        }
+
+        m_server->OnUdpData(localPort, datagram.peerIp, datagram.data, datagram.size,
+                            datagram.kernelTimestampUs);
+    }
+}
+
 } // namespace hhcast
\ No newline at end of file
@@ -0,0 +1,412 @@
+#include "ESReplyCache.h"
+
+#include <plist/plist.h>
+
+#include <iostream>
+
+namespace hhcast {
+
+namespace {
+
+// 模板里的端口占位值：都 >= 256，libplist 按 2 字节整数（标记 0x11）编码，且互不相同
+constexpr uint16_t kPortSentinels[3] = { 0xA5A1, 0xA5A2, 0xA5A3 };
+constexpr uint8_t kBplistUint16Marker = 0x11;
+
+static std::string SerializePlist(plist_t root)
+{
+    char* bin = nullptr;
+    uint32_t len = 0;
+    plist_to_bin(root, &bin, &len);
+
+    std::string out;
+    if (bin && len > 0) {
+        out.assign(bin, bin + len);
+    }
+
+    if (bin) {
+        plist_mem_free(bin);
+    }
+    return out;
+}
+
+static std::string BuildVideoSetupPlist(const ESReplyParams& params, uint16_t videoPort)
+{
+    plist_t root = plist_new_dict();
+
+    plist_t streams = plist_new_array();
+    plist_t streamItem = plist_new_dict();
+    plist_dict_set_item(streamItem, "type", plist_new_uint(static_cast<uint64_t>(110)));
+    plist_dict_set_item(streamItem, "dataPort", plist_new_uint(static_cast<uint64_t>(videoPort)));
+    plist_array_append_item(streams, streamItem);
+    plist_dict_set_item(root, "streams", streams);
+
+    plist_dict_set_item(root, "feature", plist_new_string(params.feature.c_str()));
+    plist_dict_set_item(root, "Framerate", plist_new_string(std::to_string(params.framerate).c_str()));
+    plist_dict_set_item(root, "casting_win_width", plist_new_string(std::to_string(params.width).c_str()));
+    plist_dict_set_item(root, "casting_win_height", plist_new_string(std::to_string(params.height).c_str()));
+    plist_dict_set_item(root, "format", plist_new_string(params.videoFormat.c_str()));
+
+    std::string out = SerializePlist(root);
+    plist_free(root);
+    return out;
+}
+
+static std::string BuildAudioSetupPlist(uint16_t dataPort, uint16_t controlPort, uint16_t mousePort)
+{
+    plist_t root = plist_new_dict();
+
+    plist_t streams = plist_new_array();
+    plist_t streamItem = plist_new_dict();
+    plist_dict_set_item(streamItem, "type", plist_new_uint(static_cast<uint64_t>(96)));
+    plist_dict_set_item(streamItem, "dataPort", plist_new_uint(static_cast<uint64_t>(dataPort)));
+    plist_dict_set_item(streamItem, "controlPort", plist_new_uint(static_cast<uint64_t>(controlPort)));
+    plist_dict_set_item(streamItem, "mousePort", plist_new_uint(static_cast<uint64_t>(mousePort)));
+    plist_array_append_item(streams, streamItem);
+    plist_dict_set_item(root, "streams", streams);
+
+    std::string out = SerializePlist(root);
+    plist_free(root);
+    return out;
+}
+
+// 找到占位值唯一出现的位置（返回值字节的偏移），不唯一时不能安全改写
+static bool FindUniqueUint16(const std::string& bytes, uint16_t value, size_t& offset)
+{
+    const char pattern[3] = {
+        static_cast<char>(kBplistUint16Marker),
+        static_cast<char>(value >> 8),
+        static_cast<char>(value & 0xFF),
+    };
+
+    const size_t first = bytes.find(pattern, 0, sizeof(pattern));
+    if (first == std::string::npos) {
+        return false;
+    }
+    if (bytes.find(pattern, first + 1, sizeof(pattern)) != std::string::npos) {
+        return false;
+    }
+
+    offset = first + 1;
+    return true;
+}
+
+static void WriteUint16BE(std::string& bytes, size_t offset, uint16_t value)
+{
+    bytes[offset] = static_cast<char>(value >> 8);
+    bytes[offset + 1] = static_cast<char>(value & 0xFF);
+}
+
+static void AppendNumber(std::string& out, uint64_t value)
+{
+    char digits[24];
+    size_t n = 0;
+    do {
+        digits[n++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+
+    while (n > 0) {
+        out.push_back(digits[--n]);
+    }
+}
+
+static void AppendSigned(std::string& out, int64_t value)
+{
+    if (value < 0) {
+        out.push_back('-');
+        AppendNumber(out, 0 - static_cast<uint64_t>(value));
+    } else {
+        AppendNumber(out, static_cast<uint64_t>(value));
+    }
+}
+
+} // namespace
+
+bool ESReplyParams::operator==(const ESReplyParams& other) const
+{
+    return videoPort == other.videoPort &&
+           dataPort == other.dataPort &&
+           controlPort == other.controlPort &&
+           mousePort == other.mousePort &&
+           framerate == other.framerate &&
+           width == other.width &&
+           height == other.height &&
+           feature == other.feature &&
+           videoFormat == other.videoFormat;
+}
+
+ESReplyCache::ESReplyCache()
+{
+    m_serverInfo =
+        "{\"feature\":\"0x3001bf\","
+        "\"name\":\"Newline-7465\","
+        "\"version\":20260113,"
+        "\"pin\":\"27115282\","
+        "\"airPlay\":\"CD:49:0D:D4:41:A1\","
+        "\"airPlayFeature\":\"0x527FFFF6,0x1E\","
+        "\"webPort\":8000,"
+        "\"rotation\":0,"
+        "\"id\":\"EC74CD34EFEA\"}";
+
+    m_dongleConnected = "Newline-7465\n3.0.1.320\n";
+
+    m_clientInfo =
+        "{\"boardExists\":0,"
+        "\"flavor\":\"eshareall\","
+        "\"macAddress\":\"EC74CD34EFEA\","
+        "\"replyClientInfo\":\"N\","
+        "\"rotation\":0,"
+        "\"serverHttpPort\":8000,"
+        "\"versionName\":\"v7.7.0113\","
+        "\"deviceName\":\"Newline-7465\","
+        "\"supportMirror\":1,"
+        "\"versionCode\":20260113,"
+        "\"platform\":\"\\u003cRockchip3588\\u003e\"}";
+
+    m_optionsTail =
+        "{\"Framerate\":\"30\","
+        "\"idr_req\":\"0\","
+        "\"casting_win_height\":\"2160\","
+        "\"feature\":\"1\","
+        "\"Castnum\":\"1\","
+        "\"casting_win_width\":\"3840\","
+        "\"exclusive_screen\":\"0\","
+        "\"bitrate\":\"0\","
+        "\"i-interval\":\"0\"}";
+    m_optionsTail = BuildHeadersAndBody({}, m_optionsTail);
+
+    m_teardownTail = BuildHeadersAndBody({}, {});
+    m_probeOkTail = BuildHeadersAndBody({}, R"({"byom_tx_avalible":"0"})");
+    m_probeBadTail = BuildHeadersAndBody({}, "unsupported request");
+}
+
+ESReplyCache::~ESReplyCache() = default;
+
+void ESReplyCache::SetParams(const ESReplyParams& params)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_dirty && params == m_params) {
+        return;
+    }
+
+    m_params = params;
+    m_dirty = true;
+}
+
+ESReplyParams ESReplyCache::GetParams() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_params;
+}
+
+std::string ESReplyCache::BuildHeadersAndBody(std::string_view extraHeaders, std::string_view body)
+{
+    std::string out;
+    out.reserve(extraHeaders.size() + body.size() + 32);
+    out.append(extraHeaders.data(), extraHeaders.size());
+    out += "Content-Length: ";
+    AppendNumber(out, body.size());
+    out += "\r\n\r\n";
+    out.append(body.data(), body.size());
+    return out;
+}
+
+std::string ESReplyCache::BuildRtspReply(std::string_view statusLine, std::string_view cseq,
+                                         std::string_view headersAndBody)
+{
+    std::string out;
+    out.reserve(statusLine.size() + cseq.size() + headersAndBody.size() + 16);
+    out.append(statusLine.data(), statusLine.size());
+    out += "\r\n";
+    if (!cseq.empty()) {
+        out += "CSeq: ";
+        out.append(cseq.data(), cseq.size());
+        out += "\r\n";
+    }
+    out.append(headersAndBody.data(), headersAndBody.size());
+    return out;
+}
+
+void ESReplyCache::BuildVideoTemplateLocked()
+{
+    m_videoTemplate = PlistTemplate{};
+    m_videoTemplate.bytes = BuildVideoSetupPlist(m_params, kPortSentinels[0]);
+    m_videoTemplate.portCount = 1;
+    m_videoTemplate.patchable =
+        FindUniqueUint16(m_videoTemplate.bytes, kPortSentinels[0], m_videoTemplate.portOffsets[0]);
+    ++m_rebuildCount;
+
+    m_videoTemplateFramerate = m_params.framerate;
+    m_videoTemplateWidth = m_params.width;
+    m_videoTemplateHeight = m_params.height;
+    m_videoTemplateFeature = m_params.feature;
+    m_videoTemplateFormat = m_params.videoFormat;
+}
+
+void ESReplyCache::BuildAudioTemplateLocked()
+{
+    m_audioTemplate = PlistTemplate{};
+    m_audioTemplate.bytes = BuildAudioSetupPlist(kPortSentinels[0], kPortSentinels[1], kPortSentinels[2]);
+    m_audioTemplate.portCount = 3;
+    m_audioTemplate.patchable = true;
+    for (size_t i = 0; i < m_audioTemplate.portCount; ++i) {
+        if (!FindUniqueUint16(m_audioTemplate.bytes, kPortSentinels[i], m_audioTemplate.portOffsets[i])) {
+            m_audioTemplate.patchable = false;
+        }
+    }
+    ++m_rebuildCount;
+}
+
+void ESReplyCache::RefreshLocked()
+{
+    if (!m_dirty) {
+        return;
+    }
+
+    // 视频模板里 framerate/尺寸/format 是字符串，长度会变，只能重新生成
+    if (m_videoTemplate.bytes.empty() ||
+        m_videoTemplateFramerate != m_params.framerate ||
+        m_videoTemplateWidth != m_params.width ||
+        m_videoTemplateHeight != m_params.height ||
+        m_videoTemplateFeature != m_params.feature ||
+        m_videoTemplateFormat != m_params.videoFormat) {
+        BuildVideoTemplateLocked();
+    }
+    if (m_audioTemplate.bytes.empty()) {
+        BuildAudioTemplateLocked();
+    }
+
+    // 端口 < 256 时 bplist 用 1 字节编码，长度不同不能原地改写，退回完整生成
+    std::string videoBody;
+    if (m_videoTemplate.patchable && m_params.videoPort >= 256) {
+        videoBody = m_videoTemplate.bytes;
+        WriteUint16BE(videoBody, m_videoTemplate.portOffsets[0], m_params.videoPort);
+        ++m_patchCount;
+    } else {
+        videoBody = BuildVideoSetupPlist(m_params, m_params.videoPort);
+        ++m_rebuildCount;
+    }
+
+    const uint16_t audioPorts[3] = { m_params.dataPort, m_params.controlPort, m_params.mousePort };
+    std::string audioBody;
+    if (m_audioTemplate.patchable &&
+        audioPorts[0] >= 256 && audioPorts[1] >= 256 && audioPorts[2] >= 256) {
+        audioBody = m_audioTemplate.bytes;
+        for (size_t i = 0; i < m_audioTemplate.portCount; ++i) {
+            WriteUint16BE(audioBody, m_audioTemplate.portOffsets[i], audioPorts[i]);
+        }
+        ++m_patchCount;
+    } else {
+        audioBody = BuildAudioSetupPlist(audioPorts[0], audioPorts[1], audioPorts[2]);
+        ++m_rebuildCount;
+    }
+
+    m_videoSetupTail = BuildHeadersAndBody("Content-Type: null\r\n", videoBody);
+    m_audioSetupTail = BuildHeadersAndBody("Content-Type: null\r\n", audioBody);
+    m_dirty = false;
+
+    std::cout << "[ESReplyCache] setup replies updated, videoPort=" << m_params.videoPort
+              << ", dataPort=" << m_params.dataPort
+              << ", controlPort=" << m_params.controlPort
+              << ", mousePort=" << m_params.mousePort
+              << ", video plist " << videoBody.size() << " bytes"
+              << ", audio plist " << audioBody.size() << " bytes" << std::endl;
+}
+
+std::string ESReplyCache::BuildVideoSetupReply(std::string_view cseq)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    RefreshLocked();
+    return BuildRtspReply("RTSP/1.0 200 OK", cseq, m_videoSetupTail);
+}
+
+std::string ESReplyCache::BuildAudioSetupReply(std::string_view cseq)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    RefreshLocked();
+    return BuildRtspReply("RTSP/1.0 200 OK", cseq, m_audioSetupTail);
+}
+
+std::string ESReplyCache::BuildOptionsReply(std::string_view cseq, std::string_view videoAudio)
+{
+    std::string out;
+    out.reserve(m_optionsTail.size() + cseq.size() + videoAudio.size() + 48);
+    out += "RTSP/1.0 200 OK\r\n";
+    if (!cseq.empty()) {
+        out += "CSeq: ";
+        out.append(cseq.data(), cseq.size());
+        out += "\r\n";
+    }
+    out += "Video-Audio: ";
+    out.append(videoAudio.data(), videoAudio.size());
+    out += "\r\n";
+    out += m_optionsTail;
+    return out;
+}
+
+std::string ESReplyCache::BuildTeardownReply(std::string_view cseq)
+{
+    return BuildRtspReply("RTSP/1.0 200 OK", cseq, m_teardownTail);
+}
+
+std::string ESReplyCache::BuildProbeReply(std::string_view cseq, bool supported)
+{
+    if (supported) {
+        return BuildRtspReply("RTSP/1.0 200 OK", cseq, m_probeOkTail);
+    }
+    return BuildRtspReply("RTSP/1.0 400 Bad Request", cseq, m_probeBadTail);
+}
+
+const std::string& ESReplyCache::GetServerInfoReply() const
+{
+    return m_serverInfo;
+}
+
+const std::string& ESReplyCache::GetDongleConnectedReply() const
+{
+    return m_dongleConnected;
+}
+
+const std::string& ESReplyCache::GetClientInfoReply() const
+{
+    return m_clientInfo;
+}
+
+std::string ESReplyCache::BuildHeartbeatReply(int64_t heartbeat, const ESHeartbeatTiming* timing) const
+{
+    static constexpr std::string_view kHead =
+        "{\"isModerator\":0,\"multiScreen\":1,\"radioMode\":1,\"castMode\":1,\"replyHeartbeat\":";
+    static constexpr std::string_view kTail =
+        ",\"mirrorMode\":1,\"castState\":1}";
+
+    std::string out;
+    out.reserve(kHead.size() + kTail.size() + 24 + (timing ? 96 : 0));
+    out.append(kHead.data(), kHead.size());
+    AppendSigned(out, heartbeat);
+
+    if (timing) {
+        out.append(",\"sendUs\":");
+        AppendSigned(out, timing->sendUs);
+        out.append(",\"echoUs\":");
+        AppendSigned(out, timing->echoUs);
+        out.append(",\"echoRecvUs\":");
+        AppendSigned(out, timing->echoRecvUs);
+    }
+
+    out.append(kTail.data(), kTail.size());
+    return out;
+}
+
+uint64_t ESReplyCache::GetRebuildCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_rebuildCount;
+}
+
+uint64_t ESReplyCache::GetPatchCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_patchCount;
+}
+
+} // namespace hhcast
\ No newline at end of file
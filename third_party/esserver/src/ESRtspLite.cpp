@@ -8,22 +8,25 @@ namespace hhcast {
 
 namespace {
 
-static std::string Trim(const std::string& value)
+constexpr std::string_view kHeaderTerminator = "\r\n\r\n";
+
+static bool IsSpace(char c)
 {
-    size_t begin = 0;
-    size_t end = value.size();
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
 
-    while (begin < end && std::isspace(static_cast<unsigned char>(value[begin]))) {
-        ++begin;
+static std::string_view Trim(std::string_view value)
+{
+    while (!value.empty() && IsSpace(value.front())) {
+        value.remove_prefix(1);
     }
-    while (end > begin && std::isspace(static_cast<unsigned char>(value[end - 1]))) {
-        --end;
+    while (!value.empty() && IsSpace(value.back())) {
+        value.remove_suffix(1);
     }
-
-    return value.substr(begin, end - begin);
+    return value;
 }
 
-static bool IEquals(const std::string& a, const std::string& b)
+static bool IEquals(std::string_view a, std::string_view b)
 {
     if (a.size() != b.size()) {
         return false;
@@ -38,79 +41,210 @@ static bool IEquals(const std::string& a, const std::string& b)
     return true;
 }
 
-static bool ParseContentLength(const ESRtspLiteMessage& msg, size_t& len)
+// 只接受纯数字，空值视为 0
+static bool ParseContentLength(std::string_view value, size_t& len)
 {
-    const std::string value = msg.HeaderValue("Content-Length");
-    if (value.empty()) {
-        len = 0;
-        return true;
+    value = Trim(value);
+    len = 0;
+
+    for (char c : value) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        if (len > ESRtspLiteParser::kMaxBodyBytes) {
+            return false;
+        }
+        len = len * 10 + static_cast<size_t>(c - '0');
     }
 
-    try {
-        len = static_cast<size_t>(std::stoul(Trim(value)));
-        return true;
-    } catch (...) {
-        return false;
+    return len <= ESRtspLiteParser::kMaxBodyBytes;
+}
+
+} // namespace
+
+std::string_view ESRtspLiteRequestView::HeaderValue(std::string_view key) const
+{
+    for (size_t i = 0; i < headerCount; ++i) {
+        if (IEquals(headers[i].key, key)) {
+            return headers[i].value;
+        }
     }
+    return {};
 }
 
-static bool DecodeRaw(const std::string& raw, ESRtspLiteMessage& msg, std::string* error)
+bool ESRtspLiteRequestView::IsMethod(std::string_view name) const
 {
-    msg = ESRtspLiteMessage{};
+    return IEquals(method, name);
+}
 
-    const size_t headerEnd = raw.find("\r\n\r\n");
-    if (headerEnd == std::string::npos) {
-        if (error) *error = "header terminator not found";
-        return false;
+bool ESRtspLiteParser::ParseHead(std::string_view head, HeaderSpan* spans, size_t maxSpans,
+                                 HeadInfo& info, std::string* error)
+{
+    info = HeadInfo{};
+
+    bool hasContentLength = false;
+    bool firstLine = true;
+    size_t lineBegin = 0;
+
+    while (lineBegin <= head.size()) {
+        size_t lineEnd = head.find('\n', lineBegin);
+        if (lineEnd == std::string_view::npos) {
+            lineEnd = head.size();
+        }
+
+        std::string_view line = head.substr(lineBegin, lineEnd - lineBegin);
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+
+        if (firstLine) {
+            if (line.empty()) {
+                if (error) *error = "empty start line";
+                return false;
+            }
+
+            info.startLineLength = line.size();
+            const size_t space = line.find(' ');
+            info.methodLength = (space == std::string_view::npos) ? line.size() : space;
+            firstLine = false;
+        } else {
+            const size_t colon = line.find(':');
+            if (colon != std::string_view::npos) {
+                const std::string_view key = Trim(line.substr(0, colon));
+                const std::string_view value = Trim(line.substr(colon + 1));
+
+                if (!hasContentLength && IEquals(key, "Content-Length")) {
+                    if (!ParseContentLength(value, info.contentLength)) {
+                        if (error) *error = "invalid Content-Length";
+                        return false;
+                    }
+                    hasContentLength = true;
+                }
+
+                if (info.headerCount >= maxSpans) {
+                    if (error) *error = "too many headers";
+                    return false;
+                }
+
+                HeaderSpan& span = spans[info.headerCount++];
+                span.keyOffset = static_cast<uint32_t>(key.data() - head.data());
+                span.keyLength = static_cast<uint32_t>(key.size());
+                span.valueOffset = static_cast<uint32_t>(value.data() - head.data());
+                span.valueLength = static_cast<uint32_t>(value.size());
+            }
+        }
+
+        lineBegin = lineEnd + 1;
     }
 
-    const std::string headerPart = raw.substr(0, headerEnd);
-    msg.body = raw.substr(headerEnd + 4);
+    return true;
+}
 
-    std::istringstream iss(headerPart);
-    std::string line;
+void ESRtspLiteParser::FillView(std::string_view message, size_t headerSize,
+                                const HeaderSpan* spans, const HeadInfo& info,
+                                ESRtspLiteHeaderView* headers, ESRtspLiteRequestView& view)
+{
+    for (size_t i = 0; i < info.headerCount; ++i) {
+        headers[i].key = message.substr(spans[i].keyOffset, spans[i].keyLength);
+        headers[i].value = message.substr(spans[i].valueOffset, spans[i].valueLength);
+    }
 
-    if (!std::getline(iss, line)) {
-        if (error) *error = "empty start line";
-        return false;
+    view.raw = message;
+    view.startLine = message.substr(0, info.startLineLength);
+    view.method = message.substr(0, info.methodLength);
+    view.body = message.substr(headerSize, info.contentLength);
+    view.headers = headers;
+    view.headerCount = info.headerCount;
+    view.contentLength = info.contentLength;
+}
+
+void ESRtspLiteParser::ConsumePending()
+{
+    if (m_consumePending == 0) {
+        return;
     }
 
-    if (!line.empty() && line.back() == '\r') {
-        line.pop_back();
+    m_begin += m_consumePending;
+    m_scanPos = m_begin;
+    m_consumePending = 0;
+    m_headerParsed = false;
+    m_headerSize = 0;
+}
+
+void ESRtspLiteParser::Append(const char* data, size_t size)
+{
+    ConsumePending();
+
+    // 已消费的前缀超过一半时整理，复用原有容量
+    if (m_begin > 0 && m_begin >= m_buffer.size() / 2) {
+        m_buffer.erase(0, m_begin);
+        m_scanPos -= m_begin;
+        m_begin = 0;
     }
-    msg.startLine = line;
 
-    while (std::getline(iss, line)) {
-        if (!line.empty() && line.back() == '\r') {
-            line.pop_back();
-        }
+    if (data != nullptr && size > 0) {
+        m_buffer.append(data, size);
+    }
+}
 
-        const size_t pos = line.find(':');
+ESRtspLiteParseResult ESRtspLiteParser::Next(ESRtspLiteRequestView& view, std::string* error)
+{
+    ConsumePending();
+
+    if (!m_headerParsed) {
+        // 结束符可能跨两次读取，从上次扫描末尾回退 3 字节继续找
+        const size_t pos = m_buffer.find(kHeaderTerminator.data(), m_scanPos, kHeaderTerminator.size());
         if (pos == std::string::npos) {
-            continue;
+            if (m_buffer.size() - m_begin > kMaxHeaderBytes) {
+                if (error) *error = "header too large";
+                return ESRtspLiteParseResult::Error;
+            }
+
+            const size_t rescan = kHeaderTerminator.size() - 1;
+            m_scanPos = std::max(m_begin, (m_buffer.size() > rescan) ? m_buffer.size() - rescan : 0);
+            return ESRtspLiteParseResult::NeedMore;
         }
 
-        ESRtspLiteHeader header;
-        header.key = Trim(line.substr(0, pos));
-        header.value = Trim(line.substr(pos + 1));
-        msg.headers.push_back(header);
-    }
+        const std::string_view head(m_buffer.data() + m_begin, pos - m_begin);
+        if (!ParseHead(head, m_spans.data(), m_spans.size(), m_head, error)) {
+            return ESRtspLiteParseResult::Error;
+        }
 
-    size_t contentLength = 0;
-    if (!ParseContentLength(msg, contentLength)) {
-        if (error) *error = "invalid Content-Length";
-        return false;
+        m_headerSize = pos + kHeaderTerminator.size() - m_begin;
+        m_headerParsed = true;
     }
 
-    if (msg.body.size() != contentLength) {
-        if (error) *error = "body length mismatch";
-        return false;
+    const size_t totalSize = m_headerSize + m_head.contentLength;
+    if (m_buffer.size() - m_begin < totalSize) {
+        return ESRtspLiteParseResult::NeedMore;
     }
 
-    return true;
+    const std::string_view message(m_buffer.data() + m_begin, totalSize);
+    FillView(message, m_headerSize, m_spans.data(), m_head, m_headers.data(), view);
+
+    m_consumePending = totalSize;
+    return ESRtspLiteParseResult::Complete;
 }
 
-} // namespace
+void ESRtspLiteParser::Reset()
+{
+    m_buffer.clear();
+    m_begin = 0;
+    m_scanPos = 0;
+    m_consumePending = 0;
+    m_headerParsed = false;
+    m_headerSize = 0;
+}
+
+size_t ESRtspLiteParser::GetBufferedSize() const
+{
+    return m_buffer.size() - m_begin - m_consumePending;
+}
+
+std::string_view ESRtspLiteParser::GetBuffered() const
+{
+    return std::string_view(m_buffer).substr(m_begin + m_consumePending);
+}
 
 std::string ESRtspLiteMessage::HeaderValue(const std::string& key) const
 {
@@ -138,59 +272,32 @@ bool ESRtspLiteCodec::TryDecode(std::string& buffer,
                                 std::string* rawMsg,
                                 std::string* error)
 {
-    const size_t headerEnd = buffer.find("\r\n\r\n");
-    if (headerEnd == std::string::npos) {
+    const size_t pos = buffer.find(kHeaderTerminator.data(), 0, kHeaderTerminator.size());
+    if (pos == std::string::npos) {
         return false;
     }
 
-    const std::string headerPart = buffer.substr(0, headerEnd);
-    std::istringstream iss(headerPart);
-    std::string startLine;
-    std::getline(iss, startLine);
-
-    ESRtspLiteMessage headerOnly;
-    std::string fakeRaw = buffer.substr(0, headerEnd + 4);
-    std::string parseError;
-    if (!DecodeRaw(fakeRaw, headerOnly, &parseError)) {
-        // fakeRaw body 为空，DecodeRaw 可能因为 Content-Length 不匹配失败
-        // 所以这里单独解析 Content-Length
-        headerOnly = ESRtspLiteMessage{};
-        std::string line;
-        std::istringstream hss(headerPart);
-
-        if (!std::getline(hss, line)) {
-            if (error) *error = "empty start line";
-            return false;
-        }
-        if (!line.empty() && line.back() == '\r') line.pop_back();
-        headerOnly.startLine = line;
-
-        while (std::getline(hss, line)) {
-            if (!line.empty() && line.back() == '\r') line.pop_back();
-            size_t pos = line.find(':');
-            if (pos == std::string::npos) continue;
-            headerOnly.headers.push_back({ Trim(line.substr(0, pos)), Trim(line.substr(pos + 1)) });
-        }
-    }
-
-    size_t contentLength = 0;
-    if (!ParseContentLength(headerOnly, contentLength)) {
-        if (error) *error = "invalid Content-Length";
+    ESRtspLiteParser::HeaderSpan spans[ESRtspLiteParser::kMaxHeaders];
+    ESRtspLiteParser::HeadInfo info;
+    if (!ESRtspLiteParser::ParseHead(std::string_view(buffer.data(), pos),
+                                     spans, ESRtspLiteParser::kMaxHeaders, info, error)) {
         return false;
     }
 
-    const size_t totalSize = headerEnd + 4 + contentLength;
+    const size_t headerSize = pos + kHeaderTerminator.size();
+    const size_t totalSize = headerSize + info.contentLength;
     if (buffer.size() < totalSize) {
         return false;
     }
 
-    std::string raw = buffer.substr(0, totalSize);
-    if (!DecodeSingle(raw, msg, error)) {
-        return false;
-    }
+    ESRtspLiteHeaderView headers[ESRtspLiteParser::kMaxHeaders];
+    ESRtspLiteRequestView view;
+    ESRtspLiteParser::FillView(std::string_view(buffer.data(), totalSize), headerSize,
+                               spans, info, headers, view);
+    ToMessage(view, msg);
 
     if (rawMsg) {
-        *rawMsg = raw;
+        rawMsg->assign(buffer.data(), totalSize);
     }
 
     buffer.erase(0, totalSize);
@@ -201,7 +308,45 @@ bool ESRtspLiteCodec::DecodeSingle(const std::string& rawMsg,
                                    ESRtspLiteMessage& msg,
                                    std::string* error)
 {
-    return DecodeRaw(rawMsg, msg, error);
+    msg = ESRtspLiteMessage{};
+
+    const size_t pos = rawMsg.find(kHeaderTerminator.data(), 0, kHeaderTerminator.size());
+    if (pos == std::string::npos) {
+        if (error) *error = "header terminator not found";
+        return false;
+    }
+
+    ESRtspLiteParser::HeaderSpan spans[ESRtspLiteParser::kMaxHeaders];
+    ESRtspLiteParser::HeadInfo info;
+    if (!ESRtspLiteParser::ParseHead(std::string_view(rawMsg.data(), pos),
+                                     spans, ESRtspLiteParser::kMaxHeaders, info, error)) {
+        return false;
+    }
+
+    const size_t headerSize = pos + kHeaderTerminator.size();
+    if (rawMsg.size() - headerSize != info.contentLength) {
+        if (error) *error = "body length mismatch";
+        return false;
+    }
+
+    ESRtspLiteHeaderView headers[ESRtspLiteParser::kMaxHeaders];
+    ESRtspLiteRequestView view;
+    ESRtspLiteParser::FillView(rawMsg, headerSize, spans, info, headers, view);
+    ToMessage(view, msg);
+    return true;
+}
+
+void ESRtspLiteCodec::ToMessage(const ESRtspLiteRequestView& view, ESRtspLiteMessage& msg)
+{
+    msg.startLine.assign(view.startLine.data(), view.startLine.size());
+
+    msg.headers.clear();
+    msg.headers.reserve(view.headerCount);
+    for (size_t i = 0; i < view.headerCount; ++i) {
+        msg.headers.push_back({ std::string(view.headers[i].key), std::string(view.headers[i].value) });
+    }
+
+    msg.body.assign(view.body.data(), view.body.size());
 }
 
 std::string ESRtspLiteCodec::Encode(const ESRtspLiteMessage& msg)
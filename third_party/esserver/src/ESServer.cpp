@@ -1,18 +1,71 @@
 #include "ESServer.h"
+#include "ESConnectionContext.h"
+#include "ESHandoff.h"
+#include "ESJsonLineScanner.h"
+#include "ESMulticastPublisher.h"
 #include "ESPortManager.h"
+#include "ESReplyCache.h"
 #include "ESSession.h"
 #include "ESRtspLite.h"
+#include "ESUtils.h"
+#include "hv/EventLoopThread.h"
 #include <plist/plist.h>
 
+#include <algorithm>
 #include <cctype>
 #include <iostream>
 #include <sstream>
+#include <string_view>
 #include <vector>
 
 namespace hhcast {
 
 namespace {
 
+// 当前线程正在攒的一批媒体，只属于 owner 这一个服务端
+struct MediaBatchState {
+    const ESServer* owner = nullptr;
+    int depth = 0;
+    std::vector<ESVideoEvent> video;
+    std::vector<ESAudioEvent> audio;
+    std::vector<size_t> audioOffsets;
+    std::vector<uint8_t> audioArena;
+};
+
+thread_local MediaBatchState t_mediaBatch;
+
+// 日志里按点分格式打印主机字节序的 IPv4，不为每个 datagram 构造字符串
+struct IpText {
+    uint32_t ip;
+};
+
+std::ostream& operator<<(std::ostream& os, IpText value)
+{
+    return os << (value.ip >> 24) << '.' << ((value.ip >> 16) & 0xff) << '.'
+              << ((value.ip >> 8) & 0xff) << '.' << (value.ip & 0xff);
+}
+
+// 一次批量回调的 CPU 时间按事件数平摊到所属会话
+void ChargeDispatchCpu(const ESMediaBatch& batch, uint64_t cpuNs)
+{
+    const size_t events = batch.video.Size() + batch.audio.Size();
+    if (events == 0) {
+        return;
+    }
+
+    const uint64_t share = cpuNs / events;
+    for (const auto& event : batch.video) {
+        if (event.session) {
+            event.session->AddDispatchCpuNs(share);
+        }
+    }
+    for (const auto& event : batch.audio) {
+        if (event.session) {
+            event.session->AddDispatchCpuNs(share);
+        }
+    }
+}
+
 static std::string Trim(const std::string& value)
 {
     size_t begin = 0;
@@ -47,144 +100,7 @@ static std::string GetHeaderValue(const std::string& request, const std::string&
     return "";
 }
 
-static std::string BuildRtspResponse(int statusCode,
-                                     const std::string& statusText,
-                                     const std::string& cseq,
-                                     const std::string& body)
-{
-    std::ostringstream oss;
-    oss << "RTSP/1.0 " << statusCode << " " << statusText << "\r\n";
-    if (!cseq.empty()) {
-        oss << "CSeq: " << cseq << "\r\n";
-    }
-    oss << "Content-Length: " << body.size() << "\r\n";
-    oss << "\r\n";
-    oss << body;
-    return oss.str();
-}
-
-static std::vector<std::string> SplitNonEmptyLines(const std::string& text)
-{
-    std::vector<std::string> lines;
-    std::istringstream iss(text);
-    std::string line;
-
-    while (std::getline(iss, line)) {
-        line = Trim(line);
-        if (!line.empty()) {
-            lines.push_back(line);
-        }
-    }
-
-    return lines;
-}
-
-static uint32_t IPToStreamID(const std::string& ip)
-{
-    std::istringstream iss(ip);
-    std::string token;
-    uint32_t parts[4] = { 0 };
-    int index = 0;
-
-    while (std::getline(iss, token, '.')) {
-        if (index >= 4) {
-            return 0;
-        }
-
-        token = Trim(token);
-        if (token.empty()) {
-            return 0;
-        }
-
-        for (char ch : token) {
-            if (!std::isdigit(static_cast<unsigned char>(ch))) {
-                return 0;
-            }
-        }
-
-        int value = std::stoi(token);
-        if (value < 0 || value > 255) {
-            return 0;
-        }
-
-        parts[index++] = static_cast<uint32_t>(value);
-    }
-
-    if (index != 4) {
-        return 0;
-    }
-
-    return (parts[0] << 24) | (parts[1] << 16) | (parts[2] << 8) | parts[3];
-}
-
-static bool GetJsonStringValue(const std::string& json, const std::string& key, std::string& value)
-{
-    const std::string pattern = "\"" + key + "\"";
-    size_t pos = json.find(pattern);
-    if (pos == std::string::npos) {
-        return false;
-    }
-
-    pos = json.find(':', pos + pattern.size());
-    if (pos == std::string::npos) {
-        return false;
-    }
-
-    ++pos;
-    while (pos < json.size() && std::isspace(static_cast<unsigned char>(json[pos]))) {
-        ++pos;
-    }
-
-    if (pos >= json.size() || json[pos] != '"') {
-        return false;
-    }
-
-    ++pos;
-    size_t end = json.find('"', pos);
-    if (end == std::string::npos) {
-        return false;
-    }
-
-    value = json.substr(pos, end - pos);
-    return true;
-}
-
-static bool GetJsonIntValue(const std::string& json, const std::string& key, int& value)
-{
-    const std::string pattern = "\"" + key + "\"";
-    size_t pos = json.find(pattern);
-    if (pos == std::string::npos) {
-        return false;
-    }
-
-    pos = json.find(':', pos + pattern.size());
-    if (pos == std::string::npos) {
-        return false;
-    }
-
-    ++pos;
-    while (pos < json.size() && std::isspace(static_cast<unsigned char>(json[pos]))) {
-        ++pos;
-    }
-
-    size_t end = pos;
-    if (end < json.size() && (json[end] == '-' || json[end] == '+')) {
-        ++end;
-    }
-
-    while (end < json.size() && std::isdigit(static_cast<unsigned char>(json[end]))) {
-        ++end;
-    }
-
-    if (end == pos) {
-        return false;
-    }
-
-    value = std::stoi(json.substr(pos, end - pos));
-    return true;
-}
-
-static bool IsBinaryPlistBody(const std::string& body)
+static bool IsBinaryPlistBody(std::string_view body)
 {
     return body.size() >= 8 && body.compare(0, 8, "bplist00") == 0;
 }
@@ -209,7 +125,7 @@ static void PrintPlistXml(plist_t root, const std::string& tag)
     }
 }
 
-static void TryPrintBinaryPlistXml(const std::string& bin, const std::string& tag)
+static void TryPrintBinaryPlistXml(std::string_view bin, const std::string& tag)
 {
     if (bin.empty()) {
         return;
@@ -226,7 +142,7 @@ static void TryPrintBinaryPlistXml(const std::string& bin, const std::string& ta
     plist_free(root);
 }
 
-static std::string GetVideoAudioByCSeq(const std::string& cseq)
+static const char* GetVideoAudioByCSeq(std::string_view cseq)
 {
     if (cseq == "0" || cseq == "1") return "0-0";
     if (cseq == "2") return "48-0";
@@ -235,79 +151,6 @@ static std::string GetVideoAudioByCSeq(const std::string& cseq)
     return "0-0";
 }
 
-static std::string BuildVideoSetupPlist(uint16_t videoPort,
-                                        int framerate,
-                                        int width,
-                                        int height,
-                                        const std::string& feature,
-                                        const std::string& format)
-{
-    plist_t root = plist_new_dict();
-
-    plist_t streams = plist_new_array();
-    plist_t streamItem = plist_new_dict();
-    plist_dict_set_item(streamItem, "type", plist_new_uint(static_cast<uint64_t>(110)));
-    plist_dict_set_item(streamItem, "dataPort", plist_new_uint(static_cast<uint64_t>(videoPort)));
-    plist_array_append_item(streams, streamItem);
-    plist_dict_set_item(root, "streams", streams);
-
-    plist_dict_set_item(root, "feature", plist_new_string(feature.c_str()));
-    plist_dict_set_item(root, "Framerate", plist_new_string(std::to_string(framerate).c_str()));
-    plist_dict_set_item(root, "casting_win_width", plist_new_string(std::to_string(width).c_str()));
-    plist_dict_set_item(root, "casting_win_height", plist_new_string(std::to_string(height).c_str()));
-    plist_dict_set_item(root, "format", plist_new_string(format.c_str()));
-
-    PrintPlistXml(root, "[ESServer][TCP][51040] video setup plist xml:");
-
-    char* bin = nullptr;
-    uint32_t len = 0;
-    plist_to_bin(root, &bin, &len);
-
-    std::string out;
-    if (bin && len > 0) {
-        out.assign(bin, bin + len);
-    }
-
-    if (bin) {
-        plist_mem_free(bin);
-    }
-    plist_free(root);
-    return out;
-}
-
-static std::string BuildAudioSetupPlist(uint16_t dataPort,
-                                        uint16_t controlPort,
-                                        uint16_t mousePort)
-{
-    plist_t root = plist_new_dict();
-
-    plist_t streams = plist_new_array();
-    plist_t streamItem = plist_new_dict();
-    plist_dict_set_item(streamItem, "type", plist_new_uint(static_cast<uint64_t>(96)));
-    plist_dict_set_item(streamItem, "dataPort", plist_new_uint(static_cast<uint64_t>(dataPort)));
-    plist_dict_set_item(streamItem, "controlPort", plist_new_uint(static_cast<uint64_t>(controlPort)));
-    plist_dict_set_item(streamItem, "mousePort", plist_new_uint(static_cast<uint64_t>(mousePort)));
-    plist_array_append_item(streams, streamItem);
-    plist_dict_set_item(root, "streams", streams);
-
-    PrintPlistXml(root, "[ESServer][TCP][51040] audio setup plist xml:");
-
-    char* bin = nullptr;
-    uint32_t len = 0;
-    plist_to_bin(root, &bin, &len);
-
-    std::string out;
-    if (bin && len > 0) {
-        out.assign(bin, bin + len);
-    }
-
-    if (bin) {
-        plist_mem_free(bin);
-    }
-    plist_free(root);
-    return out;
-}
-
 static std::string BuildOptionsJson(int framerate, int width, int height)
 {
     std::ostringstream oss;
@@ -330,6 +173,8 @@ ESServer::ESServer()
 {
     m_portManager = std::make_unique<ESPortManager>();
     m_portManager->SetServer(this);
+    m_multicastPublisher = std::make_unique<ESMulticastPublisher>();
+    m_replyCache = std::make_unique<ESReplyCache>();
 }
 
 ESServer::~ESServer()
@@ -343,13 +188,86 @@ int ESServer::StartServer()
         return 0;
     }
 
+    if (m_config.multicast.enabled) {
+        int ret = m_multicastPublisher->Start(m_config.multicast);
+        if (ret != 0) {
+            std::cout << "[ESServer] start multicast failed, ret=" << ret << std::endl;
+            return ret;
+        }
+    }
+
+    m_portManager->SetUdpReceiveConfig(m_config.udpReceive);
+
+    // io_uring 上的连接没法挂到 hv loop 里暂停和交接
+    ESVideoReceiveConfig videoReceive = m_config.videoReceive;
+    if (m_config.handoff.enabled && videoReceive.backend == ESVideoBackend::IoUring) {
+        std::cout << "[ESServer] handoff enabled, video backend falls back to hv" << std::endl;
+        videoReceive.backend = ESVideoBackend::Hv;
+    }
+    m_portManager->SetVideoReceiveConfig(videoReceive);
+    m_portManager->SetEventLoopConfig(m_config.eventLoop);
+    m_portManager->SetSocketConfig(m_config.socket);
+    m_portManager->SetAdmissionConfig(m_config.admission);
+
+    // 有旧进程就先接手：会话要在连接接管前建好，视频半帧才能续上
+    ESHandoffLink handoffLink;
+    ESHandoffState handoffState;
+    const bool adopting = m_config.handoff.enabled && ReceiveHandoff(handoffLink, handoffState) == 0;
+    m_handedOff = false;
+    if (adopting) {
+        RestoreSessions(handoffState);
+        m_portManager->SetHandoffState(&handoffState);
+    } else if (m_inheritedSockets) {
+        m_portManager->SetHandoffState(m_inheritedSockets);
+    }
+
     int ret = m_portManager->Start();
+    m_portManager->SetHandoffState(nullptr);
+    m_inheritedSockets = nullptr;
     if (ret != 0) {
+        if (adopting) {
+            // 旧进程收到拒绝后恢复读取，恢复出来的会话还没通知过上层，直接丢弃
+            handoffLink.SendAck(false);
+            for (const auto& item : m_sessions.TakeAll()) {
+                item.second->MarkClosed();
+            }
+        }
+        m_multicastPublisher->Stop();
         return ret;
     }
 
+    if (adopting) {
+        if (handoffLink.SendAck(true) != 0) {
+            std::cout << "[ESServer] handoff ack failed, predecessor may have exited" << std::endl;
+        }
+        handoffLink.Close();
+
+        if (m_callback) {
+            for (const auto& item : handoffState.sessions) {
+                auto session = GetSession(item.streamId);
+                if (session) {
+                    NotifySessionOpen(session, session->GetPeerIp(), true);
+                }
+            }
+        }
+    }
+
+    StartSessionReaper();
+
+    if (m_config.handoff.enabled) {
+        if (!m_handoffListener) {
+            m_handoffListener = std::make_unique<ESHandoffListener>();
+        }
+        ret = m_handoffListener->Start(m_config.handoff.socketPath, [this](ESHandoffLink& link) {
+            HandleHandoffRequest(link);
+        });
+        if (ret != 0) {
+            std::cout << "[ESServer] handoff listener start failed, ret=" << ret << std::endl;
+        }
+    }
+
     m_running = true;
-    std::cout << "[ESServer] started" << std::endl;
+    std::cout << "[ESServer] started" << (adopting ? " (adopted from predecessor)" : "") << std::endl;
     return 0;
 }
 
@@ -359,8 +277,15 @@ int ESServer::StopServer()
         return 0;
     }
 
+    // 可能在 OnHandedOff 里调用，此时就在交接线程上；对象留着，线程自行退出
+    if (m_handoffListener) {
+        m_handoffListener->Stop();
+    }
+
     m_portManager->Stop();
+    StopSessionReaper();
     ClearSessions();
+    m_multicastPublisher->Stop();
 
     m_running = false;
     std::cout << "[ESServer] stopped" << std::endl;
@@ -369,7 +294,26 @@ int ESServer::StopServer()
 
 void ESServer::SetCallback(std::shared_ptr<IESServerCallback> callback)
 {
-    m_callback = callback;
+    if (callback) {
+        m_callback = std::make_shared<ESServerCallbackAdapter>(std::move(callback));
+    } else {
+        m_callback = nullptr;
+    }
+}
+
+void ESServer::SetCallbackV2(std::shared_ptr<IESServerCallbackV2> callback)
+{
+    m_callback = std::move(callback);
+}
+
+void ESServer::SetConfig(const ESServerConfig& config)
+{
+    m_config = config;
+}
+
+const ESServerConfig& ESServer::GetConfig() const
+{
+    return m_config;
 }
 
 bool ESServer::IsRunning() const
@@ -377,6 +321,76 @@ bool ESServer::IsRunning() const
     return m_running.load();
 }
 
+uint16_t ESServer::GetAudioDataPort() const
+{
+    return m_portManager->GetDataPort();
+}
+
+uint16_t ESServer::GetAudioControlPort() const
+{
+    return m_portManager->GetControlPort();
+}
+
+int ESServer::SetSessionTimeout(uint32_t streamId, uint32_t heartbeatTimeoutMs, uint32_t mediaTimeoutMs)
+{
+    auto session = GetSession(streamId);
+    if (!session) {
+        return -1;
+    }
+
+    ESSessionTimeoutConfig config = m_config.sessionTimeout;
+    config.heartbeatTimeoutMs = heartbeatTimeoutMs;
+    config.mediaTimeoutMs = mediaTimeoutMs;
+    session->SetTimeoutConfig(config);
+
+    // 到期时按新值重新计算，这里只需尽快检查一次
+    ScheduleSessionCheck(streamId, 0);
+    return 0;
+}
+
+int ESServer::GetSessionClockSync(uint32_t streamId, ESClockSyncStats& stats)
+{
+    auto session = GetSession(streamId);
+    if (!session) {
+        return -1;
+    }
+
+    stats = session->GetClockSyncStats();
+    return 0;
+}
+
+ESAdmissionStats ESServer::GetAdmissionStats() const
+{
+    return m_portManager->GetAdmissionStats();
+}
+
+size_t ESServer::GetSessionCount() const
+{
+    return m_sessions.Size();
+}
+
+int ESServer::GetSessionResources(uint32_t streamId, ESSessionResourceStats& stats)
+{
+    auto session = GetSession(streamId);
+    if (!session) {
+        return -1;
+    }
+
+    session->GetResourceStats(stats);
+    return 0;
+}
+
+std::vector<ESSessionResourceStats> ESServer::GetResourceSnapshot() const
+{
+    std::lock_guard<std::mutex> lock(m_resourceMutex);
+    return m_resourceSnapshot;
+}
+
+void ESServer::SetInheritedSockets(ESHandoffState* state)
+{
+    m_inheritedSockets = state;
+}
+
 void ESServer::OnTcpConnected(uint16_t localPort, const std::string& peerIp)
 {
     std::cout << "[ESServer][TCP][" << localPort << "] connected: " << peerIp << std::endl;
@@ -393,60 +407,55 @@ void ESServer::OnTcpDisconnected(uint16_t localPort, const std::string& peerIp)
             return;
         }
 
-        auto session = GetSession(streamId);
-        if (session) {
-            if (m_callback) {
-                m_callback->OnDisconnect(streamId);
-            }
-            RemoveSession(streamId);
-        }
+        CloseSession(streamId, ESSessionCloseCause::PeerClosed);
     }
 }
 
-void ESServer::OnTcpData(uint16_t localPort,
-                         const std::string& peerIp,
-                         const uint8_t* data,
-                         size_t size)
+void ESServer::OnVideoTcpData(ESConnectionContext& context, const uint8_t* data, size_t size)
 {
     if (data == nullptr || size == 0) {
         return;
     }
 
-    std::cout << "[ESServer][TCP][" << localPort << "] recv "
-              << size << " bytes from " << peerIp << std::endl;
+    std::cout << "[ESServer][TCP][51030] recv "
+              << size << " bytes from " << context.peerIpText << std::endl;
 
-    if (localPort != 51030) {
+    if (context.peerIp == 0) {
+        std::cout << "[ESServer][TCP][51030] invalid peer ip: "
+                  << context.peerIpText << std::endl;
         return;
     }
 
-    const uint32_t streamId = IPToStreamID(peerIp);
-    if (streamId == 0) {
-        std::cout << "[ESServer][TCP][51030] invalid peer ip: "
-                  << peerIp << std::endl;
-        return;
+    // 会话查找只在连接第一个包或会话换代后发生，平时直接用缓存
+    std::shared_ptr<ESSession> session = context.session.lock();
+    if (!session || session->IsClosed()) {
+        session = GetSession(context.peerIp);
+        context.session = session;
     }
 
-    auto session = GetSession(streamId);
     if (!session) {
         std::cout << "[ESServer][TCP][51030] session not found, drop video, streamId="
-                  << streamId << ", peerIp=" << peerIp << std::endl;
+                  << context.peerIp << ", peerIp=" << context.peerIpText << std::endl;
         return;
     }
 
+    // 一次读到的数据可能切出多个单元，攒成一批回调
+    MediaBatchScope batchScope(*this);
     session->InputVideoTcpData(data, size);
 }
 
 void ESServer::OnUdpData(uint16_t localPort,
-                         const std::string& peerIp,
+                         uint32_t peerIp,
                          const uint8_t* data,
-                         size_t size)
+                         size_t size,
+                         uint64_t rxTimestampUs)
 {
     if (data == nullptr || size == 0) {
         return;
     }
 
     std::cout << "[ESServer][UDP][" << localPort << "] recv "
-              << size << " bytes from " << peerIp << std::endl;
+              << size << " bytes from " << IpText{ peerIp } << std::endl;
 
     if (m_portManager == nullptr) {
         return;
@@ -457,10 +466,10 @@ void ESServer::OnUdpData(uint16_t localPort,
     const uint16_t mousePort = m_portManager->GetMousePort();
 
     if (localPort == dataPort) {
-        const uint32_t streamId = IPToStreamID(peerIp);
+        const uint32_t streamId = peerIp;
         if (streamId == 0) {
             std::cout << "[ESServer][UDP][" << localPort
-                      << "] invalid peer ip: " << peerIp << std::endl;
+                      << "] invalid peer ip: " << IpText{ peerIp } << std::endl;
             return;
         }
 
@@ -468,17 +477,25 @@ void ESServer::OnUdpData(uint16_t localPort,
         if (!session) {
             std::cout << "[ESServer][UDP][" << localPort
                       << "] session not found, drop audio, streamId="
-                      << streamId << ", peerIp=" << peerIp << std::endl;
+                      << streamId << ", peerIp=" << IpText{ peerIp } << std::endl;
             return;
         }
 
-        session->InputAudioUdpDatagram(data, size);
+        MediaBatchScope batchScope(*this);
+        session->InputAudioUdpDatagram(data, size, rxTimestampUs);
         return;
     }
 
     if (localPort == controlPort) {
-        std::cout << "[ESServer][UDP][" << localPort
-                  << "] control data ignored for now." << std::endl;
+        auto session = GetSession(peerIp);
+        if (!session) {
+            return;
+        }
+
+        if (!session->InputAudioControlDatagram(data, size)) {
+            std::cout << "[ESServer][UDP][" << localPort
+                      << "] non-sync control data ignored." << std::endl;
+        }
         return;
     }
 
@@ -497,14 +514,10 @@ std::string ESServer::HandleTcpRequest(uint16_t localPort, const std::string& pe
     if (localPort == 8700) {
         const std::string cseq = GetHeaderValue(request, "CSeq");
 
-        std::string response;
-        if (request.find("OPTIONS") != std::string::npos &&
-            request.find("RTSP/1.0") != std::string::npos) {
-            const std::string body = R"({"byom_tx_avalible":"0"})";
-            response = BuildRtspResponse(200, "OK", cseq, body);
-        } else {
-            response = BuildRtspResponse(400, "Bad Request", cseq, "unsupported request");
-        }
+        const bool supported =
+            request.find("OPTIONS") != std::string::npos &&
+            request.find("RTSP/1.0") != std::string::npos;
+        std::string response = m_replyCache->BuildProbeReply(cseq, supported);
 
         std::cout << "[ESServer][TCP][8700] response to " << peerIp << ":\n"
                   << response << std::endl;
@@ -513,35 +526,22 @@ std::string ESServer::HandleTcpRequest(uint16_t localPort, const std::string& pe
     }
 
     if (localPort == 8121) {
-        std::vector<std::string> lines = SplitNonEmptyLines(request);
-        if (lines.size() < 3) {
+        ESEshareCommandRequest cmdReq;
+        if (!ParseEshareCommandRequest(request, cmdReq)) {
             std::cout << "[ESServer][TCP][8121] request lines not enough, wait more data" << std::endl;
             return "";
         }
 
-        const std::string& cmd = lines[0];
-        const std::string& senderName = lines[1];
-        const std::string& senderVersion = lines[2];
-
-        std::cout << "[ESServer][TCP][8121] cmd=" << cmd
-                  << ", senderName=" << senderName
-                  << ", senderVersion=" << senderVersion << std::endl;
+        std::cout << "[ESServer][TCP][8121] cmd=" << cmdReq.commandText
+                  << ", senderName=" << cmdReq.senderName
+                  << ", senderVersion=" << cmdReq.senderVersion << std::endl;
 
         std::string response;
-        if (cmd == "getServerInfo") {
-            response =
-                "{\"feature\":\"0x3001bf\","
-                "\"name\":\"Newline-7465\","
-                "\"version\":20260113,"
-                "\"pin\":\"27115282\","
-                "\"airPlay\":\"CD:49:0D:D4:41:A1\","
-                "\"airPlayFeature\":\"0x527FFFF6,0x1E\","
-                "\"webPort\":8000,"
-                "\"rotation\":0,"
-                "\"id\":\"EC74CD34EFEA\"}";
-        }
-        else if (cmd == "dongleConnected") {
-            response = "Newline-7465\n3.0.1.320\n";
+        if (cmdReq.command == ESEshareCommand::GetServerInfo) {
+            response = m_replyCache->GetServerInfoReply();
+        }
+        else if (cmdReq.command == ESEshareCommand::DongleConnected) {
+            response = m_replyCache->GetDongleConnectedReply();
         }
         else {
             response = "unsupported\n";
@@ -554,90 +554,16 @@ std::string ESServer::HandleTcpRequest(uint16_t localPort, const std::string& pe
     }
 
     if (localPort == 57395) {
-        uint32_t streamId = IPToStreamID(peerIp);
-        if (streamId == 0) {
-            std::cout << "[ESServer][TCP][57395] invalid peer ip: " << peerIp << std::endl;
-            return "";
-        }
-
-        const std::string text = Trim(request);
-
-        if (text.find("\"clientName\"") != std::string::npos &&
-            text.find("\"clientType\"") != std::string::npos) {
-            std::string clientName;
-            if (!GetJsonStringValue(text, "clientName", clientName)) {
-                std::cout << "[ESServer][TCP][57395] clientName not found" << std::endl;
-                return "";
-            }
-
-            auto session = GetSession(streamId);
-            bool isNewSession = false;
-            if (!session) {
-                session = CreateSession(streamId);
-                isNewSession = true;
-            }
-
-            session->SetPeerIp(peerIp);
-            session->SetName(clientName);
+        // 整段原始数据的兼容入口；端口管理器按行切分后直接调用 HandleEshareJsonLine
+        ESJsonLineSplitter splitter;
+        splitter.Append(request.data(), request.size());
 
-            if (isNewSession && m_callback) {
-                m_callback->OnConnect(streamId, session->GetName(), session->GetPeerIp());
-            }
-
-            std::string response =
-                "{\"boardExists\":0,"
-                "\"flavor\":\"eshareall\","
-                "\"macAddress\":\"EC74CD34EFEA\","
-                "\"replyClientInfo\":\"N\","
-                "\"rotation\":0,"
-                "\"serverHttpPort\":8000,"
-                "\"versionName\":\"v7.7.0113\","
-                "\"deviceName\":\"Newline-7465\","
-                "\"supportMirror\":1,"
-                "\"versionCode\":20260113,"
-                "\"platform\":\"\\u003cRockchip3588\\u003e\"}";
-
-            std::cout << "[ESServer][TCP][57395] client info response to " << peerIp << ":\n"
-                      << response << std::endl;
-
-            return response;
-        }
-
-        if (text.find("\"heartbeat\"") != std::string::npos) {
-            auto session = GetSession(streamId);
-            if (!session) {
-                std::cout << "[ESServer][TCP][57395] heartbeat received but session not found, streamId="
-                          << streamId << std::endl;
-                return "";
-            }
-
-            int heartbeat = 0;
-            if (!GetJsonIntValue(text, "heartbeat", heartbeat)) {
-                std::cout << "[ESServer][TCP][57395] heartbeat value not found" << std::endl;
-                return "";
-            }
-
-            std::ostringstream oss;
-            oss << "{"
-                << "\"isModerator\":0,"
-                << "\"multiScreen\":1,"
-                << "\"radioMode\":1,"
-                << "\"castMode\":1,"
-                << "\"replyHeartbeat\":" << heartbeat << ","
-                << "\"mirrorMode\":1,"
-                << "\"castState\":1"
-                << "}";
-
-            std::string response = oss.str();
-
-            std::cout << "[ESServer][TCP][57395] heartbeat response to " << peerIp << ":\n"
-                      << response << std::endl;
-
-            return response;
+        std::string response;
+        std::string_view line;
+        while (splitter.Next(line)) {
+            response += HandleEshareJsonLine(peerIp, line);
         }
-
-        std::cout << "[ESServer][TCP][57395] unsupported request" << std::endl;
-        return "";
+        return response;
     }
 
     if (localPort == 8600) {
@@ -662,110 +588,168 @@ std::string ESServer::HandleTcpRequest(uint16_t localPort, const std::string& pe
     }
 
     if (localPort == 51040) {
-        ESRtspLiteMessage req;
+        // 整条原始报文的兼容入口；端口管理器走增量解析后直接调用 HandleRtspRequest
+        ESRtspLiteParser parser;
+        parser.Append(request.data(), request.size());
+
+        ESRtspLiteRequestView req;
         std::string error;
-        if (!ESRtspLiteCodec::DecodeSingle(request, req, &error)) {
+        if (parser.Next(req, &error) != ESRtspLiteParseResult::Complete) {
             std::cout << "[ESServer][TCP][51040] decode failed: " << error << std::endl;
             return "";
         }
 
-        if (IsBinaryPlistBody(req.body)) {
-            TryPrintBinaryPlistXml(req.body, "[ESServer][TCP][51040] recv plist xml:");
+        // 调用方保证传入的是一条完整报文，多出的字节说明 Content-Length 不对
+        if (req.raw.size() != request.size()) {
+            std::cout << "[ESServer][TCP][51040] decode failed: body length mismatch" << std::endl;
+            return "";
         }
 
-        ESRtspLiteMessage resp;
-        const std::string cseq = req.HeaderValue("CSeq");
+        return HandleRtspRequest(peerIp, req);
+    }
 
-        const bool isSetup =
-            req.startLine.rfind("SETUP ", 0) == 0 ||
-            req.startLine.rfind("setup ", 0) == 0;
-        const bool isOptions =
-            req.startLine.rfind("OPTIONS ", 0) == 0 ||
-            req.startLine.rfind("options ", 0) == 0;
-        const bool isTeardown =
-            req.startLine.rfind("TEARDOWN ", 0) == 0 ||
-            req.startLine.rfind("teardown ", 0) == 0;
+    return "";
+}
 
-        if (isSetup) {
-            const bool isVideoSetup =
-                (cseq == "0") || !req.HeaderValue("VideoAspectRatio").empty();
+std::string ESServer::HandleEshareJsonLine(const std::string& peerIp, std::string_view line)
+{
+    // 计时字段里的“收到时间”，尽量靠前取
+    const int64_t recvUs = static_cast<int64_t>(GetSteadyTimeUs());
 
-            resp.startLine = "RTSP/1.0 200 OK";
-            if (!cseq.empty()) {
-                resp.SetHeader("CSeq", cseq);
-            }
-            resp.SetHeader("Content-Type", "null");
-
-            if (isVideoSetup) {
-                resp.body = BuildVideoSetupPlist(
-                    m_portManager->GetVideoPort(),
-                    30,
-                    3840,
-                    2160,
-                    "1",
-                    "video:h264");
-            } else {
-                resp.body = BuildAudioSetupPlist(
-                    m_portManager->GetDataPort(),
-                    m_portManager->GetControlPort(),
-                    m_portManager->GetMousePort());
-            }
+    std::cout << "[ESServer][TCP][57395] request from " << peerIp << ":\n"
+              << line << std::endl;
 
-            std::string response = ESRtspLiteCodec::Encode(resp);
-            std::cout << "[ESServer][TCP][51040] response to " << peerIp
-                      << " (" << (isVideoSetup ? "video setup" : "audio setup") << ")\n";
-            return response;
+    uint32_t streamId = IPToStreamID(peerIp);
+    if (streamId == 0) {
+        std::cout << "[ESServer][TCP][57395] invalid peer ip: " << peerIp << std::endl;
+        return "";
+    }
+
+    ESJsonLineScanner scanner;
+    if (!scanner.Parse(line)) {
+        std::cout << "[ESServer][TCP][57395] invalid json line" << std::endl;
+        return "";
+    }
+
+    std::string scratch;
+    ESEshareJsonMessage msg;
+    if (!ParseEshareJsonMessage(scanner, msg, &scratch)) {
+        if (scanner.Has("clientName") && scanner.Has("clientType")) {
+            std::cout << "[ESServer][TCP][57395] clientName not found" << std::endl;
+        }
+        else if (scanner.Has("heartbeat")) {
+            std::cout << "[ESServer][TCP][57395] heartbeat value not found" << std::endl;
+        }
+        else {
+            std::cout << "[ESServer][TCP][57395] unsupported request" << std::endl;
         }
+        return "";
+    }
 
-        if (isOptions) {
-            resp.startLine = "RTSP/1.0 200 OK";
-            if (!cseq.empty()) {
-                resp.SetHeader("CSeq", cseq);
-            }
-            resp.SetHeader("Video-Audio", GetVideoAudioByCSeq(cseq));
-            resp.body =
-                "{\"Framerate\":\"30\","
-                "\"idr_req\":\"0\","
-                "\"casting_win_height\":\"2160\","
-                "\"feature\":\"1\","
-                "\"Castnum\":\"1\","
-                "\"casting_win_width\":\"3840\","
-                "\"exclusive_screen\":\"0\","
-                "\"bitrate\":\"0\","
-                "\"i-interval\":\"0\"}";
-
-            std::string response = ESRtspLiteCodec::Encode(resp);
-            std::cout << "[ESServer][TCP][51040] options response to " << peerIp << std::endl;
-            return response;
+    if (msg.kind == ESEshareJsonKind::ClientInfo) {
+        auto session = GetSession(streamId);
+        bool isNewSession = false;
+        if (!session) {
+            session = CreateSession(streamId);
+            isNewSession = true;
         }
 
-        if (isTeardown) {
-            resp.startLine = "RTSP/1.0 200 OK";
-            if (!cseq.empty()) {
-                resp.SetHeader("CSeq", cseq);
-            }
-            resp.body.clear();
+        session->SetPeerIp(peerIp);
+        session->SetName(std::string(msg.clientName));
+        session->MarkHeartbeat();
+        session->ResetClockSync();
 
-            std::string response = ESRtspLiteCodec::Encode(resp);
-            std::cout << "[ESServer][TCP][51040] teardown response to " << peerIp << std::endl;
-            return response;
+        if (isNewSession && m_callback) {
+            NotifySessionOpen(session, peerIp, false);
         }
 
-        std::cout << "[ESServer][TCP][51040] unsupported request:\n" << request << std::endl;
+        const std::string& response = m_replyCache->GetClientInfoReply();
+
+        std::cout << "[ESServer][TCP][57395] client info response to " << peerIp << ":\n"
+                  << response << std::endl;
+
+        return response;
+    }
+
+    auto session = GetSession(streamId);
+    if (!session) {
+        std::cout << "[ESServer][TCP][57395] heartbeat received but session not found, streamId="
+                  << streamId << std::endl;
         return "";
     }
 
-    return "";
+    session->MarkHeartbeat();
+
+    // 发送端带了 sendUs 才回计时字段，老版本发送端收到的应答不变
+    ESHeartbeatTiming timing;
+    const ESHeartbeatTiming* replyTiming = nullptr;
+    if (msg.timing.sendUs != 0) {
+        ESClockExchange exchange;
+        if (ESClockSync::MakeExchange(msg.timing, recvUs, exchange)) {
+            session->InputClockExchange(exchange);
+        }
+
+        timing.echoUs = msg.timing.sendUs;
+        timing.echoRecvUs = recvUs;
+        timing.sendUs = static_cast<int64_t>(GetSteadyTimeUs());
+        replyTiming = &timing;
+    }
+
+    std::string response = m_replyCache->BuildHeartbeatReply(msg.heartbeat, replyTiming);
+
+    std::cout << "[ESServer][TCP][57395] heartbeat response to " << peerIp << ":\n"
+              << response << std::endl;
+
+    return response;
 }
 
-std::shared_ptr<ESSession> ESServer::GetSession(uint32_t streamId)
+std::string ESServer::HandleRtspRequest(const std::string& peerIp, const ESRtspLiteRequestView& req)
 {
-    auto it = m_sessions.find(streamId);
-    if (it != m_sessions.end()) {
-        return it->second;
+    if (IsBinaryPlistBody(req.body)) {
+        TryPrintBinaryPlistXml(req.body, "[ESServer][TCP][51040] recv plist xml:");
+    }
+
+    const std::string_view cseq = req.HeaderValue("CSeq");
+
+    if (req.IsMethod("SETUP")) {
+        const bool isVideoSetup =
+            (cseq == "0") || !req.HeaderValue("VideoAspectRatio").empty();
+
+        // 端口在 StartServer 后固定，参数没变时 SetParams 只做一次比较
+        ESReplyParams params;
+        params.videoPort = m_portManager->GetVideoPort();
+        params.dataPort = m_portManager->GetDataPort();
+        params.controlPort = m_portManager->GetControlPort();
+        params.mousePort = m_portManager->GetMousePort();
+        m_replyCache->SetParams(params);
+
+        std::string response = isVideoSetup
+            ? m_replyCache->BuildVideoSetupReply(cseq)
+            : m_replyCache->BuildAudioSetupReply(cseq);
+        std::cout << "[ESServer][TCP][51040] response to " << peerIp
+                  << " (" << (isVideoSetup ? "video setup" : "audio setup") << ")\n";
+        return response;
+    }
+
+    if (req.IsMethod("OPTIONS")) {
+        std::string response = m_replyCache->BuildOptionsReply(cseq, GetVideoAudioByCSeq(cseq));
+        std::cout << "[ESServer][TCP][51040] options response to " << peerIp << std::endl;
+        return response;
+    }
+
+    if (req.IsMethod("TEARDOWN")) {
+        std::string response = m_replyCache->BuildTeardownReply(cseq);
+        std::cout << "[ESServer][TCP][51040] teardown response to " << peerIp << std::endl;
+        return response;
     }
 
-    return nullptr;
+    std::cout << "[ESServer][TCP][51040] unsupported request:\n" << req.raw << std::endl;
+    return "";
+}
+
+std::shared_ptr<ESSession> ESServer::GetSession(uint32_t streamId)
+{
+    return m_sessions.Find(streamId);
 }
 
 std::shared_ptr<ESSession> ESServer::CreateSession(uint32_t streamId)
@@ -775,44 +759,587 @@ std::shared_ptr<ESSession> ESServer::CreateSession(uint32_t streamId)
         return session;
     }
 
+    // 建会话只发生在 57395 首包和交接恢复时，加锁后再查一次，避免并发各建一个、重复通知上层
+    std::lock_guard<std::mutex> createLock(m_createMutex);
+    session = GetSession(streamId);
+    if (session) {
+        return session;
+    }
+
     session = std::make_shared<ESSession>(streamId);
+    session->SetTimeoutConfig(m_config.sessionTimeout);
+    session->SetAccountingEnabled(m_config.sessionQuota.sampleIntervalMs > 0);
+
+    // 会话持有这些回调，只能弱引用自己；回调期间会话一定还在，查降级状态用裸指针即可
+    std::weak_ptr<ESSession> weakSession = session;
+    ESSession* owner = session.get();
 
     session->SetVideoCallback(
-        [this](uint32_t cbStreamId,
-               const uint8_t* data,
-               size_t size,
-               const ESVideoUnit& unit) {
-            (void)unit;
+        [this, weakSession, owner](uint32_t cbStreamId,
+                                   const uint8_t* data,
+                                   size_t size,
+                                   const ESVideoUnit& unit) {
+            if (m_multicastPublisher->IsRunning() && !owner->IsDegraded()) {
+                m_multicastPublisher->PublishVideoUnit(cbStreamId, unit);
+            }
 
             if (m_callback && data != nullptr && size > 0) {
-                m_callback->OnVideoData(cbStreamId, data, size);
+                ESVideoEvent event;
+                event.session = weakSession.lock();
+                event.streamId = cbStreamId;
+                event.unit = unit;
+                DeliverVideo(std::move(event));
             }
         });
 
     session->SetAudioCallback(
-        [this](uint32_t cbStreamId,
-               const uint8_t* data,
-               size_t size,
-               const ESAudioPayloadInfo& info) {
-            (void)info;
+        [this, weakSession, owner](uint32_t cbStreamId,
+                                   const uint8_t* data,
+                                   size_t size,
+                                   const ESAudioPayloadInfo& info) {
+            if (m_multicastPublisher->IsRunning() && !owner->IsDegraded()) {
+                m_multicastPublisher->PublishAudioPacket(cbStreamId, info);
+            }
 
             if (m_callback && data != nullptr && size > 0) {
-                m_callback->OnAudioData(cbStreamId, data, size);
+                ESAudioEvent event;
+                event.session = weakSession.lock();
+                event.streamId = cbStreamId;
+                event.info = info;
+                DeliverAudio(std::move(event));
             }
         });
 
-    m_sessions[streamId] = session;
+    session->SetAudioGapCallback(
+        [this, weakSession](uint32_t cbStreamId, const ESAudioGapInfo& gap) {
+            if (m_callback) {
+                ESAudioGapEvent event;
+                event.session = weakSession.lock();
+                event.streamId = cbStreamId;
+                event.gap = gap;
+                m_callback->OnAudioGap(event);
+            }
+        });
+
+    session->SetAudioJitterConfig(m_config.audioJitter);
+    session->SetAvSyncConfig(m_config.avSync);
+    session->SetAvSyncCallback(
+        [this, weakSession](uint32_t cbStreamId, const ESAvSyncStats& stats) {
+            if (m_callback) {
+                ESAvSyncEvent event;
+                event.session = weakSession.lock();
+                event.streamId = cbStreamId;
+                event.stats = stats;
+                m_callback->OnAvSyncReport(event);
+            }
+        });
+
+    if (m_config.audioDecode.enabled) {
+        if (m_config.audioDrift.enabled) {
+            auto output = session->EnableAudioDriftCompensation(m_config.audioDrift);
+            if (output && m_callback) {
+                ESAudioOutputEvent event;
+                event.session = session;
+                event.streamId = streamId;
+                event.output = output;
+                m_callback->OnAudioOutputReady(event);
+            }
+        }
+
+        int ret = session->EnableAudioDecode(
+            m_config.audioDecode,
+            [this, weakSession](uint32_t cbStreamId, const ESPcmFrame& frame) {
+                if (m_callback) {
+                    ESAudioPcmEvent event;
+                    event.session = weakSession.lock();
+                    event.streamId = cbStreamId;
+                    event.frame = &frame;
+                    m_callback->OnAudioPcm(event);
+                }
+            });
+        if (ret != 0) {
+            std::cout << "[ESServer] enable audio decode failed, streamId=" << streamId
+                      << ", ret=" << ret << std::endl;
+        }
+    }
+
+    m_sessions.Insert(streamId, session);
+
+    const ESSessionTimeoutConfig& timeout = m_config.sessionTimeout;
+    if (timeout.heartbeatTimeoutMs > 0 || timeout.mediaTimeoutMs > 0) {
+        ScheduleSessionCheck(streamId, (timeout.heartbeatTimeoutMs > 0)
+                                           ? timeout.heartbeatTimeoutMs
+                                           : timeout.mediaTimeoutMs);
+    }
+
     return session;
 }
 
-void ESServer::RemoveSession(uint32_t streamId)
+bool ESServer::CloseSession(uint32_t streamId, ESSessionCloseCause cause)
 {
-    m_sessions.erase(streamId);
+    // 移除是原子的，并发关闭同一会话只有一方拿到
+    std::shared_ptr<ESSession> session = m_sessions.Remove(streamId);
+    if (!session) {
+        return false;
+    }
+    session->MarkClosed();
+
+    // 抖动缓冲里压着的尾包在关闭事件之前送出；MarkClosed 之后输入线程不会再往里放
+    {
+        MediaBatchScope batchScope(*this);
+        session->FlushAudio();
+    }
+
+    if (m_handedOff.load()) {
+        cause = ESSessionCloseCause::HandedOff;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_wheelMutex);
+        m_sessionWheel.Cancel(streamId);
+    }
+
+    m_multicastPublisher->RemoveStream(streamId);
+
+    if (cause == ESSessionCloseCause::HeartbeatTimeout || cause == ESSessionCloseCause::MediaTimeout ||
+        cause == ESSessionCloseCause::QuotaExceeded) {
+        // 发送端已经不在了，连接上的接收缓冲一并释放
+        m_portManager->ClosePeerConnections(streamId);
+    }
+
+    if (m_callback) {
+        ESSessionCloseEvent event;
+        event.session = session;
+        event.streamId = streamId;
+        event.cause = cause;
+        event.disconnected = IsDisconnectCause(cause);
+        m_callback->OnSessionClose(event);
+    }
+    return true;
 }
 
 void ESServer::ClearSessions()
 {
-    m_sessions.clear();
+    const std::vector<ESSessionTable::Entry> sessions = m_sessions.TakeAll();
+
+    {
+        MediaBatchScope batchScope(*this);
+        for (const auto& item : sessions) {
+            item.second->MarkClosed();
+            item.second->FlushAudio();
+        }
+    }
+
+    const ESSessionCloseCause cause = m_handedOff.load() ? ESSessionCloseCause::HandedOff
+                                                         : ESSessionCloseCause::ServerStopped;
+    if (m_callback) {
+        for (const auto& item : sessions) {
+            ESSessionCloseEvent event;
+            event.session = item.second;
+            event.streamId = item.first;
+            event.cause = cause;
+            event.disconnected = IsDisconnectCause(cause);
+            m_callback->OnSessionClose(event);
+        }
+    }
+}
+
+void ESServer::NotifySessionOpen(const std::shared_ptr<ESSession>& session,
+                                 const std::string& peerIp,
+                                 bool restored)
+{
+    ESSessionOpenEvent event;
+    event.session = session;
+    event.streamId = session->GetStreamId();
+    event.name = session->GetName();
+    event.peerIp = peerIp;
+    event.restored = restored;
+    m_callback->OnSessionOpen(event);
+}
+
+ESServer::MediaBatchScope::MediaBatchScope(ESServer& server)
+    : m_server(server)
+{
+    MediaBatchState& batch = t_mediaBatch;
+    if (batch.depth == 0) {
+        batch.owner = &server;
+    }
+
+    // 同一线程上嵌套了另一个服务端的作用域时不参与，那边的媒体照常立即回调
+    m_active = (batch.owner == &server);
+    if (m_active) {
+        ++batch.depth;
+    }
+}
+
+ESServer::MediaBatchScope::~MediaBatchScope()
+{
+    if (!m_active) {
+        return;
+    }
+
+    MediaBatchState& batch = t_mediaBatch;
+    if (--batch.depth == 0) {
+        m_server.FlushMediaBatch();
+        batch.owner = nullptr;
+    }
+}
+
+void ESServer::DeliverVideo(ESVideoEvent&& event)
+{
+    MediaBatchState& batch = t_mediaBatch;
+    if (batch.depth > 0 && batch.owner == this) {
+        // 单元指向解包器缓冲，下次喂数据前一直有效，不用拷贝
+        batch.video.push_back(std::move(event));
+        return;
+    }
+
+    ESMediaBatch single;
+    single.video = ESSpan<ESVideoEvent>(&event, 1);
+
+    const bool accounting = m_config.sessionQuota.sampleIntervalMs > 0;
+    const uint64_t cpuStartNs = accounting ? GetThreadCpuTimeNs() : 0;
+    m_callback->OnMediaBatch(single);
+    if (accounting) {
+        ChargeDispatchCpu(single, GetThreadCpuTimeNs() - cpuStartNs);
+    }
+}
+
+void ESServer::DeliverAudio(ESAudioEvent&& event)
+{
+    MediaBatchState& batch = t_mediaBatch;
+    if (batch.depth > 0 && batch.owner == this) {
+        // 抖动缓冲的槽位在同一批里可能被复用，payload 先拷进批内缓冲，冲刷时再指回去
+        batch.audioOffsets.push_back(batch.audioArena.size());
+        batch.audioArena.insert(batch.audioArena.end(), event.info.payload,
+                                event.info.payload + event.info.payloadSize);
+        event.info.payload = nullptr;
+        batch.audio.push_back(std::move(event));
+        return;
+    }
+
+    ESMediaBatch single;
+    single.audio = ESSpan<ESAudioEvent>(&event, 1);
+
+    const bool accounting = m_config.sessionQuota.sampleIntervalMs > 0;
+    const uint64_t cpuStartNs = accounting ? GetThreadCpuTimeNs() : 0;
+    m_callback->OnMediaBatch(single);
+    if (accounting) {
+        ChargeDispatchCpu(single, GetThreadCpuTimeNs() - cpuStartNs);
+    }
+}
+
+void ESServer::FlushMediaBatch()
+{
+    MediaBatchState& batch = t_mediaBatch;
+    if (batch.video.empty() && batch.audio.empty()) {
+        return;
+    }
+
+    for (size_t i = 0; i < batch.audio.size(); ++i) {
+        batch.audio[i].info.payload = batch.audioArena.data() + batch.audioOffsets[i];
+    }
+
+    if (m_callback) {
+        ESMediaBatch out;
+        out.video = ESSpan<ESVideoEvent>(batch.video.data(), batch.video.size());
+        out.audio = ESSpan<ESAudioEvent>(batch.audio.data(), batch.audio.size());
+
+        const bool accounting = m_config.sessionQuota.sampleIntervalMs > 0;
+        const uint64_t cpuStartNs = accounting ? GetThreadCpuTimeNs() : 0;
+        m_callback->OnMediaBatch(out);
+        if (accounting) {
+            ChargeDispatchCpu(out, GetThreadCpuTimeNs() - cpuStartNs);
+        }
+    }
+
+    // 保留容量，下一批不再分配
+    batch.video.clear();
+    batch.audio.clear();
+    batch.audioOffsets.clear();
+    batch.audioArena.clear();
+}
+
+void ESServer::StartSessionReaper()
+{
+    const ESSessionTimeoutConfig& timeout = m_config.sessionTimeout;
+    const int sampleMs = static_cast<int>(m_config.sessionQuota.sampleIntervalMs);
+    const int pollMs = m_config.audioJitter.enabled ? static_cast<int>(m_config.audioJitter.pollIntervalMs) : 0;
+    if ((!timeout.enabled && sampleMs == 0 && pollMs == 0) || m_reaperThread) {
+        return;
+    }
+
+    int tickMs = 0;
+    if (timeout.enabled) {
+        std::lock_guard<std::mutex> lock(m_wheelMutex);
+        m_sessionWheel = ESTimingWheel(timeout.tickMs);
+        tickMs = static_cast<int>(m_sessionWheel.GetTickMs());
+    }
+
+    m_reaperThread = std::make_unique<hv::EventLoopThread>();
+    m_reaperThread->start(true);
+
+    hv::EventLoopPtr loop = m_reaperThread->loop();
+    loop->runInLoop([this, loop, tickMs, sampleMs, pollMs]() {
+        if (tickMs > 0) {
+            loop->setInterval(tickMs, [this](hv::TimerID) {
+                OnSessionReaperTick();
+            });
+        }
+        if (sampleMs > 0) {
+            loop->setInterval(sampleMs, [this](hv::TimerID) {
+                OnResourceSampleTick();
+            });
+        }
+        if (pollMs > 0) {
+            loop->setInterval(pollMs, [this](hv::TimerID) {
+                OnAudioPollTick();
+            });
+        }
+    });
+}
+
+void ESServer::StopSessionReaper()
+{
+    if (m_reaperThread) {
+        m_reaperThread->stop(true);
+        m_reaperThread.reset();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_resourceMutex);
+        m_resourceSnapshot.clear();
+    }
+
+    std::lock_guard<std::mutex> lock(m_wheelMutex);
+    m_sessionWheel.Clear();
+}
+
+void ESServer::ScheduleSessionCheck(uint32_t streamId, uint64_t delayMs)
+{
+    if (!m_config.sessionTimeout.enabled) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_wheelMutex);
+    m_sessionWheel.Schedule(streamId, delayMs, GetSteadyTimeUs() / 1000);
+}
+
+void ESServer::OnSessionReaperTick()
+{
+    const uint64_t nowMs = GetSteadyTimeUs() / 1000;
+
+    m_reaperExpired.clear();
+    {
+        std::lock_guard<std::mutex> lock(m_wheelMutex);
+        m_sessionWheel.Advance(nowMs, [this](uint64_t key) {
+            m_reaperExpired.push_back(key);
+        });
+    }
+
+    for (uint64_t key : m_reaperExpired) {
+        CheckSessionTimeout(static_cast<uint32_t>(key), nowMs);
+    }
+}
+
+void ESServer::OnResourceSampleTick()
+{
+    const uint64_t nowMs = GetSteadyTimeUs() / 1000;
+    const ESSessionQuotaConfig& quota = m_config.sessionQuota;
+    const std::vector<ESSessionTable::Entry> sessions = m_sessions.Snapshot();
+
+    std::vector<ESSessionResourceStats> snapshot;
+    snapshot.reserve(sessions.size());
+    std::vector<uint32_t> disconnects;
+
+    for (const auto& item : sessions) {
+        const ESQuotaLevel previous = item.second->GetQuotaLevel();
+
+        ESSessionResourceStats stats;
+        const ESQuotaAction action = item.second->SampleResources(quota, nowMs, stats);
+
+        if (stats.level != previous || action == ESQuotaAction::Disconnect) {
+            std::cout << "[ESServer] session quota level " << static_cast<int>(previous)
+                      << " -> " << static_cast<int>(stats.level) << ", streamId=" << item.first
+                      << ", action=" << static_cast<int>(action)
+                      << ", allocated=" << stats.allocatedBytes
+                      << ", cpu=" << stats.cpuPermille << "permille"
+                      << ", rate=" << stats.bytesPerSec << "B/s" << std::endl;
+
+            if (m_callback) {
+                ESSessionQuotaEvent event;
+                event.session = item.second;
+                event.streamId = item.first;
+                event.action = action;
+                event.stats = stats;
+                m_callback->OnSessionQuota(event);
+            }
+        }
+
+        if (action == ESQuotaAction::Disconnect) {
+            disconnects.push_back(item.first);
+        }
+        snapshot.push_back(stats);
+    }
+
+    for (uint32_t streamId : disconnects) {
+        CloseSession(streamId, ESSessionCloseCause::QuotaExceeded);
+    }
+
+    if (m_callback) {
+        ESResourceSnapshot out;
+        out.sampledMs = nowMs;
+        out.sessions = ESSpan<ESSessionResourceStats>(snapshot.data(), snapshot.size());
+        m_callback->OnResourceSnapshot(out);
+    }
+
+    std::lock_guard<std::mutex> lock(m_resourceMutex);
+    m_resourceSnapshot.swap(snapshot);
+}
+
+void ESServer::OnAudioPollTick()
+{
+    const uint64_t nowUs = GetSteadyTimeUs();
+    const std::vector<ESSessionTable::Entry> sessions = m_sessions.Snapshot();
+
+    // 一个 tick 里各会话放出的包攒成一批回调
+    MediaBatchScope batchScope(*this);
+    for (const auto& item : sessions) {
+        item.second->PollAudio(nowUs);
+    }
+}
+
+void ESServer::CheckSessionTimeout(uint32_t streamId, uint64_t nowMs)
+{
+    auto session = GetSession(streamId);
+    if (!session) {
+        return;
+    }
+
+    const ESSessionTimeoutConfig timeout = session->GetTimeoutConfig();
+    uint64_t nextCheckMs = 0;
+
+    if (timeout.heartbeatTimeoutMs > 0) {
+        const uint64_t deadline = session->GetLastHeartbeatMs() + timeout.heartbeatTimeoutMs;
+        if (nowMs >= deadline) {
+            std::cout << "[ESServer] session heartbeat timeout, streamId=" << streamId
+                      << ", idle=" << (nowMs - session->GetLastHeartbeatMs()) << "ms" << std::endl;
+            CloseSession(streamId, ESSessionCloseCause::HeartbeatTimeout);
+            return;
+        }
+        nextCheckMs = deadline - nowMs;
+    }
+
+    const uint64_t lastMediaMs = session->GetLastMediaMs();
+    if (timeout.mediaTimeoutMs > 0) {
+        // 还没收到过媒体时只靠心跳判定，之后再按媒体超时轮询
+        const uint64_t deadline = (lastMediaMs != 0) ? lastMediaMs + timeout.mediaTimeoutMs
+                                                     : nowMs + timeout.mediaTimeoutMs;
+        if (nowMs >= deadline) {
+            std::cout << "[ESServer] session media timeout, streamId=" << streamId
+                      << ", idle=" << (nowMs - lastMediaMs) << "ms" << std::endl;
+            CloseSession(streamId, ESSessionCloseCause::MediaTimeout);
+            return;
+        }
+        nextCheckMs = (nextCheckMs == 0) ? deadline - nowMs : std::min(nextCheckMs, deadline - nowMs);
+    }
+
+    // 期间有活动只是把截止时间推后，到期重新排一次，更新活动本身不碰时间轮
+    if (nextCheckMs > 0) {
+        ScheduleSessionCheck(streamId, nextCheckMs);
+    }
+}
+
+int ESServer::ReceiveHandoff(ESHandoffLink& link, ESHandoffState& state)
+{
+    const ESHandoffConfig& config = m_config.handoff;
+    if (link.Connect(config.socketPath) != 0) {
+        std::cout << "[ESServer] no predecessor on " << config.socketPath << ", start fresh" << std::endl;
+        return -1;
+    }
+
+    if (link.SendHello() != 0 || link.RecvState(state, config.timeoutMs) != 0) {
+        std::cout << "[ESServer] receive handoff state failed, start fresh" << std::endl;
+        link.Close();
+        state.CloseAll();
+        return -2;
+    }
+
+    std::cout << "[ESServer] handoff state received, sockets=" << state.sockets.size()
+              << ", sessions=" << state.sessions.size() << std::endl;
+    return 0;
+}
+
+void ESServer::RestoreSessions(const ESHandoffState& state)
+{
+    // 音频链路（抖动缓冲、解码）不随交接迁移，在新进程里从下一个包重新建立
+    for (const auto& item : state.sessions) {
+        if (item.streamId == 0) {
+            continue;
+        }
+
+        auto session = CreateSession(item.streamId);
+        session->SetPeerIp(item.peerIp);
+        session->SetName(item.name);
+        session->MarkHeartbeat();
+
+        if (!item.videoPending.empty()) {
+            session->InputVideoTcpData(reinterpret_cast<const uint8_t*>(item.videoPending.data()),
+                                       item.videoPending.size());
+        }
+    }
+}
+
+void ESServer::SnapshotSessions(ESHandoffState& state)
+{
+    // 各 loop 已暂停，会话的解包器和名称此时没有人在写
+    for (const auto& item : m_sessions.Snapshot()) {
+        ESHandoffSession session;
+        session.streamId = item.first;
+        session.peerIp = item.second->GetPeerIp();
+        session.name = item.second->GetName();
+        session.videoPending = item.second->GetVideoPendingBytes();
+        state.sessions.push_back(std::move(session));
+    }
+}
+
+void ESServer::HandleHandoffRequest(ESHandoffLink& link)
+{
+    const uint32_t timeoutMs = m_config.handoff.timeoutMs;
+
+    if (!m_running.load() || m_handedOff.load()) {
+        return;
+    }
+
+    if (link.RecvHello(timeoutMs) != 0) {
+        std::cout << "[ESServer] bad handoff request" << std::endl;
+        return;
+    }
+
+    ESHandoffState state;
+    int ret = m_portManager->DetachForHandoff(state, [this](ESHandoffState& snapshot) {
+        SnapshotSessions(snapshot);
+    });
+    if (ret != 0) {
+        std::cout << "[ESServer] detach for handoff failed, ret=" << ret << std::endl;
+        return;
+    }
+
+    // 新进程没确认之前连接只是停读，失败就原样恢复
+    if (link.SendState(state) != 0 || link.RecvAck(timeoutMs) != 0) {
+        std::cout << "[ESServer] handoff not acknowledged, resume" << std::endl;
+        m_portManager->ResumeAfterHandoff();
+        return;
+    }
+
+    m_handedOff = true;
+    m_portManager->FinishHandoff();
+    StopSessionReaper();
+
+    std::cout << "[ESServer] handed off to successor, sessions=" << state.sessions.size() << std::endl;
+    if (m_callback) {
+        m_callback->OnHandedOff();
+    }
 }
 
 } // namespace hhcast
\ No newline at end of file
@@ -0,0 +1,63 @@
+#include "IESServerCallbackV2.h"
+
+#include <string>
+
+namespace hhcast {
+
+ESServerCallbackAdapter::ESServerCallbackAdapter(std::shared_ptr<IESServerCallback> callback)
+    : m_callback(std::move(callback))
+{
+}
+
+void ESServerCallbackAdapter::OnSessionOpen(const ESSessionOpenEvent& event)
+{
+    m_callback->OnConnect(event.streamId, std::string(event.name), std::string(event.peerIp));
+}
+
+void ESServerCallbackAdapter::OnSessionClose(const ESSessionCloseEvent& event)
+{
+    if (event.disconnected) {
+        m_callback->OnDisconnect(event.streamId);
+    }
+    m_callback->OnSessionClosed(event.streamId, event.cause);
+}
+
+void ESServerCallbackAdapter::OnMediaBatch(const ESMediaBatch& batch)
+{
+    for (const auto& event : batch.video) {
+        m_callback->OnVideoData(event.streamId, event.unit.payload, event.unit.payloadSize);
+    }
+
+    for (const auto& event : batch.audio) {
+        m_callback->OnAudioData(event.streamId, event.info.payload, event.info.payloadSize);
+    }
+}
+
+void ESServerCallbackAdapter::OnAudioGap(const ESAudioGapEvent& event)
+{
+    m_callback->OnAudioGap(event.streamId, event.gap);
+}
+
+void ESServerCallbackAdapter::OnAudioPcm(const ESAudioPcmEvent& event)
+{
+    if (event.frame) {
+        m_callback->OnAudioPcm(event.streamId, *event.frame);
+    }
+}
+
+void ESServerCallbackAdapter::OnAudioOutputReady(const ESAudioOutputEvent& event)
+{
+    m_callback->OnAudioOutputReady(event.streamId, event.output);
+}
+
+void ESServerCallbackAdapter::OnAvSyncReport(const ESAvSyncEvent& event)
+{
+    m_callback->OnAvSyncReport(event.streamId, event.stats);
+}
+
+void ESServerCallbackAdapter::OnHandedOff()
+{
+    m_callback->OnHandedOff();
+}
+
+} // namespace hhcast
\ No newline at end of file
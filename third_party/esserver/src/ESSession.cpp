@@ -1,22 +1,37 @@
 #include "ESSession.h"
 
+#include "ESUtils.h"
+
 namespace hhcast {
 
 ESSession::ESSession(uint32_t streamId)
     : m_streamId(streamId)
+    , m_videoPipeline(ESFilterStage<KnownVideoUnit>(), ESDispatchStage<VideoUnitTarget>(VideoUnitTarget{ this }))
 {
-    m_videoDepacketizer.SetCallback(
-        [this](const ESVideoUnit& unit) {
-            OnVideoUnitReady(unit);
-        });
+    // 创建即视为一次心跳，client-info 之后迟迟没有心跳也能超时回收
+    MarkHeartbeat();
 
     m_audioDatagramParser.SetCallback(
+        [this](const ESAudioPayloadInfo& info) {
+            m_avSync.OnAudioArrival(info.timestamp, m_audioLocalUs);
+            m_audioJitterBuffer.Push(info, m_audioArrivalUs);
+        });
+
+    m_audioJitterBuffer.SetPayloadCallback(
         [this](const ESAudioPayloadInfo& info) {
             OnAudioPayloadReady(info);
         });
+
+    m_audioJitterBuffer.SetGapCallback(
+        [this](const ESAudioGapInfo& gap) {
+            OnAudioGap(gap);
+        });
 }
 
-ESSession::~ESSession() = default;
+ESSession::~ESSession()
+{
+    DisableAudioDecode();
+}
 
 uint32_t ESSession::GetStreamId() const
 {
@@ -25,21 +40,25 @@ uint32_t ESSession::GetStreamId() const
 
 void ESSession::SetPeerIp(const std::string& peerIp)
 {
+    std::lock_guard<std::mutex> lock(m_infoMutex);
     m_peerIp = peerIp;
 }
 
-const std::string& ESSession::GetPeerIp() const
+std::string ESSession::GetPeerIp() const
 {
+    std::lock_guard<std::mutex> lock(m_infoMutex);
     return m_peerIp;
 }
 
 void ESSession::SetName(const std::string& name)
 {
+    std::lock_guard<std::mutex> lock(m_infoMutex);
     m_name = name;
 }
 
-const std::string& ESSession::GetName() const
+std::string ESSession::GetName() const
 {
+    std::lock_guard<std::mutex> lock(m_infoMutex);
     return m_name;
 }
 
@@ -53,38 +72,365 @@ void ESSession::SetAudioCallback(ESSessionAudioCallback callback)
     m_audioCallback = std::move(callback);
 }
 
+void ESSession::SetAudioGapCallback(ESSessionAudioGapCallback callback)
+{
+    m_audioGapCallback = std::move(callback);
+}
+
+void ESSession::SetAudioJitterConfig(const ESAudioJitterConfig& config)
+{
+    std::lock_guard<std::mutex> lock(m_audioMutex);
+    m_audioJitterBuffer.SetConfig(config);
+}
+
+ESAudioJitterStats ESSession::GetAudioJitterStats() const
+{
+    std::lock_guard<std::mutex> lock(m_audioMutex);
+    return m_audioJitterBuffer.GetStats();
+}
+
+void ESSession::PollAudio(uint64_t nowUs)
+{
+    std::lock_guard<std::mutex> lock(m_audioMutex);
+    m_audioJitterBuffer.Poll(nowUs);
+    UpdateAudioGauges();
+}
+
+void ESSession::FlushAudio()
+{
+    std::lock_guard<std::mutex> lock(m_audioMutex);
+    m_audioJitterBuffer.Flush();
+    UpdateAudioGauges();
+}
+
+int ESSession::EnableAudioDecode(const ESAudioDecodeConfig& config, ESSessionAudioPcmCallback callback)
+{
+    DisableAudioDecode();
+
+    auto stage = std::make_unique<ESAudioDecodeStage>();
+    const uint32_t streamId = m_streamId;
+    stage->SetPcmCallback(
+        [streamId, callback, drift = m_audioDrift](const ESPcmFrame& frame) {
+            if (drift) {
+                drift->PushFrame(frame);
+            }
+            if (callback) {
+                callback(streamId, frame);
+            }
+        });
+
+    int ret = stage->Start(config);
+    if (ret != 0) {
+        return ret;
+    }
+
+    m_audioDecodeStage = std::move(stage);
+    return 0;
+}
+
+void ESSession::DisableAudioDecode()
+{
+    if (m_audioDecodeStage) {
+        m_audioDecodeStage->Stop();
+        m_audioDecodeStage.reset();
+    }
+}
+
+std::shared_ptr<ESAudioDriftResampler> ESSession::EnableAudioDriftCompensation(const ESAudioDriftConfig& config)
+{
+    auto drift = std::make_shared<ESAudioDriftResampler>();
+    if (drift->Start(config) != 0) {
+        return nullptr;
+    }
+
+    m_audioDrift = drift;
+    return drift;
+}
+
+ESAudioDriftStats ESSession::GetAudioDriftStats() const
+{
+    if (!m_audioDrift) {
+        return ESAudioDriftStats{};
+    }
+    return m_audioDrift->GetStats();
+}
+
+void ESSession::SetAvSyncConfig(const ESAvSyncConfig& config)
+{
+    m_avSync.SetConfig(config);
+}
+
+void ESSession::SetAvSyncCallback(ESSessionAvSyncCallback callback)
+{
+    m_avSyncCallback = std::move(callback);
+}
+
+ESAvSyncStats ESSession::GetAvSyncStats() const
+{
+    return m_avSync.GetStats();
+}
+
+bool ESSession::InputAudioControlDatagram(const uint8_t* data, size_t size)
+{
+    const uint64_t nowUs = GetSteadyTimeUs();
+    m_lastMediaMs.store(nowUs / 1000, std::memory_order_relaxed);
+    m_accounting.AddTraffic(ESSessionAccounting::Port::AudioControl, size);
+    return m_avSync.InputControlPacket(data, size, nowUs);
+}
+
 bool ESSession::InputVideoTcpData(const uint8_t* data, size_t size)
 {
-    return m_videoDepacketizer.PushBytes(data, size);
+    const uint64_t cpuStartNs = m_accountingEnabled ? GetThreadCpuTimeNs() : 0;
+
+    m_videoLocalUs = GetSteadyTimeUs();
+    m_lastMediaMs.store(m_videoLocalUs / 1000, std::memory_order_relaxed);
+    m_accounting.AddTraffic(ESSessionAccounting::Port::Video, size);
+
+    if (m_releasePending.exchange(false, std::memory_order_relaxed)) {
+        m_videoDepacketizer.ReleaseSpare();
+    }
+
+    const bool ok = m_videoDepacketizer.Append(data, size);
+    if (ok) {
+        m_videoDepacketizer.DrainUnits(m_videoPipeline);
+    }
+    UpdateVideoGauges();
+
+    if (m_accountingEnabled) {
+        m_accounting.AddParseCpuNs(GetThreadCpuTimeNs() - cpuStartNs);
+    }
+    return ok;
 }
 
-bool ESSession::InputAudioUdpDatagram(const uint8_t* data, size_t size)
+bool ESSession::InputAudioUdpDatagram(const uint8_t* data, size_t size, uint64_t arrivalUs)
 {
-    return m_audioDatagramParser.ParseDatagram(data, size);
+    const uint64_t cpuStartNs = m_accountingEnabled ? GetThreadCpuTimeNs() : 0;
+
+    std::unique_lock<std::mutex> lock(m_audioMutex);
+    // 关闭时已经 FlushAudio，之后再进的包不会有人出，直接丢
+    if (IsClosed()) {
+        return false;
+    }
+
+    m_audioLocalUs = GetSteadyTimeUs();
+    m_lastMediaMs.store(m_audioLocalUs / 1000, std::memory_order_relaxed);
+    m_audioArrivalUs = (arrivalUs != 0) ? arrivalUs : m_audioLocalUs;
+    m_accounting.AddTraffic(ESSessionAccounting::Port::AudioData, size);
+
+    const bool ok = m_audioDatagramParser.ParseDatagram(data, size);
+    UpdateAudioGauges();
+    lock.unlock();
+
+    if (m_accountingEnabled) {
+        m_accounting.AddParseCpuNs(GetThreadCpuTimeNs() - cpuStartNs);
+    }
+    return ok;
 }
 
 void ESSession::ResetMediaState()
 {
     m_videoDepacketizer.Reset();
-    m_audioDatagramParser.Reset();
+    {
+        std::lock_guard<std::mutex> lock(m_audioMutex);
+        m_audioDatagramParser.Reset();
+        m_audioJitterBuffer.Reset();
+    }
+    m_avSync.Reset();
+    if (m_audioDrift) {
+        m_audioDrift->Reset();
+    }
+}
+
+void ESSession::SetTimeoutConfig(const ESSessionTimeoutConfig& config)
+{
+    m_heartbeatTimeoutMs.store(config.heartbeatTimeoutMs, std::memory_order_relaxed);
+    m_mediaTimeoutMs.store(config.mediaTimeoutMs, std::memory_order_relaxed);
+}
+
+ESSessionTimeoutConfig ESSession::GetTimeoutConfig() const
+{
+    ESSessionTimeoutConfig config;
+    config.heartbeatTimeoutMs = m_heartbeatTimeoutMs.load(std::memory_order_relaxed);
+    config.mediaTimeoutMs = m_mediaTimeoutMs.load(std::memory_order_relaxed);
+    return config;
+}
+
+void ESSession::MarkHeartbeat()
+{
+    m_lastHeartbeatMs.store(GetSteadyTimeUs() / 1000, std::memory_order_relaxed);
+}
+
+uint64_t ESSession::GetLastHeartbeatMs() const
+{
+    return m_lastHeartbeatMs.load(std::memory_order_relaxed);
+}
+
+uint64_t ESSession::GetLastMediaMs() const
+{
+    return m_lastMediaMs.load(std::memory_order_relaxed);
+}
+
+void ESSession::MarkClosed()
+{
+    m_closed.store(true, std::memory_order_release);
+}
+
+bool ESSession::IsClosed() const
+{
+    return m_closed.load(std::memory_order_acquire);
+}
+
+std::string ESSession::GetVideoPendingBytes() const
+{
+    return std::string(m_videoDepacketizer.GetBuffered());
+}
+
+bool ESSession::InputClockExchange(const ESClockExchange& exchange)
+{
+    return m_clockSync.AddExchange(exchange);
+}
+
+ESClockSyncStats ESSession::GetClockSyncStats() const
+{
+    return m_clockSync.GetStats();
+}
+
+void ESSession::ResetClockSync()
+{
+    m_clockSync.Reset();
 }
 
 void ESSession::OnVideoUnitReady(const ESVideoUnit& unit)
 {
-    if (!m_videoCallback || unit.payload == nullptr || unit.payloadSize == 0) {
+    if (unit.payload == nullptr || unit.payloadSize == 0) {
+        return;
+    }
+
+    ESVideoUnit timedUnit = unit;
+    if (unit.kind == ESVideoUnitKind::Frame) {
+        timedUnit.presentationUs = m_avSync.OnVideoArrival(unit.timestamp32_32, m_videoLocalUs);
+        MaybeReportAvSync(m_videoLocalUs);
+    }
+
+    if (!m_videoCallback) {
         return;
     }
 
-    m_videoCallback(m_streamId, unit.payload, unit.payloadSize, unit);
+    m_videoCallback(m_streamId, timedUnit.payload, timedUnit.payloadSize, timedUnit);
 }
 
 void ESSession::OnAudioPayloadReady(const ESAudioPayloadInfo& info)
 {
-    if (!m_audioCallback || info.payload == nullptr || info.payloadSize == 0) {
+    if (info.payload == nullptr || info.payloadSize == 0) {
+        return;
+    }
+
+    // 出抖动缓冲时锚点可能已被同步包刷新，按最新映射重新算 deadline
+    ESAudioPayloadInfo timedInfo = info;
+    timedInfo.presentationUs = m_avSync.GetAudioDeadlineUs(info.timestamp);
+    MaybeReportAvSync(m_audioLocalUs);
+
+    if (m_audioDecodeStage && !m_accounting.IsDegraded()) {
+        m_audioDecodeStage->PushPayload(timedInfo);
+    }
+
+    if (!m_audioCallback) {
+        return;
+    }
+
+    m_audioCallback(m_streamId, timedInfo.payload, timedInfo.payloadSize, timedInfo);
+}
+
+void ESSession::OnAudioGap(const ESAudioGapInfo& gap)
+{
+    if (gap.count == 0) {
+        return;
+    }
+
+    if (m_audioDecodeStage && !m_accounting.IsDegraded()) {
+        m_audioDecodeStage->PushGap(gap);
+    }
+
+    if (!m_audioGapCallback) {
+        return;
+    }
+
+    m_audioGapCallback(m_streamId, gap);
+}
+
+void ESSession::MaybeReportAvSync(uint64_t nowUs)
+{
+    if (!m_avSyncCallback) {
         return;
     }
 
-    m_audioCallback(m_streamId, info.payload, info.payloadSize, info);
+    uint64_t lastUs = m_lastAvSyncReportUs.load(std::memory_order_relaxed);
+    if (nowUs < lastUs + 1000000 ||
+        !m_lastAvSyncReportUs.compare_exchange_strong(lastUs, nowUs, std::memory_order_relaxed)) {
+        return;
+    }
+
+    m_avSyncCallback(m_streamId, m_avSync.GetStats());
+}
+
+void ESSession::SetAccountingEnabled(bool enabled)
+{
+    m_accountingEnabled = enabled;
+}
+
+void ESSession::AddDispatchCpuNs(uint64_t ns)
+{
+    m_accounting.AddDispatchCpuNs(ns);
+}
+
+ESQuotaLevel ESSession::GetQuotaLevel() const
+{
+    return m_accounting.GetQuotaLevel();
+}
+
+bool ESSession::IsDegraded() const
+{
+    return m_accounting.IsDegraded();
+}
+
+void ESSession::GetResourceStats(ESSessionResourceStats& stats) const
+{
+    m_accounting.Fill(stats);
+    stats.streamId = m_streamId;
+
+    // 解码队列有自己的锁，直接读
+    if (m_audioDecodeStage) {
+        stats.audioBufferedBytes += m_audioDecodeStage->GetQueuedBytes();
+        stats.allocatedBytes += m_audioDecodeStage->GetAllocatedBytes();
+        stats.decodeCpuNs = m_audioDecodeStage->GetThreadCpuNs();
+    }
+}
+
+ESQuotaAction ESSession::SampleResources(const ESSessionQuotaConfig& config,
+                                         uint64_t nowMs,
+                                         ESSessionResourceStats& stats)
+{
+    GetResourceStats(stats);
+    m_accounting.Sample(nowMs, stats);
+
+    const bool wasDegraded = stats.degraded;
+    const ESQuotaAction action = m_accounting.CheckQuota(config, stats);
+    if (stats.degraded && !wasDegraded) {
+        m_releasePending.store(true, std::memory_order_relaxed);
+    }
+    return action;
+}
+
+void ESSession::UpdateVideoGauges()
+{
+    m_accounting.SetVideoBuffered(m_videoDepacketizer.GetBufferedSize(),
+                                  m_videoDepacketizer.GetAllocatedBytes());
+}
+
+void ESSession::UpdateAudioGauges()
+{
+    m_accounting.SetAudioBuffered(m_audioJitterBuffer.GetStoredBytes(),
+                                  m_audioJitterBuffer.GetAllocatedBytes());
 }
 
 } // namespace hhcast
\ No newline at end of file
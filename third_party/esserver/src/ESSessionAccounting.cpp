@@ -0,0 +1,152 @@
+#include "ESSessionAccounting.h"
+
+namespace hhcast {
+
+void ESSessionAccounting::AddTraffic(Port port, size_t bytes)
+{
+    Counter* counter = &m_video;
+    if (port == Port::AudioData) {
+        counter = &m_audioData;
+    } else if (port == Port::AudioControl) {
+        counter = &m_audioControl;
+    }
+
+    // 只有输入线程写，relaxed 即可；读方容忍两项之间的瞬时不一致
+    counter->packets.fetch_add(1, std::memory_order_relaxed);
+    counter->bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void ESSessionAccounting::AddParseCpuNs(uint64_t ns)
+{
+    m_parseCpuNs.fetch_add(ns, std::memory_order_relaxed);
+}
+
+void ESSessionAccounting::AddDispatchCpuNs(uint64_t ns)
+{
+    m_dispatchCpuNs.fetch_add(ns, std::memory_order_relaxed);
+}
+
+void ESSessionAccounting::SetVideoBuffered(size_t buffered, size_t allocated)
+{
+    m_videoBuffered.store(buffered, std::memory_order_relaxed);
+    m_videoAllocated.store(allocated, std::memory_order_relaxed);
+}
+
+void ESSessionAccounting::SetAudioBuffered(size_t buffered, size_t allocated)
+{
+    m_audioBuffered.store(buffered, std::memory_order_relaxed);
+    m_audioAllocated.store(allocated, std::memory_order_relaxed);
+}
+
+void ESSessionAccounting::Fill(ESSessionResourceStats& stats) const
+{
+    stats.videoBufferedBytes = m_videoBuffered.load(std::memory_order_relaxed);
+    stats.audioBufferedBytes = m_audioBuffered.load(std::memory_order_relaxed);
+    stats.allocatedBytes = m_videoAllocated.load(std::memory_order_relaxed) +
+                           m_audioAllocated.load(std::memory_order_relaxed);
+
+    stats.parseCpuNs = m_parseCpuNs.load(std::memory_order_relaxed);
+    stats.dispatchCpuNs = m_dispatchCpuNs.load(std::memory_order_relaxed);
+
+    stats.video.packets = m_video.packets.load(std::memory_order_relaxed);
+    stats.video.bytes = m_video.bytes.load(std::memory_order_relaxed);
+    stats.audioData.packets = m_audioData.packets.load(std::memory_order_relaxed);
+    stats.audioData.bytes = m_audioData.bytes.load(std::memory_order_relaxed);
+    stats.audioControl.packets = m_audioControl.packets.load(std::memory_order_relaxed);
+    stats.audioControl.bytes = m_audioControl.bytes.load(std::memory_order_relaxed);
+
+    stats.cpuPermille = m_cpuPermille.load(std::memory_order_relaxed);
+    stats.bytesPerSec = m_bytesPerSec.load(std::memory_order_relaxed);
+
+    stats.level = static_cast<ESQuotaLevel>(m_level.load(std::memory_order_relaxed));
+    stats.degraded = m_degraded.load(std::memory_order_relaxed);
+    stats.softViolations = m_softViolations.load(std::memory_order_relaxed);
+    stats.hardViolations = m_hardViolations.load(std::memory_order_relaxed);
+}
+
+void ESSessionAccounting::Sample(uint64_t nowMs, ESSessionResourceStats& stats)
+{
+    const uint64_t cpuNs = stats.parseCpuNs + stats.dispatchCpuNs + stats.decodeCpuNs;
+    const uint64_t bytes = stats.video.bytes + stats.audioData.bytes + stats.audioControl.bytes;
+
+    // 第一次采样只记基线
+    if (m_lastSampleMs != 0 && nowMs > m_lastSampleMs) {
+        const uint64_t elapsedMs = nowMs - m_lastSampleMs;
+        const uint64_t cpuDelta = (cpuNs > m_lastCpuNs) ? cpuNs - m_lastCpuNs : 0;
+        const uint64_t bytesDelta = (bytes > m_lastBytes) ? bytes - m_lastBytes : 0;
+
+        // ns / (ms * 1e6) * 1000 = ns / (ms * 1000)
+        stats.cpuPermille = static_cast<uint32_t>(cpuDelta / (elapsedMs * 1000));
+        stats.bytesPerSec = bytesDelta * 1000 / elapsedMs;
+
+        m_cpuPermille.store(stats.cpuPermille, std::memory_order_relaxed);
+        m_bytesPerSec.store(stats.bytesPerSec, std::memory_order_relaxed);
+    }
+
+    stats.sampledMs = nowMs;
+    m_lastSampleMs = nowMs;
+    m_lastCpuNs = cpuNs;
+    m_lastBytes = bytes;
+}
+
+ESQuotaAction ESSessionAccounting::CheckQuota(const ESSessionQuotaConfig& config, ESSessionResourceStats& stats)
+{
+    auto over = [](uint64_t value, uint64_t limit) {
+        return limit > 0 && value > limit;
+    };
+
+    ESQuotaLevel level = ESQuotaLevel::Normal;
+    if (over(stats.allocatedBytes, config.hardMemoryBytes) ||
+        over(stats.cpuPermille, config.hardCpuPermille) ||
+        over(stats.bytesPerSec, config.hardBytesPerSec)) {
+        level = ESQuotaLevel::Hard;
+    } else if (over(stats.allocatedBytes, config.softMemoryBytes) ||
+               over(stats.cpuPermille, config.softCpuPermille) ||
+               over(stats.bytesPerSec, config.softBytesPerSec)) {
+        level = ESQuotaLevel::Soft;
+    }
+
+    const ESQuotaLevel previous = static_cast<ESQuotaLevel>(m_level.load(std::memory_order_relaxed));
+    uint32_t softViolations = m_softViolations.load(std::memory_order_relaxed);
+    uint32_t hardViolations = m_hardViolations.load(std::memory_order_relaxed);
+
+    ESQuotaAction action = ESQuotaAction::None;
+    if (level == ESQuotaLevel::Hard) {
+        ++m_hardRun;
+        ++hardViolations;
+        action = (m_hardRun >= config.hardGraceIntervals) ? config.hardAction : config.softAction;
+    } else {
+        m_hardRun = 0;
+        if (level == ESQuotaLevel::Soft) {
+            action = config.softAction;
+        }
+    }
+
+    if (level != ESQuotaLevel::Normal && previous == ESQuotaLevel::Normal) {
+        ++softViolations;
+    }
+
+    const bool degraded = (action == ESQuotaAction::Degrade);
+    m_level.store(static_cast<uint8_t>(level), std::memory_order_relaxed);
+    m_degraded.store(degraded, std::memory_order_relaxed);
+    m_softViolations.store(softViolations, std::memory_order_relaxed);
+    m_hardViolations.store(hardViolations, std::memory_order_relaxed);
+
+    stats.level = level;
+    stats.degraded = degraded;
+    stats.softViolations = softViolations;
+    stats.hardViolations = hardViolations;
+    return action;
+}
+
+ESQuotaLevel ESSessionAccounting::GetQuotaLevel() const
+{
+    return static_cast<ESQuotaLevel>(m_level.load(std::memory_order_relaxed));
+}
+
+bool ESSessionAccounting::IsDegraded() const
+{
+    return m_degraded.load(std::memory_order_relaxed);
+}
+
+} // namespace hhcast
\ No newline at end of file
@@ -0,0 +1,119 @@
+#include "ESSessionTable.h"
+
+namespace hhcast {
+
+namespace {
+
+// streamId 是 IPv4 地址，同网段只差低位，混一下再取分片
+size_t ShardIndex(uint32_t streamId)
+{
+    uint32_t h = streamId;
+    h ^= h >> 16;
+    h *= 0x7feb352dU;
+    h ^= h >> 15;
+    return h % ESSessionTable::kShardCount;
+}
+
+} // namespace
+
+ESSessionTable::ESSessionTable()
+{
+    for (auto& shard : m_shards) {
+        shard.map = std::make_shared<const Map>();
+    }
+}
+
+ESSessionTable::Shard& ESSessionTable::GetShard(uint32_t streamId)
+{
+    return m_shards[ShardIndex(streamId)];
+}
+
+const ESSessionTable::Shard& ESSessionTable::GetShard(uint32_t streamId) const
+{
+    return m_shards[ShardIndex(streamId)];
+}
+
+ESSessionPtr ESSessionTable::Find(uint32_t streamId) const
+{
+    const MapPtr map = std::atomic_load(&GetShard(streamId).map);
+    auto it = map->find(streamId);
+    if (it != map->end()) {
+        return it->second;
+    }
+
+    return nullptr;
+}
+
+ESSessionPtr ESSessionTable::Insert(uint32_t streamId, ESSessionPtr session)
+{
+    Shard& shard = GetShard(streamId);
+    std::lock_guard<std::mutex> lock(shard.writeMutex);
+
+    const MapPtr current = std::atomic_load(&shard.map);
+    auto it = current->find(streamId);
+    if (it != current->end()) {
+        return it->second;
+    }
+
+    auto next = std::make_shared<Map>(*current);
+    next->emplace(streamId, session);
+    std::atomic_store(&shard.map, MapPtr(std::move(next)));
+    ++m_size;
+    return session;
+}
+
+ESSessionPtr ESSessionTable::Remove(uint32_t streamId)
+{
+    Shard& shard = GetShard(streamId);
+    std::lock_guard<std::mutex> lock(shard.writeMutex);
+
+    const MapPtr current = std::atomic_load(&shard.map);
+    auto it = current->find(streamId);
+    if (it == current->end()) {
+        return nullptr;
+    }
+
+    ESSessionPtr session = it->second;
+    auto next = std::make_shared<Map>(*current);
+    next->erase(streamId);
+    std::atomic_store(&shard.map, MapPtr(std::move(next)));
+    --m_size;
+    return session;
+}
+
+std::vector<ESSessionTable::Entry> ESSessionTable::TakeAll()
+{
+    std::vector<Entry> entries;
+    const MapPtr empty = std::make_shared<const Map>();
+
+    for (auto& shard : m_shards) {
+        std::lock_guard<std::mutex> lock(shard.writeMutex);
+        const MapPtr current = std::atomic_exchange(&shard.map, empty);
+        for (const auto& item : *current) {
+            entries.emplace_back(item.first, item.second);
+        }
+        m_size -= current->size();
+    }
+
+    return entries;
+}
+
+std::vector<ESSessionTable::Entry> ESSessionTable::Snapshot() const
+{
+    std::vector<Entry> entries;
+    for (const auto& shard : m_shards) {
+        const MapPtr map = std::atomic_load(&shard.map);
+        for (const auto& item : *map) {
+            entries.emplace_back(item.first, item.second);
+        }
+    }
+
+    return entries;
+}
+
+size_t ESSessionTable::Size() const
+{
+    return m_size.load();
+}
+
+} // namespace hhcast
\ No newline at end of file
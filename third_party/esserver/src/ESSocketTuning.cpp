@@ -0,0 +1,252 @@
+#include "ESSocketTuning.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <WS2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <linux/filter.h>
+#endif
+
+namespace hhcast {
+
+namespace {
+
+bool SetIntOption(int fd, int level, int name, int value)
+{
+    return setsockopt(fd, level, name, reinterpret_cast<const char*>(&value), sizeof(value)) == 0;
+}
+
+bool GetIntOption(int fd, int level, int name, int& value)
+{
+    socklen_t len = sizeof(value);
+    value = 0;
+    return getsockopt(fd, level, name, reinterpret_cast<char*>(&value), &len) == 0;
+}
+
+bool ApplyOne(int fd, int level, int name, int value, const char* optionName, const std::string& tag)
+{
+    if (SetIntOption(fd, level, name, value)) {
+        return true;
+    }
+
+    std::cout << "[ESSocketTuning][" << tag << "] set " << optionName << "=" << value
+              << " failed: " << std::strerror(errno) << std::endl;
+    return false;
+}
+
+} // namespace
+
+int ApplySocketOptions(int fd, const ESSocketOptions& options, bool tcp, const std::string& tag)
+{
+    if (fd < 0) {
+        return -1;
+    }
+
+    int failed = 0;
+
+    if (options.recvBufferBytes > 0 &&
+        !ApplyOne(fd, SOL_SOCKET, SO_RCVBUF, options.recvBufferBytes, "SO_RCVBUF", tag)) {
+        ++failed;
+    }
+
+    if (options.sendBufferBytes > 0 &&
+        !ApplyOne(fd, SOL_SOCKET, SO_SNDBUF, options.sendBufferBytes, "SO_SNDBUF", tag)) {
+        ++failed;
+    }
+
+    if (tcp && options.tcpNoDelay &&
+        !ApplyOne(fd, IPPROTO_TCP, TCP_NODELAY, 1, "TCP_NODELAY", tag)) {
+        ++failed;
+    }
+
+#ifdef __linux__
+    if (tcp && options.tcpQuickAck &&
+        !ApplyOne(fd, IPPROTO_TCP, TCP_QUICKACK, 1, "TCP_QUICKACK", tag)) {
+        ++failed;
+    }
+
+    if (options.busyPollUs > 0 &&
+        !ApplyOne(fd, SOL_SOCKET, SO_BUSY_POLL, options.busyPollUs, "SO_BUSY_POLL", tag)) {
+        ++failed;
+    }
+#else
+    if ((tcp && options.tcpQuickAck) || options.busyPollUs > 0) {
+        std::cout << "[ESSocketTuning][" << tag << "] TCP_QUICKACK/SO_BUSY_POLL not supported" << std::endl;
+        ++failed;
+    }
+#endif
+
+    return failed;
+}
+
+void RearmTcpQuickAck(int fd)
+{
+#ifdef __linux__
+    if (fd >= 0) {
+        SetIntOption(fd, IPPROTO_TCP, TCP_QUICKACK, 1);
+    }
+#else
+    (void)fd;
+#endif
+}
+
+std::string DescribeSocketOptions(int fd, bool tcp)
+{
+    std::ostringstream oss;
+    int value = 0;
+
+    if (GetIntOption(fd, SOL_SOCKET, SO_RCVBUF, value)) {
+        oss << "rcvbuf=" << value;
+    }
+    if (GetIntOption(fd, SOL_SOCKET, SO_SNDBUF, value)) {
+        oss << ", sndbuf=" << value;
+    }
+    if (tcp && GetIntOption(fd, IPPROTO_TCP, TCP_NODELAY, value)) {
+        oss << ", nodelay=" << value;
+    }
+#ifdef __linux__
+    if (tcp && GetIntOption(fd, IPPROTO_TCP, TCP_QUICKACK, value)) {
+        oss << ", quickack=" << value;
+    }
+    if (GetIntOption(fd, SOL_SOCKET, SO_BUSY_POLL, value)) {
+        oss << ", busy_poll=" << value;
+    }
+#endif
+
+    return oss.str();
+}
+
+int CreateReusePortListener(uint16_t port, const char* host)
+{
+#ifdef __linux__
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (host == nullptr || inet_pton(AF_INET, host, &addr.sin_addr) != 1) {
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    }
+
+    if (!SetIntOption(fd, SOL_SOCKET, SO_REUSEADDR, 1) ||
+        !SetIntOption(fd, SOL_SOCKET, SO_REUSEPORT, 1) ||
+        bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(fd, SOMAXCONN) != 0) {
+        std::cout << "[ESSocketTuning] reuseport listen " << port
+                  << " failed: " << std::strerror(errno) << std::endl;
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+#else
+    (void)port;
+    (void)host;
+    return -1;
+#endif
+}
+
+int CreateReusePortUdpSocket(uint16_t port, const char* host)
+{
+#ifdef __linux__
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (host == nullptr || inet_pton(AF_INET, host, &addr.sin_addr) != 1) {
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    }
+
+    if (!SetIntOption(fd, SOL_SOCKET, SO_REUSEADDR, 1) ||
+        !SetIntOption(fd, SOL_SOCKET, SO_REUSEPORT, 1) ||
+        bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        std::cout << "[ESSocketTuning] reuseport udp " << port
+                  << " failed: " << std::strerror(errno) << std::endl;
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+#else
+    (void)port;
+    (void)host;
+    return -1;
+#endif
+}
+
+bool AttachReusePortSteering(int fd, ESReusePortSteering steering, size_t shardCount)
+{
+    if (steering == ESReusePortSteering::Kernel) {
+        return true;
+    }
+
+#ifdef __linux__
+    if (fd < 0 || shardCount == 0) {
+        return false;
+    }
+
+    // 返回值是组内下标（按 bind 顺序），越界时内核回退到默认哈希
+    std::vector<sock_filter> code;
+    if (steering == ESReusePortSteering::PeerIp) {
+        // 程序看到的是传输层头，源地址要从网络层偏移取（TCP/UDP 一样）
+        code.push_back(BPF_STMT(BPF_LD | BPF_W | BPF_ABS, static_cast<uint32_t>(SKF_NET_OFF + 12)));
+    } else {
+        code.push_back(BPF_STMT(BPF_LD | BPF_W | BPF_ABS, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU)));
+    }
+    code.push_back(BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, static_cast<uint32_t>(shardCount)));
+    code.push_back(BPF_STMT(BPF_RET | BPF_A, 0));
+
+    sock_fprog prog;
+    prog.len = static_cast<unsigned short>(code.size());
+    prog.filter = code.data();
+
+    if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)) != 0) {
+        std::cout << "[ESSocketTuning] attach reuseport cbpf failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    return true;
+#else
+    (void)fd;
+    (void)shardCount;
+    return false;
+#endif
+}
+
+void CloseSocketFd(int fd)
+{
+    if (fd < 0) {
+        return;
+    }
+
+#ifdef _WIN32
+    closesocket(fd);
+#else
+    close(fd);
+#endif
+}
+
+} // namespace hhcast
\ No newline at end of file
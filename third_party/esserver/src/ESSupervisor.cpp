@@ -0,0 +1,575 @@
+#include "ESSupervisor.h"
+
+#include "ESHandoff.h"
+#include "ESPortManager.h"
+#include "ESServer.h"
+#include "ESSocketTuning.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace hhcast {
+
+namespace {
+
+constexpr int kPollIntervalMs = 200;           // 回收退出的 worker、检查重启的周期
+constexpr size_t kMaxAutoWorkers = 8;
+
+// worker 发给 supervisor 的定长上报，同一个二进制 fork 出来，直接按内存布局传
+struct WorkerReport {
+    uint64_t sessionCount = 0;
+    ESAdmissionStats admission;
+};
+
+uint64_t NowMs()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+#ifdef __linux__
+std::atomic<int> g_workerStopFd{ -1 };
+
+void OnWorkerSignal(int)
+{
+    const int fd = g_workerStopFd.load();
+    if (fd >= 0) {
+        const char byte = 1;
+        (void)!write(fd, &byte, 1);
+    }
+}
+
+void CloseFd(int& fd)
+{
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+#endif
+
+void AddAdmission(ESAdmissionStats& total, const ESAdmissionStats& item)
+{
+    total.accepted += item.accepted;
+    total.rejectedGlobal += item.rejectedGlobal;
+    total.rejectedPerIp += item.rejectedPerIp;
+    total.closedByRate += item.closedByRate;
+    total.droppedDatagrams += item.droppedDatagrams;
+    total.droppedBytes += item.droppedBytes;
+    total.activeConnections += item.activeConnections;
+}
+
+} // namespace
+
+struct ESSupervisor::Worker {
+    ESWorkerStats stats;
+    int reportFd = -1;                 // supervisor 一端
+    uint64_t restartAtMs = 0;          // 0 表示不需要重启
+    uint32_t restartDelayMs = 0;
+};
+
+ESSupervisor::ESSupervisor()
+{
+#ifdef __linux__
+    if (pipe2(m_stopPipe, O_CLOEXEC | O_NONBLOCK) != 0) {
+        m_stopPipe[0] = -1;
+        m_stopPipe[1] = -1;
+    }
+#endif
+}
+
+ESSupervisor::~ESSupervisor()
+{
+#ifdef __linux__
+    CloseFd(m_stopPipe[0]);
+    CloseFd(m_stopPipe[1]);
+#endif
+    CloseSockets();
+}
+
+void ESSupervisor::SetConfig(const ESSupervisorConfig& config, const ESServerConfig& serverConfig)
+{
+    m_config = config;
+    m_serverConfig = serverConfig;
+}
+
+void ESSupervisor::SetWorkerSetup(WorkerSetup setup)
+{
+    m_setup = std::move(setup);
+}
+
+void ESSupervisor::SetStatsCallback(StatsCallback callback)
+{
+    m_statsCallback = std::move(callback);
+}
+
+void ESSupervisor::RequestStop()
+{
+#ifdef __linux__
+    if (m_stopPipe[1] >= 0) {
+        const char byte = 1;
+        (void)!write(m_stopPipe[1], &byte, 1);
+    }
+#endif
+}
+
+int ESSupervisor::Run()
+{
+#ifdef __linux__
+    if (m_stopPipe[0] < 0) {
+        return -1;
+    }
+
+    m_workerCount = m_config.workers;
+    if (m_workerCount == 0) {
+        const unsigned int cores = std::thread::hardware_concurrency();
+        m_workerCount = std::min<size_t>(std::max(cores, 1u), kMaxAutoWorkers);
+    }
+
+    int ret = CreateSockets();
+    if (ret != 0) {
+        CloseSockets();
+        return ret;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_workers.assign(m_workerCount, Worker{});
+        for (size_t i = 0; i < m_workerCount; ++i) {
+            m_workers[i].stats.index = i;
+        }
+    }
+
+    for (size_t i = 0; i < m_workerCount; ++i) {
+        SpawnWorker(i);
+    }
+
+    std::cout << "[ESSupervisor] started, workers=" << m_workerCount << std::endl;
+
+    uint64_t lastStatsMs = NowMs();
+    std::vector<pollfd> fds;
+    std::vector<size_t> owners;
+    std::vector<size_t> readable;
+
+    while (true) {
+        fds.clear();
+        owners.clear();
+        fds.push_back({ m_stopPipe[0], POLLIN, 0 });
+        for (size_t i = 0; i < m_workers.size(); ++i) {
+            if (m_workers[i].reportFd >= 0) {
+                fds.push_back({ m_workers[i].reportFd, POLLIN, 0 });
+                owners.push_back(i);
+            }
+        }
+
+        const int n = poll(fds.data(), fds.size(), kPollIntervalMs);
+        if (n < 0 && errno != EINTR) {
+            std::cout << "[ESSupervisor] poll failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+
+        if (n > 0 && (fds[0].revents & POLLIN)) {
+            break;
+        }
+
+        const uint64_t nowMs = NowMs();
+
+        readable.clear();
+        for (size_t i = 1; n > 0 && i < fds.size(); ++i) {
+            if (fds[i].revents & POLLIN) {
+                readable.push_back(owners[i - 1]);
+            }
+        }
+        ReadReports(readable, nowMs);
+
+        ReapWorkers(nowMs);
+
+        for (size_t i = 0; i < m_workers.size(); ++i) {
+            const Worker& worker = m_workers[i];
+            if (!worker.stats.running && worker.restartAtMs != 0 && worker.restartAtMs <= nowMs) {
+                SpawnWorker(i);
+            }
+        }
+
+        if (nowMs - lastStatsMs >= m_config.statsIntervalMs) {
+            lastStatsMs = nowMs;
+            ReportStats();
+        }
+    }
+
+    StopWorkers();
+    CloseSockets();
+
+    // 清掉积压的停止请求，允许再次 Run
+    char drain[64];
+    while (read(m_stopPipe[0], drain, sizeof(drain)) > 0) {
+    }
+
+    std::cout << "[ESSupervisor] stopped" << std::endl;
+    return 0;
+#else
+    std::cout << "[ESSupervisor] multi-process mode requires Linux" << std::endl;
+    return -1;
+#endif
+}
+
+ESSupervisorStats ESSupervisor::GetStats() const
+{
+    ESSupervisorStats stats;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& worker : m_workers) {
+        stats.workers.push_back(worker.stats);
+        if (worker.stats.running) {
+            ++stats.runningWorkers;
+            stats.sessionCount += worker.stats.sessionCount;
+            AddAdmission(stats.admission, worker.stats.admission);
+        }
+        stats.restartCount += worker.stats.restartCount;
+    }
+    return stats;
+}
+
+int ESSupervisor::CreateSockets()
+{
+    CloseSockets();
+
+    std::vector<SocketGroup> groups;
+    for (uint16_t port : ESPortManager::GetFixedTcpPorts()) {
+        SocketGroup group;
+        group.port = port;
+        group.tcp = true;
+        groups.push_back(std::move(group));
+    }
+
+    SocketGroup mouse;
+    mouse.port = ESPortManager::GetDefaultMousePort();
+    mouse.tcp = false;
+    groups.push_back(std::move(mouse));
+
+    // 组内下标按 bind 顺序，fds[i] 就是 steering 选中 i 时的那个 socket
+    for (auto& group : groups) {
+        for (size_t i = 0; i < m_workerCount; ++i) {
+            const int fd = group.tcp ? CreateReusePortListener(group.port)
+                                     : CreateReusePortUdpSocket(group.port);
+            if (fd < 0) {
+                m_groups = std::move(groups);
+                return -100 - static_cast<int>(group.port);
+            }
+            group.fds.push_back(fd);
+        }
+
+        // 同一发送端的各个连接必须进同一个 worker，挂不上 steering 就不能分进程
+        if (m_workerCount > 1 &&
+            !AttachReusePortSteering(group.fds.front(), ESReusePortSteering::PeerIp, m_workerCount)) {
+            std::cout << "[ESSupervisor] attach steering on " << (group.tcp ? "tcp " : "udp ")
+                      << group.port << " failed" << std::endl;
+            m_groups = std::move(groups);
+            return -2;
+        }
+    }
+
+    m_groups = std::move(groups);
+    return 0;
+}
+
+void ESSupervisor::CloseSockets()
+{
+    for (auto& group : m_groups) {
+        for (int fd : group.fds) {
+            CloseSocketFd(fd);
+        }
+    }
+    m_groups.clear();
+}
+
+int ESSupervisor::SpawnWorker(size_t index)
+{
+#ifdef __linux__
+    Worker& worker = m_workers[index];
+
+    int pair[2] = { -1, -1 };
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, pair) != 0) {
+        std::cout << "[ESSupervisor] socketpair failed: " << std::strerror(errno) << std::endl;
+        worker.restartAtMs = NowMs() + m_config.restartDelayMs;
+        return -1;
+    }
+
+    std::cout.flush();
+    const pid_t pid = fork();
+    if (pid == 0) {
+        close(pair[0]);
+        RunWorker(index, pair[1]);
+    }
+
+    close(pair[1]);
+    if (pid < 0) {
+        std::cout << "[ESSupervisor] fork worker " << index << " failed: " << std::strerror(errno) << std::endl;
+        close(pair[0]);
+        worker.restartAtMs = NowMs() + m_config.restartDelayMs;
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const bool restart = worker.stats.startedMs != 0;
+    worker.reportFd = pair[0];
+    worker.restartAtMs = 0;
+    worker.stats.pid = pid;
+    worker.stats.running = true;
+    worker.stats.startedMs = NowMs();
+    worker.stats.reportedMs = 0;
+    worker.stats.sessionCount = 0;
+    worker.stats.admission = ESAdmissionStats{};
+    if (restart) {
+        ++worker.stats.restartCount;
+    }
+
+    std::cout << "[ESSupervisor] worker " << index << (restart ? " restarted" : " started")
+              << ", pid=" << pid << std::endl;
+    return 0;
+#else
+    (void)index;
+    return -1;
+#endif
+}
+
+void ESSupervisor::RunWorker(size_t index, int reportFd)
+{
+#ifdef __linux__
+    // supervisor 没了 worker 也跟着退出；fork 和 prctl 之间父进程就已退出的情况单独判断
+    const pid_t parent = getppid();
+    prctl(PR_SET_PDEATHSIG, SIGTERM);
+    if (getppid() != parent) {
+        _exit(1);
+    }
+
+    // 不继承 supervisor 的停止管道和其他 worker 的上报通道
+    CloseFd(m_stopPipe[0]);
+    CloseFd(m_stopPipe[1]);
+    for (auto& worker : m_workers) {
+        CloseFd(worker.reportFd);
+    }
+
+    int stopPipe[2] = { -1, -1 };
+    if (pipe2(stopPipe, O_CLOEXEC | O_NONBLOCK) != 0) {
+        _exit(2);
+    }
+    g_workerStopFd = stopPipe[1];
+
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = OnWorkerSignal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGTERM, &action, nullptr);
+    sigaction(SIGINT, &action, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+
+    // 每组只留自己那一个，其余关掉
+    ESHandoffState state;
+    for (auto& group : m_groups) {
+        for (size_t i = 0; i < group.fds.size(); ++i) {
+            if (i != index) {
+                CloseSocketFd(group.fds[i]);
+                continue;
+            }
+
+            ESHandoffSocket socket;
+            socket.kind = group.tcp ? ESHandoffSocketKind::TcpListener : ESHandoffSocketKind::UdpMouse;
+            socket.localPort = group.port;
+            socket.fd = group.fds[i];
+            state.sockets.push_back(std::move(socket));
+        }
+        group.fds.clear();
+    }
+    m_groups.clear();
+
+    ESServerConfig config = m_serverConfig;
+    config.handoff.enabled = false;
+
+    int exitCode = 0;
+    {
+        ESServer server;
+        server.SetConfig(config);
+        if (m_setup) {
+            m_setup(server, index);
+        }
+        server.SetInheritedSockets(&state);
+
+        if (server.StartServer() != 0) {
+            std::cout << "[ESSupervisor] worker " << index << " start server failed" << std::endl;
+            exitCode = 3;
+        } else {
+            const int intervalMs = static_cast<int>(std::max<uint32_t>(m_config.statsIntervalMs, 100));
+            while (true) {
+                pollfd fds[2] = {
+                    { stopPipe[0], POLLIN, 0 },
+                    { reportFd, POLLIN, 0 },
+                };
+                const int n = poll(fds, 2, intervalMs);
+                if (n < 0 && errno != EINTR) {
+                    break;
+                }
+                if (n > 0 && ((fds[0].revents & POLLIN) || (fds[1].revents & (POLLHUP | POLLERR)))) {
+                    break;
+                }
+
+                WorkerReport report;
+                report.sessionCount = server.GetSessionCount();
+                report.admission = server.GetAdmissionStats();
+                send(reportFd, &report, sizeof(report), MSG_DONTWAIT | MSG_NOSIGNAL);
+            }
+
+            server.StopServer();
+        }
+    }
+
+    std::cout.flush();
+    _exit(exitCode);
+#else
+    (void)index;
+    (void)reportFd;
+    std::abort();
+#endif
+}
+
+void ESSupervisor::ReapWorkers(uint64_t nowMs)
+{
+#ifdef __linux__
+    int status = 0;
+    pid_t pid = 0;
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& worker : m_workers) {
+            if (worker.stats.pid != pid) {
+                continue;
+            }
+
+            CloseFd(worker.reportFd);
+            worker.stats.running = false;
+            worker.stats.pid = 0;
+            worker.stats.lastExitStatus = status;
+
+            // 跑稳了再退出按偶发处理，否则连续崩溃逐次加长等待
+            const uint64_t uptimeMs = nowMs - worker.stats.startedMs;
+            if (worker.restartDelayMs == 0 || uptimeMs >= m_config.stableUptimeMs) {
+                worker.restartDelayMs = m_config.restartDelayMs;
+            } else {
+                worker.restartDelayMs = std::min(worker.restartDelayMs * 2, m_config.maxRestartDelayMs);
+            }
+            worker.restartAtMs = nowMs + std::max<uint32_t>(worker.restartDelayMs, 1);
+
+            std::cout << "[ESSupervisor] worker " << worker.stats.index << " pid=" << pid;
+            if (WIFSIGNALED(status)) {
+                std::cout << " killed by signal " << WTERMSIG(status);
+            } else {
+                std::cout << " exited, code=" << WEXITSTATUS(status);
+            }
+            std::cout << ", uptime=" << uptimeMs << "ms, restart in " << worker.restartDelayMs << "ms" << std::endl;
+            break;
+        }
+    }
+#else
+    (void)nowMs;
+#endif
+}
+
+void ESSupervisor::ReadReports(const std::vector<size_t>& readable, uint64_t nowMs)
+{
+#ifdef __linux__
+    for (size_t index : readable) {
+        Worker& worker = m_workers[index];
+
+        // 只保留最新的一条
+        WorkerReport report;
+        bool received = false;
+        while (worker.reportFd >= 0) {
+            WorkerReport item;
+            const ssize_t n = recv(worker.reportFd, &item, sizeof(item), MSG_DONTWAIT);
+            if (n != static_cast<ssize_t>(sizeof(item))) {
+                break;
+            }
+            report = item;
+            received = true;
+        }
+
+        if (received) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            worker.stats.sessionCount = report.sessionCount;
+            worker.stats.admission = report.admission;
+            worker.stats.reportedMs = nowMs;
+        }
+    }
+#else
+    (void)readable;
+    (void)nowMs;
+#endif
+}
+
+void ESSupervisor::StopWorkers()
+{
+#ifdef __linux__
+    for (const auto& worker : m_workers) {
+        if (worker.stats.running && worker.stats.pid > 0) {
+            kill(worker.stats.pid, SIGTERM);
+        }
+    }
+
+    auto anyRunning = [this]() {
+        for (const auto& worker : m_workers) {
+            if (worker.stats.running) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    const uint64_t deadlineMs = NowMs() + m_config.stopTimeoutMs;
+    while (anyRunning() && NowMs() < deadlineMs) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        ReapWorkers(NowMs());
+    }
+
+    for (auto& worker : m_workers) {
+        if (worker.stats.running && worker.stats.pid > 0) {
+            std::cout << "[ESSupervisor] worker " << worker.stats.index << " did not exit, kill" << std::endl;
+            kill(worker.stats.pid, SIGKILL);
+            waitpid(worker.stats.pid, nullptr, 0);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& worker : m_workers) {
+        CloseFd(worker.reportFd);
+        worker.stats.running = false;
+        worker.stats.pid = 0;
+        worker.restartAtMs = 0;
+    }
+#endif
+}
+
+void ESSupervisor::ReportStats()
+{
+    if (!m_statsCallback) {
+        return;
+    }
+
+    m_statsCallback(GetStats());
+}
+
+} // namespace hhcast
\ No newline at end of file
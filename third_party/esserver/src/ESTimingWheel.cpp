@@ -0,0 +1,177 @@
+#include "ESTimingWheel.h"
+
+#include <algorithm>
+
+namespace hhcast {
+
+namespace {
+
+constexpr uint64_t kMaxDeltaTicks =
+    (1ull << (ESTimingWheel::kSlotBits * ESTimingWheel::kLevelCount)) - 1;
+
+} // namespace
+
+ESTimingWheel::ESTimingWheel(uint32_t tickMs)
+    : m_tickMs(std::max<uint32_t>(tickMs, 1))
+{
+}
+
+void ESTimingWheel::SyncStart(uint64_t nowMs)
+{
+    if (m_started) {
+        return;
+    }
+
+    m_started = true;
+    m_startMs = nowMs;
+    m_currentTick = 0;
+}
+
+void ESTimingWheel::Schedule(uint64_t key, uint64_t delayMs, uint64_t nowMs)
+{
+    SyncStart(nowMs);
+
+    const uint64_t nowTick = (nowMs > m_startMs) ? (nowMs - m_startMs) / m_tickMs : 0;
+    const uint64_t delayTicks = std::max<uint64_t>((delayMs + m_tickMs - 1) / m_tickMs, 1);
+
+    // 超出 4 层范围的延时提前到最远槽位到期，调用方到期时再检查一次即可
+    uint64_t expireTick = std::max(nowTick, m_currentTick) + delayTicks;
+    expireTick = std::min(expireTick, m_currentTick + kMaxDeltaTicks);
+
+    Entry& entry = m_entries[key];
+    entry.expireTick = expireTick;
+    entry.generation = ++m_nextGeneration;
+    Place(key, entry);
+}
+
+bool ESTimingWheel::Cancel(uint64_t key)
+{
+    return m_entries.erase(key) > 0;
+}
+
+bool ESTimingWheel::Contains(uint64_t key) const
+{
+    return m_entries.find(key) != m_entries.end();
+}
+
+void ESTimingWheel::Place(uint64_t key, const Entry& entry)
+{
+    const uint64_t delta = (entry.expireTick > m_currentTick) ? entry.expireTick - m_currentTick : 0;
+
+    uint32_t level = 0;
+    while (level + 1 < kLevelCount && delta >= (1ull << (kSlotBits * (level + 1)))) {
+        ++level;
+    }
+
+    const size_t slot = static_cast<size_t>((entry.expireTick >> (kSlotBits * level)) & (kSlotCount - 1));
+    m_slots[level][slot].emplace_back(key, entry.generation);
+}
+
+void ESTimingWheel::Cascade(uint32_t level)
+{
+    const size_t slot = static_cast<size_t>((m_currentTick >> (kSlotBits * level)) & (kSlotCount - 1));
+
+    Slot items;
+    items.swap(m_slots[level][slot]);
+
+    for (const auto& item : items) {
+        auto it = m_entries.find(item.first);
+        if (it == m_entries.end() || it->second.generation != item.second) {
+            continue;
+        }
+        Place(item.first, it->second);
+    }
+
+    // 换回去复用容量
+    items.clear();
+    if (m_slots[level][slot].empty()) {
+        m_slots[level][slot].swap(items);
+    }
+}
+
+size_t ESTimingWheel::Advance(uint64_t nowMs, const ExpireCallback& onExpire)
+{
+    SyncStart(nowMs);
+
+    const uint64_t targetTick = (nowMs > m_startMs) ? (nowMs - m_startMs) / m_tickMs : 0;
+    if (targetTick <= m_currentTick) {
+        return 0;
+    }
+
+    if (m_entries.empty()) {
+        // 空轮直接跳过；槽位里只剩失效记录，一并清掉
+        Clear();
+        m_started = true;
+        m_currentTick = targetTick;
+        return 0;
+    }
+
+    m_expired.clear();
+
+    while (m_currentTick < targetTick) {
+        ++m_currentTick;
+
+        // 低位全部归零的层需要把下一段下放，先高层后低层
+        uint32_t top = 0;
+        for (uint32_t level = 1; level < kLevelCount; ++level) {
+            const uint64_t mask = (1ull << (kSlotBits * level)) - 1;
+            if ((m_currentTick & mask) != 0) {
+                break;
+            }
+            top = level;
+        }
+        for (uint32_t level = top; level >= 1; --level) {
+            Cascade(level);
+        }
+
+        Slot& slot = m_slots[0][m_currentTick & (kSlotCount - 1)];
+        for (const auto& item : slot) {
+            auto it = m_entries.find(item.first);
+            if (it == m_entries.end() || it->second.generation != item.second) {
+                continue;
+            }
+            m_entries.erase(it);
+            m_expired.push_back(item.first);
+        }
+        slot.clear();
+    }
+
+    // 回调里可能重新调度，先把到期列表换出来
+    std::vector<uint64_t> expired;
+    expired.swap(m_expired);
+    if (onExpire) {
+        for (uint64_t key : expired) {
+            onExpire(key);
+        }
+    }
+
+    const size_t count = expired.size();
+    expired.clear();
+    if (m_expired.empty()) {
+        m_expired.swap(expired);
+    }
+    return count;
+}
+
+void ESTimingWheel::Clear()
+{
+    for (auto& level : m_slots) {
+        for (auto& slot : level) {
+            slot.clear();
+        }
+    }
+    m_entries.clear();
+    m_expired.clear();
+}
+
+uint32_t ESTimingWheel::GetTickMs() const
+{
+    return m_tickMs;
+}
+
+size_t ESTimingWheel::GetPendingCount() const
+{
+    return m_entries.size();
+}
+
+} // namespace hhcast
\ No newline at end of file
@@ -0,0 +1,544 @@
+#include "ESUdpBatchReceiver.h"
+#include "ESUring.h"
+#include "ESUtils.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+namespace hhcast {
+
+namespace {
+
+constexpr int kRecvTimeoutMs = 200;   // 阻塞 recvmmsg / io_uring_enter 的超时，用于及时响应 Stop
+
+#ifdef __linux__
+// SO_TIMESTAMPNS 是 CLOCK_REALTIME，会话里其他时间都是 steady_clock。
+// 每批收包后同时取一次两个时钟，用"包在内核里已经待了多久"把内核时间换算到 steady 上，
+// 这样墙钟被 NTP 调整时也不会把两种时基混在一起
+struct ClockPair {
+    uint64_t realtimeUs = 0;
+    uint64_t steadyUs = 0;
+
+    static ClockPair Now()
+    {
+        ClockPair pair;
+        timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        pair.realtimeUs = static_cast<uint64_t>(ts.tv_sec) * 1000000 + static_cast<uint64_t>(ts.tv_nsec) / 1000;
+        pair.steadyUs = GetSteadyTimeUs();
+        return pair;
+    }
+
+    uint64_t ToSteadyUs(uint64_t kernelRealtimeUs) const
+    {
+        const uint64_t ageUs = (realtimeUs > kernelRealtimeUs) ? (realtimeUs - kernelRealtimeUs) : 0;
+        return (steadyUs > ageUs) ? (steadyUs - ageUs) : 0;
+    }
+};
+
+void ReadControlMessages(msghdr* hdr, const ClockPair& clocks, ESUdpDatagram& datagram,
+                         std::atomic<uint64_t>& kernelDropCount)
+{
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(hdr); cmsg != nullptr; cmsg = CMSG_NXTHDR(hdr, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET) {
+            continue;
+        }
+
+        if (cmsg->cmsg_type == SO_TIMESTAMPNS) {
+            timespec ts;
+            std::memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+            datagram.kernelTimestampUs = clocks.ToSteadyUs(
+                static_cast<uint64_t>(ts.tv_sec) * 1000000 +
+                static_cast<uint64_t>(ts.tv_nsec) / 1000);
+        } else if (cmsg->cmsg_type == SO_RXQ_OVFL) {
+            uint32_t drops = 0;
+            std::memcpy(&drops, CMSG_DATA(cmsg), sizeof(drops));
+            kernelDropCount = drops;
+        }
+    }
+}
+#endif
+
+} // namespace
+
+#ifdef __linux__
+
+struct ESUdpBatchReceiver::BatchStorage {
+    // timespec + uint32 两条 cmsg，留足余量
+    static constexpr size_t kControlSize =
+        CMSG_SPACE(sizeof(timespec)) + CMSG_SPACE(sizeof(uint32_t)) + 64;
+
+    size_t batchSize = 0;
+    size_t maxDatagramSize = 0;
+
+    std::vector<uint8_t> buffers;
+    std::vector<uint8_t> controls;
+    std::vector<iovec> iovecs;
+    std::vector<sockaddr_in> addrs;
+    std::vector<mmsghdr> msgs;
+    std::vector<ESUdpDatagram> datagrams;
+
+    void Allocate(size_t batch, size_t maxSize)
+    {
+        batchSize = batch;
+        maxDatagramSize = maxSize;
+
+        buffers.assign(batch * maxSize, 0);
+        controls.assign(batch * kControlSize, 0);
+        iovecs.assign(batch, iovec{});
+        addrs.assign(batch, sockaddr_in{});
+        msgs.assign(batch, mmsghdr{});
+        datagrams.assign(batch, ESUdpDatagram{});
+
+        for (size_t i = 0; i < batch; ++i) {
+            iovecs[i].iov_base = buffers.data() + i * maxSize;
+            iovecs[i].iov_len = maxSize;
+        }
+    }
+
+    // 每次收包前重置 msg_namelen/msg_controllen，内核会改写它们
+    void Rearm()
+    {
+        for (size_t i = 0; i < batchSize; ++i) {
+            msghdr& hdr = msgs[i].msg_hdr;
+            hdr.msg_name = &addrs[i];
+            hdr.msg_namelen = sizeof(sockaddr_in);
+            hdr.msg_iov = &iovecs[i];
+            hdr.msg_iovlen = 1;
+            hdr.msg_control = controls.data() + i * kControlSize;
+            hdr.msg_controllen = kControlSize;
+            hdr.msg_flags = 0;
+            msgs[i].msg_len = 0;
+        }
+    }
+};
+
+// 缓冲环里每个缓冲：recvmsg 固定头 + sockaddr_in + 控制消息 + 载荷
+struct ESUdpBatchReceiver::UringStorage {
+    static constexpr uint16_t kBufferGroup = 0;
+    static constexpr uint64_t kRecvTag = 1;
+    static constexpr uint64_t kCancelTag = 2;
+
+    ESUring uring;
+    ESUringBufferRing buffers;
+    msghdr msg;                        // 只用 namelen/controllen 描述缓冲布局
+    std::vector<ESUdpDatagram> datagrams;
+    std::vector<uint16_t> used;
+
+    int Init(size_t batchSize, size_t maxDatagramSize)
+    {
+        std::memset(&msg, 0, sizeof(msg));
+        msg.msg_namelen = sizeof(sockaddr_in);
+        msg.msg_controllen = BatchStorage::kControlSize;
+
+        int ret = uring.Init(16);
+        if (ret != 0) {
+            return ret;
+        }
+
+        const size_t bufferSize = ESUring::GetRecvMsgHeaderSize() + sizeof(sockaddr_in) +
+                                  BatchStorage::kControlSize + maxDatagramSize;
+        ret = buffers.Register(uring, kBufferGroup, static_cast<uint32_t>(batchSize * 4),
+                               static_cast<uint32_t>(bufferSize));
+        if (ret != 0) {
+            return ret;
+        }
+
+        datagrams.assign(buffers.GetBufferCount(), ESUdpDatagram{});
+        used.reserve(buffers.GetBufferCount());
+        return 0;
+    }
+};
+
+#else
+
+struct ESUdpBatchReceiver::BatchStorage {
+};
+
+struct ESUdpBatchReceiver::UringStorage {
+};
+
+#endif
+
+ESUdpBatchReceiver::ESUdpBatchReceiver() = default;
+
+ESUdpBatchReceiver::~ESUdpBatchReceiver()
+{
+    Stop();
+}
+
+bool ESUdpBatchReceiver::IsSupported()
+{
+#ifdef __linux__
+    return true;
+#else
+    return false;
+#endif
+}
+
+void ESUdpBatchReceiver::SetCallback(ESUdpBatchCallback callback)
+{
+    m_callback = std::move(callback);
+}
+
+int ESUdpBatchReceiver::Start(uint16_t bindPort, size_t batchSize, size_t maxDatagramSize, bool kernelTimestamps,
+                              bool useIoUring)
+{
+#ifdef __linux__
+    if (m_running.load()) {
+        return 0;
+    }
+
+    if (batchSize == 0 || maxDatagramSize == 0) {
+        return -1;
+    }
+
+    const int fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (fd < 0) {
+        std::cout << "[ESUdpBatchReceiver] create socket failed" << std::endl;
+        return -1;
+    }
+
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(bindPort);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+        std::cout << "[ESUdpBatchReceiver] bind " << bindPort << " failed" << std::endl;
+        close(fd);
+        return -2;
+    }
+
+    return StartWithSocket(fd, batchSize, maxDatagramSize, kernelTimestamps, useIoUring);
+#else
+    (void)bindPort;
+    (void)batchSize;
+    (void)maxDatagramSize;
+    (void)kernelTimestamps;
+    (void)useIoUring;
+    return -1;
+#endif
+}
+
+int ESUdpBatchReceiver::StartWithSocket(int fd, size_t batchSize, size_t maxDatagramSize, bool kernelTimestamps,
+                                        bool useIoUring)
+{
+#ifdef __linux__
+    if (m_running.load() || fd < 0) {
+        return -1;
+    }
+
+    if (batchSize == 0 || maxDatagramSize == 0) {
+        close(fd);
+        return -1;
+    }
+
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    socklen_t addrLen = sizeof(addr);
+    if (getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &addrLen) != 0) {
+        close(fd);
+        return -3;
+    }
+
+    // 接管来的 socket 可能是非阻塞的，收包线程依赖 SO_RCVTIMEO 阻塞等待
+    const int flags = fcntl(fd, F_GETFL, 0);
+    if (flags >= 0 && (flags & O_NONBLOCK) != 0) {
+        fcntl(fd, F_SETFL, flags & ~O_NONBLOCK);
+    }
+
+    const int on = 1;
+    if (kernelTimestamps) {
+        setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on));
+    }
+    setsockopt(fd, SOL_SOCKET, SO_RXQ_OVFL, &on, sizeof(on));
+
+    timeval tv;
+    tv.tv_sec = 0;
+    tv.tv_usec = kRecvTimeoutMs * 1000;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    m_uring.reset();
+    if (useIoUring && ESUring::IsSupported()) {
+        auto uring = std::make_unique<UringStorage>();
+        const int ret = uring->Init(batchSize, maxDatagramSize);
+        if (ret == 0) {
+            m_uring = std::move(uring);
+        } else {
+            std::cout << "[ESUdpBatchReceiver] io_uring init failed, ret=" << ret
+                      << ", fallback to recvmmsg" << std::endl;
+        }
+    }
+
+    if (!m_uring) {
+        m_storage = std::make_unique<BatchStorage>();
+        m_storage->Allocate(batchSize, maxDatagramSize);
+    }
+
+    m_socket = fd;
+    m_localPort = ntohs(addr.sin_port);
+    m_batchCount = 0;
+    m_datagramCount = 0;
+    m_truncatedCount = 0;
+    m_kernelDropCount = 0;
+
+    m_running = true;
+    m_thread = m_uring ? std::thread(&ESUdpBatchReceiver::UringLoop, this)
+                       : std::thread(&ESUdpBatchReceiver::RecvLoop, this);
+    return 0;
+#else
+    (void)fd;
+    (void)batchSize;
+    (void)maxDatagramSize;
+    (void)kernelTimestamps;
+    (void)useIoUring;
+    return -1;
+#endif
+}
+
+void ESUdpBatchReceiver::Stop()
+{
+    if (!m_running.exchange(false)) {
+        return;
+    }
+
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    // 先关环，挂着的 multishot 请求才会放掉对 socket 的引用
+    m_uring.reset();
+
+#ifdef __linux__
+    if (m_socket >= 0) {
+        close(m_socket);
+    }
+#endif
+
+    m_socket = -1;
+    m_localPort = 0;
+    m_storage.reset();
+}
+
+void ESUdpBatchReceiver::SetPaused(bool paused)
+{
+    m_pauseAcked = false;
+    m_paused = paused;
+    if (!paused || !m_running.load()) {
+        return;
+    }
+
+    // 正在阻塞的 recvmmsg 最多等到 SO_RCVTIMEO 才返回
+    for (int waited = 0; waited < kRecvTimeoutMs * 2 && !m_pauseAcked.load(); waited += 5) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+}
+
+bool ESUdpBatchReceiver::IsRunning() const
+{
+    return m_running.load();
+}
+
+bool ESUdpBatchReceiver::IsUsingIoUring() const
+{
+    return m_uring != nullptr;
+}
+
+uint16_t ESUdpBatchReceiver::GetLocalPort() const
+{
+    return m_localPort;
+}
+
+int ESUdpBatchReceiver::GetSocket() const
+{
+    return m_socket;
+}
+
+uint64_t ESUdpBatchReceiver::GetBatchCount() const
+{
+    return m_batchCount.load();
+}
+
+uint64_t ESUdpBatchReceiver::GetDatagramCount() const
+{
+    return m_datagramCount.load();
+}
+
+uint64_t ESUdpBatchReceiver::GetTruncatedCount() const
+{
+    return m_truncatedCount.load();
+}
+
+uint64_t ESUdpBatchReceiver::GetKernelDropCount() const
+{
+    return m_kernelDropCount.load();
+}
+
+void ESUdpBatchReceiver::RecvLoop()
+{
+#ifdef __linux__
+    BatchStorage& storage = *m_storage;
+
+    while (m_running.load()) {
+        if (m_paused.load()) {
+            m_pauseAcked = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+
+        storage.Rearm();
+
+        // MSG_WAITFORONE：至少等到一个包，之后有多少取多少，不再阻塞
+        const int n = recvmmsg(m_socket, storage.msgs.data(),
+                               static_cast<unsigned int>(storage.batchSize),
+                               MSG_WAITFORONE, nullptr);
+        if (n <= 0) {
+            continue;
+        }
+
+        const ClockPair clocks = ClockPair::Now();
+        for (int i = 0; i < n; ++i) {
+            const mmsghdr& msg = storage.msgs[i];
+            ESUdpDatagram& datagram = storage.datagrams[i];
+
+            datagram.data = static_cast<const uint8_t*>(storage.iovecs[i].iov_base);
+            datagram.size = msg.msg_len;
+            datagram.peerIp = ntohl(storage.addrs[i].sin_addr.s_addr);
+            datagram.peerPort = ntohs(storage.addrs[i].sin_port);
+            datagram.kernelTimestampUs = 0;
+            datagram.truncated = (msg.msg_hdr.msg_flags & MSG_TRUNC) != 0;
+
+            if (datagram.truncated) {
+                ++m_truncatedCount;
+            }
+
+            ReadControlMessages(const_cast<msghdr*>(&msg.msg_hdr), clocks, datagram, m_kernelDropCount);
+        }
+
+        ++m_batchCount;
+        m_datagramCount += static_cast<uint64_t>(n);
+
+        if (m_callback) {
+            m_callback(storage.datagrams.data(), static_cast<size_t>(n));
+        }
+    }
+#endif
+}
+
+void ESUdpBatchReceiver::UringLoop()
+{
+#ifdef __linux__
+    UringStorage& storage = *m_uring;
+    bool armed = false;
+    bool cancelling = false;
+
+    while (m_running.load()) {
+        // 暂停时要撤掉 multishot 请求，否则内核仍会往缓冲里收包
+        if (m_paused.load()) {
+            if (!armed) {
+                m_pauseAcked = true;
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                continue;
+            }
+            if (!cancelling) {
+                cancelling = storage.uring.PrepCancel(UringStorage::kRecvTag, UringStorage::kCancelTag);
+            }
+        } else if (!armed) {
+            armed = storage.uring.PrepRecvMsgMultishot(m_socket, &storage.msg, UringStorage::kBufferGroup,
+                                                       UringStorage::kRecvTag);
+            cancelling = false;
+        }
+
+        // 一次 enter 既提交又等待，返回后把所有已完成的包一起交出去
+        if (storage.uring.Submit(1, kRecvTimeoutMs) < 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        ++m_batchCount;
+
+        size_t n = 0;
+        const ClockPair clocks = ClockPair::Now();
+        storage.uring.DrainCompletions([&](const ESUringCompletion& completion) {
+            if (completion.userData != UringStorage::kRecvTag) {
+                return;
+            }
+
+            // 缓冲用尽（-ENOBUFS）等情况内核会结束 multishot，回收缓冲后重新挂
+            if (!completion.HasMore()) {
+                armed = false;
+                cancelling = false;
+            }
+
+            if (!completion.HasBuffer()) {
+                return;
+            }
+
+            const uint16_t bufferId = completion.GetBufferId();
+            storage.used.push_back(bufferId);
+            if (completion.result <= 0 || n >= storage.datagrams.size()) {
+                return;
+            }
+
+            ESUringRecvMsgView view;
+            if (!ESUring::ParseRecvMsg(storage.buffers.GetBuffer(bufferId),
+                                       static_cast<size_t>(completion.result), storage.msg, view)) {
+                return;
+            }
+
+            ESUdpDatagram& datagram = storage.datagrams[n++];
+            datagram.data = view.payload;
+            datagram.size = view.payloadLen;
+            datagram.peerIp = 0;
+            datagram.peerPort = 0;
+            datagram.kernelTimestampUs = 0;
+            datagram.truncated = view.truncated;
+
+            if (view.nameLen >= sizeof(sockaddr_in)) {
+                sockaddr_in addr;
+                std::memcpy(&addr, view.name, sizeof(addr));
+                datagram.peerIp = ntohl(addr.sin_addr.s_addr);
+                datagram.peerPort = ntohs(addr.sin_port);
+            }
+
+            if (datagram.truncated) {
+                ++m_truncatedCount;
+            }
+
+            msghdr hdr;
+            std::memset(&hdr, 0, sizeof(hdr));
+            hdr.msg_control = const_cast<uint8_t*>(view.control);
+            hdr.msg_controllen = view.controlLen;
+            ReadControlMessages(&hdr, clocks, datagram, m_kernelDropCount);
+        });
+
+        if (n > 0) {
+            m_datagramCount += static_cast<uint64_t>(n);
+            if (m_callback) {
+                m_callback(storage.datagrams.data(), n);
+            }
+        }
+
+        // 回调返回后 datagram 指向的缓冲才能还给内核
+        for (uint16_t bufferId : storage.used) {
+            storage.buffers.Recycle(bufferId);
+        }
+        if (!storage.used.empty()) {
+            storage.buffers.Commit();
+            storage.used.clear();
+        }
+    }
+#endif
+}
+
+} // namespace hhcast
\ No newline at end of file
@@ -0,0 +1,580 @@
+#include "ESUring.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#if defined(__linux__) && defined(ESSERVER_WITH_IO_URING)
+#include <arpa/inet.h>
+#include <linux/io_uring.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define ES_HAS_IO_URING 1
+#endif
+
+namespace hhcast {
+
+#ifdef ES_HAS_IO_URING
+
+namespace {
+
+constexpr uint32_t kMaxBufferCount = 32768;
+
+int SysSetup(uint32_t entries, io_uring_params* params)
+{
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int SysEnter(int fd, uint32_t toSubmit, uint32_t minComplete, uint32_t flags, void* arg, size_t argSize)
+{
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, arg, argSize));
+}
+
+int SysRegister(int fd, uint32_t opcode, void* arg, uint32_t count)
+{
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+uint32_t RoundUpPowerOfTwo(uint32_t value)
+{
+    uint32_t result = 1;
+    while (result < value && result < kMaxBufferCount) {
+        result <<= 1;
+    }
+    return result;
+}
+
+// 本机回环上真收一个包，确认 multishot recvmsg 和提供缓冲环都能用
+bool ProbeRecvMsgMultishot()
+{
+    ESUring uring;
+    if (uring.Init(8) != 0) {
+        return false;
+    }
+
+    ESUringBufferRing buffers;
+    if (buffers.Register(uring, 0, 2, 256) != 0) {
+        return false;
+    }
+
+    const int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addrLen = sizeof(addr);
+
+    bool ok = false;
+    msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_namelen = sizeof(sockaddr_in);
+
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0 &&
+        getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &addrLen) == 0 &&
+        uring.PrepRecvMsgMultishot(fd, &msg, 0, 1) && uring.Submit(0, 0) >= 0 &&
+        sendto(fd, "p", 1, 0, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 1 &&
+        uring.Submit(1, 200) >= 0) {
+        uring.DrainCompletions([&ok](const ESUringCompletion& completion) {
+            if (completion.userData == 1 && completion.result > 0 &&
+                completion.HasBuffer() && completion.HasMore()) {
+                ok = true;
+            }
+        });
+    }
+
+    buffers.Unregister();
+    uring.Close();
+    close(fd);
+    return ok;
+}
+
+} // namespace
+
+//
+// ESUringCompletion
+//
+
+bool ESUringCompletion::HasMore() const
+{
+    return (flags & IORING_CQE_F_MORE) != 0;
+}
+
+bool ESUringCompletion::HasBuffer() const
+{
+    return (flags & IORING_CQE_F_BUFFER) != 0;
+}
+
+uint16_t ESUringCompletion::GetBufferId() const
+{
+    return static_cast<uint16_t>(flags >> IORING_CQE_BUFFER_SHIFT);
+}
+
+//
+// ESUring
+//
+
+ESUring::ESUring() = default;
+
+ESUring::~ESUring()
+{
+    Close();
+}
+
+bool ESUring::IsSupported()
+{
+    static const bool supported = ProbeRecvMsgMultishot();
+    return supported;
+}
+
+size_t ESUring::GetRecvMsgHeaderSize()
+{
+    return sizeof(io_uring_recvmsg_out);
+}
+
+bool ESUring::ParseRecvMsg(const uint8_t* buffer, size_t size, const msghdr& msg, ESUringRecvMsgView& view)
+{
+    if (buffer == nullptr || size < sizeof(io_uring_recvmsg_out)) {
+        return false;
+    }
+
+    io_uring_recvmsg_out out;
+    std::memcpy(&out, buffer, sizeof(out));
+
+    size_t offset = sizeof(out);
+    view.name = buffer + offset;
+    view.nameLen = (out.namelen < msg.msg_namelen) ? out.namelen : msg.msg_namelen;
+    offset += msg.msg_namelen;
+
+    view.control = buffer + offset;
+    view.controlLen = (out.controllen < msg.msg_controllen) ? out.controllen
+                                                             : static_cast<uint32_t>(msg.msg_controllen);
+    offset += msg.msg_controllen;
+
+    if (offset > size) {
+        return false;
+    }
+
+    const size_t available = size - offset;
+    view.payload = buffer + offset;
+    view.payloadLen = (out.payloadlen < available) ? out.payloadlen : available;
+    view.truncated = (out.flags & MSG_TRUNC) != 0 || out.payloadlen > available;
+    return true;
+}
+
+int ESUring::Init(uint32_t entries)
+{
+    Close();
+
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CLAMP;
+
+    m_fd = SysSetup(entries, &params);
+    if (m_fd < 0) {
+        return -errno;
+    }
+
+    // 只支持单次 mmap 和带超时的 enter（5.11+），更老的内核走回退路径
+    if ((params.features & IORING_FEAT_SINGLE_MMAP) == 0 || (params.features & IORING_FEAT_EXT_ARG) == 0) {
+        Close();
+        return -ENOTSUP;
+    }
+
+    const size_t sqBytes = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    const size_t cqBytes = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    m_ringBytes = (sqBytes > cqBytes) ? sqBytes : cqBytes;
+
+    m_ringPtr = mmap(nullptr, m_ringBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     m_fd, IORING_OFF_SQ_RING);
+    if (m_ringPtr == MAP_FAILED) {
+        m_ringPtr = nullptr;
+        Close();
+        return -ENOMEM;
+    }
+
+    m_sqesBytes = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, m_sqesBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      m_fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        Close();
+        return -ENOMEM;
+    }
+    m_sqes = static_cast<io_uring_sqe*>(sqes);
+
+    uint8_t* ring = static_cast<uint8_t*>(m_ringPtr);
+    m_sqHead = reinterpret_cast<uint32_t*>(ring + params.sq_off.head);
+    m_sqTail = reinterpret_cast<uint32_t*>(ring + params.sq_off.tail);
+    m_sqMask = *reinterpret_cast<uint32_t*>(ring + params.sq_off.ring_mask);
+    m_sqEntries = params.sq_entries;
+
+    // sqe 下标和数组位置一一对应，之后只推 tail
+    uint32_t* array = reinterpret_cast<uint32_t*>(ring + params.sq_off.array);
+    for (uint32_t i = 0; i < m_sqEntries; ++i) {
+        array[i] = i;
+    }
+    m_sqeTail = *m_sqTail;
+    m_sqeSubmitted = m_sqeTail;
+
+    m_cqHead = reinterpret_cast<uint32_t*>(ring + params.cq_off.head);
+    m_cqTail = reinterpret_cast<uint32_t*>(ring + params.cq_off.tail);
+    m_cqMask = *reinterpret_cast<uint32_t*>(ring + params.cq_off.ring_mask);
+    m_cqes = ring + params.cq_off.cqes;
+
+    m_enterCount = 0;
+    m_completionCount = 0;
+    return 0;
+}
+
+void ESUring::Close()
+{
+    if (m_sqes != nullptr) {
+        munmap(m_sqes, m_sqesBytes);
+        m_sqes = nullptr;
+    }
+
+    if (m_ringPtr != nullptr) {
+        munmap(m_ringPtr, m_ringBytes);
+        m_ringPtr = nullptr;
+    }
+
+    if (m_fd >= 0) {
+        close(m_fd);
+        m_fd = -1;
+    }
+
+    m_sqHead = nullptr;
+    m_sqTail = nullptr;
+    m_cqHead = nullptr;
+    m_cqTail = nullptr;
+    m_cqes = nullptr;
+}
+
+bool ESUring::IsOpen() const
+{
+    return m_fd >= 0;
+}
+
+int ESUring::GetFd() const
+{
+    return m_fd;
+}
+
+io_uring_sqe* ESUring::GetSqe()
+{
+    if (m_fd < 0) {
+        return nullptr;
+    }
+
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        const uint32_t head = __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+        if (m_sqeTail - head < m_sqEntries) {
+            io_uring_sqe* sqe = &m_sqes[m_sqeTail & m_sqMask];
+            ++m_sqeTail;
+            std::memset(sqe, 0, sizeof(*sqe));
+            return sqe;
+        }
+        Submit(0, 0);
+    }
+    return nullptr;
+}
+
+bool ESUring::PrepRecvMultishot(int fd, uint16_t bufferGroup, uint64_t userData)
+{
+    io_uring_sqe* sqe = GetSqe();
+    if (sqe == nullptr) {
+        return false;
+    }
+
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = bufferGroup;
+    sqe->user_data = userData;
+    return true;
+}
+
+bool ESUring::PrepRecvMsgMultishot(int fd, msghdr* msg, uint16_t bufferGroup, uint64_t userData)
+{
+    io_uring_sqe* sqe = GetSqe();
+    if (sqe == nullptr) {
+        return false;
+    }
+
+    sqe->opcode = IORING_OP_RECVMSG;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(msg);
+    sqe->len = 1;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = bufferGroup;
+    sqe->user_data = userData;
+    return true;
+}
+
+bool ESUring::PrepAcceptMultishot(int fd, uint64_t userData)
+{
+    io_uring_sqe* sqe = GetSqe();
+    if (sqe == nullptr) {
+        return false;
+    }
+
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    sqe->user_data = userData;
+    return true;
+}
+
+bool ESUring::PrepCancel(uint64_t targetUserData, uint64_t userData)
+{
+    io_uring_sqe* sqe = GetSqe();
+    if (sqe == nullptr) {
+        return false;
+    }
+
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = targetUserData;
+    sqe->user_data = userData;
+    return true;
+}
+
+int ESUring::Submit(uint32_t waitNr, uint32_t timeoutMs)
+{
+    if (m_fd < 0) {
+        return -EBADF;
+    }
+
+    __atomic_store_n(m_sqTail, m_sqeTail, __ATOMIC_RELEASE);
+    const uint32_t toSubmit = m_sqeTail - m_sqeSubmitted;
+    if (toSubmit == 0 && waitNr == 0) {
+        return 0;
+    }
+
+    __kernel_timespec ts;
+    ts.tv_sec = timeoutMs / 1000;
+    ts.tv_nsec = static_cast<long long>(timeoutMs % 1000) * 1000000;
+
+    io_uring_getevents_arg arg;
+    std::memset(&arg, 0, sizeof(arg));
+    arg.sigmask_sz = _NSIG / 8;
+    arg.ts = reinterpret_cast<uint64_t>(&ts);
+
+    uint32_t flags = 0;
+    if (waitNr > 0) {
+        flags = IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+    }
+
+    ++m_enterCount;
+    const int ret = SysEnter(m_fd, toSubmit, waitNr, flags, (waitNr > 0) ? &arg : nullptr,
+                             (waitNr > 0) ? sizeof(arg) : 0);
+    if (ret < 0) {
+        return (errno == ETIME || errno == EINTR || errno == EBUSY) ? 0 : -errno;
+    }
+
+    m_sqeSubmitted += static_cast<uint32_t>(ret);
+    return ret;
+}
+
+size_t ESUring::DrainCompletions(const std::function<void(const ESUringCompletion&)>& fn)
+{
+    if (m_fd < 0) {
+        return 0;
+    }
+
+    const io_uring_cqe* cqes = static_cast<const io_uring_cqe*>(m_cqes);
+    uint32_t head = *m_cqHead;
+    const uint32_t tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+
+    size_t count = 0;
+    for (; head != tail; ++head, ++count) {
+        const io_uring_cqe& cqe = cqes[head & m_cqMask];
+
+        ESUringCompletion completion;
+        completion.userData = cqe.user_data;
+        completion.result = cqe.res;
+        completion.flags = cqe.flags;
+        if (fn) {
+            fn(completion);
+        }
+    }
+
+    __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+    m_completionCount += count;
+    return count;
+}
+
+uint64_t ESUring::GetEnterCount() const
+{
+    return m_enterCount;
+}
+
+uint64_t ESUring::GetCompletionCount() const
+{
+    return m_completionCount;
+}
+
+//
+// ESUringBufferRing
+//
+
+ESUringBufferRing::ESUringBufferRing() = default;
+
+ESUringBufferRing::~ESUringBufferRing()
+{
+    Unregister();
+}
+
+int ESUringBufferRing::Register(ESUring& uring, uint16_t groupId, uint32_t count, uint32_t bufferSize)
+{
+    Unregister();
+
+    if (!uring.IsOpen() || count == 0 || bufferSize == 0) {
+        return -EINVAL;
+    }
+
+    m_count = RoundUpPowerOfTwo(count);
+    m_bufferSize = bufferSize;
+    m_groupId = groupId;
+    m_tail = 0;
+
+    m_ringBytes = m_count * sizeof(io_uring_buf);
+    void* ring = mmap(nullptr, m_ringBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ring == MAP_FAILED) {
+        return -ENOMEM;
+    }
+    m_ring = static_cast<io_uring_buf_ring*>(ring);
+
+    io_uring_buf_reg reg;
+    std::memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<uint64_t>(m_ring);
+    reg.ring_entries = m_count;
+    reg.bgid = groupId;
+    if (SysRegister(uring.GetFd(), IORING_REGISTER_PBUF_RING, &reg, 1) != 0) {
+        const int error = errno;
+        munmap(m_ring, m_ringBytes);
+        m_ring = nullptr;
+        return -error;
+    }
+    m_uring = &uring;
+
+    m_buffers.assign(static_cast<size_t>(m_count) * m_bufferSize, 0);
+    for (uint32_t i = 0; i < m_count; ++i) {
+        Recycle(static_cast<uint16_t>(i));
+    }
+    Commit();
+    return 0;
+}
+
+void ESUringBufferRing::Unregister()
+{
+    if (m_ring == nullptr) {
+        return;
+    }
+
+    if (m_uring != nullptr && m_uring->IsOpen()) {
+        io_uring_buf_reg reg;
+        std::memset(&reg, 0, sizeof(reg));
+        reg.bgid = m_groupId;
+        SysRegister(m_uring->GetFd(), IORING_UNREGISTER_PBUF_RING, &reg, 1);
+    }
+
+    munmap(m_ring, m_ringBytes);
+    m_ring = nullptr;
+    m_uring = nullptr;
+    m_buffers.clear();
+    m_buffers.shrink_to_fit();
+}
+
+uint16_t ESUringBufferRing::GetGroupId() const
+{
+    return m_groupId;
+}
+
+uint32_t ESUringBufferRing::GetBufferCount() const
+{
+    return m_count;
+}
+
+uint32_t ESUringBufferRing::GetBufferSize() const
+{
+    return m_bufferSize;
+}
+
+uint8_t* ESUringBufferRing::GetBuffer(uint16_t bufferId)
+{
+    return m_buffers.data() + static_cast<size_t>(bufferId) * m_bufferSize;
+}
+
+// C++ 里 __DECLARE_FLEX_ARRAY 的空结构体占 1 字节，bufs 会错位，按裸数组访问；
+// tail 和 bufs[0].resv 重叠
+static io_uring_buf* RingEntries(io_uring_buf_ring* ring)
+{
+    return reinterpret_cast<io_uring_buf*>(ring);
+}
+
+void ESUringBufferRing::Recycle(uint16_t bufferId)
+{
+    io_uring_buf* buf = &RingEntries(m_ring)[m_tail & (m_count - 1)];
+    buf->addr = reinterpret_cast<uint64_t>(GetBuffer(bufferId));
+    buf->len = m_bufferSize;
+    buf->bid = bufferId;
+    ++m_tail;
+}
+
+void ESUringBufferRing::Commit()
+{
+    if (m_ring != nullptr) {
+        __atomic_store_n(&RingEntries(m_ring)[0].resv, m_tail, __ATOMIC_RELEASE);
+    }
+}
+
+#else
+
+bool ESUringCompletion::HasMore() const { return false; }
+bool ESUringCompletion::HasBuffer() const { return false; }
+uint16_t ESUringCompletion::GetBufferId() const { return 0; }
+
+ESUring::ESUring() = default;
+ESUring::~ESUring() = default;
+bool ESUring::IsSupported() { return false; }
+size_t ESUring::GetRecvMsgHeaderSize() { return 0; }
+bool ESUring::ParseRecvMsg(const uint8_t*, size_t, const msghdr&, ESUringRecvMsgView&) { return false; }
+int ESUring::Init(uint32_t) { return -1; }
+void ESUring::Close() {}
+bool ESUring::IsOpen() const { return false; }
+int ESUring::GetFd() const { return -1; }
+io_uring_sqe* ESUring::GetSqe() { return nullptr; }
+bool ESUring::PrepRecvMultishot(int, uint16_t, uint64_t) { return false; }
+bool ESUring::PrepRecvMsgMultishot(int, msghdr*, uint16_t, uint64_t) { return false; }
+bool ESUring::PrepAcceptMultishot(int, uint64_t) { return false; }
+bool ESUring::PrepCancel(uint64_t, uint64_t) { return false; }
+int ESUring::Submit(uint32_t, uint32_t) { return -1; }
+size_t ESUring::DrainCompletions(const std::function<void(const ESUringCompletion&)>&) { return 0; }
+uint64_t ESUring::GetEnterCount() const { return 0; }
+uint64_t ESUring::GetCompletionCount() const { return 0; }
+
+ESUringBufferRing::ESUringBufferRing() = default;
+ESUringBufferRing::~ESUringBufferRing() = default;
+int ESUringBufferRing::Register(ESUring&, uint16_t, uint32_t, uint32_t) { return -1; }
+void ESUringBufferRing::Unregister() {}
+uint16_t ESUringBufferRing::GetGroupId() const { return 0; }
+uint32_t ESUringBufferRing::GetBufferCount() const { return 0; }
+uint32_t ESUringBufferRing::GetBufferSize() const { return 0; }
+uint8_t* ESUringBufferRing::GetBuffer(uint16_t) { return nullptr; }
+void ESUringBufferRing::Recycle(uint16_t) {}
+void ESUringBufferRing::Commit() {}
+
+#endif
+
+} // namespace hhcast
\ No newline at end of file
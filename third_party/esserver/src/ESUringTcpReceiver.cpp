@@ -0,0 +1,370 @@
+#include "ESUringTcpReceiver.h"
+#include "ESSocketTuning.h"
+#include "ESUring.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <cerrno>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace hhcast {
+
+namespace {
+
+constexpr uint32_t kRingEntries = 256;
+constexpr uint32_t kWaitTimeoutMs = 200;       // 单次 enter 的等待上限，用于及时响应 Stop
+constexpr uint32_t kAcceptBackoffMs = 100;     // accept 出错（如 EMFILE）后的重试间隔
+constexpr uint16_t kBufferGroup = 0;
+
+// user_data 高 8 位是请求类型，低 32 位是连接编号
+constexpr uint64_t kAcceptTag = 1;
+constexpr uint64_t kRecvTag = 2;
+
+uint64_t MakeUserData(uint64_t tag, uint32_t id)
+{
+    return (tag << 56) | id;
+}
+
+uint64_t NowMs()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+#ifdef __linux__
+void PinCurrentThread(int cpu)
+{
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        return;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+        std::cout << "[ESUringTcpReceiver] pin thread to cpu " << cpu << " failed" << std::endl;
+    }
+}
+#endif
+
+} // namespace
+
+struct ESUringTcpReceiver::RingStorage {
+    ESUring uring;
+    ESUringBufferRing buffers;
+};
+
+ESUringTcpReceiver::ESUringTcpReceiver()
+{
+}
+
+ESUringTcpReceiver::~ESUringTcpReceiver()
+{
+    Stop();
+}
+
+void ESUringTcpReceiver::SetCallbacks(ESUringAcceptCallback onAccept, ESUringDataCallback onData,
+                                      ESUringCloseCallback onClose)
+{
+    m_onAccept = std::move(onAccept);
+    m_onData = std::move(onData);
+    m_onClose = std::move(onClose);
+}
+
+int ESUringTcpReceiver::Start(int listenfd, uint32_t bufferCount, uint32_t bufferSize, int cpu)
+{
+#ifdef __linux__
+    if (m_running.load() || listenfd < 0) {
+        if (listenfd >= 0) {
+            close(listenfd);
+        }
+        return -1;
+    }
+
+    auto ring = std::make_unique<RingStorage>();
+    int ret = ring->uring.Init(kRingEntries);
+    if (ret == 0) {
+        ret = ring->buffers.Register(ring->uring, kBufferGroup, bufferCount, bufferSize);
+    }
+    if (ret != 0) {
+        std::cout << "[ESUringTcpReceiver] init io_uring failed, ret=" << ret << std::endl;
+        close(listenfd);
+        return -2;
+    }
+
+    m_ring = std::move(ring);
+    m_listenFd = listenfd;
+    m_cpu = cpu;
+    m_enterCount = 0;
+    m_completionCount = 0;
+    m_recvBytes = 0;
+
+    m_running = true;
+    m_thread = std::thread(&ESUringTcpReceiver::RecvLoop, this);
+    return 0;
+#else
+    (void)bufferCount;
+    (void)bufferSize;
+    (void)cpu;
+    if (listenfd >= 0) {
+        CloseSocketFd(listenfd);
+    }
+    return -1;
+#endif
+}
+
+void ESUringTcpReceiver::Stop()
+{
+    m_running = false;
+
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    // 先关环，挂着的 accept/recv 请求才会放掉对 socket 的引用
+    m_ring.reset();
+
+    std::unordered_map<uint32_t, std::unique_ptr<Connection>> connections;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        connections.swap(m_connections);
+    }
+
+#ifdef __linux__
+    for (auto& item : connections) {
+        if (m_onClose) {
+            m_onClose(*item.second->context);
+        }
+        close(item.second->fd);
+    }
+
+    if (m_listenFd >= 0) {
+        close(m_listenFd);
+        m_listenFd = -1;
+
+        std::cout << "[ESUringTcpReceiver] stopped, enters=" << m_enterCount.load()
+                  << ", completions=" << m_completionCount.load()
+                  << ", bytes=" << m_recvBytes.load() << std::endl;
+    }
+#endif
+}
+
+bool ESUringTcpReceiver::IsRunning() const
+{
+    return m_running.load();
+}
+
+int ESUringTcpReceiver::GetListenFd() const
+{
+    return m_listenFd;
+}
+
+void ESUringTcpReceiver::CloseConnections(uint32_t peerIp)
+{
+#ifdef __linux__
+    // 只 shutdown，multishot recv 随即以 EOF 结束，收包线程据此回调 onClose 并关闭 fd
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& item : m_connections) {
+        Connection& conn = *item.second;
+        if (conn.peerIp == peerIp && !conn.closing.exchange(true)) {
+            shutdown(conn.fd, SHUT_RDWR);
+        }
+    }
+#else
+    (void)peerIp;
+#endif
+}
+
+ESUringTcpStats ESUringTcpReceiver::GetStats() const
+{
+    ESUringTcpStats stats;
+    stats.enterCount = m_enterCount.load();
+    stats.completionCount = m_completionCount.load();
+    stats.recvBytes = m_recvBytes.load();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    stats.connectionCount = m_connections.size();
+    return stats;
+}
+
+void ESUringTcpReceiver::AcceptConnection(int fd)
+{
+#ifdef __linux__
+    sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    std::memset(&addr, 0, sizeof(addr));
+
+    uint32_t peerIp = 0;
+    if (getpeername(fd, reinterpret_cast<sockaddr*>(&addr), &len) == 0 && addr.sin_family == AF_INET) {
+        peerIp = ntohl(addr.sin_addr.s_addr);
+    }
+
+    ESConnectionContextPtr context = m_onAccept ? m_onAccept(fd, peerIp) : nullptr;
+    if (!context) {
+        close(fd);
+        return;
+    }
+
+    auto conn = std::make_unique<Connection>();
+    conn->fd = fd;
+    conn->peerIp = peerIp;
+    conn->context = std::move(context);
+
+    uint32_t id = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        do {
+            id = ++m_nextId;
+        } while (id == 0 || m_connections.count(id) > 0);
+        m_connections.emplace(id, std::move(conn));
+    }
+
+    if (!m_ring->uring.PrepRecvMultishot(fd, kBufferGroup, MakeUserData(kRecvTag, id))) {
+        ReleaseConnection(id);
+    }
+#else
+    (void)fd;
+#endif
+}
+
+void ESUringTcpReceiver::ReleaseConnection(uint32_t id)
+{
+#ifdef __linux__
+    std::unique_ptr<Connection> conn;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_connections.find(id);
+        if (it == m_connections.end()) {
+            return;
+        }
+        conn = std::move(it->second);
+        m_connections.erase(it);
+    }
+
+    if (m_onClose) {
+        m_onClose(*conn->context);
+    }
+    close(conn->fd);
+#else
+    (void)id;
+#endif
+}
+
+void ESUringTcpReceiver::RecvLoop()
+{
+#ifdef __linux__
+    PinCurrentThread(m_cpu);
+
+    RingStorage& storage = *m_ring;
+    bool acceptArmed = false;
+    uint64_t acceptRetryMs = 0;
+    std::vector<uint32_t> rearm;
+    std::vector<uint32_t> finished;
+
+    while (m_running.load()) {
+        if (!acceptArmed && NowMs() >= acceptRetryMs) {
+            acceptArmed = storage.uring.PrepAcceptMultishot(m_listenFd, MakeUserData(kAcceptTag, 0));
+        }
+
+        // 缓冲用尽或内核主动结束的 recv 重新挂上
+        for (uint32_t id : rearm) {
+            int fd = -1;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                auto it = m_connections.find(id);
+                if (it != m_connections.end()) {
+                    fd = it->second->fd;
+                }
+            }
+            if (fd >= 0 && !storage.uring.PrepRecvMultishot(fd, kBufferGroup, MakeUserData(kRecvTag, id))) {
+                ReleaseConnection(id);
+            }
+        }
+        rearm.clear();
+
+        if (storage.uring.Submit(1, kWaitTimeoutMs) < 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        bool recycled = false;
+        storage.uring.DrainCompletions([&](const ESUringCompletion& completion) {
+            const uint64_t tag = completion.userData >> 56;
+
+            if (tag == kAcceptTag) {
+                if (completion.result >= 0) {
+                    AcceptConnection(completion.result);
+                }
+                if (!completion.HasMore()) {
+                    acceptArmed = false;
+                    if (completion.result < 0) {
+                        acceptRetryMs = NowMs() + kAcceptBackoffMs;
+                    }
+                }
+                return;
+            }
+
+            if (tag != kRecvTag) {
+                return;
+            }
+
+            const uint32_t id = static_cast<uint32_t>(completion.userData);
+            Connection* conn = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                auto it = m_connections.find(id);
+                if (it != m_connections.end()) {
+                    conn = it->second.get();
+                }
+            }
+
+            if (completion.HasBuffer()) {
+                const uint16_t bufferId = completion.GetBufferId();
+                if (conn && completion.result > 0 && !conn->closing.load()) {
+                    const size_t size = static_cast<size_t>(completion.result);
+                    m_recvBytes += size;
+                    if (m_onData &&
+                        !m_onData(conn->fd, *conn->context, storage.buffers.GetBuffer(bufferId), size) &&
+                        !conn->closing.exchange(true)) {
+                        shutdown(conn->fd, SHUT_RDWR);
+                    }
+                }
+                storage.buffers.Recycle(bufferId);
+                recycled = true;
+            }
+
+            if (conn && !completion.HasMore()) {
+                if (completion.result == -ENOBUFS || (completion.result > 0 && !conn->closing.load())) {
+                    rearm.push_back(id);
+                } else {
+                    finished.push_back(id);   // EOF、出错或已要求断开
+                }
+            }
+        });
+
+        // 回调返回后缓冲即可还给内核，一批只发布一次
+        if (recycled) {
+            storage.buffers.Commit();
+        }
+
+        for (uint32_t id : finished) {
+            ReleaseConnection(id);
+        }
+        finished.clear();
+
+        m_enterCount = storage.uring.GetEnterCount();
+        m_completionCount = storage.uring.GetCompletionCount();
+    }
+#endif
+}
+
+} // namespace hhcast
\ No newline at end of file
@@ -1,9 +1,13 @@
 #include "ESUtils.h"
 
+#include <chrono>
+
 #ifdef _WIN32
 #include <WS2tcpip.h>
+#include <windows.h>
 #else
 #include <arpa/inet.h>
+#include <time.h>
 #endif
 
 namespace hhcast {
@@ -19,4 +23,34 @@ uint32_t IPToStreamID(const std::string& ipAddress)
     return 0;
 }
 
+uint64_t GetSteadyTimeUs()
+{
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+uint64_t GetThreadCpuTimeNs()
+{
+#ifdef _WIN32
+    FILETIME creation, exitTime, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exitTime, &kernel, &user)) {
+        return 0;
+    }
+
+    // FILETIME 以 100ns 为单位
+    const uint64_t kernel100ns = (static_cast<uint64_t>(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime;
+    const uint64_t user100ns = (static_cast<uint64_t>(user.dwHighDateTime) << 32) | user.dwLowDateTime;
+    return (kernel100ns + user100ns) * 100;
+#elif defined(CLOCK_THREAD_CPUTIME_ID)
+    timespec cpu = {};
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu) != 0) {
+        return 0;
+    }
+    return static_cast<uint64_t>(cpu.tv_sec) * 1000000000ULL + static_cast<uint64_t>(cpu.tv_nsec);
+#else
+    return 0;
+#endif
+}
+
 } // namespace hhcast
\ No newline at end of file
@@ -16,20 +16,44 @@ void ESVideoDepacketizer::SetCallback(ESVideoUnitCallback callback)
 }
 
 bool ESVideoDepacketizer::PushBytes(const uint8_t* data, size_t size)
+{
+    if (!Append(data, size)) {
+        return false;
+    }
+
+    ESVideoUnit unit;
+    while (NextUnit(unit)) {
+        if (m_callback &&
+            (unit.kind == ESVideoUnitKind::Config || unit.kind == ESVideoUnitKind::Frame) &&
+            unit.payloadSize > 0)
+        {
+            m_callback(unit);
+        }
+    }
+    return true;
+}
+
+bool ESVideoDepacketizer::Append(const uint8_t* data, size_t size)
 {
     if (data == nullptr || size == 0) {
         return false;
     }
 
+    // 上一次交出去的单元到这里才移走，回调方可以把 payload 留到本次调用之前
+    if (m_readOffset > 0) {
+        m_buffer.erase(m_buffer.begin(), m_buffer.begin() + static_cast<std::ptrdiff_t>(m_readOffset));
+        m_readOffset = 0;
+    }
+
     m_inputBytes += static_cast<uint64_t>(size);
     m_buffer.insert(m_buffer.end(), data, data + size);
-    ProcessBuffer();
     return true;
 }
 
 void ESVideoDepacketizer::Reset()
 {
     m_buffer.clear();
+    m_readOffset = 0;
     m_inputBytes = 0;
     m_unitCount = 0;
     m_droppedUnitCount = 0;
@@ -50,6 +74,30 @@ uint64_t ESVideoDepacketizer::GetInputBytes() const
     return m_inputBytes;
 }
 
+size_t ESVideoDepacketizer::GetBufferedSize() const
+{
+    return m_buffer.size() - m_readOffset;
+}
+
+std::string_view ESVideoDepacketizer::GetBuffered() const
+{
+    return std::string_view(reinterpret_cast<const char*>(m_buffer.data()) + m_readOffset, GetBufferedSize());
+}
+
+size_t ESVideoDepacketizer::GetAllocatedBytes() const
+{
+    return m_buffer.capacity();
+}
+
+void ESVideoDepacketizer::ReleaseSpare()
+{
+    if (m_readOffset > 0) {
+        m_buffer.erase(m_buffer.begin(), m_buffer.begin() + static_cast<std::ptrdiff_t>(m_readOffset));
+        m_readOffset = 0;
+    }
+    m_buffer.shrink_to_fit();
+}
+
 uint32_t ESVideoDepacketizer::ReadLe32(const uint8_t* p)
 {
     return  (static_cast<uint32_t>(p[0])      ) |
@@ -67,60 +115,53 @@ uint64_t ESVideoDepacketizer::ReadLe64(const uint8_t* p)
     return v;
 }
 
-void ESVideoDepacketizer::ProcessBuffer()
+bool ESVideoDepacketizer::NextUnit(ESVideoUnit& unit)
 {
-    while (true) {
-        if (m_buffer.size() < kEsVideoHeaderSize) {
-            return;
-        }
-
-        const uint8_t* base = m_buffer.data();
-        const uint32_t payloadLen = ReadLe32(base + 0x00);
-        const uint32_t rawKind = ReadLe32(base + 0x04);
-        const uint64_t timestamp32_32 = ReadLe64(base + 0x08);
-
-        if (payloadLen > kMaxEsVideoPayloadLen) {
-            ++m_droppedUnitCount;
-            m_buffer.clear();
-            return;
-        }
-
-        const size_t totalLen = kEsVideoHeaderSize + static_cast<size_t>(payloadLen);
-        if (m_buffer.size() < totalLen) {
-            return;
-        }
+    const size_t available = m_buffer.size() - m_readOffset;
+    if (available < kEsVideoHeaderSize) {
+        return false;
+    }
 
-        ESVideoUnit unit;
-        unit.payloadLen = payloadLen;
-        unit.rawKind = rawKind;
-        unit.timestamp32_32 = timestamp32_32;
-        unit.payload = base + kEsVideoHeaderSize;
-        unit.payloadSize = payloadLen;
-
-        switch (rawKind) {
-        case static_cast<uint32_t>(ESVideoUnitKind::Config):
-            unit.kind = ESVideoUnitKind::Config;
-            break;
-        case static_cast<uint32_t>(ESVideoUnitKind::Frame):
-            unit.kind = ESVideoUnitKind::Frame;
-            break;
-        default:
-            unit.kind = ESVideoUnitKind::Unknown;
-            ++m_droppedUnitCount;
-            break;
-        }
+    const uint8_t* base = m_buffer.data() + m_readOffset;
+    const uint32_t payloadLen = ReadLe32(base + 0x00);
+    const uint32_t rawKind = ReadLe32(base + 0x04);
+    const uint64_t timestamp32_32 = ReadLe64(base + 0x08);
 
-        ++m_unitCount;
+    if (payloadLen > kMaxEsVideoPayloadLen) {
+        ++m_droppedUnitCount;
+        m_buffer.clear();
+        m_readOffset = 0;
+        return false;
+    }
 
-        if (m_callback &&
-            (unit.kind == ESVideoUnitKind::Config || unit.kind == ESVideoUnitKind::Frame) &&
-            unit.payloadSize > 0)
-        {
-            m_callback(unit);
-        }
+    const size_t totalLen = kEsVideoHeaderSize + static_cast<size_t>(payloadLen);
+    if (available < totalLen) {
+        return false;
+    }
 
-        m_buffer.erase(m_buffer.begin(), m_buffer.begin() + static_cast<std::ptrdiff_t>(totalLen));
+    unit = ESVideoUnit{};
+    unit.payloadLen = payloadLen;
+    unit.rawKind = rawKind;
+    unit.timestamp32_32 = timestamp32_32;
+    unit.payload = base + kEsVideoHeaderSize;
+    unit.payloadSize = payloadLen;
+
+    switch (rawKind) {
+    case static_cast<uint32_t>(ESVideoUnitKind::Config):
+        unit.kind = ESVideoUnitKind::Config;
+        break;
+    case static_cast<uint32_t>(ESVideoUnitKind::Frame):
+        unit.kind = ESVideoUnitKind::Frame;
+        break;
+    default:
+        unit.kind = ESVideoUnitKind::Unknown;
+        ++m_droppedUnitCount;
+        break;
     }
+
+    ++m_unitCount;
+    m_readOffset += totalLen;
+    return true;
 }
 
 } // namespace hhcast
\ No newline at end of file